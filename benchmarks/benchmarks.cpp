@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Microbenchmark support: input generation and cycle timing.
+ */
+
+#include "config.h"
+
+#include "benchmarks.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace ue2 {
+namespace bench {
+
+/** Total bytes to scan per trial; keeps short buffers from being dominated by
+ * timer overhead. */
+static const size_t BYTES_PER_TRIAL = 16 * 1024 * 1024;
+
+/** Number of trials; the fastest is reported. */
+static const u32 TRIALS = 5;
+
+vector<CharShape> charShapes() {
+    vector<CharShape> shapes;
+
+    shapes.push_back({"single", CharReach('a')});
+
+    CharReach caseless('a');
+    caseless.set('A');
+    shapes.push_back({"caseless", caseless});
+
+    shapes.push_back({"range", CharReach('0', '9')});
+
+    /* members spread over many high and low nibbles, which costs shufti
+     * several bucket bits */
+    shapes.push_back({"sparse", CharReach(string("\t\n%@Q_z~"))});
+
+    /* more distinct nibble combinations than shufti has buckets */
+    CharReach wide(string("!#%')+-/13579;=?ACEGIKMOQSUWY"));
+    for (u32 c = 0x80; c < 0x100; c += 5) {
+        wide.set(c);
+    }
+    shapes.push_back({"wide", wide});
+
+    return shapes;
+}
+
+u8 randomMember(const CharReach &cr, mt19937 &rng) {
+    assert(cr.any());
+    size_t n = uniform_int_distribution<size_t>(0, cr.count() - 1)(rng);
+    size_t c = cr.find_nth(n);
+    assert(c != CharReach::npos);
+    return (u8)c;
+}
+
+BenchBuffer::BenchBuffer(const BenchParams &p, const CharReach &hits,
+                         const CharReach &misses, u32 seed)
+    : buf(aligned_zmalloc_unique<u8>(p.len + p.align + 64)), len(p.len),
+      align(p.align) {
+    assert(misses.any());
+    mt19937 rng(seed);
+    bernoulli_distribution is_hit(p.density);
+    u8 *d = buf.get() + align;
+    for (size_t i = 0; i < len; i++) {
+        const CharReach &cr = hits.any() && is_hit(rng) ? hits : misses;
+        d[i] = randomMember(cr, rng);
+    }
+}
+
+void BenchBuffer::plant(size_t pos, const string &s) {
+    if (pos >= len) {
+        return;
+    }
+    size_t n = min(s.size(), len - pos);
+    memcpy(buf.get() + align + pos, s.data(), n);
+}
+
+double cyclesPerOp(const Kernel &k, const u8 *buf, size_t len, size_t ops) {
+    assert(len && ops);
+    size_t reps = max(BYTES_PER_TRIAL / len, (size_t)1);
+
+    /* warm the caches and branch predictors */
+    volatile size_t sink = k(buf, len);
+
+    u64a best = ~0ULL;
+    for (u32 t = 0; t < TRIALS; t++) {
+        size_t acc = 0;
+        u64a start = __rdtsc();
+        for (size_t r = 0; r < reps; r++) {
+            acc += k(buf, len);
+        }
+        u64a cycles = __rdtsc() - start;
+        sink = sink + acc;
+        best = min(best, cycles);
+    }
+    (void)sink;
+
+    return (double)best / ((double)reps * ops);
+}
+
+double cyclesPerByte(const Kernel &k, const u8 *buf, size_t len) {
+    return cyclesPerOp(k, buf, len, len);
+}
+
+} // namespace bench
+} // namespace ue2
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Microbenchmark support: input generation and cycle timing.
+ */
+
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include "ue2common.h"
+#include "util/alloc.h"
+#include "util/charreach.h"
+#include "util/simd_types.h"
+
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ue2 {
+namespace bench {
+
+/** \brief Parameters for a single timed run of a kernel. */
+struct BenchParams {
+    size_t len;     //!< bytes scanned per call
+    u32 align;      //!< offset of the buffer from a cacheline boundary
+    double density; //!< fraction of positions holding a match
+};
+
+/**
+ * \brief Scans the given buffer once. Returns a value derived from the
+ * results so that the work cannot be optimised away.
+ */
+using Kernel = std::function<size_t(const u8 *buf, size_t len)>;
+
+/** \brief A set of characters to search for, with a descriptive name. */
+struct CharShape {
+    const char *name;
+    CharReach cr;
+};
+
+/** \brief The character class shapes exercised by the class scanners. */
+std::vector<CharShape> charShapes();
+
+/**
+ * \brief Cacheline-aligned buffer holding benchmark input at a given
+ * misalignment.
+ *
+ * Positions are drawn from \a hits with probability \a density and from
+ * \a misses otherwise, using a fixed seed so that runs are repeatable.
+ */
+class BenchBuffer {
+public:
+    BenchBuffer(const BenchParams &p, const CharReach &hits,
+                const CharReach &misses, u32 seed = 0);
+
+    const u8 *data() const { return buf.get() + align; }
+    size_t size() const { return len; }
+
+    /** \brief Overwrites the buffer from \a pos with the given string. */
+    void plant(size_t pos, const std::string &s);
+
+private:
+    aligned_unique_ptr<u8> buf;
+    size_t len;
+    u32 align;
+};
+
+/** \brief Picks a uniformly random member of a non-empty CharReach. */
+u8 randomMember(const CharReach &cr, std::mt19937 &rng);
+
+/**
+ * \brief Runs \a k over \a buf repeatedly and returns the best observed
+ * cycles per byte over several trials.
+ */
+double cyclesPerByte(const Kernel &k, const u8 *buf, size_t len);
+
+/**
+ * \brief As cyclesPerByte, but divides by \a ops, the number of operations
+ * performed by each call of \a k, rather than by \a len.
+ */
+double cyclesPerOp(const Kernel &k, const u8 *buf, size_t len, size_t ops);
+
+} // namespace bench
+} // namespace ue2
+
+#endif // BENCHMARKS_H
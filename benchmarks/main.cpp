@@ -0,0 +1,559 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Microbenchmarks for the SIMD scanning primitives.
+ *
+ * Each benchmark family is run over a grid of buffer lengths, alignments and
+ * match densities (and, for the character class scanners, class shapes) and
+ * reports the best observed cycles per byte. Use -f to restrict the run to
+ * families whose names contain the given string.
+ */
+
+#include "config.h"
+
+#include "benchmarks.h"
+#include "ue2common.h"
+#include "fdr/fdr.h"
+#include "fdr/fdr_compile.h"
+#include "fdr/fdr_compile_internal.h"
+#include "fdr/teddy_compile.h"
+#include "grey.h"
+#include "hwlm/hwlm_literal.h"
+#include "hwlm/noodle_build.h"
+#include "hwlm/noodle_engine.h"
+#include "nfa/shufti.h"
+#include "nfa/shufticompile.h"
+#include "nfa/truffle.h"
+#include "nfa/trufflecompile.h"
+#include "nfa/vermicelli.h"
+#include "util/masked_move.h"
+#include "util/multibit.h"
+#include "util/simd_utils.h"
+#include "util/state_compress.h"
+#include "util/target_info.h"
+#include "util/ue2_containers.h"
+#include "util/verify_types.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace ue2;
+using namespace ue2::bench;
+
+namespace {
+
+struct Options {
+    vector<size_t> lengths = {16, 64, 256, 4096, 65536};
+    vector<u32> aligns = {0, 1, 7};
+    vector<double> densities = {0.0, 0.001, 0.01, 0.1};
+    string filter;
+};
+
+void printHeader() {
+    printf("%-18s %-10s %8s %5s %8s %12s %12s\n", "benchmark", "variant",
+           "len", "align", "density", "cycles/byte", "cycles/op");
+}
+
+/** Reports a result for a scanner, in cycles per byte scanned. */
+void report(const char *name, const string &variant, const BenchParams &p,
+            double cpb) {
+    printf("%-18s %-10s %8zu %5u %8g %12.3f %12s\n", name, variant.c_str(),
+           p.len, p.align, p.density, cpb, "-");
+    fflush(stdout);
+}
+
+/** Reports a result for a primitive that is not a scanner, in cycles per
+ * operation (key visited, block compressed, ...). */
+void reportOp(const char *name, const string &variant, const BenchParams &p,
+              double cpo) {
+    printf("%-18s %-10s %8zu %5u %8g %12s %12.3f\n", name, variant.c_str(),
+           p.len, p.align, p.density, "-", cpo);
+    fflush(stdout);
+}
+
+/** Calls \a f once for each combination of length, alignment and density. */
+template<class Func>
+void forEachParams(const Options &opts, Func f) {
+    for (size_t len : opts.lengths) {
+        for (u32 align : opts.aligns) {
+            for (double density : opts.densities) {
+                f(BenchParams{len, align, density});
+            }
+        }
+    }
+}
+
+/** Runs a forward "find first" scanner over the whole buffer, restarting after
+ * each match, and returns the number of matches found. */
+template<class Exec>
+size_t scanForward(const u8 *buf, size_t len, Exec exec) {
+    size_t matches = 0;
+    const u8 *p = buf;
+    const u8 *end = buf + len;
+    while (p < end) {
+        const u8 *m = exec(p, end);
+        if (m >= end) {
+            break;
+        }
+        matches++;
+        p = m + 1;
+    }
+    return matches;
+}
+
+/** As scanForward, for reverse scanners that return (buf - 1) on failure. */
+template<class Exec>
+size_t scanReverse(const u8 *buf, size_t len, Exec exec) {
+    size_t matches = 0;
+    const u8 *end = buf + len;
+    while (end > buf) {
+        const u8 *m = exec(buf, end);
+        if (m < buf) {
+            break;
+        }
+        matches++;
+        end = m;
+    }
+    return matches;
+}
+
+void benchShufti(const Options &opts) {
+    for (const CharShape &shape : charShapes()) {
+        m128 lo, hi;
+        if (shuftiBuildMasks(shape.cr, &lo, &hi) == -1) {
+            continue; /* shape does not fit in shufti's buckets */
+        }
+        forEachParams(opts, [&](const BenchParams &p) {
+            BenchBuffer b(p, shape.cr, ~shape.cr);
+            double fwd = cyclesPerByte([&](const u8 *buf, size_t len) {
+                return scanForward(buf, len, [&](const u8 *s, const u8 *e) {
+                    return shuftiExec(lo, hi, s, e);
+                });
+            }, b.data(), b.size());
+            report("shufti", shape.name, p, fwd);
+            double rev = cyclesPerByte([&](const u8 *buf, size_t len) {
+                return scanReverse(buf, len, [&](const u8 *s, const u8 *e) {
+                    return rshuftiExec(lo, hi, s, e);
+                });
+            }, b.data(), b.size());
+            report("rshufti", shape.name, p, rev);
+        });
+    }
+}
+
+void benchDoubleShufti(const Options &opts) {
+    /* two-byte pairs drawn from the class shapes: "xy" for each pair of
+     * members, planted at the requested density */
+    for (const CharShape &shape : charShapes()) {
+        if (shape.cr.count() > 8) {
+            continue; /* double shufti has eight buckets */
+        }
+        flat_set<pair<u8, u8>> pairs;
+        for (size_t i = shape.cr.find_first(); i != CharReach::npos;
+             i = shape.cr.find_next(i)) {
+            pairs.emplace((u8)i, (u8)'z');
+        }
+        m128 lo1, hi1, lo2, hi2;
+        shuftiBuildDoubleMasks(CharReach(), pairs, &lo1, &hi1, &lo2, &hi2);
+        forEachParams(opts, [&](const BenchParams &p) {
+            BenchBuffer b(p, shape.cr, ~(shape.cr | CharReach('z')));
+            mt19937 rng(1);
+            bernoulli_distribution is_hit(p.density);
+            for (size_t i = 0; i + 1 < p.len; i++) {
+                if (is_hit(rng)) {
+                    string s = {(char)randomMember(shape.cr, rng), 'z'};
+                    b.plant(i, s);
+                }
+            }
+            double cpb = cyclesPerByte([&](const u8 *buf, size_t len) {
+                return scanForward(buf, len, [&](const u8 *s, const u8 *e) {
+                    return shuftiDoubleExec(lo1, hi1, lo2, hi2, s, e);
+                });
+            }, b.data(), b.size());
+            report("double-shufti", shape.name, p, cpb);
+        });
+    }
+}
+
+void benchTruffle(const Options &opts) {
+    for (const CharShape &shape : charShapes()) {
+        m128 lo, hi;
+        truffleBuildMasks(shape.cr, &lo, &hi);
+        forEachParams(opts, [&](const BenchParams &p) {
+            BenchBuffer b(p, shape.cr, ~shape.cr);
+            double fwd = cyclesPerByte([&](const u8 *buf, size_t len) {
+                return scanForward(buf, len, [&](const u8 *s, const u8 *e) {
+                    return truffleExec(lo, hi, s, e);
+                });
+            }, b.data(), b.size());
+            report("truffle", shape.name, p, fwd);
+            double rev = cyclesPerByte([&](const u8 *buf, size_t len) {
+                return scanReverse(buf, len, [&](const u8 *s, const u8 *e) {
+                    return rtruffleExec(lo, hi, s, e);
+                });
+            }, b.data(), b.size());
+            report("rtruffle", shape.name, p, rev);
+        });
+    }
+}
+
+void benchVermicelli(const Options &opts) {
+    for (bool nocase : {false, true}) {
+        const char *variant = nocase ? "caseless" : "single";
+        CharReach cr('a');
+        if (nocase) {
+            cr.set('A');
+        }
+        forEachParams(opts, [&](const BenchParams &p) {
+            BenchBuffer b(p, cr, ~cr);
+            double fwd = cyclesPerByte([&](const u8 *buf, size_t len) {
+                return scanForward(buf, len, [&](const u8 *s, const u8 *e) {
+                    return vermicelliExec('a', nocase, s, e);
+                });
+            }, b.data(), b.size());
+            report("vermicelli", variant, p, fwd);
+            double rev = cyclesPerByte([&](const u8 *buf, size_t len) {
+                return scanReverse(buf, len, [&](const u8 *s, const u8 *e) {
+                    return rvermicelliExec('a', nocase, s, e);
+                });
+            }, b.data(), b.size());
+            report("rvermicelli", variant, p, rev);
+            double dbl = cyclesPerByte([&](const u8 *buf, size_t len) {
+                return scanForward(buf, len, [&](const u8 *s, const u8 *e) {
+                    /* the double scanner needs a full block; leave short
+                     * tails unscanned */
+                    if (e - s < VERM_BOUNDARY) {
+                        return e;
+                    }
+                    return vermicelliDoubleExec('a', 'a', nocase, s, e);
+                });
+            }, b.data(), b.size());
+            report("double-vermicelli", variant, p, dbl);
+        });
+    }
+}
+
+hwlmcb_rv_t countMatch(UNUSED size_t start, UNUSED size_t end, UNUSED u32 id,
+                       void *ctxt) {
+    (*(size_t *)ctxt)++;
+    return HWLM_CONTINUE_MATCHING;
+}
+
+/** Fills a buffer of background characters and plants copies of the given
+ * literals at the requested density. */
+BenchBuffer literalBuffer(const BenchParams &p, const vector<string> &lits) {
+    CharReach background('a', 'z');
+    for (const string &s : lits) {
+        background.clear((u8)s[0]);
+    }
+    BenchBuffer b(p, CharReach(), background);
+    mt19937 rng(2);
+    bernoulli_distribution is_hit(p.density);
+    uniform_int_distribution<size_t> which(0, lits.size() - 1);
+    for (size_t i = 0; i < p.len; i++) {
+        if (is_hit(rng)) {
+            b.plant(i, lits[which(rng)]);
+        }
+    }
+    return b;
+}
+
+void benchNoodle(const Options &opts) {
+    for (bool nocase : {false, true}) {
+        const string lit = "hyperscan";
+        auto n = noodBuildTable((const u8 *)lit.c_str(), lit.size(), nocase,
+                                0);
+        forEachParams(opts, [&](const BenchParams &p) {
+            BenchBuffer b = literalBuffer(p, {lit});
+            double cpb = cyclesPerByte([&](const u8 *buf, size_t len) {
+                size_t matches = 0;
+                noodExec(n.get(), buf, len, 0, countMatch, &matches);
+                return matches;
+            }, b.data(), b.size());
+            report("noodle", nocase ? "caseless" : "cased", p, cpb);
+        });
+    }
+}
+
+vector<string> randomLiterals(u32 count, u32 min_len, u32 max_len) {
+    mt19937 rng(3);
+    uniform_int_distribution<u32> len_dist(min_len, max_len);
+    uniform_int_distribution<int> char_dist('A', 'Z');
+    vector<string> lits;
+    for (u32 i = 0; i < count; i++) {
+        string s(len_dist(rng), 'A');
+        for (char &c : s) {
+            c = (char)char_dist(rng);
+        }
+        lits.push_back(s);
+    }
+    return lits;
+}
+
+/** Builds a literal matcher over the given literals, or returns nullptr if
+ * the engine cannot take them. */
+using LitBuilder =
+    function<aligned_unique_ptr<FDR>(const vector<hwlmLiteral> &lits)>;
+
+void benchLiteralMatcher(const Options &opts, const char *name,
+                         const LitBuilder &build) {
+    for (u32 count : {8, 64, 1000}) {
+        vector<string> strs = randomLiterals(count, 4, 12);
+        vector<hwlmLiteral> lits;
+        for (u32 i = 0; i < strs.size(); i++) {
+            lits.push_back(hwlmLiteral(strs[i], false, i));
+        }
+        auto fdr = build(lits);
+        if (!fdr) {
+            continue; /* engine cannot take this many literals */
+        }
+        ostringstream variant;
+        variant << count << "-lits";
+        forEachParams(opts, [&](const BenchParams &p) {
+            BenchBuffer b = literalBuffer(p, strs);
+            double cpb = cyclesPerByte([&](const u8 *buf, size_t len) {
+                size_t matches = 0;
+                fdrExec(fdr.get(), buf, len, 0, countMatch, &matches,
+                        HWLM_ALL_GROUPS);
+                return matches;
+            }, b.data(), b.size());
+            report(name, variant.str(), p, cpb);
+        });
+    }
+}
+
+void benchFdr(const Options &opts) {
+    /* keep fdrBuildTable from handing small sets to Teddy */
+    Grey grey;
+    grey.fdrAllowTeddy = false;
+    benchLiteralMatcher(opts, "fdr", [&](const vector<hwlmLiteral> &lits) {
+        return fdrBuildTable(lits, false, get_current_target(), grey);
+    });
+}
+
+void benchTeddy(const Options &opts) {
+    benchLiteralMatcher(opts, "teddy", [](const vector<hwlmLiteral> &lits) {
+        return teddyBuildTableHinted(lits, false, HINT_INVALID,
+                                     get_current_target(),
+                                     pair<u8 *, size_t>(nullptr, 0));
+    });
+}
+
+/* For the following, "len" is the number of keys (multibit) or bytes of state
+ * (state_compress), and density is the fraction of bits set. Results are
+ * reported per key visited or per m128 compressed and restored. */
+
+void benchMultibit(const Options &opts) {
+    forEachParams(opts, [&](const BenchParams &p) {
+        u32 total_bits = verify_u32(p.len);
+        vector<u8> storage(mmbit_size(total_bits) + p.align);
+        u8 *ba = storage.data() + p.align;
+        mmbit_clear(ba, total_bits);
+        mt19937 rng(4);
+        bernoulli_distribution is_set(p.density);
+        for (u32 i = 0; i < total_bits; i++) {
+            if (is_set(rng)) {
+                mmbit_set(ba, total_bits, i);
+            }
+        }
+        double cpo = cyclesPerOp([&](const u8 *, size_t) {
+            size_t sum = 0;
+            for (u32 i = mmbit_iterate(ba, total_bits, MMB_INVALID);
+                 i != MMB_INVALID; i = mmbit_iterate(ba, total_bits, i)) {
+                sum += i;
+            }
+            return sum;
+        }, ba, p.len, total_bits);
+        reportOp("multibit-iterate", "keys", p, cpo);
+    });
+}
+
+void benchStateCompress(const Options &opts) {
+    forEachParams(opts, [&](const BenchParams &p) {
+        size_t count = max(p.len / sizeof(m128), (size_t)1);
+        size_t bytes = count * sizeof(m128);
+        auto val_store = aligned_zmalloc_unique<u8>(bytes);
+        auto mask_store = aligned_zmalloc_unique<u8>(bytes);
+        const m128 *vals = (const m128 *)val_store.get();
+        const m128 *masks = (const m128 *)mask_store.get();
+        mt19937 rng(5);
+        /* density here is the fraction of state bits that are live */
+        bernoulli_distribution is_set(max(p.density, 0.25));
+        for (size_t i = 0; i < bytes; i++) {
+            val_store.get()[i] = (u8)rng();
+            u8 m = 0;
+            for (u32 k = 0; k < 8; k++) {
+                m |= is_set(rng) ? (1U << k) : 0;
+            }
+            mask_store.get()[i] = m;
+        }
+        vector<u8> out(bytes + p.align);
+        u8 *base = out.data() + p.align;
+        double cpo = cyclesPerOp([&](const u8 *, size_t) {
+            size_t sum = 0;
+            for (size_t i = 0; i < count; i++) {
+                u8 *dest = base + i * sizeof(m128);
+                storecompressed128(dest, &vals[i], &masks[i], sizeof(m128));
+                m128 x;
+                loadcompressed128(&x, dest, &masks[i], sizeof(m128));
+                sum += movq(x);
+            }
+            return sum;
+        }, base, bytes, count);
+        reportOp("state-compress", "m128", p, cpo);
+    });
+}
+
+void benchMaskedMove(UNUSED const Options &opts) {
+#if defined(__AVX2__)
+    forEachParams(opts, [&](const BenchParams &p) {
+        BenchBuffer b(p, CharReach(), CharReach::dot());
+        double cpb = cyclesPerByte([&](const u8 *buf, size_t len) {
+            m256 acc = zeroes256();
+            for (size_t i = 0; i < len; i += 32) {
+                u32 n = (u32)min(len - i, (size_t)32);
+                if (n < 4) {
+                    break; /* masked_move256_len needs at least 4 bytes */
+                }
+                acc = or256(acc, masked_move256_len(buf + i, n));
+            }
+            return movq(movdq_lo(acc)) + movq(movdq_hi(acc));
+        }, b.data(), b.size());
+        report("masked-move", "m256", p, cpb);
+    });
+#endif
+}
+
+struct Family {
+    const char *name;
+    void (*run)(const Options &);
+};
+
+const Family families[] = {
+    {"shufti", benchShufti},
+    {"double-shufti", benchDoubleShufti},
+    {"truffle", benchTruffle},
+    {"vermicelli", benchVermicelli},
+    {"noodle", benchNoodle},
+    {"fdr", benchFdr},
+    {"teddy", benchTeddy},
+    {"multibit", benchMultibit},
+    {"state-compress", benchStateCompress},
+    {"masked-move", benchMaskedMove},
+};
+
+template<class T>
+vector<T> parseList(const char *arg) {
+    vector<T> out;
+    istringstream in(arg);
+    string tok;
+    while (getline(in, tok, ',')) {
+        istringstream conv(tok);
+        T val;
+        if (!(conv >> val)) {
+            fprintf(stderr, "Bad list element '%s'\n", tok.c_str());
+            exit(1);
+        }
+        out.push_back(val);
+    }
+    return out;
+}
+
+void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s [-f FILTER] [-l LENGTHS] [-a ALIGNS] [-d DENSITIES]\n"
+            "  -f FILTER     only run families whose name contains FILTER\n"
+            "  -l LENGTHS    comma-separated buffer lengths\n"
+            "  -a ALIGNS     comma-separated offsets from a cacheline\n"
+            "  -d DENSITIES  comma-separated match densities (0..1)\n"
+            "Families:",
+            name);
+    for (const Family &f : families) {
+        fprintf(stderr, " %s", f.name);
+    }
+    fprintf(stderr, "\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options opts;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:l:a:d:h")) != -1) {
+        switch (opt) {
+        case 'f':
+            opts.filter = optarg;
+            break;
+        case 'l':
+            opts.lengths = parseList<size_t>(optarg);
+            break;
+        case 'a':
+            opts.aligns = parseList<u32>(optarg);
+            break;
+        case 'd':
+            opts.densities = parseList<double>(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    for (size_t len : opts.lengths) {
+        if (!len) {
+            fprintf(stderr, "Lengths must be non-zero\n");
+            return 1;
+        }
+    }
+    for (u32 align : opts.aligns) {
+        if (align >= 64) {
+            fprintf(stderr, "Alignments must be less than 64\n");
+            return 1;
+        }
+    }
+
+    printHeader();
+    for (const Family &f : families) {
+        if (opts.filter.empty() || strstr(f.name, opts.filter.c_str())) {
+            f.run(opts);
+        }
+    }
+
+    return 0;
+}
@@ -35,26 +35,37 @@
  * way to examine the performance achievable on a particular combination of
  * platform, pattern set and input data.
  *
+ * With -T, the streaming mode scan is instead run as a multi-threaded
+ * pipeline: a reader thread hashes each packet's 5-tuple to pick one of N
+ * worker threads and hands it over through a lock-free single-producer,
+ * single-consumer queue. Each worker has its own scratch (cloned with
+ * hs_clone_scratch) and its own table of open streams, so all packets of a
+ * flow are scanned in order by the same thread.
+ *
  * Build instructions:
  *
- *     g++ -std=c++11 -O2 -o pcapscan pcapscan.cc $(pkg-config --cflags --libs libhs) -lpcap
+ *     g++ -std=c++11 -O2 -pthread -o pcapscan pcapscan.cc $(pkg-config --cflags --libs libhs) -lpcap
  *
  * Usage:
  *
- *     ./pcapscan [-n repeats] <pattern file> <pcap file>
+ *     ./pcapscan [-n repeats] [-T threads] <pattern file> <pcap file>
  *
  * We recommend the use of a utility like 'taskset' on multiprocessor hosts to
- * pin execution to a single processor: this will remove processor migration
- * by the scheduler as a source of noise in the results.
+ * pin execution to a single processor (or, with -T, to a fixed set of
+ * processors): this will remove processor migration by the scheduler as a
+ * source of noise in the results.
  *
  */
 
+#include <atomic>
 #include <cstring>
 #include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -80,6 +91,7 @@ using std::cout;
 using std::endl;
 using std::ifstream;
 using std::string;
+using std::unique_ptr;
 using std::unordered_map;
 using std::vector;
 
@@ -154,6 +166,56 @@ private:
     std::chrono::time_point<std::chrono::system_clock> time_start, time_end;
 };
 
+// Single-producer, single-consumer ring of packet indices, used to hand packets
+// from the reader thread to one worker without locking. The head and tail
+// counters only ever increase; the producer owns the tail and the consumer
+// owns the head.
+class SpscQueue {
+public:
+    static const size_t END = ~(size_t)0; // marks the end of the input
+
+    SpscQueue() : head(0), tail(0), slots(CAPACITY) {}
+
+    bool push(size_t v) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == CAPACITY) {
+            return false; // full
+        }
+        slots[t % CAPACITY] = v;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(size_t *v) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false; // empty
+        }
+        *v = slots[h % CAPACITY];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static const size_t CAPACITY = 4096;
+
+    // Keep the two counters on separate cache lines so that the reader and
+    // the worker do not contend for the same line on every operation.
+    std::atomic<size_t> head;
+    char pad[64];
+    std::atomic<size_t> tail;
+    vector<size_t> slots;
+};
+
+// Per-worker results from a threaded streaming scan.
+struct WorkerStats {
+    size_t packets = 0;
+    size_t bytes = 0;
+    size_t matches = 0;
+    size_t streams = 0;
+    double scanSeconds = 0.0; // time spent inside Hyperscan calls
+};
+
 // Class wrapping all state associated with the benchmark
 class Benchmark {
 private:
@@ -166,6 +228,9 @@ private:
     // Map used to construct stream_ids
     unordered_map<FiveTuple, size_t, FiveTupleHash> stream_map;
 
+    // Hash of the 5-tuple of each stream, used to assign it to a worker
+    vector<size_t> stream_hashes;
+
     // Hyperscan compiled database (streaming mode)
     const hs_database_t *db_streaming;
 
@@ -230,8 +295,13 @@ public:
                     + sizeof(struct ether_header));
             const char *payload = (const char *)pktData + offset;
 
-            size_t id = stream_map.insert(std::make_pair(FiveTuple(iphdr),
-                                          stream_map.size())).first->second;
+            FiveTuple tuple(iphdr);
+            auto ins = stream_map.insert(std::make_pair(tuple,
+                                                        stream_map.size()));
+            size_t id = ins.first->second;
+            if (ins.second) {
+                stream_hashes.push_back(FiveTupleHash()(tuple));
+            }
 
             packets.push_back(string(payload, length));
             stream_ids.push_back(id);
@@ -314,6 +384,57 @@ public:
         }
     }
 
+    // Scan all packets in streaming mode on numThreads worker threads, fed by
+    // the calling thread. Streams stay open across repeats and are closed
+    // once the input is exhausted. Returns the wall clock time taken.
+    double scanStreamsThreaded(unsigned int numThreads,
+                               unsigned int repeatCount,
+                               vector<WorkerStats> &stats) {
+        // Pick a worker for each stream from its 5-tuple hash, mixed so that
+        // the low bits of the simple XOR hash do not all land on one thread.
+        vector<unsigned int> shard(stream_hashes.size());
+        for (size_t i = 0; i != shard.size(); ++i) {
+            unsigned long long h = stream_hashes[i] * 0x9e3779b97f4a7c15ULL;
+            shard[i] = (h >> 32) % numThreads;
+        }
+
+        vector<unique_ptr<SpscQueue>> queues;
+        for (unsigned int i = 0; i < numThreads; i++) {
+            queues.emplace_back(new SpscQueue());
+        }
+        stats.assign(numThreads, WorkerStats());
+
+        Clock clock;
+        clock.start();
+
+        vector<std::thread> workers;
+        for (unsigned int i = 0; i < numThreads; i++) {
+            workers.emplace_back(&Benchmark::worker, this,
+                                 std::ref(*queues[i]), std::ref(stats[i]));
+        }
+
+        // Reader: dispatch packets to workers by flow.
+        for (unsigned int r = 0; r < repeatCount; r++) {
+            for (size_t i = 0; i != packets.size(); ++i) {
+                SpscQueue &q = *queues[shard[stream_ids[i]]];
+                while (!q.push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        for (auto &q : queues) {
+            while (!q->push(SpscQueue::END)) {
+                std::this_thread::yield();
+            }
+        }
+
+        for (auto &t : workers) {
+            t.join();
+        }
+        clock.stop();
+        return clock.seconds();
+    }
+
     // Display some information about the compiled database and scanned data.
     void displayStats() {
         size_t numPackets = packets.size();
@@ -358,6 +479,67 @@ public:
             cout << "Error getting stream state size" << endl;
         }
     }
+
+private:
+    // Worker thread body: scan the packets handed over by the reader, each
+    // in the stream for its flow, until the end marker arrives.
+    void worker(SpscQueue &queue, WorkerStats &st) {
+        hs_scratch_t *workerScratch = nullptr;
+        if (hs_clone_scratch(scratch, &workerScratch) != HS_SUCCESS) {
+            cerr << "ERROR: could not clone scratch space. Exiting." << endl;
+            exit(-1);
+        }
+
+        // This worker's flow table, keyed by stream ID.
+        unordered_map<size_t, hs_stream_t *> flows;
+        std::chrono::steady_clock::duration scanTime(0);
+
+        size_t i;
+        for (;;) {
+            if (!queue.pop(&i)) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (i == SpscQueue::END) {
+                break;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            hs_stream_t *&stream = flows[stream_ids[i]];
+            if (!stream && hs_open_stream(db_streaming, 0, &stream)
+                               != HS_SUCCESS) {
+                cerr << "ERROR: Unable to open stream. Exiting." << endl;
+                exit(-1);
+            }
+            const string &pkt = packets[i];
+            hs_error_t err = hs_scan_stream(stream, pkt.c_str(), pkt.length(),
+                                            0, workerScratch, onMatch,
+                                            &st.matches);
+            if (err != HS_SUCCESS) {
+                cerr << "ERROR: Unable to scan packet. Exiting." << endl;
+                exit(-1);
+            }
+            scanTime += std::chrono::steady_clock::now() - start;
+            st.packets++;
+            st.bytes += pkt.length();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (auto &flow : flows) {
+            hs_error_t err = hs_close_stream(flow.second, workerScratch,
+                                             onMatch, &st.matches);
+            if (err != HS_SUCCESS) {
+                cerr << "ERROR: Unable to close stream. Exiting." << endl;
+                exit(-1);
+            }
+        }
+        scanTime += std::chrono::steady_clock::now() - start;
+
+        st.streams = flows.size();
+        st.scanSeconds =
+            std::chrono::duration<double>(scanTime).count();
+        hs_free_scratch(workerScratch);
+    }
 };
 
 // helper function - see end of file
@@ -438,20 +620,75 @@ static void databasesFromFile(const char *filename,
 }
 
 static void usage(const char *prog) {
-    cerr << "Usage: " << prog << " [-n repeats] <pattern file> <pcap file>" << endl;
+    cerr << "Usage: " << prog
+         << " [-n repeats] [-T threads] <pattern file> <pcap file>" << endl;
+}
+
+// Run the multi-threaded streaming benchmark and report per-worker and
+// aggregate results.
+static void runThreaded(Benchmark &bench, const hs_database_t *db_streaming,
+                        unsigned int numThreads, unsigned int repeatCount) {
+    vector<WorkerStats> stats;
+    double secs = bench.scanStreamsThreaded(numThreads, repeatCount, stats);
+
+    size_t streamSize = 0;
+    if (hs_stream_size(db_streaming, &streamSize) != HS_SUCCESS) {
+        cerr << "ERROR: Unable to get stream size. Exiting." << endl;
+        exit(-1);
+    }
+
+    cout << endl << "Streaming mode, " << numThreads << " worker threads:"
+         << endl << endl;
+
+    WorkerStats total;
+    for (unsigned int i = 0; i < numThreads; i++) {
+        const WorkerStats &st = stats[i];
+        double tput = st.scanSeconds > 0 ? st.bytes * 8 / st.scanSeconds : 0;
+        cout << std::fixed << std::setprecision(2);
+        cout << "  Worker " << std::setw(2) << i << ": " << std::setw(9)
+             << st.packets << " packets, " << std::setw(6) << st.streams
+             << " streams, " << std::setw(8) << st.matches << " matches, "
+             << tput / 1000000000 << " gigabits/sec (scan time only)"
+             << endl;
+        total.packets += st.packets;
+        total.bytes += st.bytes;
+        total.matches += st.matches;
+        total.streams += st.streams;
+    }
+
+    cout << endl;
+    cout << "  Total matches: " << total.matches << endl;
+    cout << std::fixed << std::setprecision(4);
+    cout << "  Match rate:    " << total.matches / (total.bytes / 1024.0)
+         << " matches/kilobyte" << endl;
+    cout << "  Stream state:  " << total.streams * streamSize << " bytes ("
+         << total.streams << " streams of " << streamSize << " bytes)"
+         << endl;
+    cout << std::fixed << std::setprecision(2);
+    cout << "  Aggregate throughput (wall clock): "
+         << total.bytes * 8 / secs / 1000000000 << " gigabits/sec" << endl;
+    cout << endl;
 }
 
 // Main entry point.
 int main(int argc, char **argv) {
     unsigned int repeatCount = 1;
+    unsigned int numThreads = 0;
 
     // Process command line arguments.
     int opt;
-    while ((opt = getopt(argc, argv, "n:")) != -1) {
+    while ((opt = getopt(argc, argv, "n:T:")) != -1) {
         switch (opt) {
         case 'n':
             repeatCount = atoi(optarg);
             break;
+        case 'T':
+            numThreads = atoi(optarg);
+            if (numThreads == 0) {
+                usage(argv[0]);
+                exit(-1);
+            }
+            break;
         default:
             usage(argv[0]);
             exit(-1);
@@ -485,6 +722,13 @@ int main(int argc, char **argv) {
 
     bench.displayStats();
 
+    if (numThreads) {
+        runThreaded(bench, db_streaming, numThreads, repeatCount);
+        hs_free_database(db_streaming);
+        hs_free_database(db_block);
+        return 0;
+    }
+
     Clock clock;
 
     // Streaming mode scans.
@@ -296,7 +296,13 @@ static
 aligned_unique_ptr<RoseEngine> generateRoseEngine(NG &ng) {
     const u32 minWidth =
         ng.minWidth.is_finite() ? verify_u32(ng.minWidth) : ROSE_BOUND_INF;
-    auto rose = ng.rose->buildRose(minWidth);
+    const u32 maxWidth =
+        ng.maxWidth.is_finite() ? verify_u32(ng.maxWidth) : ROSE_BOUND_INF;
+    // The runtime scans a couple of bytes past the last match offset, so
+    // treat offsets within that distance of MAX_OFFSET as unbounded.
+    const u64a maxOffset =
+        ng.maxOffset < MAX_OFFSET - 2 ? ng.maxOffset : MAX_OFFSET;
+    auto rose = ng.rose->buildRose(minWidth, maxWidth, maxOffset);
 
     if (!rose) {
         DEBUG_PRINTF("error building rose\n");
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Database layout introspection: public API.
+ */
+#include "allocator.h"
+#include "database.h"
+#include "hs_layout.h"
+#include "hs_runtime.h"
+#include "ue2common.h"
+#include "fdr/fdr_compile_internal.h"
+#include "fdr/fdr_engine_description.h"
+#include "fdr/fdr_internal.h"
+#include "hwlm/hwlm_build.h"
+#include "hwlm/hwlm_internal.h"
+#include "nfa/accelcompile.h"
+#include "nfa/nfa_build_util.h"
+#include "nfa/nfa_internal.h"
+#include "rose/rose_internal.h"
+#include "smallwrite/smallwrite_internal.h"
+#include "util/verify_types.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace ue2;
+
+static
+const char *hwlmTypeName(const HWLM *h) {
+    switch (h->type) {
+    case HWLM_ENGINE_NOOD:
+        return "noodle";
+    case HWLM_ENGINE_FDR: {
+        /* teddy engines don't have an fdr engine description */
+        const FDR *fdr = (const FDR *)HWLM_C_DATA(h);
+        return getFdrDescription(fdr->engineID) ? "fdr" : "teddy";
+    }
+    default:
+        return "unknown";
+    }
+}
+
+static
+void addMatcher(vector<hs_matcher_layout_t> &matchers, unsigned int table,
+                const void *matcher) {
+    if (!matcher) {
+        return;
+    }
+
+    const HWLM *h = (const HWLM *)matcher;
+    hs_matcher_layout_t m;
+    memset(&m, 0, sizeof(m));
+    m.table = table;
+    m.type = hwlmTypeName(h);
+    m.accel = accelName(h->accel0.accel_type);
+    m.literal_count = h->literalCount;
+    m.size = hwlmSize(h);
+    matchers.push_back(m);
+}
+
+static
+void addEngine(vector<hs_engine_layout_t> &engines, unsigned int role,
+               const NFA *nfa) {
+    hs_engine_layout_t e;
+    memset(&e, 0, sizeof(e));
+    e.role = role;
+    e.type = nfa_type_name((NFAEngineType)nfa->type);
+    e.accelerated = has_accel(*nfa) ? 1 : 0;
+    e.reverse_accel = accelName(nfa->rAccelType);
+    e.stream_state_size = nfa->streamStateSize;
+    e.scratch_state_size = nfa->scratchStateSize;
+    e.size = nfa->length;
+    engines.push_back(e);
+}
+
+static
+unsigned int queueRole(const RoseEngine *t, u32 qi) {
+    if (qi < t->outfixBeginQueue) {
+        return HS_ENGINE_ROLE_CHAINED;
+    }
+    if (qi < t->outfixEndQueue) {
+        return HS_ENGINE_ROLE_OUTFIX;
+    }
+    if (qi < t->leftfixBeginQueue) {
+        return HS_ENGINE_ROLE_SUFFIX;
+    }
+    return getLeftInfoByQueue(t, qi)->infix ? HS_ENGINE_ROLE_INFIX
+                                            : HS_ENGINE_ROLE_PREFIX;
+}
+
+static
+void addEngines(vector<hs_engine_layout_t> &engines, const RoseEngine *t) {
+    for (u32 qi = 0; qi < t->queueCount; qi++) {
+        addEngine(engines, queueRole(t, qi), getNfaByQueue(t, qi));
+    }
+
+    const anchored_matcher_info *curr = getALiteralMatcher(t);
+    while (curr) {
+        const NFA *n = (const NFA *)((const char *)curr + sizeof(*curr));
+        addEngine(engines, HS_ENGINE_ROLE_ANCHORED, n);
+        curr = curr->next_offset ? (const anchored_matcher_info *)
+            ((const char *)curr + curr->next_offset) : nullptr;
+    }
+
+    const SmallWriteEngine *smwr = getSmallWrite(t);
+    if (smwr) {
+        for (u32 i = 0; i < smwr->nfaCount; i++) {
+            addEngine(engines, HS_ENGINE_ROLE_SMALL_WRITE, getSmwrNfa(smwr, i));
+        }
+    }
+}
+
+static
+hs_error_t scratchSize(const hs_database_t *db, size_t *size) {
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t ret = hs_alloc_scratch(db, &scratch);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    ret = hs_scratch_size(scratch, size);
+    hs_free_scratch(scratch);
+    return ret;
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_database_layout(const hs_database_t *db,
+                              hs_database_layout_t **layout) {
+    if (!layout) {
+        return HS_INVALID;
+    }
+    *layout = nullptr;
+
+    hs_error_t ret = validDatabase(db);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    const RoseEngine *t = (const RoseEngine *)hs_get_bytecode(db);
+    if (!ISALIGNED_16(t)) {
+        return HS_INVALID;
+    }
+
+    size_t database_size = 0;
+    ret = hs_database_size(db, &database_size);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    size_t stream_size = 0;
+    if (t->mode == HS_MODE_STREAM) {
+        ret = hs_stream_size(db, &stream_size);
+        if (ret != HS_SUCCESS) {
+            return ret;
+        }
+    }
+
+    size_t scratch_size = 0;
+    ret = scratchSize(db, &scratch_size);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    vector<hs_matcher_layout_t> matchers;
+    vector<hs_engine_layout_t> engines;
+    try {
+        addMatcher(matchers, HS_MATCHER_FLOATING, getFLiteralMatcher(t));
+        addMatcher(matchers, HS_MATCHER_EOD_ANCHORED, getELiteralMatcher(t));
+        addMatcher(matchers, HS_MATCHER_SMALL_BLOCK, getSBLiteralMatcher(t));
+        addEngines(engines, t);
+    } catch (const std::bad_alloc &) {
+        return HS_NOMEM;
+    }
+
+    // The layout, its matchers and its engines share a single allocation.
+    size_t matchers_offset = ROUNDUP_N(sizeof(hs_database_layout_t),
+                                       alignof(hs_matcher_layout_t));
+    size_t engines_offset =
+        ROUNDUP_N(matchers_offset + matchers.size() * sizeof(matchers[0]),
+                  alignof(hs_engine_layout_t));
+    size_t len = engines_offset + engines.size() * sizeof(engines[0]);
+
+    char *mem = (char *)hs_misc_alloc(len);
+    ret = hs_check_alloc(mem);
+    if (ret != HS_SUCCESS) {
+        hs_misc_free(mem);
+        return ret;
+    }
+    memset(mem, 0, len);
+
+    hs_database_layout_t *rv = (hs_database_layout_t *)mem;
+    rv->database_size = database_size;
+    rv->stream_size = stream_size;
+    rv->scratch_size = scratch_size;
+    const SmallWriteEngine *smwr = getSmallWrite(t);
+    if (smwr) {
+        rv->small_write_size = smwr->size;
+    }
+
+    rv->matcher_count = verify_u32(matchers.size());
+    rv->matchers = (hs_matcher_layout_t *)(mem + matchers_offset);
+    if (!matchers.empty()) {
+        memcpy(rv->matchers, &matchers[0],
+               matchers.size() * sizeof(matchers[0]));
+    }
+
+    rv->engine_count = verify_u32(engines.size());
+    rv->engines = (hs_engine_layout_t *)(mem + engines_offset);
+    if (!engines.empty()) {
+        memcpy(rv->engines, &engines[0], engines.size() * sizeof(engines[0]));
+    }
+
+    *layout = rv;
+    return HS_SUCCESS;
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_free_database_layout(hs_database_layout_t *layout) {
+    hs_misc_free(layout);
+    return HS_SUCCESS;
+}
@@ -430,7 +430,7 @@ bool getMultiEntriesAtPosition(const FDREngineDescription &eng,
                     maskByte &= cmask;
                     dontCareByte |= ~cmask;
                 }
-                if (lit.nocase && ourisalpha(c)) {
+                if (lit.isNocaseChar(sz - newPos - 1) && ourisalpha(c)) {
                     maskByte &= 0xdf;
                     dontCareByte |= 0x20;
                 }
@@ -517,7 +517,7 @@ fdrBuildTableInternal(const vector<hwlmLiteral> &lits, bool make_small,
                       hwlmStreamingControl *stream_control) {
     pair<u8 *, size_t> link(nullptr, 0);
     if (stream_control) {
-        link = fdrBuildTableStreaming(lits, stream_control);
+        link = fdrBuildTableStreaming(lits, grey, stream_control);
     }
 
     DEBUG_PRINTF("cpu has %s\n", target.has_avx2() ? "avx2" : "no-avx2");
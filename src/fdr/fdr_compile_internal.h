@@ -54,6 +54,7 @@ typedef u32 PositionInBucket;  // zero is 'we are matching right now!",
 
 class EngineDescription;
 class FDREngineDescription;
+struct Grey;
 struct hwlmStreamingControl;
 
 size_t getFDRConfirm(const std::vector<hwlmLiteral> &lits, FDRConfirm **fdrc_p,
@@ -74,7 +75,7 @@ setupFDRFloodControl(const std::vector<hwlmLiteral> &lits,
 
 std::pair<u8 *, size_t>
 fdrBuildTableStreaming(const std::vector<hwlmLiteral> &lits,
-                       hwlmStreamingControl *stream_control);
+                       const Grey &grey, hwlmStreamingControl *stream_control);
 
 static constexpr u32 HINT_INVALID = 0xffffffff;
 
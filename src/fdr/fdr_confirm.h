@@ -46,14 +46,17 @@ typedef enum LitInfoFlags {
     NoFlags = 0,
     Caseless = 1,
     NoRepeat = 2,
-    ComplexConfirm = 4
+    ComplexConfirm = 4,
+    MixedCase = 8
 } LitInfoFlags;
 
 /**
  * \brief Structure describing a literal, linked to by FDRConfirm.
  *
  * This structure is followed in memory by a variable-sized string prefix at
- * LitInfo::s, for strings that are longer than CONF_TYPE.
+ * LitInfo::s, for strings that are longer than CONF_TYPE. For a MixedCase
+ * literal, the prefix is followed by a byte mask of the same length, which is
+ * applied to the input before it is compared with the prefix.
  */
 struct LitInfo {
     CONF_TYPE v;
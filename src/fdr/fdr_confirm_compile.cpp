@@ -50,14 +50,19 @@ typedef u8 ConfSplitType;
 typedef pair<BucketIndex, ConfSplitType> BucketSplitPair;
 typedef map<BucketSplitPair, pair<FDRConfirm *, size_t> > BC2CONF;
 
-// return the number of bytes beyond a length threshold in all strings in lits
+// return the number of bytes beyond a length threshold in all strings in lits,
+// including the case mask that follows the prefix of a mixed-case literal
 static
 size_t thresholdedSize(const vector<hwlmLiteral> &lits, size_t threshold) {
     size_t tot = 0;
     for (const auto &lit : lits) {
         size_t sz = lit.s.size();
         if (sz > threshold) {
-            tot += ROUNDUP_N(sz - threshold, 8);
+            size_t prefix_len = sz - threshold;
+            if (lit.isMixedCase()) {
+                prefix_len *= 2;
+            }
+            tot += ROUNDUP_N(prefix_len, 8);
         }
     }
     return tot;
@@ -96,7 +101,9 @@ void fillLitInfo(const vector<hwlmLiteral> &lits, vector<LitInfo> &tmpLitInfo,
         memset(&info, 0, sizeof(info));
         info.id = lit.id;
         u8 flags = NoFlags;
-        if (lit.nocase) {
+        if (lit.isMixedCase()) {
+            flags |= MixedCase;
+        } else if (lit.nocase) {
             flags |= Caseless;
         }
         if (lit.noruns) {
@@ -119,7 +126,7 @@ void fillLitInfo(const vector<hwlmLiteral> &lits, vector<LitInfo> &tmpLitInfo,
                 msk &= ~((CONF_TYPE)0xff << shiftLoc);
             } else {
                 u8 c = lit.s[lit.s.size() - j - 1];
-                if (lit.nocase && ourisalpha(c)) {
+                if (lit.isNocaseChar(lit.s.size() - j - 1) && ourisalpha(c)) {
                     msk &= ~((CONF_TYPE)CASE_BIT << shiftLoc);
                     val |= (CONF_TYPE)(c & CASE_CLEAR) << shiftLoc;
                 } else {
@@ -195,7 +202,8 @@ size_t getFDRConfirm(const vector<hwlmLiteral> &lits, FDRConfirm **fdrc_p,
         for (u32 i = 0; i < lits[0].s.size(); i++) {
             u32 shiftLoc = (sizeof(u32) - i - 1) * 8;
             u8 c = lits[0].s[lits[0].s.size() - i - 1];
-            if (lits[0].nocase && ourisalpha(c)) {
+            if (lits[0].isNocaseChar(lits[0].s.size() - i - 1) &&
+                ourisalpha(c)) {
                 soleLitCmp |= (u32)(c & CASE_CLEAR) << shiftLoc;
                 soleLitMsk |= (u32)CASE_CLEAR << shiftLoc;
             }
@@ -326,11 +334,24 @@ size_t getFDRConfirm(const vector<hwlmLiteral> &lits, FDRConfirm **fdrc_p,
 
             // Write literal prefix (everything before the last N characters,
             // as the last N are already confirmed).
-            const string &t = lits[litIdx].s;
+            const hwlmLiteral &lit = lits[litIdx];
+            const string &t = lit.s;
             if (t.size() > sizeof(CONF_TYPE)) {
                 size_t prefix_len = t.size() - sizeof(CONF_TYPE);
                 memcpy(&finalLI.s[0], t.c_str(), prefix_len);
                 ptr = &finalLI.s[0] + prefix_len;
+
+                // A mixed-case literal's prefix is followed by a byte mask
+                // applied to the input before comparison; its caseless
+                // characters are stored upper-cased to match.
+                if (lit.isMixedCase()) {
+                    for (size_t j = 0; j < prefix_len; j++) {
+                        bool nc = lit.isNocaseChar(j) && ourisalpha(t[j]);
+                        finalLI.s[j] = nc ? mytoupper(t[j]) : t[j];
+                        ptr[j] = nc ? CASE_CLEAR : 0xff;
+                    }
+                    ptr += prefix_len;
+                }
             }
 
             ptr = ROUNDUP_PTR(ptr, alignof(LitInfo));
@@ -386,6 +407,7 @@ u32 setupMultiConfirms(const vector<hwlmLiteral> &lits,
                 hwlmLiteral lit = lits[*i]; // copy
                 // c is last char of this literal
                 u8 c = *(lit.s.rbegin());
+                bool c_nocase = lit.isNocaseChar(lit.s.size() - 1);
 
                 bool suppressSplit = false;
                 if (pullBack) {
@@ -393,6 +415,9 @@ u32 setupMultiConfirms(const vector<hwlmLiteral> &lits,
                     // getFDRConfirm doesn't know about that stuff
                     assert(lit.s.size() >= pullBack);
                     lit.s.resize(lit.s.size() - pullBack);
+                    if (lit.isMixedCase()) {
+                        lit.nocase_chars.resize(lit.s.size());
+                    }
 
                     u8 c_sub, c_sub_msk;
                     if (lit.msk.empty()) {
@@ -407,15 +432,15 @@ u32 setupMultiConfirms(const vector<hwlmLiteral> &lits,
                         lit.cmp.resize(len);
                     }
 
-                    // if c_sub_msk is 0xff and lit.nocase
+                    // if c_sub_msk is 0xff and c is caseless
                     // resteer 'c' to an exact value and set suppressSplit
-                    if ((c_sub_msk == 0xff) && (lit.nocase)) {
+                    if ((c_sub_msk == 0xff) && c_nocase) {
                         suppressSplit = true;
                         c = c_sub;
                     }
                 }
 
-                if (!suppressSplit && splitHasCase && lit.nocase &&
+                if (!suppressSplit && splitHasCase && c_nocase &&
                     ourisalpha(c)) {
                     vl[(u8)(mytoupper(c) & splitMask)].push_back(lit);
                     vl[(u8)(mytolower(c) & splitMask)].push_back(lit);
@@ -39,6 +39,18 @@
 #define CONF_LOADVAL_CALL lv_u64a
 #define CONF_LOADVAL_CALL_CAUTIOUS lv_u64a_ce
 
+// compare len bytes at p against the literal prefix of l from offset off;
+// mixed-case literals carry a mask for the input after their prefix
+static really_inline
+int cmpLitPrefix(const u8 *p, const struct LitInfo *l, size_t off, size_t len,
+                 u8 caseless) {
+    if (unlikely(l->flags & MixedCase)) {
+        const u8 *msk = l->s + l->size - sizeof(CONF_TYPE);
+        return cmpForwardMasked(p, l->s + off, msk + off, len);
+    }
+    return cmpForward(p, l->s + off, len, caseless);
+}
+
 // this is ordinary confirmation function which runs through
 // the whole confirmation procedure
 static really_inline
@@ -106,8 +118,6 @@ void confWithBit(const struct FDRConfirm * fdrc,
                 // as for the regular case, no need to do a full confirm if
                 // we're a short literal
                 if (unlikely(l->size > sizeof(CONF_TYPE))) {
-                    const u8 * s1 = l->s;
-                    const u8 * s2 = s1 + full_overhang;
                     const u8 * loc1 = history + len_history - full_overhang;
                     const u8 * loc2 = buf;
                     size_t size1 = MIN(full_overhang,
@@ -117,10 +127,11 @@ void confWithBit(const struct FDRConfirm * fdrc,
                     size_t size2 = wind_size2_back > l->size ?
                                    0 : l->size - wind_size2_back;
 
-                    if (cmpForward(loc1, s1, size1, caseless)) {
+                    if (cmpLitPrefix(loc1, l, 0, size1, caseless)) {
                         goto out;
                     }
-                    if (cmpForward(loc2, s2, size2, caseless)) {
+                    if (cmpLitPrefix(loc2, l, full_overhang, size2,
+                                     caseless)) {
                         goto out;
                     }
                 }
@@ -128,7 +139,8 @@ void confWithBit(const struct FDRConfirm * fdrc,
 
                 // if string < conf_type we don't need regular string cmp
                 if (unlikely(l->size > sizeof(CONF_TYPE))) {
-                    if (cmpForward(loc, l->s, l->size - sizeof(CONF_TYPE), caseless)) {
+                    if (cmpLitPrefix(loc, l, 0, l->size - sizeof(CONF_TYPE),
+                                     caseless)) {
                         goto out;
                     }
                 }
@@ -30,6 +30,7 @@
 #include "fdr_internal.h"
 #include "fdr_streaming_internal.h"
 #include "fdr_compile_internal.h"
+#include "grey.h"
 #include "hwlm/hwlm_build.h"
 #include "util/alloc.h"
 #include "util/bitutils.h"
@@ -98,6 +99,8 @@ bool setupLongLits(const vector<hwlmLiteral> &lits,
     for (vector<hwlmLiteral>::const_iterator it = lits.begin();
          it != lits.end(); ++it) {
         if (it->s.length() > max_len) {
+            // The long literal table has only caseful and caseless modes.
+            assert(!it->isMixedCase());
             hwlmLiteral tmp = *it; // copy
             tmp.s.erase(tmp.s.size() - 1, 1); // erase last char
             tmp.id = 0; // recalc later
@@ -307,16 +310,34 @@ size_t maxMaskLen(const vector<hwlmLiteral> &lits) {
     return rv;
 }
 
+/**
+ * \brief Returns the length of the longest mixed-case literal, or zero if
+ * there are none.
+ */
+static
+size_t maxMixedCaseLen(const vector<hwlmLiteral> &lits) {
+    size_t rv = 0;
+    for (const auto &lit : lits) {
+        if (lit.isMixedCase()) {
+            rv = max(rv, lit.s.length());
+        }
+    }
+    return rv;
+}
+
 pair<u8 *, size_t>
-fdrBuildTableStreaming(const vector<hwlmLiteral> &lits,
+fdrBuildTableStreaming(const vector<hwlmLiteral> &lits, const Grey &grey,
                        hwlmStreamingControl *stream_control) {
     // refuse to compile if we are forced to have smaller than minimum
     // history required for long-literal support, full stop
     // otherwise, choose the maximum of the preferred history quantity
-    // (currently a fairly extravagant 32) or the already used history
-    // quantity - subject to the limitation of stream_control->history_max
+    // (grey.fdrLongLitHashLen) or the already used history quantity - subject
+    // to the limitation of stream_control->history_max. Literals longer than
+    // this are tracked across stream writes in our stream state, so it bounds
+    // the history they need.
 
-    const size_t MIN_HISTORY_REQUIRED = 32;
+    const size_t MIN_HISTORY_REQUIRED =
+        MAX((size_t)STREAMING_HASH_MIN_LEN, (size_t)grey.fdrLongLitHashLen);
 
     if (MIN_HISTORY_REQUIRED > stream_control->history_max) {
         throw std::logic_error("Cannot set history to minimum history required");
@@ -326,6 +347,19 @@ fdrBuildTableStreaming(const vector<hwlmLiteral> &lits,
         MIN(stream_control->history_max,
             MAX(MIN_HISTORY_REQUIRED, stream_control->history_min));
     assert(max_len >= MIN_HISTORY_REQUIRED);
+
+    // The long literal table only has caseful and caseless modes, so
+    // mixed-case literals must never be long: keep enough history to confirm
+    // them in full instead.
+    size_t max_mixed_len = maxMixedCaseLen(lits);
+    if (max_mixed_len > max_len) {
+        if (max_mixed_len > stream_control->history_max) {
+            throw std::logic_error("Cannot set history to cover mixed-case "
+                                   "literals");
+        }
+        max_len = max_mixed_len;
+    }
+
     size_t max_mask_len = maxMaskLen(lits);
 
     vector<hwlmLiteral> long_lits;
@@ -126,27 +126,42 @@ u32 has_bit(const struct FDRSHashEntry * ent, u32 bit) {
     return (ent->bitfield >> bit) & 0x1;
 }
 
+// shortest window that streaming_hash can be computed over
+#define STREAMING_HASH_MIN_LEN 8
+
+// hashes up to the first three 8-byte blocks of the window at ptr
 static really_inline
-u32 streaming_hash(const u8 *ptr, UNUSED size_t len, MODES mode) {
+u32 streaming_hash(const u8 *ptr, size_t len, MODES mode) {
     const u64a CASEMASK = 0xdfdfdfdfdfdfdfdfULL;
     const u64a MULTIPLIER = 0x0b4e0ef37bc32127ULL;
-    assert(len >= 32);
+    assert(len >= STREAMING_HASH_MIN_LEN);
 
     u64a v1 = unaligned_load_u64a(ptr);
-    u64a v2 = unaligned_load_u64a(ptr + 8);
-    u64a v3 = unaligned_load_u64a(ptr + 16);
     if (mode == CASELESS) {
         v1 &= CASEMASK;
-        v2 &= CASEMASK;
-        v3 &= CASEMASK;
     }
     v1 *= MULTIPLIER;
-    v2 *= (MULTIPLIER*MULTIPLIER);
-    v3 *= (MULTIPLIER*MULTIPLIER*MULTIPLIER);
-    v1 >>= 32;
-    v2 >>= 32;
-    v3 >>= 32;
-    return v1 ^ v2 ^ v3;
+    u32 rv = v1 >> 32;
+
+    if (len >= 16) {
+        u64a v2 = unaligned_load_u64a(ptr + 8);
+        if (mode == CASELESS) {
+            v2 &= CASEMASK;
+        }
+        v2 *= (MULTIPLIER*MULTIPLIER);
+        rv ^= v2 >> 32;
+    }
+
+    if (len >= 24) {
+        u64a v3 = unaligned_load_u64a(ptr + 16);
+        if (mode == CASELESS) {
+            v3 &= CASEMASK;
+        }
+        v3 *= (MULTIPLIER*MULTIPLIER*MULTIPLIER);
+        rv ^= v3 >> 32;
+    }
+
+    return rv;
 }
 
 #endif
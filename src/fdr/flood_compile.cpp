@@ -105,11 +105,12 @@ pair<u8 *, size_t> setupFDRFloodControl(const vector<hwlmLiteral> &lits,
 
     for (const auto &lit : lits) {
         DEBUG_PRINTF("lit: '%s'%s\n", escapeString(lit.s).c_str(),
-                     lit.nocase ? " (nocase)" : "");
+                     lit.isMixedCase() ? " (mixed)"
+                                       : lit.nocase ? " (nocase)" : "");
         u32 litSize = verify_u32(lit.s.size());
         u32 maskSize = (u32)lit.msk.size();
         u8 c = lit.s[litSize - 1];
-        bool nocase = ourisalpha(c) ? lit.nocase : false;
+        bool nocase = ourisalpha(c) ? lit.isNocaseChar(litSize - 1) : false;
 
         if (nocase && maskSize && (lit.msk[maskSize - 1] & CASE_BIT)) {
             c = (lit.cmp[maskSize - 1] & CASE_BIT) ? mytolower(c) : mytoupper(c);
@@ -124,13 +125,28 @@ pair<u8 *, size_t> setupFDRFloodControl(const vector<hwlmLiteral> &lits,
 
         for (u32 i = 0; i < iEnd; i++) {
             if (i < litSize) {
-                if (isDifferent(c, lit.s[litSize - i - 1], lit.nocase)) {
+                u8 lc = lit.s[litSize - i - 1];
+                bool lc_nocase = lit.isNocaseChar(litSize - i - 1);
+                if (isDifferent(c, lc, nocase || lc_nocase)) {
                     DEBUG_PRINTF("non-flood char in literal[%u] %c != %c\n",
-                                                i, c, lit.s[litSize - i - 1]);
+                                                i, c, lc);
                     upSuffix = MIN(upSuffix, i);
                     loSuffix = MIN(loSuffix, i); // makes sense only for case-less
                     break;
                 }
+                if (nocase && !lc_nocase && ourisalpha(lc)) {
+                    // a case-sensitive char in a mixed-case literal only
+                    // matches one case of a caseless flood
+                    if (lc != (u8)mytoupper(c)) {
+                        upSuffix = MIN(upSuffix, i);
+                    }
+                    if (lc != (u8)mytolower(c)) {
+                        loSuffix = MIN(loSuffix, i);
+                    }
+                    if (loSuffix != iEnd && upSuffix != iEnd) {
+                        break;
+                    }
+                }
             }
             if (i < maskSize) {
                 u8 m = lit.msk[maskSize - i - 1];
@@ -79,11 +79,11 @@ m128 vectoredLoad128(m128 *p_mask, const u8 *ptr, const u8 *lo, const u8 *hi,
     u.val128 = zeroes128();
 
     if (ptr >= lo) {
-        u32 avail = (u32)(hi - ptr);
-        if (avail >= 16) {
+        if ((size_t)(hi - ptr) >= 16) {
             *p_mask = load128((const void*)(p_mask_arr[16] + 16));
             return loadu128(ptr);
         }
+        u32 avail = (u32)(hi - ptr);
         *p_mask = load128((const void*)(p_mask_arr[avail] + 16));
         for (u32 i = 0; i < avail; i++) {
             u.val8[i] = ptr[i];
@@ -95,7 +95,7 @@ m128 vectoredLoad128(m128 *p_mask, const u8 *ptr, const u8 *lo, const u8 *hi,
         for (i = start - need; ptr + i < lo; i++) {
             u.val8[i] = buf_history[len_history - (lo - (ptr + i))];
         }
-        u32 end = MIN(16, (u32)(hi - ptr));
+        u32 end = (u32)MIN(16, (size_t)(hi - ptr));
         *p_mask = loadu128((const void*)(p_mask_arr[end - start] + 16 - start));
         for (; i < end; i++) {
             u.val8[i] = ptr[i];
@@ -197,11 +197,11 @@ m256 vectoredLoad256(m256 *p_mask, const u8 *ptr, const u8 *lo, const u8 *hi,
     } u;
 
     if (ptr >= lo) {
-        u32 avail = (u32)(hi - ptr);
-        if (avail >= 32) {
+        if ((size_t)(hi - ptr) >= 32) {
             *p_mask = load256((const void*)(p_mask_arr256[32] + 32));
             return loadu256(ptr);
         }
+        u32 avail = (u32)(hi - ptr);
         *p_mask = load256((const void*)(p_mask_arr256[avail] + 32));
         for (u32 i = 0; i < avail; i++) {
             u.val8[i] = ptr[i];
@@ -215,7 +215,7 @@ m256 vectoredLoad256(m256 *p_mask, const u8 *ptr, const u8 *lo, const u8 *hi,
         for (i = start; ptr + i < lo; i++) {
             u.val8[i] = buf_history[len_history - (lo - (ptr + i))];
         }
-        u32 end = MIN(32, (u32)(hi - ptr));
+        u32 end = (u32)MIN(32, (size_t)(hi - ptr));
         *p_mask = loadu256((const void*)(p_mask_arr256[end - start] + 32 - start));
         for (; i < end; i++) {
             u.val8[i] = ptr[i];
@@ -126,7 +126,8 @@ public:
                 u8 c_hi = (c >> 4) & 0xf;
                 u8 c_lo = c & 0xf;
                 nibbleSets[i*2] = 1 << c_lo;
-                if (lits[lit_id].nocase && ourisalpha(c)) {
+                if (lits[lit_id].isNocaseChar(s.size() - i - 1) &&
+                    ourisalpha(c)) {
                     nibbleSets[i*2+1] =  (1 << (c_hi&0xd)) | (1 << (c_hi|0x2));
                 } else {
                     nibbleSets[i*2+1] =  1 << c_hi;
@@ -290,7 +291,8 @@ aligned_unique_ptr<FDR> TeddyCompiler::build(pair<u8 *, size_t> link) {
 #ifdef TEDDY_DEBUG
     for (size_t i = 0; i < lits.size(); i++) {
         printf("lit %zu (len = %zu, %s) is ", i, lits[i].s.size(),
-               lits[i].nocase ? "caseless" : "caseful");
+               lits[i].isMixedCase() ? "mixed-case"
+                   : lits[i].nocase ? "caseless" : "caseful");
         for (size_t j = 0; j < lits[i].s.size(); j++) {
             printf("%02x", ((u32)lits[i].s[j])&0xff);
         }
@@ -405,7 +407,7 @@ aligned_unique_ptr<FDR> TeddyCompiler::build(pair<u8 *, size_t> link) {
                             }
                         }
                     } else{
-                        if (l.nocase && ourisalpha(c)) {
+                        if (l.isNocaseChar(sz - 1 - j) && ourisalpha(c)) {
                             u32 cmHalfClear = (0xdf >> hiShift) & 0xf;
                             u32 cmHalfSet   = (0x20 >> hiShift) & 0xf;
                             baseMsk[msk_id_hi * 16 + (n_hi & cmHalfClear)] |= bmsk;
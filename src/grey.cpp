@@ -56,13 +56,19 @@ Grey::Grey(void) :
                    allowLimExNFA(true),
                    allowSidecar(true),
                    allowAnchoredAcyclic(true),
+                   allowAnchoredLitTable(true),
                    allowSmallLiteralSet(true),
                    allowCastle(true),
+                   allowTamarama(true),
                    allowDecoratedLiteral(true),
                    allowNoodle(true),
                    fdrAllowTeddy(true),
+                   fdrLongLitHashLen(16),
                    puffImproveHead(true),
                    castleExclusive(true),
+                   castleUniform(true),
+                   mpvBatchMinPuffettes(16),
+                   tamaChunkSize(100),
                    mergeSEP(true), /* short exhaustible passthroughs */
                    mergeRose(true), // roses inside rose
                    mergeSuffixes(true), // suffix nfas inside rose
@@ -86,12 +92,14 @@ Grey::Grey(void) :
                    maxHistoryAvailable(DEFAULT_MAX_HISTORY),
                    minHistoryAvailable(0), /* debugging only */
                    maxAnchoredRegion(63), /* for rose's atable to run over */
+                   minAnchoredLitTable(64),
                    minRoseLiteralLength(3),
                    minRoseNetflowLiteralLength(2),
                    maxRoseNetflowEdges(50000), /* otherwise no netflow pass. */
                    minExtBoundedRepeatSize(32),
                    goughCopyPropagate(true),
                    goughRegisterAllocate(true),
+                   goughWideIns(true),
                    shortcutLiterals(true),
                    roseGraphReduction(true),
                    roseRoleAliasing(true),
@@ -116,6 +124,7 @@ Grey::Grey(void) :
                    somMaxRevNfaLength(126),
                    hamsterAccelForward(true),
                    hamsterAccelReverse(false),
+                   hamsterMixedCase(true),
                    miracleHistoryBonus(16),
                    equivalenceEnable(true),
 
@@ -126,6 +135,10 @@ Grey::Grey(void) :
                                                 // all blocks larger than this
                                                 // are given to rose &co
                    smallWriteLargestBufferBad(35),
+                   smallWriteLargestBufferAccel(256), // used when every dfa
+                                                      // can accelerate from
+                                                      // its start state
+                   smallWriteMaxDFAs(4),
                    limitSmallWriteOutfixSize(1048576), // 1 MB
                    dumpFlags(0),
                    limitPatternCount(8000000), // 8M patterns
@@ -209,13 +222,19 @@ void applyGreyOverrides(Grey *g, const string &s) {
         G_UPDATE(allowLimExNFA);
         G_UPDATE(allowSidecar);
         G_UPDATE(allowAnchoredAcyclic);
+        G_UPDATE(allowAnchoredLitTable);
         G_UPDATE(allowSmallLiteralSet);
         G_UPDATE(allowCastle);
+        G_UPDATE(allowTamarama);
         G_UPDATE(allowDecoratedLiteral);
         G_UPDATE(allowNoodle);
         G_UPDATE(fdrAllowTeddy);
+        G_UPDATE(fdrLongLitHashLen);
         G_UPDATE(puffImproveHead);
         G_UPDATE(castleExclusive);
+        G_UPDATE(castleUniform);
+        G_UPDATE(mpvBatchMinPuffettes);
+        G_UPDATE(tamaChunkSize);
         G_UPDATE(mergeSEP);
         G_UPDATE(mergeRose);
         G_UPDATE(mergeSuffixes);
@@ -239,12 +258,14 @@ void applyGreyOverrides(Grey *g, const string &s) {
         G_UPDATE(maxHistoryAvailable);
         G_UPDATE(minHistoryAvailable);
         G_UPDATE(maxAnchoredRegion);
+        G_UPDATE(minAnchoredLitTable);
         G_UPDATE(minRoseLiteralLength);
         G_UPDATE(minRoseNetflowLiteralLength);
         G_UPDATE(maxRoseNetflowEdges);
         G_UPDATE(minExtBoundedRepeatSize);
         G_UPDATE(goughCopyPropagate);
         G_UPDATE(goughRegisterAllocate);
+        G_UPDATE(goughWideIns);
         G_UPDATE(shortcutLiterals);
         G_UPDATE(roseGraphReduction);
         G_UPDATE(roseRoleAliasing);
@@ -269,11 +290,14 @@ void applyGreyOverrides(Grey *g, const string &s) {
         G_UPDATE(somMaxRevNfaLength);
         G_UPDATE(hamsterAccelForward);
         G_UPDATE(hamsterAccelReverse);
+        G_UPDATE(hamsterMixedCase);
         G_UPDATE(miracleHistoryBonus);
         G_UPDATE(equivalenceEnable);
         G_UPDATE(allowSmallWrite);
         G_UPDATE(smallWriteLargestBuffer);
         G_UPDATE(smallWriteLargestBufferBad);
+        G_UPDATE(smallWriteLargestBufferAccel);
+        G_UPDATE(smallWriteMaxDFAs);
         G_UPDATE(limitSmallWriteOutfixSize);
         G_UPDATE(limitPatternCount);
         G_UPDATE(limitPatternLength);
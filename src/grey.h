@@ -56,15 +56,21 @@ struct Grey {
     bool allowLimExNFA;
     bool allowSidecar;
     bool allowAnchoredAcyclic;
+    bool allowAnchoredLitTable;
     bool allowSmallLiteralSet;
     bool allowCastle;
+    bool allowTamarama; // combine exclusive suffixes into Tamarama engines
     bool allowDecoratedLiteral;
 
     bool allowNoodle;
     bool fdrAllowTeddy;
+    u32 fdrLongLitHashLen; // history used to track long streaming literals
 
     bool puffImproveHead;
     bool castleExclusive; // enable castle mutual exclusion analysis
+    bool castleUniform; // batch identical castle repeats in array form
+    u32 mpvBatchMinPuffettes; // use batched mpv report checks at this size
+    u32 tamaChunkSize; // max number of subengines in a Tamarama
 
     bool mergeSEP;
     bool mergeRose;
@@ -94,6 +100,7 @@ struct Grey {
     u32 maxHistoryAvailable;
     u32 minHistoryAvailable;
     u32 maxAnchoredRegion;
+    u32 minAnchoredLitTable; // fixed-offset anchored literals to use table
     u32 minRoseLiteralLength;
     u32 minRoseNetflowLiteralLength;
     u32 maxRoseNetflowEdges;
@@ -102,6 +109,7 @@ struct Grey {
 
     bool goughCopyPropagate;
     bool goughRegisterAllocate;
+    bool goughWideIns;
 
     bool shortcutLiterals;
 
@@ -133,6 +141,7 @@ struct Grey {
 
     bool hamsterAccelForward;
     bool hamsterAccelReverse; // currently not implemented
+    bool hamsterMixedCase; // per-char case masks rather than rose benefits
 
     u32 miracleHistoryBonus; /* cheap hack to make miracles better, TODO
                               * something dignified */
@@ -143,6 +152,8 @@ struct Grey {
     bool allowSmallWrite;
     u32 smallWriteLargestBuffer;  // largest buffer that can be small write
     u32 smallWriteLargestBufferBad;// largest buffer that can be small write
+    u32 smallWriteLargestBufferAccel; // largest buffer for accel-start dfas
+    u32 smallWriteMaxDFAs; //!< max number of dfas in the smallwrite engine
     u32 limitSmallWriteOutfixSize; //!< max total size of outfix DFAs
 
     enum DumpFlags {
@@ -179,6 +179,32 @@ hs_error_t hs_deserialize_database_at(const char *bytes, const size_t length,
  */
 hs_error_t hs_stream_size(const hs_database_t *database, size_t *stream_size);
 
+/**
+ * Provides the maximum width of any match that can be produced by the given
+ * database.
+ *
+ * Every match reported by a database with a bounded maximum width is
+ * determined by at most that many bytes of data ending at the match offset,
+ * plus one byte either side for assertions such as word boundaries. This
+ * allows a large block to be divided into overlapping pieces which can be
+ * scanned independently.
+ *
+ * @param database
+ *      Pointer to a compiled pattern database.
+ *
+ * @param max_width
+ *      On success, the maximum width in bytes of any match is placed in this
+ *      parameter. If the width is unbounded, or if the database contains
+ *      patterns whose matches depend on more than the matched data (those
+ *      compiled with @ref HS_FLAG_SINGLEMATCH or with extended parameters), it
+ *      will be set to the maximum value of an unsigned int (UINT_MAX).
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_database_max_width(const hs_database_t *database,
+                                 unsigned int *max_width);
+
 /**
  * Provides the size of the given database in bytes.
  *
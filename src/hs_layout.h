@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Database layout introspection API.
+ *
+ * The functions in this header report how a compiled database is made up: the
+ * literal matchers and automata engines it contains, what each engine is used
+ * for and how much stream and scratch space the database requires. Unlike the
+ * dump facilities available in debug builds, this information is returned as
+ * structured data and is available in release builds, so that it can be used
+ * to check programmatically that a change to a pattern set does not bloat the
+ * database it compiles to.
+ *
+ * These functions are provided by the full Hyperscan library, not by the
+ * runtime-only library.
+ */
+
+#ifndef HS_LAYOUT_H
+#define HS_LAYOUT_H
+
+#include "hs_common.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @defgroup HS_MATCHER_TABLE Literal matcher tables
+ *
+ * The role of a literal matcher in the database, as reported in @ref
+ * hs_matcher_layout_t::table.
+ *
+ * @{
+ */
+
+/** \brief Matches literals anywhere in the data. */
+#define HS_MATCHER_FLOATING         0
+
+/** \brief Matches literals that must end at the end of the data. */
+#define HS_MATCHER_EOD_ANCHORED     1
+
+/** \brief Matches literals in small blocks in block mode. */
+#define HS_MATCHER_SMALL_BLOCK      2
+
+/** @} */
+
+/**
+ * @defgroup HS_ENGINE_ROLE Engine roles
+ *
+ * The use an automata engine is put to in the database, as reported in @ref
+ * hs_engine_layout_t::role.
+ *
+ * @{
+ */
+
+/** \brief Engine runs from the start of the data, independent of any
+ * literal. */
+#define HS_ENGINE_ROLE_OUTFIX       0
+
+/** \brief Engine must match before a literal for the literal to be
+ * considered, with the literal at a fixed position. */
+#define HS_ENGINE_ROLE_PREFIX       1
+
+/** \brief Engine must match between two literals. */
+#define HS_ENGINE_ROLE_INFIX        2
+
+/** \brief Engine is started by a literal match and runs after it. */
+#define HS_ENGINE_ROLE_SUFFIX       3
+
+/** \brief Engine handles bounded repeats chained from other engines. */
+#define HS_ENGINE_ROLE_CHAINED      4
+
+/** \brief Engine matches literals anchored to the start of the data. */
+#define HS_ENGINE_ROLE_ANCHORED     5
+
+/** \brief Engine replaces the rest of the database when scanning small
+ * blocks. */
+#define HS_ENGINE_ROLE_SMALL_WRITE  6
+
+/** @} */
+
+/** \brief Description of one literal matcher in a database. */
+typedef struct hs_matcher_layout {
+    /** \brief One of the @ref HS_MATCHER_TABLE values. */
+    unsigned int table;
+
+    /** \brief Name of the literal matching algorithm used, such as "noodle",
+     * "fdr" or "teddy". */
+    const char *type;
+
+    /** \brief Name of the acceleration scheme used to skip ahead when no
+     * literal groups are known to be off, or "none". */
+    const char *accel;
+
+    /** \brief Number of literals in the matcher. */
+    unsigned int literal_count;
+
+    /** \brief Size of the matcher in bytes. */
+    size_t size;
+} hs_matcher_layout_t;
+
+/** \brief Description of one automata engine in a database. */
+typedef struct hs_engine_layout {
+    /** \brief One of the @ref HS_ENGINE_ROLE values. */
+    unsigned int role;
+
+    /** \brief Name of the engine implementation, such as "McClellan 8". */
+    const char *type;
+
+    /** \brief Non-zero if the engine uses acceleration when scanning
+     * forwards. */
+    int accelerated;
+
+    /** \brief Name of the scheme used to accelerate the engine when it is run
+     * backwards, or "none". */
+    const char *reverse_accel;
+
+    /** \brief Bytes of stream state used by the engine. */
+    unsigned int stream_state_size;
+
+    /** \brief Bytes of scratch state used by the engine. */
+    unsigned int scratch_state_size;
+
+    /** \brief Size of the engine in bytes. */
+    size_t size;
+} hs_engine_layout_t;
+
+/** \brief Layout of a compiled database. */
+typedef struct hs_database_layout {
+    /** \brief Size of the database in bytes, as returned by @ref
+     * hs_database_size(). */
+    size_t database_size;
+
+    /** \brief Size of a stream in bytes, as returned by @ref
+     * hs_stream_size(), or zero if the database is not a streaming
+     * database. */
+    size_t stream_size;
+
+    /** \brief Size of a scratch region allocated for this database alone, as
+     * returned by @ref hs_scratch_size(). */
+    size_t scratch_size;
+
+    /** \brief Size of the small write engine in bytes, or zero if the
+     * database has none. */
+    size_t small_write_size;
+
+    /** \brief Number of entries in @a matchers. */
+    unsigned int matcher_count;
+
+    /** \brief The literal matchers in the database. */
+    hs_matcher_layout_t *matchers;
+
+    /** \brief Number of entries in @a engines. */
+    unsigned int engine_count;
+
+    /** \brief The automata engines in the database, including those making
+     * up the small write engine. */
+    hs_engine_layout_t *engines;
+} hs_database_layout_t;
+
+/**
+ * Describes the layout of a compiled database.
+ *
+ * The layout is returned in a single allocation made with the misc allocator
+ * (see @ref hs_set_misc_allocator()) and must be released with @ref
+ * hs_free_database_layout(). The type and accel name strings are static and
+ * remain valid after the layout is freed.
+ *
+ * @param db
+ *      A database generated by one of the Hyperscan compiler functions.
+ *
+ * @param layout
+ *      On success, a pointer to the layout of the database is returned in this
+ *      parameter.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_database_layout(const hs_database_t *db,
+                              hs_database_layout_t **layout);
+
+/**
+ * Frees a layout returned by @ref hs_database_layout().
+ *
+ * @param layout
+ *      The layout to free. NULL may also be safely provided.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_free_database_layout(hs_database_layout_t *layout);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* HS_LAYOUT_H */
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Scan cost profiling API. Available to internal tools.
+ *
+ * Databases built by a library configured with PROFILE_SUPPORT carry a
+ * provenance table mapping each literal and engine back to the expressions
+ * that own it. Attaching a profile to a scratch region makes every scan using
+ * that scratch charge the time spent in literal role processing and in each
+ * engine to the owning expressions, so that a single instrumented scan can
+ * name the most expensive patterns in a set.
+ *
+ * Time is measured in timestamp counter cycles and is exclusive: work done by
+ * an engine catching up from within a literal's role processing is charged to
+ * the engine, not to the literal. Cost shared by several expressions is split
+ * evenly between them. Time spent finding literal candidates in the literal
+ * matchers themselves is not attributed to any expression.
+ */
+
+#ifndef HS_PROFILE_H
+#define HS_PROFILE_H
+
+#include "hs.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** \brief Opaque scan cost profile, allocated for a particular database. */
+typedef struct hs_profile hs_profile_t;
+
+/** \brief Cost charged to one expression by a profile. */
+typedef struct hs_profile_entry {
+    /** \brief Expression id, as passed to the compiler. */
+    unsigned int id;
+
+    /** \brief Timestamp counter cycles charged to this expression. */
+    unsigned long long cycles;
+
+    /** \brief Number of literal matches and engine executions this
+     * expression took part in. */
+    unsigned long long events;
+} hs_profile_entry_t;
+
+/**
+ * \brief Allocates a zeroed profile for the given database.
+ *
+ * Returns HS_INVALID if the library was built without profiling support or if
+ * the database carries no provenance table.
+ */
+hs_error_t hs_alloc_profile(const hs_database_t *db, hs_profile_t **profile);
+
+/** \brief Frees a profile. It must not be attached to any scratch. */
+hs_error_t hs_free_profile(hs_profile_t *profile);
+
+/** \brief Zeroes all counters in a profile. */
+hs_error_t hs_reset_profile(hs_profile_t *profile);
+
+/**
+ * \brief Attaches a profile to a scratch region, or detaches the current one
+ * if \a profile is NULL.
+ *
+ * Scans using this scratch will accumulate cost into the profile, which must
+ * have been allocated for the database being scanned. Cloning or
+ * reallocating the scratch does not carry the profile over.
+ */
+hs_error_t hs_set_scratch_profile(hs_scratch_t *scratch,
+                                  hs_profile_t *profile);
+
+/**
+ * \brief Fills \a entries with the (at most) \a max costliest expressions,
+ * most expensive first, and sets \a count to the number written.
+ */
+hs_error_t hs_profile_top(const hs_profile_t *profile, unsigned int max,
+                          hs_profile_entry_t *entries, unsigned int *count);
+
+/**
+ * \brief Reports the exclusive cost of one engine, before it is split among
+ * the expressions that own it.
+ *
+ * Engines are numbered in the order they are listed by \ref
+ * hs_database_layout(). Only the engines run by the main matcher are
+ * profiled; HS_INVALID is returned for \a index past the last of them, which
+ * includes the anchored and small write engines.
+ */
+hs_error_t hs_profile_engine(const hs_profile_t *profile, unsigned int index,
+                             unsigned long long *cycles,
+                             unsigned long long *events);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
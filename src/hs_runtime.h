@@ -190,6 +190,16 @@ hs_error_t hs_scan_stream(hs_stream_t *id, const char *data,
                           hs_scratch_t *scratch, match_event_handler onEvent,
                           void *ctxt);
 
+/**
+ * Write data to be scanned to the opened stream, with a @c size_t length.
+ *
+ * This function behaves exactly as @ref hs_scan_stream(), but allows a single
+ * write of more than 4GB of data.
+ */
+hs_error_t hs_scan_stream64(hs_stream_t *id, const char *data, size_t length,
+                            unsigned int flags, hs_scratch_t *scratch,
+                            match_event_handler onEvent, void *ctxt);
+
 /**
  * Close a stream.
  *
@@ -360,6 +370,16 @@ hs_error_t hs_scan(const hs_database_t *db, const char *data,
                    hs_scratch_t *scratch, match_event_handler onEvent,
                    void *context);
 
+/**
+ * The block regular expression scanner, with a @c size_t length.
+ *
+ * This function behaves exactly as @ref hs_scan(), but allows a block of more
+ * than 4GB, such as a memory-mapped file, to be scanned in a single call.
+ */
+hs_error_t hs_scan64(const hs_database_t *db, const char *data, size_t length,
+                     unsigned int flags, hs_scratch_t *scratch,
+                     match_event_handler onEvent, void *context);
+
 /**
  * The vectored regular expression scanner.
  *
@@ -403,6 +423,17 @@ hs_error_t hs_scan_vector(const hs_database_t *db, const char *const *data,
                           unsigned int flags, hs_scratch_t *scratch,
                           match_event_handler onEvent, void *context);
 
+/**
+ * The vectored regular expression scanner, with @c size_t block lengths.
+ *
+ * This function behaves exactly as @ref hs_scan_vector(), but allows data
+ * blocks of more than 4GB.
+ */
+hs_error_t hs_scan_vector64(const hs_database_t *db, const char *const *data,
+                            const size_t *length, unsigned int count,
+                            unsigned int flags, hs_scratch_t *scratch,
+                            match_event_handler onEvent, void *context);
+
 /**
  * Allocate a "scratch" space for use by Hyperscan.
  *
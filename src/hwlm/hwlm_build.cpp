@@ -50,6 +50,7 @@
 #include "util/ue2string.h"
 #include "util/verify_types.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
@@ -372,7 +373,7 @@ void findForwardAccelScheme(const vector<hwlmLiteral> &lits,
 
         for (u32 i = 0; i < MAX_ACCEL_OFFSET && i < lit.s.length(); i++) {
             unsigned char c = lit.s[i];
-            if (lit.nocase) {
+            if (lit.isNocaseChar(i)) {
                 DEBUG_PRINTF("adding %02hhx to %u\n", mytoupper(c), i);
                 DEBUG_PRINTF("adding %02hhx to %u\n", mytolower(c), i);
                 reach[i].set(mytoupper(c));
@@ -429,7 +430,8 @@ void dumpLits(UNUSED const vector<hwlmLiteral> &lits) {
     DEBUG_PRINTF("building lit table for:\n");
     for (const auto &lit : lits) {
         printf("\t%u:%016llx %s%s\n", lit.id, lit.groups,
-               escapeString(lit.s).c_str(), lit.nocase ? " (nc)" : "");
+               escapeString(lit.s).c_str(),
+               lit.isMixedCase() ? " (mixed)" : lit.nocase ? " (nc)" : "");
     }
 #endif
 }
@@ -467,6 +469,17 @@ bool isNoodleable(const vector<hwlmLiteral> &lits,
                          stream_control->history_max);
             return false;
         }
+
+        // Noodle needs the whole literal in history. Past the long literal
+        // hash window, FDR can track it in a few bytes of stream state.
+        size_t fdr_history = max(stream_control->history_min,
+                                 (size_t)cc.grey.fdrLongLitHashLen);
+        if (lits.front().s.length() - 1 > fdr_history &&
+            fdr_history <= stream_control->history_max) {
+            DEBUG_PRINTF("length of %zu better served by FDR long literal "
+                         "support\n", lits.front().s.length());
+            return false;
+        }
     }
 
     if (!lits.front().msk.empty()) {
@@ -474,6 +487,11 @@ bool isNoodleable(const vector<hwlmLiteral> &lits,
         return false;
     }
 
+    if (lits.front().isMixedCase()) {
+        DEBUG_PRINTF("noodle can't handle mixed-case literals\n");
+        return false;
+    }
+
     return true;
 }
 
@@ -532,8 +550,8 @@ aligned_unique_ptr<HWLM> hwlmBuild(const vector<hwlmLiteral> &lits,
             engSize = noodSize(noodle.get());
         }
         if (stream_control) {
-            // For now, a single literal still goes to noodle and asks
-            // for a great big history
+            // Noodle keeps the whole literal in history; isNoodleable only
+            // accepts literals short enough for that to be cheap.
             stream_control->literal_history_required = lit.s.length() - 1;
             assert(stream_control->literal_history_required
                    <= stream_control->history_max);
@@ -563,6 +581,7 @@ aligned_unique_ptr<HWLM> hwlmBuild(const vector<hwlmLiteral> &lits,
     auto h = aligned_zmalloc_unique<HWLM>(ROUNDUP_CL(sizeof(HWLM)) + engSize);
 
     h->type = engType;
+    h->literalCount = verify_u32(lits.size());
     memcpy(HWLM_DATA(h.get()), eng.get(), engSize);
 
     if (engType == HWLM_ENGINE_FDR && cc.grey.hamsterAccelForward) {
@@ -59,6 +59,7 @@ void hwlmPrintStats(const HWLM *h, FILE *f) {
         fprintf(f, "<unknown hwlm subengine>\n");
     }
 
+    fprintf(f, "literals:      %u\n", h->literalCount);
     fprintf(f, "accel1_groups: %016llx\n", h->accel1_groups);
 
     fprintf(f, "accel1:");
@@ -47,6 +47,7 @@
  * engine-specific structure. */
 struct HWLM {
     u8 type; /**< HWLM_ENGINE_NOOD or HWLM_ENGINE_FDR */
+    u32 literalCount; /**< number of literals the table was built from */
     hwlm_group_t accel1_groups; /**< accelerable groups. */
     union AccelAux accel1; /**< used if group mask is subset of accel1_groups */
     union AccelAux accel0; /**< fallback accel scheme */
@@ -58,12 +58,19 @@ std::string dumpMask(const vector<u8> &v) {
 
 bool maskIsConsistent(const std::string &s, bool nocase, const vector<u8> &msk,
                       const vector<u8> &cmp) {
+    return maskIsConsistent(s, vector<bool>(s.size(), nocase), msk, cmp);
+}
+
+bool maskIsConsistent(const std::string &s, const vector<bool> &nocase,
+                      const vector<u8> &msk, const vector<u8> &cmp) {
+    assert(nocase.size() == s.size());
     string::const_reverse_iterator si = s.rbegin();
+    vector<bool>::const_reverse_iterator ni = nocase.rbegin();
     vector<u8>::const_reverse_iterator mi = msk.rbegin(), ci = cmp.rbegin();
 
-    for (; si != s.rend() && mi != msk.rend(); ++si, ++mi, ++ci) {
+    for (; si != s.rend() && mi != msk.rend(); ++si, ++ni, ++mi, ++ci) {
         u8 c = *si, m = *mi, v = *ci;
-        if (nocase && ourisalpha(c)) {
+        if (*ni && ourisalpha(c)) {
             m &= ~CASE_BIT;
             v &= ~CASE_BIT;
         }
@@ -108,4 +115,39 @@ hwlmLiteral::hwlmLiteral(const std::string &s_in, bool nocase_in,
     }
 }
 
+/** \brief Returns true if any alphabetic character of \a s is flagged
+ * case-insensitive in \a nocase. */
+static
+bool anyNocaseAlpha(const string &s, const vector<bool> &nocase) {
+    assert(nocase.size() == s.size());
+    for (size_t i = 0; i < s.size(); i++) {
+        if (nocase[i] && ourisalpha(s[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+hwlmLiteral::hwlmLiteral(const std::string &s_in, const vector<bool> &nocase_in,
+                         bool noruns_in, u32 id_in, hwlm_group_t groups_in,
+                         const vector<u8> &msk_in, const vector<u8> &cmp_in)
+    : hwlmLiteral(s_in, anyNocaseAlpha(s_in, nocase_in), noruns_in, id_in,
+                  groups_in, msk_in, cmp_in) {
+    assert(maskIsConsistent(s, nocase_in, msk_in, cmp_in));
+
+    // Only keep per-character sensitivity if some alphabetic character is
+    // case-sensitive in an otherwise case-insensitive literal.
+    if (!nocase) {
+        return;
+    }
+    for (size_t i = 0; i < s.size(); i++) {
+        if (!nocase_in[i] && ourisalpha(s[i])) {
+            nocase_chars = nocase_in;
+            DEBUG_PRINTF("literal '%s' is mixed-case\n",
+                         escapeString(s).c_str());
+            return;
+        }
+    }
+}
+
 } // namespace ue2
@@ -54,7 +54,18 @@ struct hwlmLiteral {
      * should not be used. */
     u32 id;
 
-    bool nocase; //!< \brief True if literal is case-insensitive.
+    /** \brief True if literal is case-insensitive.
+     *
+     * For a mixed-case literal (see \ref nocase_chars), this is true as some
+     * of its characters are case-insensitive. */
+    bool nocase;
+
+    /** \brief Per-character case sensitivity of a mixed-case literal.
+     *
+     * Empty unless the literal has both case-sensitive and case-insensitive
+     * alphabetic characters, in which case it holds one entry per character
+     * of \ref s, true where that character is case-insensitive. */
+    std::vector<bool> nocase_chars;
 
     /** \brief Matches for runs of this literal can be quashed.
      *
@@ -107,6 +118,26 @@ struct hwlmLiteral {
     hwlmLiteral(const std::string &s_in, bool nocase_in, bool noruns_in,
                 u32 id_in, hwlm_group_t groups_in,
                 const std::vector<u8> &msk_in, const std::vector<u8> &cmp_in);
+
+    /** \brief Complete constructor with per-character case sensitivity.
+     *
+     * \a nocase_in must have one entry per character of \a s_in. If its
+     * alphabetic characters all share the same sensitivity, the literal is
+     * built as a plain caseful or caseless one. */
+    hwlmLiteral(const std::string &s_in, const std::vector<bool> &nocase_in,
+                bool noruns_in, u32 id_in, hwlm_group_t groups_in,
+                const std::vector<u8> &msk_in, const std::vector<u8> &cmp_in);
+
+    /** \brief True if this literal mixes case-sensitive and
+     * case-insensitive characters. */
+    bool isMixedCase() const { return !nocase_chars.empty(); }
+
+    /** \brief True if the character at index \a i of \ref s is
+     * case-insensitive. */
+    bool isNocaseChar(size_t i) const {
+        assert(i < s.size());
+        return isMixedCase() ? nocase_chars[i] : nocase;
+    }
 };
 
 /**
@@ -116,6 +147,13 @@ struct hwlmLiteral {
 bool maskIsConsistent(const std::string &s, bool nocase,
                       const std::vector<u8> &msk, const std::vector<u8> &cmp);
 
+/**
+ * Consistency test for a literal with per-character case sensitivity, with
+ * one entry in \a nocase per character of \a s.
+ */
+bool maskIsConsistent(const std::string &s, const std::vector<bool> &nocase,
+                      const std::vector<u8> &msk, const std::vector<u8> &cmp);
+
 } // namespace ue2
 
 #endif // HWLM_LITERAL_H
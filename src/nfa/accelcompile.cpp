@@ -188,4 +188,45 @@ bool buildAccelAux(const AccelInfo &info, AccelAux *aux) {
     return aux->accel_type != ACCEL_NONE;
 }
 
+const char *accelName(u8 accel_type) {
+    switch (accel_type) {
+    case ACCEL_NONE:
+        return "none";
+    case ACCEL_VERM:
+        return "vermicelli";
+    case ACCEL_VERM_NOCASE:
+        return "vermicelli nocase";
+    case ACCEL_DVERM:
+        return "double-vermicelli";
+    case ACCEL_DVERM_NOCASE:
+        return "double-vermicelli nocase";
+    case ACCEL_RVERM:
+        return "reverse vermicelli";
+    case ACCEL_RVERM_NOCASE:
+        return "reverse vermicelli nocase";
+    case ACCEL_RDVERM:
+        return "reverse double-vermicelli";
+    case ACCEL_RDVERM_NOCASE:
+        return "reverse double-vermicelli nocase";
+    case ACCEL_REOD:
+        return "reverse eod";
+    case ACCEL_REOD_NOCASE:
+        return "reverse eod nocase";
+    case ACCEL_RDEOD:
+        return "reverse double-eod";
+    case ACCEL_RDEOD_NOCASE:
+        return "reverse double-eod nocase";
+    case ACCEL_SHUFTI:
+        return "shufti";
+    case ACCEL_DSHUFTI:
+        return "double-shufti";
+    case ACCEL_TRUFFLE:
+        return "truffle";
+    case ACCEL_RED_TAPE:
+        return "red tape";
+    default:
+        return "unknown!";
+    }
+}
+
 } // namespace ue2
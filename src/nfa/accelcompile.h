@@ -51,6 +51,9 @@ struct AccelInfo {
 
 bool buildAccelAux(const AccelInfo &info, AccelAux *aux);
 
+/** \brief Human-readable name of an acceleration scheme (an AccelType). */
+const char *accelName(u8 accel_type);
+
 } // namespace ue2
 
 #endif
@@ -83,6 +83,223 @@ enum MatchMode {
     STOP_AT_MATCH,
 };
 
+/*
+ * Uniform castles: every SubCastle has the same bounds and an offset-only
+ * repeat model, and their control blocks form a dense array of top offsets.
+ * Rather than going through the generic repeat API per SubCastle, we gather
+ * active SubCastles in batches and evaluate them against the shared bounds in
+ * simple loops over the array.
+ */
+
+/** \brief Max number of SubCastles evaluated together in a uniform castle. */
+#define CASTLE_UNIFORM_BATCH 32
+
+static really_inline
+const struct RepeatInfo *getUniformRepeatInfo(const struct Castle *c) {
+    assert(c->uniform);
+    return getRepeatInfo(getSubCastle(c, 0));
+}
+
+static really_inline
+const u64a *getUniformTops(const struct Castle *c, const void *full_state) {
+    assert(c->uniform);
+    const u64a *tops = (const u64a *)((const char *)full_state +
+                                      getSubCastle(c, 0)->fullStateOffset);
+    assert(ISALIGNED(tops));
+    return tops;
+}
+
+/** \brief Gathers up to CASTLE_UNIFORM_BATCH active SubCastles following
+ * \a *it into \a idx, returning the number found. */
+static really_inline
+u32 uniformGatherActive(const struct Castle *c, const u8 *active, u32 *it,
+                        u32 *idx) {
+    u32 n = 0;
+    u32 i = *it;
+    while (n < CASTLE_UNIFORM_BATCH) {
+        i = mmbit_iterate(active, c->numRepeats, i);
+        if (i == MMB_INVALID) {
+            break;
+        }
+        idx[n++] = i;
+    }
+    *it = i;
+    return n;
+}
+
+/** \brief Batch equivalent of repeatHasMatch for the FIRST and LAST models. */
+static really_inline
+void uniformHasMatch(const struct RepeatInfo *info, const u64a *tops,
+                     const u32 *idx, u32 n, u64a offset, u8 *rv) {
+    const u64a min = info->repeatMin;
+    const u64a max = info->repeatMax;
+    const char bounded = info->repeatMax != REPEAT_INF;
+    for (u32 k = 0; k < n; k++) {
+        u64a top = tops[idx[k]];
+        rv[k] = offset < top + min ? REPEAT_NOMATCH
+              : !bounded || offset <= top + max ? REPEAT_MATCH
+              : REPEAT_STALE;
+    }
+}
+
+/** \brief Batch equivalent of repeatNextMatch for the FIRST and LAST models.
+ * Zero means no more matches. */
+static really_inline
+void uniformNextMatch(const struct RepeatInfo *info, const u64a *tops,
+                      const u32 *idx, u32 n, u64a loc, u64a *next) {
+    const u64a min = info->repeatMin;
+    const u64a max = info->repeatMax;
+    const char bounded = info->repeatMax != REPEAT_INF;
+    for (u32 k = 0; k < n; k++) {
+        u64a top = tops[idx[k]];
+        u64a first = top + min;
+        u64a m = first > loc ? first : loc + 1;
+        next[k] = bounded && loc >= top + max ? 0 : m;
+    }
+}
+
+static really_inline
+char uniformReportCurrent(const struct Castle *c, struct mq *q,
+                          const u64a offset) {
+    const struct RepeatInfo *info = getUniformRepeatInfo(c);
+    const u64a *tops = getUniformTops(c, q->state);
+    const u8 *active = (const u8 *)q->streamState;
+
+    u32 idx[CASTLE_UNIFORM_BATCH];
+    u8 match[CASTLE_UNIFORM_BATCH];
+    u32 it = MMB_INVALID;
+    u32 n;
+    while ((n = uniformGatherActive(c, active, &it, idx))) {
+        uniformHasMatch(info, tops, idx, n, offset, match);
+        for (u32 k = 0; k < n; k++) {
+            if (match[k] != REPEAT_MATCH) {
+                continue;
+            }
+            const struct SubCastle *sub = getSubCastle(c, idx[k]);
+            DEBUG_PRINTF("firing match at %llu for sub %u\n", offset, idx[k]);
+            if (q->cb(offset, sub->report, q->context) == MO_HALT_MATCHING) {
+                return MO_HALT_MATCHING;
+            }
+        }
+    }
+
+    return MO_CONTINUE_MATCHING;
+}
+
+static really_inline
+char uniformInAccept(const struct Castle *c, struct mq *q,
+                     const ReportID report, const u64a offset) {
+    const struct RepeatInfo *info = getUniformRepeatInfo(c);
+    const u64a *tops = getUniformTops(c, q->state);
+    const u8 *active = (const u8 *)q->streamState;
+
+    u32 idx[CASTLE_UNIFORM_BATCH];
+    u8 match[CASTLE_UNIFORM_BATCH];
+    u32 it = MMB_INVALID;
+    u32 n;
+    while ((n = uniformGatherActive(c, active, &it, idx))) {
+        uniformHasMatch(info, tops, idx, n, offset, match);
+        for (u32 k = 0; k < n; k++) {
+            if (match[k] == REPEAT_MATCH &&
+                getSubCastle(c, idx[k])->report == report) {
+                DEBUG_PRINTF("sub %u in an accept\n", idx[k]);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static really_inline
+void uniformDeactivateStaleSubs(const struct Castle *c, const u64a offset,
+                                void *full_state, void *stream_state) {
+    const struct RepeatInfo *info = getUniformRepeatInfo(c);
+    const u64a *tops = getUniformTops(c, full_state);
+    u8 *active = (u8 *)stream_state;
+
+    u32 idx[CASTLE_UNIFORM_BATCH];
+    u8 match[CASTLE_UNIFORM_BATCH];
+    u32 it = MMB_INVALID;
+    u32 n;
+    while ((n = uniformGatherActive(c, active, &it, idx))) {
+        uniformHasMatch(info, tops, idx, n, offset, match);
+        for (u32 k = 0; k < n; k++) {
+            if (match[k] == REPEAT_STALE) {
+                DEBUG_PRINTF("sub %u is stale at offset %llu\n", idx[k],
+                             offset);
+                mmbit_unset(active, c->numRepeats, idx[k]);
+            }
+        }
+    }
+}
+
+static really_inline
+char uniformFindMatch(const struct Castle *c, const u64a begin,
+                      const u64a end, void *full_state, void *stream_state,
+                      size_t *mloc) {
+    const struct RepeatInfo *info = getUniformRepeatInfo(c);
+    const u64a *tops = getUniformTops(c, full_state);
+    u8 *active = (u8 *)stream_state;
+
+    char found = 0;
+    u32 idx[CASTLE_UNIFORM_BATCH];
+    u64a next[CASTLE_UNIFORM_BATCH];
+    u32 it = MMB_INVALID;
+    u32 n;
+    while ((n = uniformGatherActive(c, active, &it, idx))) {
+        uniformNextMatch(info, tops, idx, n, begin, next);
+        for (u32 k = 0; k < n; k++) {
+            if (!next[k]) {
+                DEBUG_PRINTF("no more matches for sub %u\n", idx[k]);
+                mmbit_unset(active, c->numRepeats, idx[k]);
+            } else if (next[k] <= end) {
+                size_t diff = next[k] - begin;
+                if (!found || diff < *mloc) {
+                    *mloc = diff;
+                }
+                found = 1;
+            }
+        }
+    }
+
+    return found;
+}
+
+static really_inline
+void uniformMatchLoop(const struct Castle *c, void *full_state,
+                      void *stream_state, const u64a end, const u64a loc,
+                      u64a *offset) {
+    const struct RepeatInfo *info = getUniformRepeatInfo(c);
+    const u64a *tops = getUniformTops(c, full_state);
+    u8 *active = (u8 *)stream_state;
+    u8 *matching = full_state;
+    mmbit_clear(matching, c->numRepeats);
+
+    u32 idx[CASTLE_UNIFORM_BATCH];
+    u64a next[CASTLE_UNIFORM_BATCH];
+    u32 it = MMB_INVALID;
+    u32 n;
+    while ((n = uniformGatherActive(c, active, &it, idx))) {
+        uniformNextMatch(info, tops, idx, n, loc, next);
+        for (u32 k = 0; k < n; k++) {
+            u64a match = next[k];
+            if (match == 0) {
+                DEBUG_PRINTF("no more matches for sub %u\n", idx[k]);
+                mmbit_unset(active, c->numRepeats, idx[k]);
+            } else if (match > end) {
+                continue;
+            } else if (match == *offset) {
+                mmbit_set(matching, c->numRepeats, idx[k]);
+            } else if (match < *offset) {
+                *offset = match;
+                mmbit_clear(matching, c->numRepeats);
+                mmbit_set(matching, c->numRepeats, idx[k]);
+            }
+        }
+    }
+}
+
 static really_inline
 char subCastleReportCurrent(const struct Castle *c, struct mq *q,
                             const u64a offset, const u32 subIdx) {
@@ -110,6 +327,10 @@ int castleReportCurrent(const struct Castle *c, struct mq *q) {
     const u64a offset = q_cur_offset(q);
     DEBUG_PRINTF("offset=%llu\n", offset);
 
+    if (c->uniform) {
+        return uniformReportCurrent(c, q, offset);
+    }
+
     if (c->exclusive) {
         const u32 activeIdx = partial_load_u32(q->streamState,
                                                c->activeIdxSize);
@@ -163,6 +384,10 @@ char castleInAccept(const struct Castle *c, struct mq *q,
                     const ReportID report, const u64a offset) {
     DEBUG_PRINTF("offset=%llu\n", offset);
 
+    if (c->uniform) {
+        return uniformInAccept(c, q, report, offset);
+    }
+
     if (c->exclusive) {
         const u32 activeIdx = partial_load_u32(q->streamState,
                                                c->activeIdxSize);
@@ -216,6 +441,11 @@ void castleDeactivateStaleSubs(const struct Castle *c, const u64a offset,
                                void *full_state, void *stream_state) {
     DEBUG_PRINTF("offset=%llu\n", offset);
 
+    if (c->uniform) {
+        uniformDeactivateStaleSubs(c, offset, full_state, stream_state);
+        return;
+    }
+
     if (c->exclusive) {
         const u32 activeIdx = partial_load_u32(stream_state, c->activeIdxSize);
         if (activeIdx < c->numRepeats) {
@@ -328,6 +558,10 @@ char castleFindMatch(const struct Castle *c, const u64a begin, const u64a end,
     char found = 0;
     *mloc = 0;
 
+    if (c->uniform) {
+        return uniformFindMatch(c, begin, end, full_state, stream_state, mloc);
+    }
+
     if (c->exclusive) {
         const u32 activeIdx = partial_load_u32(stream_state, c->activeIdxSize);
         if (activeIdx < c->numRepeats) {
@@ -371,6 +605,11 @@ static really_inline
 void subCastleMatchLoop(const struct Castle *c, void *full_state,
                         void *stream_state, const u64a end,
                         const u64a loc, u64a *offset) {
+    if (c->uniform) {
+        uniformMatchLoop(c, full_state, stream_state, end, loc, offset);
+        return;
+    }
+
     u8 *active = (u8 *)stream_state + c->activeIdxSize;
     u8 *matching = full_state;
     mmbit_clear(matching, c->numRepeats);
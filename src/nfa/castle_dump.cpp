@@ -73,6 +73,7 @@ void nfaExecCastle0_dumpText(const struct NFA *nfa, FILE *f) {
     fprintf(f, "Castle multi-tenant repeat engine\n");
     fprintf(f, "\n");
     fprintf(f, "Number of repeat tenants:  %u\n", c->numRepeats);
+    fprintf(f, "Uniform repeats:           %s\n", c->uniform ? "yes" : "no");
     fprintf(f, "Scan type:                 ");
     switch (c->type) {
     case CASTLE_DOT:
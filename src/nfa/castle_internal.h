@@ -75,6 +75,12 @@ struct SubCastle {
  * the repeats (used by \ref castleMatchLoop), followed by the repeat control
  * blocks for each SubCastle. If all SubCastles are mutual exclusive, we only
  * need to store the repeat control blocks for each SubCastle.
+ *
+ * If all SubCastles are non-exclusive and share the same bounds and an
+ * offset-only repeat model (::REPEAT_FIRST or ::REPEAT_LAST), the Castle is
+ * "uniform": the control blocks are laid out as a dense array of u64a top
+ * offsets, and the runtime evaluates active SubCastles against the shared
+ * bounds in batches rather than one at a time.
  */
 struct ALIGN_AVX_DIRECTIVE Castle {
     u32 numRepeats;
@@ -83,6 +89,7 @@ struct ALIGN_AVX_DIRECTIVE Castle {
     char pureExclusive; //!< tells us if all SubCastles are mutual exclusive
     u8 activeIdxSize; //!< number of bytes in stream state to store
                       // active SubCastle id for exclusive mode
+    char uniform; //!< SubCastles share one offset-only repeat shape
     union {
         struct {
             char c;
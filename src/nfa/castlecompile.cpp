@@ -42,6 +42,7 @@
 #include "nfagraph/ng_redundancy.h"
 #include "nfagraph/ng_util.h"
 #include "util/alloc.h"
+#include "util/clique.h"
 #include "util/compile_context.h"
 #include "util/container.h"
 #include "util/dump_charclass.h"
@@ -52,7 +53,6 @@
 #include "util/verify_types.h"
 #include "grey.h"
 
-#include <stack>
 #include <cassert>
 
 #include <boost/range/adaptor/map.hpp>
@@ -132,114 +132,6 @@ bool literalOverlap(const vector<CharReach> &a, const vector<CharReach> &b,
     return b.size() > dist;
 }
 
-struct CliqueVertexProps {
-    CliqueVertexProps() {}
-    explicit CliqueVertexProps(u32 state_in) : stateId(state_in) {}
-
-    u32 stateId = ~0U;
-};
-
-typedef boost::adjacency_list<boost::listS, boost::listS, boost::undirectedS,
-                              CliqueVertexProps> CliqueGraph;
-typedef CliqueGraph::vertex_descriptor CliqueVertex;
-
-static
-void getNeighborInfo(const CliqueGraph &g, vector<u32> &neighbor,
-                     const CliqueVertex &cv, const set<u32> &group) {
-    u32 id = g[cv].stateId;
-    ue2::unordered_set<u32> neighborId;
-
-    // find neighbors for cv
-    for (const auto &v : adjacent_vertices_range(cv, g)) {
-        if (g[v].stateId != id && contains(group, g[v].stateId)){
-            neighbor.push_back(g[v].stateId);
-            neighborId.insert(g[v].stateId);
-            DEBUG_PRINTF("Neighbor:%u\n", g[v].stateId);
-        }
-    }
-}
-
-static
-void findCliqueGroup(CliqueGraph &cg, vector<u32> &clique) {
-    stack<vector<u32>> gStack;
-
-    // Create mapping between vertex and id
-    map<u32, CliqueVertex> vertexMap;
-    vector<u32> init;
-    for (const auto &v : vertices_range(cg)) {
-        vertexMap[cg[v].stateId] = v;
-        init.push_back(cg[v].stateId);
-    }
-    gStack.push(init);
-
-    // Get the vertex to start from
-    CliqueGraph::vertex_iterator vi, ve;
-    tie(vi, ve) = vertices(cg);
-    while (!gStack.empty()) {
-        vector<u32> g = gStack.top();
-        gStack.pop();
-
-        // Choose a vertex from the graph
-        u32 id = g[0];
-        const CliqueVertex &n = vertexMap.at(id);
-        clique.push_back(id);
-        // Corresponding vertex in the original graph
-        vector<u32> neighbor;
-        set<u32> subgraphId(g.begin(), g.end());
-        getNeighborInfo(cg, neighbor, n, subgraphId);
-        // Get graph consisting of neighbors for left branch
-        if (!neighbor.empty()) {
-            gStack.push(neighbor);
-        }
-    }
-}
-
-template<typename Graph>
-bool graph_empty(const Graph &g) {
-    typename Graph::vertex_iterator vi, ve;
-    tie(vi, ve) = vertices(g);
-    return vi == ve;
-}
-
-static
-vector<u32> removeClique(CliqueGraph &cg) {
-    vector<vector<u32>> cliquesVec(1);
-    DEBUG_PRINTF("graph size:%lu\n", num_vertices(cg));
-    findCliqueGroup(cg, cliquesVec[0]);
-    while (!graph_empty(cg)) {
-        const vector<u32> &c = cliquesVec.back();
-        vector<CliqueVertex> dead;
-        for (const auto &v : vertices_range(cg)) {
-            if (find(c.begin(), c.end(), cg[v].stateId) != c.end()) {
-                dead.push_back(v);
-            }
-        }
-        for (const auto &v : dead) {
-            clear_vertex(v, cg);
-            remove_vertex(v, cg);
-        }
-        if (graph_empty(cg)) {
-            break;
-        }
-        vector<u32> clique;
-        findCliqueGroup(cg, clique);
-        cliquesVec.push_back(clique);
-    }
-
-    // get the independent set with max size
-    size_t max = 0;
-    size_t id = 0;
-    for (size_t j = 0; j < cliquesVec.size(); ++j) {
-        if (cliquesVec[j].size() > max) {
-            max = cliquesVec[j].size();
-            id = j;
-        }
-    }
-
-    DEBUG_PRINTF("clique size:%lu\n", cliquesVec[id].size());
-    return cliquesVec[id];
-}
-
 // if the location of any reset character in one literal are after
 // the end locations where it overlaps with other literals,
 // then the literals are mutual exclusive
@@ -299,13 +191,40 @@ vector<u32> checkExclusion(const CharReach &cr,
     return removeClique(*cg);
 }
 
+/**
+ * \brief True if every repeat in the castle has the same bounds and uses an
+ * offset-only repeat model, so that their controls can be stored as an array
+ * and evaluated in batches at runtime.
+ */
+static
+bool isUniformCastle(const CastleProto &proto,
+                     const vector<pair<depth, bool>> &repeatInfoPair) {
+    const DepthMinMax &bounds = proto.repeats.begin()->second.bounds;
+
+    u32 i = 0;
+    for (const PureRepeat &pr : proto.repeats | map_values) {
+        if (pr.bounds != bounds) {
+            return false;
+        }
+        enum RepeatType rtype = chooseRepeatType(pr.bounds.min, pr.bounds.max,
+                                                 repeatInfoPair[i].first,
+                                                 repeatInfoPair[i].second);
+        if (rtype != REPEAT_FIRST && rtype != REPEAT_LAST) {
+            return false;
+        }
+        i++;
+    }
+
+    return true;
+}
+
 static
 void buildSubcastles(const CastleProto &proto, vector<SubCastle> &subs,
                      vector<RepeatInfo> &infos, vector<u64a> &patchSize,
                      const vector<pair<depth, bool>> &repeatInfoPair,
                      u32 &scratchStateSize, u32 &streamStateSize,
                      u32 &tableSize, vector<u64a> &tables, u32 &sparseRepeats,
-                     const set<u32> &exclusiveGroup) {
+                     const set<u32> &exclusiveGroup, bool uniform) {
     u32 i = 0;
     u32 maxStreamSize = 0;
     bool exclusive = exclusiveGroup.size() > 1;
@@ -332,7 +251,10 @@ void buildSubcastles(const CastleProto &proto, vector<SubCastle> &subs,
         if (exclusive && exclusiveGroup.find(i) != exclusiveGroup.end()) {
             maxStreamSize = MAX(maxStreamSize, rsi.packedCtrlSize);
         } else {
-            subScratchStateSize = verify_u32(sizeof(RepeatControl));
+            // Uniform castles only need the top offset in the control block,
+            // and pack them together.
+            subScratchStateSize = uniform ? verify_u32(sizeof(u64a))
+                                          : verify_u32(sizeof(RepeatControl));
             subStreamStateSize = verify_u32(rsi.packedCtrlSize + rsi.stateSize);
 
             info.packedCtrlSize = rsi.packedCtrlSize;
@@ -487,14 +409,20 @@ buildCastle(const CastleProto &proto,
         }
     }
 
-    DEBUG_PRINTF("reach %s exclusive %u\n", describeClass(cr).c_str(),
-                 exclusive);
+    // Case 2: uniform repeats
+    bool uniform = false;
+    if (cc.grey.castleUniform && !exclusive && numRepeats > 1) {
+        uniform = isUniformCastle(proto, repeatInfoPair);
+    }
+
+    DEBUG_PRINTF("reach %s exclusive %u uniform %u\n",
+                 describeClass(cr).c_str(), exclusive, uniform);
 
     u32 tableSize = 0;
     u32 sparseRepeats = 0;
     buildSubcastles(proto, subs, infos, patchSize, repeatInfoPair,
                     scratchStateSize, streamStateSize, tableSize,
-                    tables, sparseRepeats, exclusiveGroup);
+                    tables, sparseRepeats, exclusiveGroup, uniform);
 
     const size_t total_size =
         sizeof(NFA) +                      // initial NFA structure
@@ -521,6 +449,7 @@ buildCastle(const CastleProto &proto,
     c->exclusive = exclusive;
     c->pureExclusive = pureExclusive;
     c->activeIdxSize = verify_u8(activeIdxSize);
+    c->uniform = uniform;
 
     writeCastleScanEngine(cr, c);
 
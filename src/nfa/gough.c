@@ -52,6 +52,12 @@ void compressSomValue(u32 comp_slot_width, u64a curr_offset,
     /* gough does not initialise all slots, so may contain garbage */
     u64a delta = curr_offset - val;
     switch (comp_slot_width) {
+    case 1:
+        if (delta >= (u8)~0U) {
+            delta = GOUGH_SOM_EARLY;
+        }
+        *(u8 *)dest_som = delta;
+        break;
     case 2:
         if (delta >= (u16)~0U) {
             delta = GOUGH_SOM_EARLY;
@@ -84,6 +90,12 @@ u64a expandSomValue(u32 comp_slot_width, u64a curr_offset,
     const void *src_som = (const u8 *)src_som_base + i * comp_slot_width;
     u64a val = 0;
     switch (comp_slot_width) {
+    case 1:
+        val = *(const u8 *)src_som;
+        if (val == (u8)~0U) {
+            return GOUGH_SOM_EARLY;
+        }
+        break;
     case 2:
         val = unaligned_load_u16(src_som);
         if (val == (u16)~0U) {
@@ -179,12 +191,42 @@ const char *dump_op(u8 op) {
         return "NEW";
     case GOUGH_INS_MIN:
         return "MIN";
+    case GOUGH_INS_MOV2:
+        return "MOV2";
+    case GOUGH_INS_MIN2:
+        return "MIN2";
     default:
         return "???";
     }
 }
 #endif
 
+/* SOM slots are compared with GOUGH_SOM_EARLY ordered before every real
+ * offset; adding one maps GOUGH_SOM_EARLY to zero so a plain unsigned min
+ * gives the right answer. */
+static really_inline
+u64a gough_min(u64a a, u64a b) {
+    return MIN(a + 1, b + 1) - 1;
+}
+
+static really_inline
+void gough_min2(u64a *dest, const u64a *src) {
+#if defined(__SSE4_2__)
+    /* bias so that signed 64-bit compares order values as gough_min() does:
+     * (x + 1) ^ (1ULL << 63) == x + (1ULL << 63) + 1 */
+    const m128 bias = set2x64(0x8000000000000001ULL);
+    m128 d = loadu128(dest);
+    m128 s = loadu128(src);
+    m128 take_src = _mm_cmpgt_epi64(add2x64(d, bias), add2x64(s, bias));
+    storeu128(dest, or128(and128(take_src, s), andnot128(take_src, d)));
+#else
+    u64a s0 = src[0];
+    u64a s1 = src[1];
+    dest[0] = gough_min(dest[0], s0);
+    dest[1] = gough_min(dest[1], s1);
+#endif
+}
+
 static really_inline
 void run_prog_i(UNUSED const struct NFA *nfa,
                 const struct gough_ins *pc, u64a som_offset,
@@ -197,6 +239,8 @@ void run_prog_i(UNUSED const struct NFA *nfa,
         u32 src = pc->src;
         assert(pc->op == GOUGH_INS_END
                || dest < (nfa->scratchStateSize - 16) / 8);
+        assert((pc->op != GOUGH_INS_MOV2 && pc->op != GOUGH_INS_MIN2)
+               || dest + 1 < (nfa->scratchStateSize - 16) / 8);
         DEBUG_PRINTF("%s %u %u\n", dump_op(pc->op), dest, src);
         switch (pc->op) {
         case GOUGH_INS_END:
@@ -212,13 +256,13 @@ void run_prog_i(UNUSED const struct NFA *nfa,
             som->slots[dest] = som_offset - pc->src;
             break;
         case GOUGH_INS_MIN:
-            /* TODO: shift all values along by one so that a normal min works
-             */
-            if (som->slots[src] == GOUGH_SOM_EARLY) {
-                som->slots[dest] = som->slots[src];
-            } else if (som->slots[dest] != GOUGH_SOM_EARLY) {
-                LIMIT_TO_AT_MOST(&som->slots[dest], som->slots[src]);
-            }
+            som->slots[dest] = gough_min(som->slots[dest], som->slots[src]);
+            break;
+        case GOUGH_INS_MOV2:
+            storeu128(&som->slots[dest], loadu128(&som->slots[src]));
+            break;
+        case GOUGH_INS_MIN2:
+            gough_min2(&som->slots[dest], &som->slots[src]);
             break;
         default:
             assert(0);
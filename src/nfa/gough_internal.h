@@ -39,6 +39,8 @@
 #define GOUGH_INS_MOV 1
 #define GOUGH_INS_NEW 2
 #define GOUGH_INS_MIN 3
+#define GOUGH_INS_MOV2 4 /* MOV of slots dest, dest + 1 from src, src + 1 */
+#define GOUGH_INS_MIN2 5 /* MIN of slots dest, dest + 1 with src, src + 1 */
 /* todo: add instructions targeting acc reg? */
 
 struct gough_ins {
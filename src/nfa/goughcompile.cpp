@@ -695,19 +695,31 @@ void GoughSSAVarJoin::remove_input_raw(GoughSSAVar *v) {
      inputs.erase(v);
 }
 
+static
+bool is_wide_ins(const gough_ins &ins) {
+    return ins.op == GOUGH_INS_MOV2 || ins.op == GOUGH_INS_MIN2;
+}
+
 static
 u32 highest_slot_used(const vector<gough_ins> &program) {
     u32 rv = INVALID_SLOT;
     for (const gough_ins &ins : program) {
+        /* wide instructions also touch the slots after dest and src */
+        u32 dest = ins.dest;
+        u32 src = ins.src;
+        if (is_wide_ins(ins)) {
+            dest++;
+            src++;
+        }
         if (rv == INVALID_SLOT) {
-            rv = ins.dest;
-        } else if (ins.dest != INVALID_SLOT) {
-            ENSURE_AT_LEAST(&rv, ins.dest);
+            rv = dest;
+        } else if (dest != INVALID_SLOT) {
+            ENSURE_AT_LEAST(&rv, dest);
         }
         if (rv == INVALID_SLOT) {
-            rv = ins.src;
-        } else if (ins.src != INVALID_SLOT) {
-            ENSURE_AT_LEAST(&rv, ins.src);
+            rv = src;
+        } else if (src != INVALID_SLOT) {
+            ENSURE_AT_LEAST(&rv, src);
         }
     }
     assert(rv != INVALID_SLOT);
@@ -889,10 +901,40 @@ void add_joins_to_block(edge_join_info &eji, vector<gough_ins> *out,
      }
 }
 
+/* Replaces pairs of MOV or MIN instructions on consecutive slots with a
+ * single wide instruction so that the runtime can update both slots with one
+ * 128-bit operation rather than interpreting each instruction separately. */
+static
+void fuse_wide_ins(vector<gough_ins> *block) {
+    vector<gough_ins> out;
+    for (size_t i = 0; i < block->size(); i++) {
+        const gough_ins &a = (*block)[i];
+        if (i + 1 < block->size()
+            && (a.op == GOUGH_INS_MOV || a.op == GOUGH_INS_MIN)) {
+            const gough_ins &b = (*block)[i + 1];
+            /* the wide op reads both sources before writing either
+             * destination, so b must not read the slot written by a */
+            if (b.op == a.op && b.dest == a.dest + 1 && b.src == a.src + 1
+                && b.src != a.dest) {
+                gough_ins wide = a;
+                wide.op = a.op == GOUGH_INS_MOV ? GOUGH_INS_MOV2
+                                                : GOUGH_INS_MIN2;
+                DEBUG_PRINTF("fused %u<-%u and %u<-%u\n", a.dest, a.src,
+                             b.dest, b.src);
+                out.push_back(wide);
+                i++;
+                continue;
+            }
+        }
+        out.push_back(a);
+    }
+    block->swap(out);
+}
+
 static
 void build_blocks(const GoughGraph &g,
                   map<gough_edge_id, vector<gough_ins> > *blocks,
-                  u32 base_temp_slot) {
+                  u32 base_temp_slot, const Grey &grey) {
     for (const auto &e : edges_range(g)) {
         if (g[e].vars.empty()) {
             continue;
@@ -928,6 +970,9 @@ void build_blocks(const GoughGraph &g,
 
     for (vector<gough_ins> &ins_list : *blocks | map_values) {
         assert(!ins_list.empty());
+        if (grey.goughWideIns) {
+            fuse_wide_ins(&ins_list);
+        }
         ins_list.push_back(make_gough_ins(GOUGH_INS_END));
     }
 }
@@ -1033,6 +1078,87 @@ void update_accel_prog_offset(const gough_build_strat &gbs,
     }
 }
 
+/* Returns the length of the longest path from the anchored start state
+ * through live states, or ~0U if the dfa has a floating start or any cycle. */
+static
+u32 longest_live_path(const raw_som_dfa &raw) {
+    if (raw.start_floating != DEAD_STATE || raw.start_anchored == DEAD_STATE) {
+        return ~0U;
+    }
+
+    const u16 top_sym = raw.alpha_remap[TOP];
+    vector<u32> in_degree(raw.states.size(), 0);
+    for (size_t i = 0; i < raw.states.size(); i++) {
+        if (i == DEAD_STATE) {
+            continue;
+        }
+        for (u16 sym = 0; sym < raw.alpha_size; sym++) {
+            dstate_id_t t = raw.states[i].next[sym];
+            if (sym != top_sym && t != DEAD_STATE) {
+                in_degree[t]++;
+            }
+        }
+    }
+
+    /* Kahn's algorithm; states unreachable from the start state are ignored
+     * unless they lie on a cycle, which conservatively gives up. */
+    vector<u32> dist(raw.states.size(), 0);
+    vector<dstate_id_t> ready;
+    for (size_t i = 0; i < raw.states.size(); i++) {
+        if (i != DEAD_STATE && !in_degree[i]) {
+            ready.push_back(i);
+        }
+    }
+
+    u32 done = 0;
+    u32 rv = 0;
+    while (!ready.empty()) {
+        dstate_id_t s = ready.back();
+        ready.pop_back();
+        done++;
+        ENSURE_AT_LEAST(&rv, dist[s]);
+        for (u16 sym = 0; sym < raw.alpha_size; sym++) {
+            dstate_id_t t = raw.states[s].next[sym];
+            if (sym == top_sym || t == DEAD_STATE) {
+                continue;
+            }
+            ENSURE_AT_LEAST(&dist[t], dist[s] + 1);
+            if (!--in_degree[t]) {
+                ready.push_back(t);
+            }
+        }
+    }
+
+    if (done != raw.states.size() - 1) {
+        DEBUG_PRINTF("dfa has cycles\n");
+        return ~0U;
+    }
+
+    return rv;
+}
+
+/* Picks the width of the relative SOM values held in stream state. An
+ * anchored, untriggered, acyclic dfa cannot be alive more than its longest
+ * path into the stream, so no live SOM value can be further behind the
+ * current offset than that and a narrower encoding than the requested
+ * precision loses nothing. */
+static
+u32 stream_som_width(const raw_som_dfa &raw, u32 somPrecision) {
+    if (raw.kind != NFA_OUTFIX && raw.kind != NFA_PREFIX) {
+        return somPrecision;
+    }
+
+    u32 max_dist = longest_live_path(raw);
+    DEBUG_PRINTF("longest live path %u\n", max_dist);
+    if (max_dist < (u8)~0U - 1) {
+        return MIN(somPrecision, 1);
+    } else if (max_dist < (u16)~0U - 1) {
+        return MIN(somPrecision, 2);
+    }
+
+    return somPrecision;
+}
+
 aligned_unique_ptr<NFA> goughCompile(raw_som_dfa &raw, u8 somPrecision,
                                      const CompileContext &cc) {
     assert(somPrecision == 2 || somPrecision == 4 || somPrecision == 8
@@ -1052,7 +1178,7 @@ aligned_unique_ptr<NFA> goughCompile(raw_som_dfa &raw, u8 somPrecision,
     dump(*cfg, "slots", cc.grey);
 
     map<gough_edge_id, vector<gough_ins> > blocks;
-    build_blocks(*cfg, &blocks, slot_count);
+    build_blocks(*cfg, &blocks, slot_count, cc.grey);
     DEBUG_PRINTF("%u slots\n", highest_slot_used(blocks) + 1);
 
     u32 scratch_slot_count = highest_slot_used(blocks) + 1;
@@ -1109,8 +1235,11 @@ aligned_unique_ptr<NFA> goughCompile(raw_som_dfa &raw, u8 somPrecision,
     u32 total_prog_size = byte_length(temp_blocks);
     curr_offset += total_prog_size;
 
+    u32 stream_width = stream_som_width(raw, somPrecision);
+    DEBUG_PRINTF("stream som width %u (precision %u)\n", stream_width,
+                 (u32)somPrecision);
     gi.stream_som_loc_count = slot_count;
-    gi.stream_som_loc_width = somPrecision;
+    gi.stream_som_loc_width = stream_width;
 
     u32 gough_size = ROUNDUP_N(curr_offset, 16);
     aligned_unique_ptr<NFA> gough_dfa = aligned_zmalloc_unique<NFA>(gough_size);
@@ -1126,7 +1255,7 @@ aligned_unique_ptr<NFA> goughCompile(raw_som_dfa &raw, u8 somPrecision,
 
     /* update stream state requirements */
     u32 base_state_size = gough_dfa->type == GOUGH_NFA_8 ? 1 : 2;
-    gough_dfa->streamStateSize = base_state_size + slot_count * somPrecision;
+    gough_dfa->streamStateSize = base_state_size + slot_count * stream_width;
     gough_dfa->scratchStateSize = (u32)(16 + scratch_slot_count * sizeof(u64a));
 
     mcclellan *m = (mcclellan *)getMutableImplNfa(gough_dfa.get());
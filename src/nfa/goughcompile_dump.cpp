@@ -303,6 +303,12 @@ void dump_block(FILE *f, const gough_edge_id &e,
         case GOUGH_INS_MIN:
             fprintf(f, "MIN %u %u", ins.dest, ins.src);
             break;
+        case GOUGH_INS_MOV2:
+            fprintf(f, "MOV2 %u %u", ins.dest, ins.src);
+            break;
+        case GOUGH_INS_MIN2:
+            fprintf(f, "MIN2 %u %u", ins.dest, ins.src);
+            break;
         default:
             fprintf(f, "<UNKNOWN>");
             break;
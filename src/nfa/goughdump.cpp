@@ -179,6 +179,12 @@ void dump_program(FILE *f, const pair<u32, u32> &e, const gough_ins *prog) {
         case GOUGH_INS_MIN:
             fprintf(f, "MIN %u %u", d, s);
             break;
+        case GOUGH_INS_MOV2:
+            fprintf(f, "MOV2 %u %u", d, s);
+            break;
+        case GOUGH_INS_MIN2:
+            fprintf(f, "MIN2 %u %u", d, s);
+            break;
         default:
             fprintf(f, "<UNKNOWN>");
             fprintf(f, "\n");
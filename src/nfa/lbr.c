@@ -105,6 +105,9 @@ void clearRepeat(const struct RepeatInfo *info, struct lbr_state *lstate) {
     case REPEAT_TRAILER:
         lstate->ctrl.trailer.offset = REPEAT_DEAD;
         break;
+    case REPEAT_WINDOW:
+        lstate->ctrl.window.offset = REPEAT_DEAD;
+        break;
     default:
         assert(0);
         break;
@@ -130,6 +133,8 @@ char repeatIsDead(const struct RepeatInfo *info,
         return lstate->ctrl.ring.offset == REPEAT_DEAD;
     case REPEAT_TRAILER:
         return lstate->ctrl.trailer.offset == REPEAT_DEAD;
+    case REPEAT_WINDOW:
+        return lstate->ctrl.window.offset == REPEAT_DEAD;
     }
 
     assert(0);
@@ -53,6 +53,7 @@
 #include "util/graph.h"
 #include "util/graph_range.h"
 #include "util/order_check.h"
+#include "util/state_compress.h"
 #include "util/verify_types.h"
 #include "util/ue2_containers.h"
 
@@ -1011,28 +1012,26 @@ void setNfaFlag(NFA *nfa, u32 flag) {
 }
 
 // Some of our NFA types support compressing the state down if we're not using
-// all of it.
-template<class implNFA_t>
+// all of it. Returns true if the state is to be compressed, with the states
+// to mask off before compression in maskedStates.
 static
-void findStateSize(const build_info &args, implNFA_t *limex) {
-    // Nothing is masked off by default.
-    maskFill(limex->compressMask, 0xff);
+bool findStateCompression(const build_info &args, NFAStateSet &maskedStates,
+                          u32 *stateSize) {
+    maskedStates.reset();
 
     u32 sizeUncompressed = uncompressedStateSize(args.num_states);
-    assert(sizeUncompressed <= sizeof(limex->compressMask));
+    *stateSize = sizeUncompressed;
 
     if (!args.stateCompression) {
         DEBUG_PRINTF("compression disabled, uncompressed state size %u\n",
                      sizeUncompressed);
-        limex->stateSize = sizeUncompressed;
-        return;
+        return false;
     }
 
-    NFAStateSet maskedStates(args.num_states);
-    findMaskedCompressionStates(args, maskedStates);
+    NFAStateSet masked(args.num_states);
+    findMaskedCompressionStates(args, masked);
 
-    u32 sizeCompressed = compressedStateSize(args.h, maskedStates, args.state_ids);
-    assert(sizeCompressed <= sizeof(limex->compressMask));
+    u32 sizeCompressed = compressedStateSize(args.h, masked, args.state_ids);
 
     DEBUG_PRINTF("compressed=%u, uncompressed=%u\n", sizeCompressed,
                  sizeUncompressed);
@@ -1041,22 +1040,75 @@ void findStateSize(const build_info &args, implNFA_t *limex) {
     if ((sizeCompressed * 100) <= (sizeUncompressed * 90)) {
         DEBUG_PRINTF("using compression, state size %u\n",
                      sizeCompressed);
-        setLimexFlag(limex, LIMEX_FLAG_COMPRESS_STATE);
-        limex->stateSize = sizeCompressed;
+        *stateSize = sizeCompressed;
+        maskedStates = masked;
+        return true;
+    }
 
+    DEBUG_PRINTF("not using compression, state size %u\n",
+                 sizeUncompressed);
+    return false;
+}
+
+template<class implNFA_t>
+static
+void writeStateSize(bool compress, const NFAStateSet &maskedStates,
+                    u32 stateSize, implNFA_t *limex) {
+    // Nothing is masked off by default.
+    maskFill(limex->compressMask, 0xff);
+    assert(stateSize <= sizeof(limex->compressMask));
+    limex->stateSize = stateSize;
+
+    if (!compress) {
+        return;
+    }
+
+    setLimexFlag(limex, LIMEX_FLAG_COMPRESS_STATE);
+
+    if (maskedStates.any()) {
+        DEBUG_PRINTF("masking %zu states\n", maskedStates.count());
+        setLimexFlag(limex, LIMEX_FLAG_COMPRESS_MASKED);
+        for (size_t i = maskedStates.find_first(); i != NFAStateSet::npos;
+                i = maskedStates.find_next(i)) {
+            maskClearBit(limex->compressMask, i);
+        }
+    }
+}
+
+/**
+ * \brief Computes the layout of state compressed under each reach mask (less
+ * any masked states), as used by the 128-bit and wider runtimes.
+ */
+static
+vector<compress_chunks> buildCompressChunks(const vector<NFAStateSet> &reach,
+                                            const NFAStateSet &maskedStates,
+                                            u32 chunks) {
+    assert(chunks <= ARRAY_LENGTH(compress_chunks().bits));
+    vector<compress_chunks> out;
+    out.reserve(reach.size());
+
+    for (const auto &r : reach) {
+        NFAStateSet m = r;
         if (maskedStates.any()) {
-            DEBUG_PRINTF("masking %zu states\n", maskedStates.count());
-            setLimexFlag(limex, LIMEX_FLAG_COMPRESS_MASKED);
-            for (size_t i = maskedStates.find_first(); i != NFAStateSet::npos;
-                    i = maskedStates.find_next(i)) {
-                maskClearBit(limex->compressMask, i);
-            }
+            m &= ~maskedStates;
         }
-    } else {
-        DEBUG_PRINTF("not using compression, state size %u\n",
-                     sizeUncompressed);
-        limex->stateSize = sizeUncompressed;
+
+        compress_chunks c;
+        memset(&c, 0, sizeof(c));
+        for (size_t i = m.find_first(); i != m.npos; i = m.find_next(i)) {
+            assert(i / 64 < chunks);
+            c.bits[i / 64]++;
+        }
+
+        u32 offset = 0;
+        for (u32 i = 0; i < chunks; i++) {
+            c.offset[i] = verify_u16(offset);
+            offset += c.bits[i];
+        }
+        out.push_back(c);
     }
+
+    return out;
 }
 
 /*
@@ -1536,10 +1588,19 @@ struct Factory {
                                     : repeatOffsets[proto.repeat_index];
             e.repeatOffset = repeat_offset;
 
+            // Exceptions with no repeat trigger and no reports only switch
+            // on successors and squash states, so the runtime can apply them
+            // as a batch.
+            bool plain = proto.trigger == LIMEX_TRIGGER_NONE &&
+                         proto.reports_index == MO_INVALID_IDX;
+
             // for each state that can switch it on
             for (auto state_id : states) {
                 // set this bit in the exception mask
                 maskSetBit(limex->exceptionMask, state_id);
+                if (plain) {
+                    maskSetBit(limex->exceptionPlainMask, state_id);
+                }
                 // set this index in the exception map
                 limex->exceptionMap[state_id] = ecount;
             }
@@ -1584,6 +1645,20 @@ struct Factory {
         limex->topCount = verify_u32(tops.size());
     }
 
+    static
+    void writeCompressChunks(const vector<compress_chunks> &compressChunks,
+                             implNFA_t *limex, const u32 chunksOffset) {
+        if (compressChunks.empty()) {
+            limex->compressChunkOffset = 0;
+            return;
+        }
+
+        DEBUG_PRINTF("compressChunksOffset=%u\n", chunksOffset);
+        assert(compressChunks.size() == limex->reachSize);
+        limex->compressChunkOffset = chunksOffset;
+        copy_bytes((char *)limex + chunksOffset, compressChunks);
+    }
+
     static
     void writeAccelSsse3Masks(const NFAStateSet &accelMask, implNFA_t *limex) {
         char *perm_base = (char *)&limex->accelPermute;
@@ -1776,6 +1851,19 @@ struct Factory {
         vector<u8> accelTable;
         buildAccel(args, accelMask, accelFriendsMask, accelAux, accelTable);
 
+        // Determine the state required for our state vector.
+        NFAStateSet maskedStates(args.num_states);
+        u32 stateSize = 0;
+        bool compress = findStateCompression(args, maskedStates, &stateSize);
+
+        // Wide NFAs compress their state a 64-bit chunk at a time, using a
+        // layout computed here for each reach mask.
+        vector<compress_chunks> compressChunks;
+        if (compress && sizeof(tableRow_t) >= sizeof(m128)) {
+            compressChunks = buildCompressChunks(reach, maskedStates,
+                                                 sizeof(tableRow_t) / 8);
+        }
+
         // Compute the offsets in the bytecode for this LimEx NFA for all of
         // our structures. First, the NFA and LimEx structures. All other
         // offsets are relative to the start of the LimEx struct, starting with
@@ -1788,6 +1876,10 @@ struct Factory {
         const u32 topsOffset = offset;
         offset += sizeof(tableRow_t) * tops.size();
 
+        offset = ROUNDUP_N(offset, alignof(compress_chunks));
+        const u32 compressChunksOffset = offset;
+        offset += sizeof(compress_chunks) * compressChunks.size();
+
         const u32 accelTableOffset = offset;
         offset += sizeof(u8) * accelTable.size();
 
@@ -1841,8 +1933,8 @@ struct Factory {
 
         writeShiftMasks(args, limex);
 
-        // Determine the state required for our state vector.
-        findStateSize(args, limex);
+        writeStateSize(compress, maskedStates, stateSize, limex);
+        writeCompressChunks(compressChunks, limex, compressChunksOffset);
 
         writeExceptionReports(exceptionReports, limex, exceptionReportsOffset);
 
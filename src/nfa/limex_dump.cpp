@@ -258,6 +258,7 @@ void dumpLimexText(const limex_type *limex, FILE *f) {
              size);
     dumpMask(f, "compress_mask", (const u8 *)&limex->compressMask, size);
     dumpMask(f, "emask", (const u8 *)&limex->exceptionMask, size);
+    dumpMask(f, "eplain", (const u8 *)&limex->exceptionPlainMask, size);
     dumpMask(f, "zombie", (const u8 *)&limex->zombieMask, size);
 
     // Dump top masks, if there are any.
@@ -44,6 +44,7 @@
 #define PE_FN                   JOIN(processExceptional, SIZE)
 #define RUN_EXCEPTION_FN        JOIN(runException, SIZE)
 #define ZERO_STATE              JOIN(zero_, STATE_T)
+#define ONES_STATE              JOIN(ones_, STATE_T)
 #define LOAD_STATE              JOIN(load_, STATE_T)
 #define STORE_STATE             JOIN(store_, STATE_T)
 #define AND_STATE               JOIN(and_, STATE_T)
@@ -235,17 +236,28 @@ int PE_FN(STATE_ARG, ESTATE_ARG, u32 diffmask, STATE_T *succ,
     STORE_STATE(&ctx->local_succ, ZERO_STATE);
 #endif
 
-    // A copy of the estate as an array of GPR-sized chunks.
+    // A copy of the estate as an array of GPR-sized chunks, split into the
+    // plain exceptions (no trigger, no reports) and the rest.
+    const STATE_T plain = AND_STATE(estate,
+                                    LOAD_STATE(&limex->exceptionPlainMask));
     CHUNK_T chunks[sizeof(STATE_T) / sizeof(CHUNK_T)];
+    CHUNK_T plain_chunks[sizeof(STATE_T) / sizeof(CHUNK_T)];
 #ifdef ESTATE_ON_STACK
     memcpy(chunks, &estate, sizeof(STATE_T));
 #else
     memcpy(chunks, estatep, sizeof(STATE_T));
 #endif
+    memcpy(plain_chunks, &plain, sizeof(STATE_T));
 
     struct proto_cache new_cache = {0, NULL};
     enum CacheResult cacheable = CACHE_RESULT;
 
+    // Plain exceptions only switch on successors and squash states, which
+    // commute with everything else done here, so we accumulate them into a
+    // single OR and a single AND rather than running each one in turn.
+    STATE_T plain_succ = ZERO_STATE;
+    STATE_T plain_squash = ONES_STATE;
+
     do {
         u32 t = findAndClearLSB_32(&diffmask);
 #ifdef ARCH_64_BIT
@@ -255,7 +267,17 @@ int PE_FN(STATE_ARG, ESTATE_ARG, u32 diffmask, STATE_T *succ,
         CHUNK_T word = chunks[t];
         assert(word != 0);
         u32 base = t * sizeof(CHUNK_T) * 8;
-        do {
+
+        CHUNK_T plain_word = plain_chunks[t];
+        word &= ~plain_word;
+        while (plain_word) {
+            u32 bit = FIND_AND_CLEAR_FN(&plain_word) + base;
+            const EXCEPTION_T *e = &exceptions[exceptionMap[bit]];
+            plain_succ = OR_STATE(plain_succ, LOAD_STATE(&e->successors));
+            plain_squash = AND_STATE(plain_squash, LOAD_STATE(&e->squash));
+        }
+
+        while (word) {
             u32 bit = FIND_AND_CLEAR_FN(&word) + base;
             u32 idx = exceptionMap[bit];
             const EXCEPTION_T *e = &exceptions[idx];
@@ -268,12 +290,22 @@ int PE_FN(STATE_ARG, ESTATE_ARG, u32 diffmask, STATE_T *succ,
                                   &cacheable, in_rev, flags)) {
                 return PE_RV_HALT;
             }
-        } while (word);
+        }
     } while (diffmask);
 
+    if (!EQ_STATE(plain_squash, ONES_STATE)) {
+        STORE_STATE(succ, AND_STATE(LOAD_STATE(succ), plain_squash));
+        if (cacheable == CACHE_RESULT) {
+            cacheable = DO_NOT_CACHE_RESULT;
+        }
+    }
+
 #ifndef BIG_MODEL
+    local_succ = OR_STATE(local_succ, plain_succ);
     STORE_STATE(succ, OR_STATE(LOAD_STATE(succ), local_succ));
 #else
+    STORE_STATE(&ctx->local_succ, OR_STATE(LOAD_STATE(&ctx->local_succ),
+                                           plain_succ));
     STORE_STATE(succ, OR_STATE(LOAD_STATE(succ), ctx->local_succ));
 #endif
 
@@ -298,6 +330,7 @@ int PE_FN(STATE_ARG, ESTATE_ARG, u32 diffmask, STATE_T *succ,
 #endif
 
 #undef ZERO_STATE
+#undef ONES_STATE
 #undef AND_STATE
 #undef EQ_STATE
 #undef OR_STATE
@@ -39,6 +39,9 @@
             NFACommonXXX.reachMap.
         Tops
             Variable length array of state bitvectors, used for TOP_N events.
+        Compression layouts
+            Variable length array of compress_chunks structs, one per reach
+            entry, for NFAs of 128 states and up with compressed state.
         Acceleration structures
             Variable length array of AccelAux structs.
         Accepts
@@ -154,6 +157,8 @@ struct LimExNFA##size { /* MUST align with LimExNFABase */                  \
     u32 squashCount;                                                        \
     u32 topCount;                                                           \
     u32 topOffset; /* rel. to start of LimExNFA */                          \
+    u32 compressChunkOffset; /**< rel. to start of LimExNFA, or 0: one      \
+                              *  compress_chunks per reach entry */         \
     u32 stateSize; /**< not including extended history */                   \
     u32 flags;                                                              \
     u_##size init;                                                          \
@@ -167,6 +172,8 @@ struct LimExNFA##size { /* MUST align with LimExNFABase */                  \
                                     *  followers */                         \
     u_##size compressMask; /**< switch off before compress */               \
     u_##size exceptionMask;                                                 \
+    u_##size exceptionPlainMask; /**< exception states with no trigger or
+                                  *  reports, applied as a batch */         \
     u_##size repeatCyclicMask;                                              \
     u_##size shift[MAX_MAX_SHIFT];                                          \
     u_##size zombieMask; /**< zombie if in any of the set states */         \
@@ -102,7 +102,27 @@ int processExceptional32(u32 s, u32 estate, UNUSED u32 diffmask, u32 *succ,
     /* Note that only exception-states that consist of exceptions that _only_
      * set successors (not fire accepts or squash states) are cacheable. */
 
-    do {
+    /* Plain exceptions (no trigger, no reports) just switch on successors and
+     * squash states, which commute with everything else we do here, so we
+     * can accumulate them without the full runException32 treatment. */
+    u32 plain = estate & limex->exceptionPlainMask;
+    if (plain) {
+        estate &= ~plain;
+        u32 squash = ~0U;
+        do {
+            u32 bit = findAndClearLSB_32(&plain);
+            const struct NFAException32 *e = &exceptions[exceptionMap[bit]];
+            local_succ |= e->successors;
+            squash &= e->squash;
+        } while (plain);
+
+        if (squash != ~0U) {
+            *succ &= squash;
+            cacheable = DO_NOT_CACHE_RESULT;
+        }
+    }
+
+    while (estate) {
         u32 bit = findAndClearLSB_32(&estate);
         u32 idx = exceptionMap[bit];
         const struct NFAException32 *e = &exceptions[idx];
@@ -110,7 +130,7 @@ int processExceptional32(u32 s, u32 estate, UNUSED u32 diffmask, u32 *succ,
                             ctx, &new_cache, &cacheable, in_rev, flags)) {
             return PE_RV_HALT;
         }
-    } while (estate != 0);
+    }
 
     *succ |= local_succ;
 
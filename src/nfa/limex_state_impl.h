@@ -46,6 +46,10 @@
 #define EXPAND_FN           JOIN(moNfaExpandState, SIZE)
 #define COMPRESSED_STORE_FN JOIN(storecompressed, SIZE)
 #define COMPRESSED_LOAD_FN  JOIN(loadcompressed, SIZE)
+#define CHUNKS_STORE_FN     JOIN(storecompressed, JOIN(SIZE, _chunks))
+#define CHUNKS_LOAD_FN      JOIN(loadcompressed, JOIN(SIZE, _chunks))
+#define STORE_COMPRESSED_FN     JOIN(moNfaStoreCompressed, SIZE)
+#define LOAD_COMPRESSED_FN      JOIN(moNfaLoadCompressed, SIZE)
 #define PARTIAL_STORE_FN    JOIN(partial_store_, STATE_T)
 #define PARTIAL_LOAD_FN     JOIN(partial_load_, STATE_T)
 #define LOAD_STATE          JOIN(load_, STATE_T)
@@ -62,6 +66,36 @@ const STATE_T *REACHMASK_FN(const IMPL_NFA_T *limex, const u8 key) {
     return &reach[limex->reachMap[key]];
 }
 
+/* Wide engines have the layout of each compression mask precomputed, one per
+ * reach entry; see LimExNFA::compressChunkOffset. */
+static really_inline
+void STORE_COMPRESSED_FN(const IMPL_NFA_T *limex, u8 *dest, const STATE_T *src,
+                     const STATE_T *mask, u8 key) {
+#if SIZE >= 128
+    assert(limex->compressChunkOffset);
+    const struct compress_chunks *chunks = (const struct compress_chunks *)
+        ((const char *)limex + limex->compressChunkOffset);
+    CHUNKS_STORE_FN(dest, src, mask, &chunks[limex->reachMap[key]]);
+#else
+    (void)key;
+    COMPRESSED_STORE_FN(dest, src, mask, limex->stateSize);
+#endif
+}
+
+static really_inline
+void LOAD_COMPRESSED_FN(const IMPL_NFA_T *limex, STATE_T *dest, const u8 *src,
+                    const STATE_T *mask, u8 key) {
+#if SIZE >= 128
+    assert(limex->compressChunkOffset);
+    const struct compress_chunks *chunks = (const struct compress_chunks *)
+        ((const char *)limex + limex->compressChunkOffset);
+    CHUNKS_LOAD_FN(dest, src, mask, &chunks[limex->reachMap[key]]);
+#else
+    (void)key;
+    COMPRESSED_LOAD_FN(dest, src, mask, limex->stateSize);
+#endif
+}
+
 static really_inline
 void COMPRESS_FN(const IMPL_NFA_T *limex, u8 *dest, const STATE_T *src,
                  u8 key) {
@@ -92,9 +126,9 @@ void COMPRESS_FN(const IMPL_NFA_T *limex, u8 *dest, const STATE_T *src,
 
             STATE_T mask = AND_STATE(LOAD_STATE(&limex->compressMask),
                                      LOAD_STATE(reachmask));
-            COMPRESSED_STORE_FN(dest, &s, &mask, limex->stateSize);
+            STORE_COMPRESSED_FN(limex, dest, &s, &mask, key);
         } else {
-            COMPRESSED_STORE_FN(dest, src, reachmask, limex->stateSize);
+            STORE_COMPRESSED_FN(limex, dest, src, reachmask, key);
         }
     }
 }
@@ -116,11 +150,11 @@ void EXPAND_FN(const IMPL_NFA_T *limex, STATE_T *dest, const u8 *src,
         if (limex->flags & LIMEX_FLAG_COMPRESS_MASKED) {
             STATE_T mask = AND_STATE(LOAD_STATE(&limex->compressMask),
                                      LOAD_STATE(reachmask));
-            COMPRESSED_LOAD_FN(dest, src, &mask, limex->stateSize);
+            LOAD_COMPRESSED_FN(limex, dest, src, &mask, key);
             STORE_STATE(dest, OR_STATE(LOAD_STATE(&limex->initDS),
                         LOAD_STATE(dest)));
         } else {
-            COMPRESSED_LOAD_FN(dest, src, reachmask, limex->stateSize);
+            LOAD_COMPRESSED_FN(limex, dest, src, reachmask, key);
         }
     }
 }
@@ -132,6 +166,10 @@ void EXPAND_FN(const IMPL_NFA_T *limex, STATE_T *dest, const u8 *src,
 #undef EXPAND_FN
 #undef COMPRESSED_STORE_FN
 #undef COMPRESSED_LOAD_FN
+#undef CHUNKS_STORE_FN
+#undef CHUNKS_LOAD_FN
+#undef STORE_COMPRESSED_FN
+#undef LOAD_COMPRESSED_FN
 #undef PARTIAL_STORE_FN
 #undef PARTIAL_LOAD_FN
 #undef LOAD_STATE
@@ -37,6 +37,7 @@
 #include "ue2common.h"
 #include "vermicelli.h"
 #include "vermicelli_run.h"
+#include "util/bitutils.h"
 #include "util/multibit.h"
 #include "util/partial_store.h"
 #include "util/simd_utils.h"
@@ -88,15 +89,94 @@ void normalize_counters(struct mpv_decomp_state *dstate, const struct mpv *m) {
         return;
     }
 
-    for (u32 i = 0; i < m->counter_count; i++) {
-        /* update all counters - alive or dead */
+    /* update all counters - alive or dead; they are laid out contiguously in
+     * the decompressed state, so we can do two at a time */
+    u32 i = 0;
+    m128 adj2 = set2x64(adj);
+    for (; i + 2 <= m->counter_count; i += 2) {
+        storeu128(&counters[i], add2x64(loadu128(&counters[i]), adj2));
+    }
+    for (; i < m->counter_count; i++) {
         counters[i] += adj;
+    }
+
+#ifdef DEBUG
+    for (i = 0; i < m->counter_count; i++) {
         DEBUG_PRINTF("counter %u: %llu\n", i, counters[i]);
     }
+#endif
 
     dstate->counter_adj = 0;
 }
 
+/**
+ * \brief Fires the reports for one kilo using the batched threshold arrays.
+ *
+ * Equivalent to walking from \a curr down to the kilo's sentinel, but the
+ * threshold compares are done four puffettes at a time. Reports are still
+ * fired in descending puffette order.
+ */
+static really_inline
+char processKiloReportsBatch(const struct mpv *m,
+                             const struct mpv_kilopuff *kp,
+                             const struct mpv_puffette *curr,
+                             u64a counter_val, u64a report_offset,
+                             NfaCallback cb, void *ctxt, ReportID **rl,
+                             u32 *rl_count, char *did_stuff) {
+    const struct mpv_puffette *pbase = get_puff_base(m);
+    const u32 *repeats = get_batch_repeats(m);
+    const u32 *unbounded = get_batch_unbounded(m);
+
+    const u32 lo = get_puff_array(m, kp) - pbase;
+    const u32 hi = curr - pbase;
+    assert(hi >= lo);
+
+    /* a counter beyond 32 bits can only satisfy unbounded puffettes */
+    const u32 eq_mask = counter_val <= ~0U ? 0xf : 0;
+    const m128 cv = set4x32((u32)counter_val);
+    const m128 zero = zeroes128();
+
+    u32 j = hi & ~3U;
+    u32 range = (2U << (hi - j)) - 1;
+    for (;;) {
+        if (lo > j) {
+            range &= ~((1U << (lo - j)) - 1);
+        }
+
+        u32 fire = (~diffrich128(loadu128(repeats + j), cv) & eq_mask)
+                 | diffrich128(loadu128(unbounded + j), zero);
+        fire &= range;
+
+        while (fire) {
+            u32 k = findAndClearMSB_32(&fire);
+            const struct mpv_puffette *p = pbase + j + k;
+            assert(counter_val >= p->repeats);
+            DEBUG_PRINTF("report %u at %llu\n", p->report, report_offset);
+
+            if (p->unbounded) {
+                assert(*rl_count < m->puffette_count);
+                **rl = p->report;
+                ++*rl;
+                ++*rl_count;
+            }
+
+            if (cb(report_offset, p->report, ctxt) == MO_HALT_MATCHING) {
+                DEBUG_PRINTF("bailing\n");
+                return MO_HALT_MATCHING;
+            }
+            *did_stuff = 1;
+        }
+
+        if (j <= lo) {
+            break;
+        }
+        j -= 4;
+        range = 0xf;
+    }
+
+    return MO_CONTINUE_MATCHING;
+}
+
 static really_inline
 char processReports(const struct mpv *m, u8 *reporters,
                     const struct mpv_decomp_state *dstate, u64a counter_adj,
@@ -118,27 +198,37 @@ char processReports(const struct mpv *m, u8 *reporters,
                                                      * is -1 */
         char did_stuff = 0;
 
-        while (curr->report != INVALID_REPORT) {
-            assert(curr_counter_val >= curr->repeats);
-            if (curr->unbounded || curr_counter_val == curr->repeats) {
-                DEBUG_PRINTF("report %u at %llu\n", curr->report,
-                              report_offset);
-
-                if (curr->unbounded) {
-                    assert(rl_count < m->puffette_count);
-                    *rl = curr->report;
-                    ++rl;
-                    rl_count++;
+        if (m->batch_offset && curr->report != INVALID_REPORT) {
+            if (processKiloReportsBatch(m, &kp[i], curr, curr_counter_val,
+                                        report_offset, cb, ctxt, &rl,
+                                        &rl_count, &did_stuff)
+                == MO_HALT_MATCHING) {
+                return MO_HALT_MATCHING;
+            }
+        } else {
+            while (curr->report != INVALID_REPORT) {
+                assert(curr_counter_val >= curr->repeats);
+                if (curr->unbounded || curr_counter_val == curr->repeats) {
+                    DEBUG_PRINTF("report %u at %llu\n", curr->report,
+                                  report_offset);
+
+                    if (curr->unbounded) {
+                        assert(rl_count < m->puffette_count);
+                        *rl = curr->report;
+                        ++rl;
+                        rl_count++;
+                    }
+
+                    if (cb(report_offset, curr->report, ctxt)
+                        == MO_HALT_MATCHING) {
+                        DEBUG_PRINTF("bailing\n");
+                        return MO_HALT_MATCHING;
+                    }
+                    did_stuff = 1;
                 }
 
-                if (cb(report_offset, curr->report, ctxt) == MO_HALT_MATCHING) {
-                    DEBUG_PRINTF("bailing\n");
-                    return MO_HALT_MATCHING;
-                }
-                did_stuff = 1;
+                curr--;
             }
-
-            curr--;
         }
 
         if (!did_stuff) {
@@ -392,7 +482,7 @@ void handleTopN(const struct mpv *m, s64a loc, u8 *active, u8 *reporters,
     /* setup puffette, find next trigger */
     dstate->active[i].curr = get_init_puff(m, &kp[i]);
     if (dstate->active[i].curr[1].report != INVALID_REPORT) {
-        u32 next_trigger = dstate->active[i].curr[1].repeats - 1ULL + loc;
+        u64a next_trigger = dstate->active[i].curr[1].repeats - 1ULL + loc;
         lim = MIN(lim, next_trigger);
     }
 
@@ -658,7 +748,7 @@ void restartKilo(const struct mpv *m, UNUSED u8 *active, u8 *reporters,
     dstate->active[i].limit = lim;
 
     if (dstate->active[i].curr[1].report != INVALID_REPORT) {
-        u32 next_trigger = dstate->active[i].curr[1].repeats + prev_limit;
+        u64a next_trigger = dstate->active[i].curr[1].repeats + prev_limit;
         lim = MIN(lim, next_trigger);
     }
 
@@ -133,6 +133,7 @@ void nfaExecMpv0_dumpText(const NFA *nfa, FILE *f) {
             m->kilo_count);
     fprintf(f, "initial kilopuffs %u - %u\n", m->top_kilo_begin,
             m->top_kilo_end - 1);
+    fprintf(f, "batched report checks: %s\n", m->batch_offset ? "yes" : "no");
 
     const mpv_kilopuff *k = (const mpv_kilopuff *)(m + 1);
     for (u32 i = 0; i < m->kilo_count; i++) {
@@ -92,6 +92,8 @@ struct ALIGN_AVX_DIRECTIVE mpv {
     u32 top_kilo_begin; /**< first kilo to switch on when top arrives */
     u32 top_kilo_end; /**< one past the last kilo to switch on when top
                        * arrives */
+    u32 batch_offset; /**< offset (rel. to mpv) to the batched puffette
+                       * threshold arrays, or 0 if not present */
 };
 
 struct mpv_decomp_kilo {
@@ -136,6 +138,11 @@ struct mpv_decomp_state {
  * ---
  * | | sentinel mpv_puffette
  * ---
+ * | | (optional, when mpv::batch_offset is non-zero)
+ * | | u32 repeats for every puffette above, sentinels included
+ * | | u32 unbounded masks (0 or ~0) for every puffette above
+ * | | (both arrays padded to a multiple of four entries)
+ * ---
  */
 
 /*
@@ -176,6 +183,31 @@ const struct mpv_puffette *get_puff_array(const struct mpv *m,
     return (const struct mpv_puffette *)((const char *)m + kp->puffette_offset);
 }
 
+/* returns pointer to the initial sentinel, which begins the puffette array */
+static really_inline
+const struct mpv_puffette *get_puff_base(const struct mpv *m) {
+    const struct mpv_kilopuff *kp = (const struct mpv_kilopuff *)(m + 1);
+    return get_puff_array(m, kp) - 1;
+}
+
+/** \brief Number of entries in each batched puffette array. */
+static really_inline
+u32 mpv_batch_len(const struct mpv *m) {
+    /* real puffettes, a sentinel per kilo and the initial sentinel */
+    return ROUNDUP_N(m->puffette_count + m->kilo_count + 1, 4);
+}
+
+static really_inline
+const u32 *get_batch_repeats(const struct mpv *m) {
+    assert(m->batch_offset);
+    return (const u32 *)((const char *)m + m->batch_offset);
+}
+
+static really_inline
+const u32 *get_batch_unbounded(const struct mpv *m) {
+    return get_batch_repeats(m) + mpv_batch_len(m);
+}
+
 static really_inline
 const struct mpv_counter_info *get_counter_info(const struct mpv *m) {
     return (const struct mpv_counter_info *)((const char *)(m + 1)
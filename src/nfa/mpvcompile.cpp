@@ -33,6 +33,7 @@
 #include "nfa_internal.h"
 #include "shufticompile.h"
 #include "trufflecompile.h"
+#include "grey.h"
 #include "util/alloc.h"
 #include "util/multibit_internal.h"
 #include "util/order_check.h"
@@ -124,6 +125,23 @@ size_t calcSize(const map<ClusterKey, vector<raw_puff>> &raw,
     return len;
 }
 
+/** \brief Writes the batched threshold arrays (see mpv_internal.h) from the
+ * puffette array that has already been written at \a pa_base. */
+static
+void writeBatchArrays(mpv *m, const mpv_puffette *pa_base) {
+    const u32 batch_len = mpv_batch_len(m);
+    u32 *repeats = (u32 *)((char *)m + m->batch_offset);
+    u32 *unbounded = repeats + batch_len;
+
+    const u32 puff_len = m->puffette_count + m->kilo_count + 1;
+    for (u32 i = 0; i < puff_len; i++) {
+        repeats[i] = pa_base[i].repeats;
+        unbounded[i] = pa_base[i].unbounded ? ~0U : 0;
+    }
+    /* padding entries are zeroed by the allocator and are masked off by the
+     * runtime anyway */
+}
+
 static
 void populateClusters(const vector<raw_puff> &puffs_in,
                       const vector<raw_puff> &triggered_puffs,
@@ -301,7 +319,8 @@ const mpv_counter_info &findCounter(const vector<mpv_counter_info> &counters,
 }
 
 aligned_unique_ptr<NFA> mpvCompile(const vector<raw_puff> &puffs_in,
-                                   const vector<raw_puff> &triggered_puffs) {
+                                   const vector<raw_puff> &triggered_puffs,
+                                   const Grey &grey) {
     assert(!puffs_in.empty() || !triggered_puffs.empty());
     u32 puffette_count = puffs_in.size() + triggered_puffs.size();
 
@@ -330,6 +349,19 @@ aligned_unique_ptr<NFA> mpvCompile(const vector<raw_puff> &puffs_in,
     curr_comp_offset += mmbit_size(puff_clusters.size());
 
     u32 len = calcSize(puff_clusters, counters);
+    UNUSED const u32 puff_end = len;
+
+    /* large mpvs also carry their puffette thresholds as flat arrays so that
+     * report checks can be done a vector at a time */
+    u32 batch_offset = 0;
+    if (puffette_count >= grey.mpvBatchMinPuffettes) {
+        len = ROUNDUP_N(len, 16);
+        batch_offset = len - sizeof(NFA);
+        u32 batch_len = ROUNDUP_N(puffette_count + puff_clusters.size() + 1,
+                                  4);
+        len += 2 * sizeof(u32) * batch_len;
+        DEBUG_PRINTF("batch arrays at offset %u\n", batch_offset);
+    }
 
     DEBUG_PRINTF("%u puffs, len = %u\n", puffette_count, len);
 
@@ -363,6 +395,7 @@ aligned_unique_ptr<NFA> mpvCompile(const vector<raw_puff> &puffs_in,
     m->active_offset = active_offset;
     m->top_kilo_begin = verify_u32(triggered_puffs.size());
     m->top_kilo_end = verify_u32(puff_clusters.size());
+    m->batch_offset = batch_offset;
 
     mpv_kilopuff *kp_begin = (mpv_kilopuff *)(m + 1);
     mpv_kilopuff *kp = kp_begin;
@@ -371,7 +404,11 @@ aligned_unique_ptr<NFA> mpvCompile(const vector<raw_puff> &puffs_in,
                       m, kp, &pa);
         ++kp;
     }
-    assert((char *)pa == (char *)nfa.get() + len);
+    assert((char *)pa == (char *)nfa.get() + puff_end);
+
+    if (batch_offset) {
+        writeBatchArrays(m, pa_base);
+    }
 
     mpv_counter_info *out_ci = (mpv_counter_info *)kp;
     for (const auto &counter : counters) {
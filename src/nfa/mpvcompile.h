@@ -40,6 +40,8 @@ struct NFA;
 
 namespace ue2 {
 
+struct Grey;
+
 struct raw_puff {
     raw_puff(u32 repeats_in, bool unbounded_in, ReportID report_in,
              const CharReach &reach_in, bool auto_restart_in = false)
@@ -58,7 +60,7 @@ struct raw_puff {
  */
 aligned_unique_ptr<NFA>
 mpvCompile(const std::vector<raw_puff> &puffs,
-           const std::vector<raw_puff> &triggered_puffs);
+           const std::vector<raw_puff> &triggered_puffs, const Grey &grey);
 
 } // namespace ue2
 
@@ -33,6 +33,8 @@
 
 #include "nfa_api_queue.h"
 #include "nfa_internal.h"
+#include "profile.h"
+#include "scratch.h"
 #include "ue2common.h"
 
 // Engine implementations.
@@ -42,6 +44,7 @@
 #include "limex.h"
 #include "mcclellan.h"
 #include "mpv.h"
+#include "tamarama.h"
 
 #define DISPATCH_CASE(dc_ltype, dc_ftype, dc_subtype, dc_func_call) \
     case dc_ltype##_NFA_##dc_subtype:                               \
@@ -98,6 +101,7 @@
         DISPATCH_CASE(LBR, Lbr, Shuf, dbnt_func);             \
         DISPATCH_CASE(LBR, Lbr, Truf, dbnt_func);             \
         DISPATCH_CASE(CASTLE, Castle, 0, dbnt_func);          \
+        DISPATCH_CASE(TAMARAMA, Tamarama, 0, dbnt_func);      \
     default:                                                  \
         assert(0);                                            \
     }
@@ -141,6 +145,61 @@ char nfaQueueExecRose_i(const struct NFA *nfa, struct mq *q, ReportID report) {
     return 0;
 }
 
+#ifdef PROFILE_SUPPORT
+static really_inline
+struct hs_profile *queueProfile(const struct mq *q) {
+    return q->scratch ? q->scratch->profile : NULL;
+}
+#endif
+
+/* The _p variants charge the engine's run to its queue in the attached scan
+ * cost profile, if any. */
+
+static really_inline
+char nfaQueueExec_p(const struct NFA *nfa, struct mq *q, s64a end) {
+#ifdef PROFILE_SUPPORT
+    struct hs_profile *prof = queueProfile(q);
+    if (unlikely(prof != NULL)) {
+        struct profile_section ps;
+        profileBegin(prof, &ps);
+        char rv = nfaQueueExec_i(nfa, q, end);
+        profileEndQueue(prof, &ps, nfa->queueIndex);
+        return rv;
+    }
+#endif
+    return nfaQueueExec_i(nfa, q, end);
+}
+
+static really_inline
+char nfaQueueExec2_p(const struct NFA *nfa, struct mq *q, s64a end) {
+#ifdef PROFILE_SUPPORT
+    struct hs_profile *prof = queueProfile(q);
+    if (unlikely(prof != NULL)) {
+        struct profile_section ps;
+        profileBegin(prof, &ps);
+        char rv = nfaQueueExec2_i(nfa, q, end);
+        profileEndQueue(prof, &ps, nfa->queueIndex);
+        return rv;
+    }
+#endif
+    return nfaQueueExec2_i(nfa, q, end);
+}
+
+static really_inline
+char nfaQueueExecRose_p(const struct NFA *nfa, struct mq *q, ReportID report) {
+#ifdef PROFILE_SUPPORT
+    struct hs_profile *prof = queueProfile(q);
+    if (unlikely(prof != NULL)) {
+        struct profile_section ps;
+        profileBegin(prof, &ps);
+        char rv = nfaQueueExecRose_i(nfa, q, report);
+        profileEndQueue(prof, &ps, nfa->queueIndex);
+        return rv;
+    }
+#endif
+    return nfaQueueExecRose_i(nfa, q, report);
+}
+
 /** Returns 0 if this NFA cannot possibly match (due to width constraints etc)
  * and the caller should return 0. May also edit the queue. */
 static really_inline
@@ -239,7 +298,7 @@ char nfaQueueExec(const struct NFA *nfa, struct mq *q, s64a end) {
         return 0;
     }
 
-    char rv = nfaQueueExec_i(nfa, q, end);
+    char rv = nfaQueueExec_p(nfa, q, end);
 
 #ifdef DEBUG
     debugQueue(q);
@@ -289,7 +348,7 @@ char nfaQueueExecToMatch(const struct NFA *nfa, struct mq *q, s64a end) {
         return 0;
     }
 
-    char rv = nfaQueueExec2_i(nfa, q, end);
+    char rv = nfaQueueExec2_p(nfa, q, end);
     assert(!q->report_current);
     DEBUG_PRINTF("returned rv=%d, q_trimmed=%d\n", rv, q_trimmed);
     if (rv == MO_MATCHES_PENDING) {
@@ -305,6 +364,40 @@ char nfaQueueExecToMatch(const struct NFA *nfa, struct mq *q, s64a end) {
     return rv && !q_trimmed && !q_trimmed_ra;
 }
 
+char nfaQueueExec_raw(const struct NFA *nfa, struct mq *q, s64a end) {
+    DEBUG_PRINTF("nfa=%p end=%lld\n", nfa, end);
+#ifdef DEBUG
+    debugQueue(q);
+#endif
+
+    assert(q && q->context && q->state);
+    assert(end >= 0);
+    assert(q->cur < q->end);
+    assert(q->end <= MAX_MQE_LEN);
+    assert(ISALIGNED_CL(nfa) && ISALIGNED_CL(getImplNfa(nfa)));
+    assert(end < q->items[q->end - 1].location
+           || q->items[q->end - 1].type == MQE_END);
+
+    return nfaQueueExec_i(nfa, q, end);
+}
+
+char nfaQueueExec2_raw(const struct NFA *nfa, struct mq *q, s64a end) {
+    DEBUG_PRINTF("nfa=%p end=%lld\n", nfa, end);
+#ifdef DEBUG
+    debugQueue(q);
+#endif
+
+    assert(q && q->context && q->state);
+    assert(end >= 0);
+    assert(q->cur < q->end);
+    assert(q->end <= MAX_MQE_LEN);
+    assert(ISALIGNED_CL(nfa) && ISALIGNED_CL(getImplNfa(nfa)));
+    assert(end < q->items[q->end - 1].location
+           || q->items[q->end - 1].type == MQE_END);
+
+    return nfaQueueExec2_i(nfa, q, end);
+}
+
 char nfaReportCurrentMatches(const struct NFA *nfa, struct mq *q) {
     DISPATCH_BY_NFA_TYPE(_reportCurrent(nfa, q));
     return 0;
@@ -327,7 +420,7 @@ char nfaQueueExecRose(const struct NFA *nfa, struct mq *q, ReportID r) {
     assert(ISALIGNED_CL(nfa) && ISALIGNED_CL(getImplNfa(nfa)));
     assert(!q->report_current);
 
-    return nfaQueueExecRose_i(nfa, q, r);
+    return nfaQueueExecRose_p(nfa, q, r);
 }
 
 char nfaBlockExecReverse(const struct NFA *nfa, u64a offset, const u8 *buf,
@@ -92,7 +92,6 @@ bool has_accel_generic(const NFA *) {
     return false;
 }
 
-#ifdef DUMP_SUPPORT
 namespace {
 template<NFAEngineType t>
 struct getName {
@@ -100,7 +99,10 @@ struct getName {
         return NFATraits<t>::name;
     }
 };
+}
 
+#ifdef DUMP_SUPPORT
+namespace {
 // descr helper for LimEx NFAs
 template<NFAEngineType t>
 static
@@ -133,7 +135,7 @@ struct getDescription {
 namespace {
 enum NFACategory {NFA_LIMEX, NFA_OTHER};
 
-// Some of our traits we want around in DUMP_SUPPORT mode only.
+// Some of our helpers we want around in DUMP_SUPPORT mode only.
 #if defined(DUMP_SUPPORT)
 #define DO_IF_DUMP_SUPPORT(a) a
 #else
@@ -153,9 +155,9 @@ enum NFACategory {NFA_LIMEX, NFA_OTHER};
     };                                                                  \
     const has_accel_fn NFATraits<LIMEX_NFA_##mlt_size##_##mlt_shift>::has_accel \
             = has_accel_limex<LimExNFA##mlt_size>;                      \
-    DO_IF_DUMP_SUPPORT(                                                 \
     const char *NFATraits<LIMEX_NFA_##mlt_size##_##mlt_shift>::name     \
         = "LimEx (0-"#mlt_shift") "#mlt_size;                           \
+    DO_IF_DUMP_SUPPORT(                                                 \
     template<> struct getDescription<LIMEX_NFA_##mlt_size##_##mlt_shift> { \
         static string call(const void *ptr) {                            \
             return getDescriptionLimEx<LIMEX_NFA_##mlt_size##_##mlt_shift>((const NFA *)ptr); \
@@ -206,9 +208,7 @@ template<> struct NFATraits<MCCLELLAN_NFA_8> {
     static const has_accel_fn has_accel;
 };
 const has_accel_fn NFATraits<MCCLELLAN_NFA_8>::has_accel = has_accel_dfa;
-#if defined(DUMP_SUPPORT)
 const char *NFATraits<MCCLELLAN_NFA_8>::name = "McClellan 8";
-#endif
 
 template<> struct NFATraits<MCCLELLAN_NFA_16> {
     UNUSED static const char *name;
@@ -218,9 +218,7 @@ template<> struct NFATraits<MCCLELLAN_NFA_16> {
     static const has_accel_fn has_accel;
 };
 const has_accel_fn NFATraits<MCCLELLAN_NFA_16>::has_accel = has_accel_dfa;
-#if defined(DUMP_SUPPORT)
 const char *NFATraits<MCCLELLAN_NFA_16>::name = "McClellan 16";
-#endif
 
 template<> struct NFATraits<GOUGH_NFA_8> {
     UNUSED static const char *name;
@@ -230,9 +228,7 @@ template<> struct NFATraits<GOUGH_NFA_8> {
     static const has_accel_fn has_accel;
 };
 const has_accel_fn NFATraits<GOUGH_NFA_8>::has_accel = has_accel_dfa;
-#if defined(DUMP_SUPPORT)
 const char *NFATraits<GOUGH_NFA_8>::name = "Goughfish 8";
-#endif
 
 template<> struct NFATraits<GOUGH_NFA_16> {
     UNUSED static const char *name;
@@ -242,9 +238,7 @@ template<> struct NFATraits<GOUGH_NFA_16> {
     static const has_accel_fn has_accel;
 };
 const has_accel_fn NFATraits<GOUGH_NFA_16>::has_accel = has_accel_dfa;
-#if defined(DUMP_SUPPORT)
 const char *NFATraits<GOUGH_NFA_16>::name = "Goughfish 16";
-#endif
 
 template<> struct NFATraits<MPV_NFA_0> {
     UNUSED static const char *name;
@@ -254,9 +248,7 @@ template<> struct NFATraits<MPV_NFA_0> {
     static const has_accel_fn has_accel;
 };
 const has_accel_fn NFATraits<MPV_NFA_0>::has_accel = has_accel_generic;
-#if defined(DUMP_SUPPORT)
 const char *NFATraits<MPV_NFA_0>::name = "Mega-Puff-Vac";
-#endif
 
 template<> struct NFATraits<CASTLE_NFA_0> {
     UNUSED static const char *name;
@@ -266,9 +258,7 @@ template<> struct NFATraits<CASTLE_NFA_0> {
     static const has_accel_fn has_accel;
 };
 const has_accel_fn NFATraits<CASTLE_NFA_0>::has_accel = has_accel_generic;
-#if defined(DUMP_SUPPORT)
 const char *NFATraits<CASTLE_NFA_0>::name = "Castle";
-#endif
 
 template<> struct NFATraits<LBR_NFA_Dot> {
     UNUSED static const char *name;
@@ -278,9 +268,7 @@ template<> struct NFATraits<LBR_NFA_Dot> {
     static const has_accel_fn has_accel;
 };
 const has_accel_fn NFATraits<LBR_NFA_Dot>::has_accel = has_accel_generic;
-#if defined(DUMP_SUPPORT)
 const char *NFATraits<LBR_NFA_Dot>::name = "Lim Bounded Repeat (D)";
-#endif
 
 template<> struct NFATraits<LBR_NFA_Verm> {
     UNUSED static const char *name;
@@ -290,9 +278,7 @@ template<> struct NFATraits<LBR_NFA_Verm> {
     static const has_accel_fn has_accel;
 };
 const has_accel_fn NFATraits<LBR_NFA_Verm>::has_accel = has_accel_generic;
-#if defined(DUMP_SUPPORT)
 const char *NFATraits<LBR_NFA_Verm>::name = "Lim Bounded Repeat (V)";
-#endif
 
 template<> struct NFATraits<LBR_NFA_NVerm> {
     UNUSED static const char *name;
@@ -302,9 +288,7 @@ template<> struct NFATraits<LBR_NFA_NVerm> {
     static const has_accel_fn has_accel;
 };
 const has_accel_fn NFATraits<LBR_NFA_NVerm>::has_accel = has_accel_generic;
-#if defined(DUMP_SUPPORT)
 const char *NFATraits<LBR_NFA_NVerm>::name = "Lim Bounded Repeat (NV)";
-#endif
 
 template<> struct NFATraits<LBR_NFA_Shuf> {
     UNUSED static const char *name;
@@ -314,9 +298,7 @@ template<> struct NFATraits<LBR_NFA_Shuf> {
     static const has_accel_fn has_accel;
 };
 const has_accel_fn NFATraits<LBR_NFA_Shuf>::has_accel = has_accel_generic;
-#if defined(DUMP_SUPPORT)
 const char *NFATraits<LBR_NFA_Shuf>::name = "Lim Bounded Repeat (S)";
-#endif
 
 template<> struct NFATraits<LBR_NFA_Truf> {
     UNUSED static const char *name;
@@ -326,18 +308,26 @@ template<> struct NFATraits<LBR_NFA_Truf> {
     static const has_accel_fn has_accel;
 };
 const has_accel_fn NFATraits<LBR_NFA_Truf>::has_accel = has_accel_generic;
-#if defined(DUMP_SUPPORT)
 const char *NFATraits<LBR_NFA_Truf>::name = "Lim Bounded Repeat (M)";
-#endif
 
-} // namespace
+template<> struct NFATraits<TAMARAMA_NFA_0> {
+    UNUSED static const char *name;
+    static const NFACategory category = NFA_OTHER;
+    static const u32 stateAlign = 64;
+    static const bool fast = true;
+    static const has_accel_fn has_accel;
+};
+const has_accel_fn NFATraits<TAMARAMA_NFA_0>::has_accel = has_accel_generic;
+const char *NFATraits<TAMARAMA_NFA_0>::name = "Tamarama";
 
-#if defined(DUMP_SUPPORT)
+} // namespace
 
 const char *nfa_type_name(NFAEngineType type) {
     return DISPATCH_BY_NFA_TYPE(type, getName, nullptr);
 }
 
+#if defined(DUMP_SUPPORT)
+
 string describe(const NFA &nfa) {
     return DISPATCH_BY_NFA_TYPE((NFAEngineType)nfa.type, getDescription, &nfa);
 }
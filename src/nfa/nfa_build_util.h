@@ -38,9 +38,11 @@ struct NFA;
 
 namespace ue2 {
 
+/** \brief Human-readable name of an engine type. */
+const char *nfa_type_name(NFAEngineType type);
+
 #ifdef DUMP_SUPPORT
 /* provided for debugging functions */
-const char *nfa_type_name(NFAEngineType type);
 std::string describe(const NFA &nfa);
 #endif
 
@@ -97,6 +97,7 @@ enum NFAEngineType {
     LBR_NFA_Shuf,       /**< magic pseudo nfa */
     LBR_NFA_Truf,       /**< magic pseudo nfa */
     CASTLE_NFA_0,       /**< magic pseudo nfa */
+    TAMARAMA_NFA_0,     /**< magic nfa container */
     /** \brief bogus NFA - not used */
     INVALID_NFA
 };
@@ -238,6 +239,13 @@ int isMultiTopType(u8 t) {
     return !isDfaType(t) && !isLbrType(t);
 }
 
+/** \brief True if the given type (from NFA::type) is a container engine,
+ * holding other engines. */
+static really_inline
+int isContainerType(u8 t) {
+    return t == TAMARAMA_NFA_0;
+}
+
 /** Macros used in place of unimplemented NFA API functions for a given
  * engine. */
 #if !defined(_WIN32)
@@ -38,6 +38,7 @@
 #include "util/multibit.h"
 #include "util/pack_bits.h"
 #include "util/partial_store.h"
+#include "util/simd_utils.h"
 #include "util/unaligned.h"
 
 #include <stdint.h>
@@ -187,6 +188,83 @@ u64a repeatLastTopTrailer(const struct RepeatInfo *info,
     return xs->offset - info->repeatMin;
 }
 
+u64a repeatLastTopWindow(const struct RepeatInfo *info,
+                         const union RepeatControl *ctrl) {
+    const struct RepeatWindowControl *xs = &ctrl->window;
+    assert(xs->offset >= info->repeatMin);
+    return xs->offset - info->repeatMin;
+}
+
+/*
+ * The REPEAT_WINDOW model keeps a bit window in repeat state in which bit i
+ * records whether (xs->offset - 1 - i) is a match offset, for i < repeatMin.
+ * Bits at or above repeatMin are stale history and are never examined. The
+ * window is a whole number of 128-bit blocks, stored unaligned.
+ */
+
+static really_inline
+u32 windowBlocks(const struct RepeatInfo *info) {
+    assert(info->stateSize % sizeof(m128) == 0);
+    return info->stateSize / sizeof(m128);
+}
+
+/** \brief Returns a mask of bits [lo, hi] of the window that fall in the
+ * given 128-bit block. */
+static really_inline
+m128 windowRangeMask(u32 block, u32 lo, u32 hi) {
+    assert(lo <= hi);
+    const u32 base = block * 128;
+    if (hi < base || lo >= base + 128) {
+        return zeroes128();
+    }
+    u32 a = lo > base ? lo - base : 0;
+    u32 b = hi < base + 127 ? hi - base : 127;
+    return and128(lshift128_var(ones128(), a),
+                  rshift128_var(ones128(), 127 - b));
+}
+
+/** \brief Shifts the window up by \a n bits, as the extent moves forward. */
+static
+void windowShift(u8 *window, u32 blocks, u64a n) {
+    if (n >= (u64a)blocks * 128) {
+        memset(window, 0, blocks * sizeof(m128));
+        return;
+    }
+
+    const u32 q = n / 128;
+    const u32 r = n % 128;
+
+    // Work from the top down, so that the source blocks are still intact.
+    for (u32 i = blocks; i-- > 0;) {
+        m128 v = zeroes128();
+        if (i >= q) {
+            v = lshift128_var(loadu128(window + (i - q) * sizeof(m128)), r);
+            if (r && i > q) {
+                m128 lo = loadu128(window + (i - q - 1) * sizeof(m128));
+                v = or128(v, rshift128_var(lo, 128 - r));
+            }
+        }
+        storeu128(window + i * sizeof(m128), v);
+    }
+}
+
+/** \brief Returns the index of the highest bit set in the window below \a
+ * limit, or ~0U if there isn't one. */
+static
+u32 windowFindLast(const u8 *window, u32 limit) {
+    for (u32 w = (limit + 63) / 64; w-- > 0;) {
+        u64a word = unaligned_load_u64a(window + w * sizeof(u64a));
+        u32 bits = limit - w * 64;
+        if (bits < 64) {
+            word &= (1ULL << bits) - 1;
+        }
+        if (word) {
+            return w * 64 + 63 - clz64(word);
+        }
+    }
+    return ~0U;
+}
+
 u64a repeatNextMatchRing(const struct RepeatInfo *info,
                          const union RepeatControl *ctrl, const void *state,
                          u64a offset) {
@@ -342,6 +420,42 @@ u64a repeatNextMatchTrailer(const struct RepeatInfo *info,
     return xs->offset;
 }
 
+u64a repeatNextMatchWindow(const struct RepeatInfo *info,
+                           const union RepeatControl *ctrl, const void *state,
+                           u64a offset) {
+    const struct RepeatWindowControl *xs = &ctrl->window;
+    const u32 m_width = info->repeatMax - info->repeatMin;
+
+    DEBUG_PRINTF("offset=%llu, xs->offset=%llu\n", offset, xs->offset);
+    assert(xs->offset >= info->repeatMin);
+
+    if (offset >= xs->offset + m_width) {
+        DEBUG_PRINTF("no more matches\n");
+        return 0;
+    }
+
+    if (offset >= xs->offset) {
+        DEBUG_PRINTF("inside most recent match window, next match %llu\n",
+                     offset + 1);
+        return offset + 1;
+    }
+
+    // Offset is before the match window; the earliest match after it is the
+    // highest bit in the window that still lies beyond offset.
+    u64a diff = xs->offset - offset;
+    u32 limit = (u32)MIN(diff - 1, (u64a)info->repeatMin);
+    u32 idx = windowFindLast((const u8 *)state, limit);
+    if (idx != ~0U) {
+        u64a next_match = xs->offset - idx - 1;
+        DEBUG_PRINTF("next match in window at %llu\n", next_match);
+        assert(next_match > offset);
+        return next_match;
+    }
+
+    DEBUG_PRINTF("next match is start of match window, %llu\n", xs->offset);
+    return xs->offset;
+}
+
 /** \brief Store the first top in the ring buffer. */
 static
 void storeInitialRingTop(struct RepeatRingControl *xs, u8 *ring,
@@ -694,6 +808,45 @@ void repeatStoreTrailer(const struct RepeatInfo *info,
 #endif
 }
 
+void repeatStoreWindow(const struct RepeatInfo *info,
+                       union RepeatControl *ctrl, void *state, u64a offset,
+                       char is_alive) {
+    DEBUG_PRINTF("{%u,%u} repeat, top at %llu\n", info->repeatMin,
+                 info->repeatMax, offset);
+
+    struct RepeatWindowControl *xs = &ctrl->window;
+    u8 *window = (u8 *)state;
+    const u32 blocks = windowBlocks(info);
+    const u64a next_extent = offset + info->repeatMin;
+
+    if (!is_alive) {
+        xs->offset = next_extent;
+        memset(window, 0, info->stateSize);
+        DEBUG_PRINTF("initial top, set extent to %llu\n", next_extent);
+        return;
+    }
+
+    assert(next_extent > xs->offset);
+    const u64a diff = next_extent - xs->offset;
+    const u32 m_width = info->repeatMax - info->repeatMin;
+    DEBUG_PRINTF("diff=%llu, m_width=%u\n", diff, m_width);
+
+    windowShift(window, blocks, diff);
+
+    // The previous match window [xs->offset, xs->offset + m_width] now lies
+    // at bits [diff - 1 - m_width, diff - 1]; switch on what we still need.
+    if (diff - 1 < (u64a)m_width + info->repeatMin) {
+        u32 hi = (u32)MIN(diff - 1, (u64a)info->repeatMin - 1);
+        u32 lo = diff - 1 > m_width ? (u32)(diff - 1 - m_width) : 0;
+        for (u32 i = 0; i < blocks; i++) {
+            u8 *p = window + i * sizeof(m128);
+            storeu128(p, or128(loadu128(p), windowRangeMask(i, lo, hi)));
+        }
+    }
+
+    xs->offset = next_extent;
+}
+
 enum RepeatMatch repeatHasMatchRing(const struct RepeatInfo *info,
                                     const union RepeatControl *ctrl,
                                     const void *state, u64a offset) {
@@ -882,6 +1035,39 @@ enum RepeatMatch repeatHasMatchTrailer(const struct RepeatInfo *info,
     return REPEAT_NOMATCH;
 }
 
+enum RepeatMatch repeatHasMatchWindow(const struct RepeatInfo *info,
+                                      const union RepeatControl *ctrl,
+                                      const void *state, u64a offset) {
+    const struct RepeatWindowControl *xs = &ctrl->window;
+    const u32 m_width = info->repeatMax - info->repeatMin;
+
+    DEBUG_PRINTF("offset=%llu, xs->offset=%llu\n", offset, xs->offset);
+
+    if (offset > xs->offset + m_width) {
+        DEBUG_PRINTF("stale\n");
+        return REPEAT_STALE;
+    }
+
+    if (offset >= xs->offset) {
+        DEBUG_PRINTF("in match window\n");
+        return REPEAT_MATCH;
+    }
+
+    if (offset >= xs->offset - info->repeatMin) {
+        const u8 *window = (const u8 *)state;
+        u32 idx = xs->offset - offset - 1;
+        DEBUG_PRINTF("check window idx %u\n", idx);
+        assert(idx < info->repeatMin);
+        if (window[idx / 8] & (1U << (idx % 8))) {
+            DEBUG_PRINTF("match in window\n");
+            return REPEAT_MATCH;
+        }
+    }
+
+    DEBUG_PRINTF("no match\n");
+    return REPEAT_NOMATCH;
+}
+
 static really_inline
 void storePackedRelative(char *dest, u64a val, u64a offset, u64a max, u32 len) {
     assert(val <= offset);
@@ -1016,6 +1202,23 @@ void repeatPackTrailer(char *dest, const struct RepeatInfo *info,
     pack_bits_64(dest, v, info->packedFieldSizes, 2);
 }
 
+static
+void repeatPackWindow(char *dest, const struct RepeatInfo *info,
+                      const union RepeatControl *ctrl, u64a offset) {
+    const struct RepeatWindowControl *xs = &ctrl->window;
+
+    // Only the most recent top needs packing, as the window itself lives in
+    // repeat state. As with the trailer model, xs->offset may be zero here.
+    u64a top = 0;
+    if (xs->offset) {
+        assert(xs->offset >= info->repeatMin);
+        top = xs->offset - info->repeatMin;
+    }
+
+    storePackedRelative(dest, top, offset, info->horizon,
+                        info->packedCtrlSize);
+}
+
 void repeatPack(char *dest, const struct RepeatInfo *info,
                 const union RepeatControl *ctrl, u64a offset) {
     assert(dest && info && ctrl);
@@ -1040,6 +1243,9 @@ void repeatPack(char *dest, const struct RepeatInfo *info,
     case REPEAT_TRAILER:
         repeatPackTrailer(dest, info, ctrl, offset);
         break;
+    case REPEAT_WINDOW:
+        repeatPackWindow(dest, info, ctrl, offset);
+        break;
     }
 }
 
@@ -1125,6 +1331,15 @@ void repeatUnpackTrailer(const char *src, const struct RepeatInfo *info,
                  xs->bitmap);
 }
 
+static
+void repeatUnpackWindow(const char *src, const struct RepeatInfo *info,
+                        u64a offset, union RepeatControl *ctrl) {
+    struct RepeatWindowControl *xs = &ctrl->window;
+    xs->offset = loadPackedRelative(src, offset, info->packedCtrlSize) +
+                 info->repeatMin;
+    DEBUG_PRINTF("loaded: xs->offset=%llu\n", xs->offset);
+}
+
 void repeatUnpack(const char *src, const struct RepeatInfo *info, u64a offset,
                   union RepeatControl *ctrl) {
     assert(src && info && ctrl);
@@ -1149,6 +1364,9 @@ void repeatUnpack(const char *src, const struct RepeatInfo *info, u64a offset,
     case REPEAT_TRAILER:
         repeatUnpackTrailer(src, info, offset, ctrl);
         break;
+    case REPEAT_WINDOW:
+        repeatUnpackWindow(src, info, offset, ctrl);
+        break;
     }
 }
 
@@ -112,6 +112,9 @@ u64a repeatLastTopBitmap(const union RepeatControl *ctrl);
 u64a repeatLastTopTrailer(const struct RepeatInfo *info,
                           const union RepeatControl *ctrl);
 
+u64a repeatLastTopWindow(const struct RepeatInfo *info,
+                         const union RepeatControl *ctrl);
+
 u64a repeatLastTopSparseOptimalP(const struct RepeatInfo *info,
                                  const union RepeatControl *ctrl,
                                  const void *state);
@@ -135,6 +138,8 @@ u64a repeatLastTop(const struct RepeatInfo *info,
         return repeatLastTopSparseOptimalP(info, ctrl, state);
     case REPEAT_TRAILER:
         return repeatLastTopTrailer(info, ctrl);
+    case REPEAT_WINDOW:
+        return repeatLastTopWindow(info, ctrl);
     }
 
     DEBUG_PRINTF("bad repeat type %u\n", info->type);
@@ -177,6 +182,10 @@ u64a repeatNextMatchSparseOptimalP(const struct RepeatInfo *info,
 u64a repeatNextMatchTrailer(const struct RepeatInfo *info,
                             const union RepeatControl *ctrl, u64a offset);
 
+u64a repeatNextMatchWindow(const struct RepeatInfo *info,
+                           const union RepeatControl *ctrl, const void *state,
+                           u64a offset);
+
 static really_inline
 u64a repeatNextMatch(const struct RepeatInfo *info,
                      const union RepeatControl *ctrl, const void *state,
@@ -200,6 +209,8 @@ u64a repeatNextMatch(const struct RepeatInfo *info,
         return repeatNextMatchSparseOptimalP(info, ctrl, state, offset);
     case REPEAT_TRAILER:
         return repeatNextMatchTrailer(info, ctrl, offset);
+    case REPEAT_WINDOW:
+        return repeatNextMatchWindow(info, ctrl, state, offset);
     }
 
     DEBUG_PRINTF("bad repeat type %u\n", info->type);
@@ -243,6 +254,10 @@ void repeatStoreTrailer(const struct RepeatInfo *info,
                         union RepeatControl *ctrl, u64a offset,
                         char is_alive);
 
+void repeatStoreWindow(const struct RepeatInfo *info,
+                       union RepeatControl *ctrl, void *state, u64a offset,
+                       char is_alive);
+
 static really_inline
 void repeatStore(const struct RepeatInfo *info, union RepeatControl *ctrl,
                  void *state, u64a offset, char is_alive) {
@@ -275,6 +290,9 @@ void repeatStore(const struct RepeatInfo *info, union RepeatControl *ctrl,
     case REPEAT_TRAILER:
         repeatStoreTrailer(info, ctrl, offset, is_alive);
         break;
+    case REPEAT_WINDOW:
+        repeatStoreWindow(info, ctrl, state, offset, is_alive);
+        break;
     }
 }
 
@@ -325,6 +343,10 @@ enum RepeatMatch repeatHasMatchTrailer(const struct RepeatInfo *info,
                                        const union RepeatControl *ctrl,
                                        u64a offset);
 
+enum RepeatMatch repeatHasMatchWindow(const struct RepeatInfo *info,
+                                      const union RepeatControl *ctrl,
+                                      const void *state, u64a offset);
+
 static really_inline
 enum RepeatMatch repeatHasMatch(const struct RepeatInfo *info,
                                 const union RepeatControl *ctrl,
@@ -348,6 +370,8 @@ enum RepeatMatch repeatHasMatch(const struct RepeatInfo *info,
         return repeatHasMatchSparseOptimalP(info, ctrl, state, offset);
     case REPEAT_TRAILER:
         return repeatHasMatchTrailer(info, ctrl, offset);
+    case REPEAT_WINDOW:
+        return repeatHasMatchWindow(info, ctrl, state, offset);
     }
 
     assert(0);
@@ -85,6 +85,13 @@ enum RepeatType {
     /** Used for {N,M} repeats where 0 < N < 64. Uses the \ref RepeatTrailerControl
      * structure at runtime. */
     REPEAT_TRAILER = 6,
+
+    /** Used for {N,M} repeats where N <= ::REPEAT_WINDOW_MAX_BITS. Like
+     * ::REPEAT_TRAILER, but the history of earlier matches is a bit window of
+     * up to 256 bits kept in repeat state and updated with 128-bit vector
+     * shifts, so a new top costs the same no matter how many are live. Uses
+     * the \ref RepeatWindowControl structure at runtime. */
+    REPEAT_WINDOW = 7,
 };
 
 /**
@@ -98,6 +105,9 @@ enum RepeatType {
 /** Max slots used by ::REPEAT_RANGE repeat model. */
 #define REPEAT_RANGE_MAX_SLOTS 16
 
+/** Max history window size in bits used by ::REPEAT_WINDOW repeat model. */
+#define REPEAT_WINDOW_MAX_BITS 256
+
 /** Structure describing a bounded repeat in the bytecode */
 struct RepeatInfo {
     u8 type; //!< from enum RepeatType.
@@ -177,6 +187,12 @@ struct RepeatTrailerControl {
     u64a bitmap; //!< trailing bitmap of earlier matches, relative to offset.
 };
 
+/** Runtime control block structure for ::REPEAT_WINDOW bounded repeats. The
+ * window of earlier matches lives in repeat state. */
+struct RepeatWindowControl {
+    u64a offset; //!< min extent of most recent match window.
+};
+
 /** \brief Union of control block types, used at runtime. */
 union RepeatControl {
     struct RepeatRingControl ring;
@@ -184,6 +200,7 @@ union RepeatControl {
     struct RepeatOffsetControl offset;
     struct RepeatBitmapControl bitmap;
     struct RepeatTrailerControl trailer;
+    struct RepeatWindowControl window;
 };
 
 /** For debugging, returns the name of a repeat model. */
@@ -204,6 +221,8 @@ const char *repeatTypeName(u8 type) {
         return "SPARSE_OPTIMAL_P";
     case REPEAT_TRAILER:
         return "TRAILER";
+    case REPEAT_WINDOW:
+        return "WINDOW";
     }
     assert(0);
     return "UNKNOWN";
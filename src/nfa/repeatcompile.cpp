@@ -206,6 +206,14 @@ RepeatStateInfo::RepeatStateInfo(enum RepeatType type, const depth &repeatMin,
         packedFieldSizes[1] = repeatMin;
         packedCtrlSize = (packedFieldSizes[0] + packedFieldSizes[1] + 7U) / 8U;
         break;
+    case REPEAT_WINDOW:
+        assert(repeatMax.is_finite());
+        assert(repeatMin <= depth(REPEAT_WINDOW_MAX_BITS));
+        // Window of repeatMin bits, in whole 128-bit blocks.
+        stateSize = ROUNDUP_N((u32)repeatMin, 128) / 8;
+        horizon = repeatMax + 1;
+        packedCtrlSize = calcPackedBytes(horizon + 1);
+        break;
     }
     DEBUG_PRINTF("stateSize=%u, packedCtrlSize=%u, horizon=%u\n", stateSize,
                  packedCtrlSize, horizon);
@@ -272,6 +280,17 @@ enum RepeatType chooseRepeatType(const depth &repeatMin, const depth &repeatMax,
         streamStateSize(REPEAT_SPARSE_OPTIMAL_P, repeatMin, repeatMax, minPeriod);
     }
 
+    // Without a useful minimum period, tops may arrive densely, which is
+    // where the ring model spends most time. The window model has a constant
+    // cost per top and per check, so we use it if its history fits.
+    if (sparse_len == ~0U && repeatMin <= depth(REPEAT_WINDOW_MAX_BITS)) {
+        u32 window_len =
+            streamStateSize(REPEAT_WINDOW, repeatMin, repeatMax, minPeriod);
+        if (window_len <= range_len) {
+            return REPEAT_WINDOW;
+        }
+    }
+
     if (range_len != ~0U || sparse_len != ~0U) {
         return range_len < sparse_len ? REPEAT_RANGE : REPEAT_SPARSE_OPTIMAL_P;
     }
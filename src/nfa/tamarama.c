@@ -0,0 +1,506 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** \file
+ * \brief Tamarama: container engine for exclusive engines, runtime code.
+ *
+ * The container's queue carries top events in the container's own top space.
+ * To run it, we copy the events belonging to the active subengine into a
+ * subqueue (translating them into the subengine's top space), stopping at the
+ * first top owned by a different subengine. The active subengine is run over
+ * that subqueue; if a switch is pending, it is then discarded and the
+ * container carries on from the new subengine's top.
+ */
+
+#include "tamarama.h"
+
+#include "tamarama_internal.h"
+#include "nfa_api.h"
+#include "nfa_api_queue.h"
+#include "nfa_api_util.h"
+#include "nfa_internal.h"
+#include "scratch.h"
+#include "util/partial_store.h"
+#include "ue2common.h"
+
+static really_inline
+const u32 *getBaseTops(const struct Tamarama *t) {
+    return (const u32 *)((const char *)t + sizeof(struct Tamarama));
+}
+
+static really_inline
+const struct NFA *getSubEngine(const struct NFA *n, const struct Tamarama *t,
+                               u32 idx) {
+    assert(idx < t->numSubEngines);
+    const u32 *subOffset = getBaseTops(t) + t->numSubEngines;
+    const struct NFA *sub =
+        (const struct NFA *)((const char *)n + subOffset[idx]);
+    assert(ISALIGNED_CL(sub));
+    assert(!isContainerType(sub->type));
+    return sub;
+}
+
+static really_inline
+u32 loadActiveIdx(const struct Tamarama *t, const char *streamState) {
+    return partial_load_u32(streamState, t->activeIdxSize);
+}
+
+static really_inline
+void storeActiveIdx(const struct Tamarama *t, char *streamState, u32 idx) {
+    assert(idx <= t->numSubEngines);
+    partial_store_u32(streamState, idx, t->activeIdxSize);
+}
+
+/** \brief Returns the index of the subengine owning the given top event. */
+static really_inline
+u32 findEngineForTop(const struct Tamarama *t, u32 event) {
+    const u32 *baseTop = getBaseTops(t);
+    assert(event >= baseTop[0] && event < MQE_INVALID);
+
+    u32 lo = 0;
+    u32 hi = t->numSubEngines;
+    while (hi - lo > 1) {
+        u32 mid = lo + (hi - lo) / 2;
+        if (event >= baseTop[mid]) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    DEBUG_PRINTF("event %u -> subengine %u\n", event, lo);
+    return lo;
+}
+
+/** \brief Translates a container event into subengine \a idx's events. */
+static really_inline
+u32 toSubEvent(const struct Tamarama *t, const struct NFA *sub, u32 idx,
+               u32 event) {
+    if (event == MQE_START || event == MQE_END) {
+        return event;
+    }
+    if (!isMultiTopType(sub->type)) {
+        return MQE_TOP;
+    }
+    return MQE_TOP_FIRST + event - getBaseTops(t)[idx];
+}
+
+/** \brief Translates an event of subengine \a idx into a container event. */
+static really_inline
+u32 fromSubEvent(const struct Tamarama *t, const struct NFA *sub, u32 idx,
+                 u32 event) {
+    if (event == MQE_START || event == MQE_END) {
+        return event;
+    }
+    if (!isMultiTopType(sub->type)) {
+        return getBaseTops(t)[idx];
+    }
+    return getBaseTops(t)[idx] + event - MQE_TOP_FIRST;
+}
+
+/** \brief Sets up an empty subqueue for \a sub, sharing the container queue's
+ * buffers, callbacks and state. */
+static really_inline
+void initSubQueue(const struct Tamarama *t, const struct mq *q, struct mq *q1,
+                  const struct NFA *sub) {
+    q1->nfa = sub;
+    q1->cur = 0;
+    q1->end = 0;
+    q1->state = q->state;
+    q1->streamState = q->streamState + t->activeIdxSize;
+    q1->offset = q->offset;
+    q1->buffer = q->buffer;
+    q1->length = q->length;
+    q1->history = q->history;
+    q1->hlength = q->hlength;
+    q1->scratch = q->scratch;
+    q1->report_current = 0;
+    q1->cb = q->cb;
+    q1->som_cb = q->som_cb;
+    q1->context = q->context;
+}
+
+/**
+ * \brief Fills the subqueue with the container's events for subengine \a idx,
+ * from the current MQE_START up to the first top for a different subengine.
+ *
+ * If such a top exists, an MQE_END is pushed at its location. Returns the
+ * index of that top in the container queue, or q->end if there is none.
+ */
+static really_inline
+u32 fillSubQueue(const struct Tamarama *t, const struct mq *q, struct mq *q1,
+                 u32 idx) {
+    assert(q_cur_type(q) == MQE_START);
+    const struct NFA *sub = q1->nfa;
+    const u32 *baseTop = getBaseTops(t);
+    const u32 lo = baseTop[idx];
+    const u32 hi = idx + 1 < t->numSubEngines ? baseTop[idx + 1] : MQE_INVALID;
+
+    q1->items[q1->end++] = q->items[q->cur];
+
+    u32 i = q->cur + 1;
+    for (; i < q->end; i++) {
+        const struct mq_item *item = &q->items[i];
+        if (item->type != MQE_END && (item->type < lo || item->type >= hi)) {
+            DEBUG_PRINTF("top %u@%lld switches subengine\n", item->type,
+                         item->location);
+            pushQueueNoMerge(q1, MQE_END, item->location);
+            break;
+        }
+        assert(q1->end < MAX_MQE_LEN);
+        q1->items[q1->end] = *item;
+        q1->items[q1->end].type = toSubEvent(t, sub, idx, item->type);
+        q1->end++;
+    }
+
+    return i;
+}
+
+/**
+ * \brief Copies the events left on the subqueue after the subengine stopped
+ * early back into the container queue, ahead of event \a next.
+ */
+static really_inline
+void copyBack(const struct Tamarama *t, struct mq *q, const struct mq *q1,
+              u32 idx, u32 next) {
+    const struct NFA *sub = q1->nfa;
+    assert(q1->cur < q1->end);
+    u32 count = q1->end - q1->cur;
+    if (next < q->end && count > 1 &&
+        q1->items[q1->end - 1].type == MQE_END) {
+        count--; // drop the MQE_END we added at the switch
+    }
+
+    assert(next >= q->cur + count);
+    u32 dst = next - count;
+    for (u32 i = 0; i < count; i++) {
+        q->items[dst + i] = q1->items[q1->cur + i];
+        q->items[dst + i].type =
+            fromSubEvent(t, sub, idx, q1->items[q1->cur + i].type);
+    }
+    q->cur = dst;
+    assert(q_cur_type(q) == MQE_START);
+
+#ifdef DEBUG
+    debugQueue(q);
+#endif
+}
+
+/**
+ * \brief Makes the subengine owning the top after the current MQE_START the
+ * active one, moving the MQE_START up to that top.
+ *
+ * Returns zero if there are no more tops, or the next top is beyond \a end.
+ */
+static really_inline
+char activateNextEngine(const struct NFA *n, const struct Tamarama *t,
+                        struct mq *q, s64a end) {
+    assert(q_cur_type(q) == MQE_START);
+    assert(q->cur + 1 < q->end);
+    const struct mq_item *next = &q->items[q->cur + 1];
+    if (next->type == MQE_END) {
+        DEBUG_PRINTF("no more tops\n");
+        return 0;
+    }
+
+    if (next->location > end) {
+        DEBUG_PRINTF("next top is beyond end\n");
+        q->items[q->cur].location = end;
+        return 0;
+    }
+
+    u32 idx = findEngineForTop(t, next->type);
+    storeActiveIdx(t, q->streamState, idx);
+    q->items[q->cur].location = next->location;
+
+    const struct NFA *sub = getSubEngine(n, t, idx);
+    struct mq q1;
+    initSubQueue(t, q, &q1, sub);
+    nfaQueueInitState(sub, &q1);
+    return 1;
+}
+
+/**
+ * \brief Discards the active subengine and sets the container queue up to
+ * continue from event \a next, the top that owns another subengine.
+ */
+static really_inline
+void switchEngine(const struct Tamarama *t, struct mq *q, u32 next, s64a end) {
+    assert(next < q->end && next > q->cur);
+    storeActiveIdx(t, q->streamState, t->numSubEngines);
+    q->cur = next - 1;
+    q->items[q->cur].type = MQE_START;
+    q->items[q->cur].location = MIN(q->items[next].location, end);
+}
+
+static really_inline
+char nfaExecTamarama0_Q_i(const struct NFA *n, struct mq *q, s64a end,
+                          char stop_at_match) {
+    assert(n && q);
+    assert(n->type == TAMARAMA_NFA_0);
+
+    const struct Tamarama *t = getImplNfa(n);
+    const u32 numSubEngines = t->numSubEngines;
+
+    if (q->cur == q->end) {
+        assert(!q->report_current);
+        return 1;
+    }
+
+    assert(q->cur + 1 < q->end); // require at least two items
+    assert(q_cur_type(q) == MQE_START);
+
+    while (1) {
+        u32 idx = loadActiveIdx(t, q->streamState);
+        if (idx == numSubEngines) {
+            assert(!q->report_current);
+            if (!activateNextEngine(n, t, q, end)) {
+                if (q->items[q->cur + 1].type == MQE_END) {
+                    DEBUG_PRINTF("tamarama is dead\n");
+                    q->cur = q->end;
+                    return 0;
+                }
+                return MO_ALIVE;
+            }
+            idx = loadActiveIdx(t, q->streamState);
+        }
+
+        const struct NFA *sub = getSubEngine(n, t, idx);
+        struct mq q1;
+        initSubQueue(t, q, &q1, sub);
+        q1.report_current = q->report_current;
+        q->report_current = 0;
+        u32 next = fillSubQueue(t, q, &q1, idx);
+
+        DEBUG_PRINTF("running subengine %u to %lld\n", idx, end);
+        char rv = stop_at_match ? nfaQueueExec2_raw(sub, &q1, end)
+                                : nfaQueueExec_raw(sub, &q1, end);
+        if (!rv) {
+            if (q->scratch && can_stop_matching(q->scratch)) {
+                return MO_HALT_MATCHING;
+            }
+            DEBUG_PRINTF("subengine %u is dead\n", idx);
+            if (next == q->end) {
+                storeActiveIdx(t, q->streamState, numSubEngines);
+                q->cur = q->end;
+                return 0;
+            }
+            switchEngine(t, q, next, end);
+            continue;
+        }
+
+        if (rv == MO_MATCHES_PENDING || q1.cur < q1.end) {
+            DEBUG_PRINTF("subengine %u stopped early\n", idx);
+            copyBack(t, q, &q1, idx, next);
+            return rv;
+        }
+
+        if (next == q->end) {
+            q->cur = q->end;
+            return rv;
+        }
+
+        // The subengine has consumed all of its events up to the next
+        // subengine's top, and exclusivity guarantees that it can raise no
+        // further matches.
+        switchEngine(t, q, next, end);
+    }
+}
+
+char nfaExecTamarama0_Q(const struct NFA *n, struct mq *q, s64a end) {
+    DEBUG_PRINTF("entry\n");
+    return nfaExecTamarama0_Q_i(n, q, end, 0);
+}
+
+char nfaExecTamarama0_Q2(const struct NFA *n, struct mq *q, s64a end) {
+    DEBUG_PRINTF("entry\n");
+    return nfaExecTamarama0_Q_i(n, q, end, 1);
+}
+
+char nfaExecTamarama0_QR(const struct NFA *n, struct mq *q, ReportID report) {
+    assert(n && q);
+    assert(n->type == TAMARAMA_NFA_0);
+    DEBUG_PRINTF("entry\n");
+
+    const struct Tamarama *t = getImplNfa(n);
+    const u32 numSubEngines = t->numSubEngines;
+
+    if (q->cur == q->end) {
+        return 1;
+    }
+
+    assert(q->cur + 1 < q->end); // require at least two items
+    assert(q_cur_type(q) == MQE_START);
+    const s64a end = q->items[q->end - 1].location;
+
+    while (1) {
+        u32 idx = loadActiveIdx(t, q->streamState);
+        if (idx == numSubEngines) {
+            if (!activateNextEngine(n, t, q, end)) {
+                DEBUG_PRINTF("tamarama is dead\n");
+                q->cur = q->end;
+                return 0;
+            }
+            idx = loadActiveIdx(t, q->streamState);
+        }
+
+        const struct NFA *sub = getSubEngine(n, t, idx);
+        struct mq q1;
+        initSubQueue(t, q, &q1, sub);
+        u32 next = fillSubQueue(t, q, &q1, idx);
+
+        char rv = nfaQueueExecRose(sub, &q1, report);
+        if (next == q->end) {
+            if (!rv && report == MO_INVALID_IDX) {
+                // With no report given, a zero return means the subengine is
+                // dead.
+                storeActiveIdx(t, q->streamState, numSubEngines);
+            }
+            q->cur = q->end;
+            return rv;
+        }
+
+        switchEngine(t, q, next, end);
+    }
+}
+
+char nfaExecTamarama0_testEOD(const struct NFA *n, const char *state,
+                              const char *streamState, u64a offset,
+                              NfaCallback callback, SomNfaCallback som_cb,
+                              void *context) {
+    assert(n && state && streamState);
+    assert(n->type == TAMARAMA_NFA_0);
+
+    const struct Tamarama *t = getImplNfa(n);
+    u32 idx = loadActiveIdx(t, streamState);
+    if (idx == t->numSubEngines) {
+        return MO_CONTINUE_MATCHING;
+    }
+
+    const struct NFA *sub = getSubEngine(n, t, idx);
+    if (!nfaAcceptsEod(sub)) {
+        return MO_CONTINUE_MATCHING;
+    }
+
+    return nfaCheckFinalState(sub, state, streamState + t->activeIdxSize,
+                              offset, callback, som_cb, context);
+}
+
+/** \brief Sets up a subqueue for the active subengine holding just the
+ * container queue's current event. Returns NULL if nothing is active. */
+static really_inline
+const struct NFA *prepActiveQueue(const struct NFA *n, const struct mq *q,
+                                  struct mq *q1) {
+    const struct Tamarama *t = getImplNfa(n);
+    u32 idx = loadActiveIdx(t, q->streamState);
+    if (idx == t->numSubEngines) {
+        return NULL;
+    }
+
+    const struct NFA *sub = getSubEngine(n, t, idx);
+    initSubQueue(t, q, q1, sub);
+    if (q->cur < q->end) {
+        q1->items[0] = q->items[q->cur];
+        q1->items[0].type = toSubEvent(t, sub, idx, q->items[q->cur].type);
+        q1->end = 1;
+    }
+    return sub;
+}
+
+char nfaExecTamarama0_reportCurrent(const struct NFA *n, struct mq *q) {
+    assert(n && q);
+    assert(n->type == TAMARAMA_NFA_0);
+    DEBUG_PRINTF("entry\n");
+
+    struct mq q1;
+    const struct NFA *sub = prepActiveQueue(n, q, &q1);
+    if (!sub) {
+        return 0;
+    }
+
+    return nfaReportCurrentMatches(sub, &q1);
+}
+
+char nfaExecTamarama0_inAccept(const struct NFA *n, ReportID report,
+                               struct mq *q) {
+    assert(n && q);
+    assert(n->type == TAMARAMA_NFA_0);
+    DEBUG_PRINTF("entry\n");
+
+    struct mq q1;
+    const struct NFA *sub = prepActiveQueue(n, q, &q1);
+    if (!sub) {
+        return 0;
+    }
+
+    return nfaInAcceptState(sub, report, &q1);
+}
+
+char nfaExecTamarama0_queueInitState(const struct NFA *n, struct mq *q) {
+    assert(n && q);
+    assert(n->type == TAMARAMA_NFA_0);
+    DEBUG_PRINTF("entry\n");
+
+    // Nothing is active until the first top arrives.
+    const struct Tamarama *t = getImplNfa(n);
+    storeActiveIdx(t, q->streamState, t->numSubEngines);
+    return 0;
+}
+
+char nfaExecTamarama0_queueCompressState(const struct NFA *n,
+                                         const struct mq *q, s64a loc) {
+    assert(n && q);
+    assert(n->type == TAMARAMA_NFA_0);
+    DEBUG_PRINTF("entry, loc=%lld\n", loc);
+
+    struct mq q1;
+    const struct NFA *sub = prepActiveQueue(n, q, &q1);
+    if (!sub) {
+        return 0;
+    }
+
+    return nfaQueueCompressState(sub, &q1, loc);
+}
+
+char nfaExecTamarama0_expandState(const struct NFA *n, void *dest,
+                                  const void *src, u64a offset, u8 key) {
+    assert(n && dest && src);
+    assert(n->type == TAMARAMA_NFA_0);
+    DEBUG_PRINTF("entry, src=%p, dest=%p, offset=%llu\n", src, dest, offset);
+
+    const struct Tamarama *t = getImplNfa(n);
+    u32 idx = loadActiveIdx(t, src);
+    if (idx == t->numSubEngines) {
+        return 0;
+    }
+
+    const struct NFA *sub = getSubEngine(n, t, idx);
+    return nfaExpandState(sub, dest, (const char *)src + t->activeIdxSize,
+                          offset, key);
+}
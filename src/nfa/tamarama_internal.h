@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** \file
+ * \brief Tamarama: container engine for exclusive engines, data structures.
+ */
+
+#ifndef NFA_TAMARAMA_INTERNAL_H
+#define NFA_TAMARAMA_INTERNAL_H
+
+#include "ue2common.h"
+
+/**
+ * \brief Tamarama engine structure.
+ *
+ * A Tamarama holds a set of mutually exclusive subengines, at most one of
+ * which can be alive at any time. They share a single queue, active array bit
+ * and state region: the subengines' tops are renumbered into one top space and
+ * the Tamarama dispatches each top to the subengine that owns it. When a top
+ * for a different subengine arrives, the active subengine is run up to the
+ * location of that top and is then discarded.
+ *
+ * The whole engine is laid out in memory as:
+ *
+ * - struct NFA
+ * - struct Tamarama
+ * - u32 baseTop[numSubEngines]: first container top event of each subengine
+ * - u32 subOffset[numSubEngines]: offset of each subengine's struct NFA,
+ *   relative to the start of the container's struct NFA
+ * - the subengines, each cacheline-aligned
+ *
+ * Stream state holds the index of the active subengine (numSubEngines if none
+ * is active) in activeIdxSize bytes, followed by the stream state of the
+ * active subengine. Full state in scratch is shared by all subengines.
+ */
+struct Tamarama {
+    u32 numSubEngines;
+    u8 activeIdxSize; //!< bytes used to store the active subengine index
+};
+
+#endif // NFA_TAMARAMA_INTERNAL_H
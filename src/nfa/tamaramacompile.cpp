@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** \file
+ * \brief Tamarama: container engine for exclusive engines, compiler code.
+ */
+
+#include "tamaramacompile.h"
+
+#include "tamarama_internal.h"
+#include "nfa_api_queue.h"
+#include "nfa_internal.h"
+#include "repeatcompile.h"
+#include "util/container.h"
+#include "util/verify_types.h"
+
+#include <cstring>
+
+using namespace std;
+
+namespace ue2 {
+
+static
+void remapTops(const TamaInfo &tamaInfo, vector<u32> &baseTop,
+               map<pair<const NFA *, u32>, u32> &out_top_remap) {
+    u32 i = 0;
+    u32 cur = MQE_TOP_FIRST;
+    for (const auto &sub : tamaInfo.subengines) {
+        baseTop.push_back(cur);
+        const auto &tops = tamaInfo.tops[i++];
+        assert(!tops.empty());
+
+        if (!isMultiTopType(sub->type)) {
+            // Classic-top engines take a single MQE_TOP, whatever the top.
+            for (const auto &t : tops) {
+                out_top_remap.emplace(make_pair(sub, t), cur);
+            }
+            cur++;
+            continue;
+        }
+
+        for (const auto &t : tops) {
+            DEBUG_PRINTF("subengine %u top %u -> %u\n", i - 1, t, cur + t);
+            out_top_remap.emplace(make_pair(sub, t), cur + t);
+        }
+        cur += *tops.rbegin() + 1;
+        assert(cur < MQE_INVALID);
+    }
+}
+
+/** \brief Fill in the NFA header fields that depend on the subengines. */
+static
+void setupContainerProperties(NFA *nfa, const TamaInfo &tamaInfo,
+                              u32 activeIdxSize) {
+    u32 maxStreamStateSize = 0;
+    u32 maxScratchStateSize = 0;
+    u32 minWidth = ~0U;
+    u32 maxWidth = 0;
+    u32 maxOffset = 0;
+    bool infWidth = false;
+    bool infOffset = false;
+    u32 nPositions = 0;
+
+    for (const auto &sub : tamaInfo.subengines) {
+        maxStreamStateSize = max(maxStreamStateSize, sub->streamStateSize);
+        maxScratchStateSize = max(maxScratchStateSize, sub->scratchStateSize);
+        minWidth = min(minWidth, sub->minWidth);
+        if (!sub->maxWidth) {
+            infWidth = true;
+        }
+        maxWidth = max(maxWidth, sub->maxWidth);
+        if (!sub->maxOffset) {
+            infOffset = true;
+        }
+        maxOffset = max(maxOffset, sub->maxOffset);
+        nPositions += sub->nPositions;
+        if (nfaAcceptsEod(sub)) {
+            nfa->flags |= NFA_ACCEPTS_EOD;
+        }
+    }
+
+    nfa->type = verify_u8(TAMARAMA_NFA_0);
+    nfa->nPositions = nPositions;
+    nfa->streamStateSize = activeIdxSize + maxStreamStateSize;
+    nfa->scratchStateSize = maxScratchStateSize;
+    nfa->minWidth = minWidth;
+    nfa->maxWidth = infWidth ? 0 : maxWidth;
+    nfa->maxOffset = infOffset ? 0 : maxOffset;
+}
+
+void TamaInfo::add(NFA *sub, const set<u32> &top) {
+    assert(subengines.size() < max_occupancy);
+    subengines.push_back(sub);
+    tops.push_back(top);
+}
+
+aligned_unique_ptr<NFA>
+buildTamarama(const TamaInfo &tamaInfo, const u32 queue,
+              map<pair<const NFA *, u32>, u32> &out_top_remap) {
+    const auto &subengines = tamaInfo.subengines;
+    const u32 numSubEngines = verify_u32(subengines.size());
+    assert(numSubEngines > 1);
+    assert(tamaInfo.tops.size() == numSubEngines);
+
+    vector<u32> baseTop;
+    remapTops(tamaInfo, baseTop, out_top_remap);
+
+    // One extra value is needed to mean "no active subengine".
+    u32 activeIdxSize = calcPackedBytes(numSubEngines + 1);
+
+    size_t subSize = 0;
+    for (const auto &sub : subengines) {
+        assert(!isContainerType(sub->type));
+        subSize += ROUNDUP_CL(sub->length);
+    }
+
+    size_t headerSize = sizeof(NFA) + sizeof(Tamarama) +
+                        sizeof(u32) * numSubEngines * 2; // baseTop, subOffset
+    size_t subBase = ROUNDUP_CL(headerSize);
+    size_t total_size = subBase + subSize;
+
+    DEBUG_PRINTF("%u subengines, %zu bytes\n", numSubEngines, total_size);
+
+    aligned_unique_ptr<NFA> nfa = aligned_zmalloc_unique<NFA>(total_size);
+    nfa->length = verify_u32(total_size);
+    nfa->queueIndex = queue;
+    setupContainerProperties(nfa.get(), tamaInfo, activeIdxSize);
+
+    char *ptr = (char *)nfa.get() + sizeof(NFA);
+    Tamarama *t = (Tamarama *)ptr;
+    t->numSubEngines = numSubEngines;
+    t->activeIdxSize = verify_u8(activeIdxSize);
+
+    ptr += sizeof(Tamarama);
+    copy_bytes(ptr, baseTop);
+    ptr += sizeof(u32) * numSubEngines;
+    u32 *subOffset = (u32 *)ptr;
+
+    char *base = (char *)nfa.get();
+    size_t offset = subBase;
+    for (u32 i = 0; i < numSubEngines; i++) {
+        const NFA *sub = subengines[i];
+        subOffset[i] = verify_u32(offset);
+        NFA *dst = (NFA *)(base + offset);
+        memcpy(dst, sub, sub->length);
+        dst->queueIndex = queue;
+        offset += ROUNDUP_CL(sub->length);
+    }
+
+    return nfa;
+}
+
+} // namespace ue2
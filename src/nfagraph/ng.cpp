@@ -78,6 +78,8 @@ namespace ue2 {
 NG::NG(const CompileContext &in_cc, unsigned in_somPrecision)
     : maxSomRevHistoryAvailable(in_cc.grey.somMaxRevNfaLength),
       minWidth(depth::infinity()),
+      maxWidth(0),
+      maxOffset(0),
       rm(in_cc.grey),
       ssm(in_somPrecision),
       cc(in_cc),
@@ -347,6 +349,22 @@ bool NG::addGraph(NGWrapper &w) {
         throw CompileError(w.expressionIndex, "Pattern can never match.");
     }
 
+    if (w.highlander || w.min_offset || w.max_offset != MAX_OFFSET ||
+        w.min_length) {
+        maxWidth = depth::infinity();
+    } else {
+        maxWidth = max(maxWidth, findMaxWidth(w));
+    }
+
+    u64a exprMaxOffset = w.max_offset;
+    if (isAnchored(w)) {
+        depth d = findMaxWidth(w);
+        if (d.is_finite()) {
+            exprMaxOffset = min(exprMaxOffset, (u64a)d);
+        }
+    }
+    maxOffset = max(maxOffset, exprMaxOffset);
+
     optimiseVirtualStarts(w); /* good for som */
 
     handleExtendedParams(rm, w, cc);
@@ -570,6 +588,9 @@ bool NG::addLiteral(const ue2_literal &literal, u32 expr_index,
     rose->add(false, false, literal, {id});
 
     minWidth = min(minWidth, depth(literal.length()));
+    maxWidth = highlander ? depth::infinity()
+                          : max(maxWidth, depth(literal.length()));
+    maxOffset = MAX_OFFSET; // floating literals may match anywhere
 
     smwr->add(literal, id); /* inform small write handler about this literal */
 
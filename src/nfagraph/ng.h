@@ -113,6 +113,18 @@ public:
      * patterns, which give an effective minWidth of zero). */
     depth minWidth;
 
+    /** \brief The length of the longest match any pattern contained in the
+     * NG can produce, or infinity if that is unbounded or if some pattern's
+     * matches depend on more than the bytes matched (single-match and
+     * extended parameter patterns). */
+    depth maxWidth;
+
+    /** \brief The largest offset at which any pattern contained in the NG can
+     * report a match, or MAX_OFFSET if some pattern is unbounded. Bounded
+     * patterns are those with a max_offset extended parameter or anchored
+     * patterns of finite width. */
+    u64a maxOffset;
+
     ReportManager rm;
     SomSlotManager ssm;
     BoundaryReports boundary;
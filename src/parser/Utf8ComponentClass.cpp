@@ -40,9 +40,14 @@
 #include "position_info.h"
 #include "nfagraph/ng_builder.h"
 #include "util/compare.h"
+#include "util/verify_types.h"
 #include "util/unicode_def.h"
 
+#include <algorithm>
 #include <cstring>
+#include <map>
+#include <set>
+#include <vector>
 
 #include "ucp_table.h"
 
@@ -487,14 +492,7 @@ CodePointSet getPredefinedCodePointSet(PredefinedClass c,
 }
 
 UTF8ComponentClass::UTF8ComponentClass(const ParseMode &mode_in)
-    : ComponentClass(mode_in),
-      single_pos(         GlushkovBuildState::POS_UNINITIALIZED),
-      one_dot_trailer(    GlushkovBuildState::POS_UNINITIALIZED),
-      two_dot_trailer(    GlushkovBuildState::POS_UNINITIALIZED),
-      three_dot_trailer(  GlushkovBuildState::POS_UNINITIALIZED),
-      two_char_dot_head(  GlushkovBuildState::POS_UNINITIALIZED),
-      three_char_dot_head(GlushkovBuildState::POS_UNINITIALIZED),
-      four_char_dot_head( GlushkovBuildState::POS_UNINITIALIZED) {
+    : ComponentClass(mode_in) {
     assert(mode.utf8);
 }
 
@@ -585,533 +583,182 @@ void UTF8ComponentClass::finalize() {
     finalized = true;
 }
 
-Position UTF8ComponentClass::getHead(NFABuilder &builder, u8 first_byte) {
-    map<u8, Position>::const_iterator it = heads.find(first_byte);
-    if (it != heads.end()) {
-        return it->second;
-    }
-
-    Position head = builder.makePositions(1);
-    assert(heads.find(first_byte) == heads.end());
-    builder.addCharReach(head, CharReach(first_byte));
-    /* no report id as head can not be directly wired to accept */
-
-    heads[first_byte] = head;
-    return head;
-}
-
-void UTF8ComponentClass::ensureDotTrailer(GlushkovBuildState &bs) {
-    NFABuilder &builder = bs.getBuilder();
-    if (one_dot_trailer != GlushkovBuildState::POS_UNINITIALIZED) {
-        return;
-    }
-
-    one_dot_trailer = builder.makePositions(1);
-    builder.setNodeReportID(one_dot_trailer, 0);
-    builder.addCharReach(one_dot_trailer, CharReach(0x80, 0xbf));
-    tails.insert(one_dot_trailer);
-}
-
-void UTF8ComponentClass::ensureTwoDotTrailer(GlushkovBuildState &bs) {
-    NFABuilder &builder = bs.getBuilder();
-    if (two_dot_trailer != GlushkovBuildState::POS_UNINITIALIZED) {
-        return;
-    }
-
-    ensureDotTrailer(bs);
-
-    two_dot_trailer = builder.makePositions(1);
-    builder.addCharReach(two_dot_trailer, CharReach(0x80, 0xbf));
-    bs.addSuccessor(two_dot_trailer, one_dot_trailer);
-}
-
-void UTF8ComponentClass::ensureThreeDotTrailer(GlushkovBuildState &bs) {
-    NFABuilder &builder = bs.getBuilder();
-    if (three_dot_trailer != GlushkovBuildState::POS_UNINITIALIZED) {
-        return;
-    }
-
-    ensureTwoDotTrailer(bs);
+namespace {
 
-    three_dot_trailer = builder.makePositions(1);
-    builder.addCharReach(three_dot_trailer, CharReach(0x80, 0xbf));
-    bs.addSuccessor(three_dot_trailer, two_dot_trailer);
-}
-
-void UTF8ComponentClass::buildOneByte(GlushkovBuildState &bs) {
-    NFABuilder &builder = bs.getBuilder();
-    for (CodePointSet::const_iterator it = cps.begin(); it != cps.end(); ++it) {
-        unichar b = lower(*it);
-        unichar e = upper(*it) + 1;
-        if (b >= UTF_2CHAR_MIN) {
+/**
+ * \brief Minimised byte automaton over the UTF-8 encodings of a set of code
+ * points.
+ *
+ * Built bottom-up over the encoding tree: a node stands for the continuation
+ * byte sequences that complete a code point in the set from some prefix, and
+ * nodes completing the same sequences are merged, so that common suffixes are
+ * shared across lead bytes and ranges. Edges from one node to the same child
+ * are merged into a single edge whose reach is the union of their bytes.
+ */
+class Utf8Automaton {
+public:
+    explicit Utf8Automaton(const CodePointSet &cps);
+
+    /** \brief Node reached at the end of a complete encoding. */
+    static const u32 ACCEPT = 0;
+
+    /** \brief Node for the start of an encoding. */
+    u32 root;
+
+    /** \brief Out-edges of each node as (child, reach), ordered by child. */
+    vector<vector<pair<u32, CharReach>>> edges;
+
+private:
+    static const u32 NONE = ~0U;
+
+    u32 build(u32 conts, unichar base);
+    u32 full(u32 conts);
+    u32 addNode(const map<u32, CharReach> &out);
+    bool covers(unichar lo, unichar hi, bool *full_out) const;
+
+    /** \brief Intervals of the set with the encoding length being built. */
+    vector<pair<unichar, unichar>> ranges;
+
+    map<vector<pair<u32, CharReach>>, u32> nodeIds;
+};
+
+Utf8Automaton::Utf8Automaton(const CodePointSet &cps) {
+    static const unichar len_min[] = {0, UTF_2CHAR_MIN, UTF_3CHAR_MIN,
+                                      UTF_4CHAR_MIN};
+    static const unichar len_max[] = {UTF_2CHAR_MIN - 1, UTF_3CHAR_MIN - 1,
+                                      UTF_4CHAR_MIN - 1, MAX_UNICODE};
+    static const u8 headers[] = {0, UTF_TWO_BYTE_HEADER,
+                                 UTF_THREE_BYTE_HEADER, UTF_FOUR_BYTE_HEADER};
+
+    edges.push_back(vector<pair<u32, CharReach>>()); // ACCEPT
+
+    map<u32, CharReach> root_out;
+    for (u32 conts = 0; conts < 4; conts++) {
+        ranges.clear();
+        for (const auto &i : cps) {
+            unichar lo = MAX(lower(i), len_min[conts]);
+            unichar hi = MIN(upper(i), len_max[conts]);
+            if (lo <= hi) {
+                ranges.push_back(make_pair(lo, hi));
+            }
+        }
+        if (ranges.empty()) {
             continue;
         }
 
-        DEBUG_PRINTF("building vertices for [%u, %u)\n", b, e);
-
-        if (single_pos == GlushkovBuildState::POS_UNINITIALIZED) {
-            single_pos = builder.makePositions(1);
-            builder.setNodeReportID(single_pos, 0 /* offset adj */);
-            tails.insert(single_pos);
+        u32 shift = conts * UTF_CONT_SHIFT;
+        unichar first = ranges.front().first >> shift;
+        unichar last = ranges.back().second >> shift;
+        for (unichar p = first; p <= last; p++) {
+            u32 child = build(conts, p << shift);
+            if (child != NONE) {
+                root_out[child].set(headers[conts] | p);
+            }
         }
-        CharReach cr(b, MIN(e, UTF_2CHAR_MIN) - 1);
-        builder.addCharReach(single_pos, cr);
-    }
-}
-
-void UTF8ComponentClass::addToTail(GlushkovBuildState &bs,
-                                   map<Position, Position> &finals,
-                                   Position prev, unichar b, unichar e) {
-    NFABuilder &builder = bs.getBuilder();
-    Position tail;
-    if (finals.find(prev) == finals.end()) {
-        tail = builder.makePositions(1);
-        builder.setNodeReportID(tail, 0 /* offset adj */);
-        bs.addSuccessor(prev, tail);
-        finals[prev] = tail;
-        tails.insert(tail);
-    } else {
-        tail = finals[prev];
     }
 
-    u8 bb = makeContByte(b);
-    u8 ee = makeContByte(e - 1);
-    builder.addCharReach(tail, CharReach(bb, ee));
+    root = addNode(root_out);
 }
 
-void UTF8ComponentClass::buildTwoByte(GlushkovBuildState &bs) {
-    NFABuilder &builder = bs.getBuilder();
-    map<Position, Position> finals;
-
-    for (auto it = cps.begin(); it != cps.end(); ++it) {
-        unichar b = lower(*it);
-        unichar e = upper(*it) + 1;
-
-        b = MAX(b, UTF_2CHAR_MIN);
-        e = MIN(e, UTF_3CHAR_MIN);
-
-        if (b >= e) {
-            continue; /* we're done here */
-        }
-
-        /* raise b to the start of the next tail byte boundary */
-        if (b & UTF_CONT_BYTE_VALUE_MASK) {
-            unichar bb = MIN(e, ROUNDUP_N(b, UTF_CONT_BYTE_RANGE));
-            u8 first_byte = UTF_TWO_BYTE_HEADER | (b >> UTF_CONT_SHIFT);
-            assert(first_byte > 0xc1 && first_byte <= 0xdf);
-
-            Position head = getHead(builder, first_byte);
-            addToTail(bs, finals, head, b, bb);
-
-            b = bb;
-        }
-
-        if (b == e) {
-            continue; /* we're done here */
-        }
-        assert(b < e);
-
-        /* lower e to the end of a tail byte boundary */
-        if (e & UTF_CONT_BYTE_VALUE_MASK) {
-            unichar ee = e & ~UTF_CONT_BYTE_VALUE_MASK;
-            assert(ee >= b);
-
-            u8 first_byte = UTF_TWO_BYTE_HEADER | (ee >> UTF_CONT_SHIFT);
-            assert(first_byte > 0xc1 && first_byte <= 0xdf);
-
-            Position head = getHead(builder, first_byte);
-            addToTail(bs, finals, head, ee, e);
-
-            e = ee;
-        }
-
-        if (b == e) {
-            continue; /* we're done here */
-        }
-        assert(b < e);
+/** \brief Returns true if [lo, hi] intersects the current ranges, setting
+ * \a full_out if it lies wholly within them. */
+bool Utf8Automaton::covers(unichar lo, unichar hi, bool *full_out) const {
+    auto it = lower_bound(ranges.begin(), ranges.end(), lo,
+                          [](const pair<unichar, unichar> &r, unichar v) {
+                              return r.second < v;
+                          });
+    if (it == ranges.end() || it->first > hi) {
+        return false;
+    }
+    // Intervals in a CodePointSet are never adjacent, so only one can
+    // contain the whole of [lo, hi].
+    *full_out = it->first <= lo && it->second >= hi;
+    return true;
+}
 
-        /* middle section just goes to a common full vertex */
-        ensureDotTrailer(bs);
+/** \brief Builds the node for the \a conts continuation bytes that follow
+ * the prefix of the code points starting at \a base. */
+u32 Utf8Automaton::build(u32 conts, unichar base) {
+    unichar span = 1U << (conts * UTF_CONT_SHIFT);
+    bool is_full = false;
+    if (!covers(base, base + span - 1, &is_full)) {
+        return NONE;
+    }
+    if (is_full) {
+        return full(conts);
+    }
 
-        if (two_char_dot_head == GlushkovBuildState::POS_UNINITIALIZED) {
-            two_char_dot_head = builder.makePositions(1);
-            bs.addSuccessor(two_char_dot_head, one_dot_trailer);
+    assert(conts); // a single code point is either in the set or not
+    unichar child_span = span >> UTF_CONT_SHIFT;
+    map<u32, CharReach> out;
+    for (u32 c = 0; c < UTF_CONT_BYTE_RANGE; c++) {
+        u32 child = build(conts - 1, base + c * child_span);
+        if (child != NONE) {
+            out[child].set(makeContByte(c));
         }
-
-        u8 min_first_byte =  UTF_TWO_BYTE_HEADER | (b >> UTF_CONT_SHIFT);
-        u8 max_first_byte =  UTF_TWO_BYTE_HEADER | ((e - 1) >> UTF_CONT_SHIFT);
-
-        assert(min_first_byte > 0xc1 && min_first_byte <= 0xdf);
-        assert(max_first_byte > 0xc1 && max_first_byte <= 0xdf);
-
-        builder.addCharReach(two_char_dot_head,
-                             CharReach(min_first_byte, max_first_byte));
     }
+    assert(!out.empty());
+    return addNode(out);
 }
 
-static
-Position getMid(GlushkovBuildState &bs, map<Position, map<u8, Position> > &mids,
-                const Position &prev, u8 byte_val) {
-    NFABuilder &builder = bs.getBuilder();
-    map<u8, Position> &by_byte = mids[prev];
-
-    map<u8, Position>::const_iterator it = by_byte.find(byte_val);
-    if (it != by_byte.end()) {
-        return it->second;
+/** \brief Node accepting any \a conts continuation bytes. */
+u32 Utf8Automaton::full(u32 conts) {
+    if (!conts) {
+        return ACCEPT;
     }
 
-    Position mid = builder.makePositions(1);
-    builder.addCharReach(mid, CharReach(byte_val));
-    bs.addSuccessor(prev, mid);
-    /* no report id as mid can not be directly wired to accept */
-
-    by_byte[byte_val] = mid;
-    return mid;
+    map<u32, CharReach> out;
+    out[full(conts - 1)] = UTF_CONT_CR;
+    return addNode(out);
 }
 
-void UTF8ComponentClass::buildThreeByte(GlushkovBuildState &bs) {
-    NFABuilder &builder = bs.getBuilder();
-
-    map<Position, map<u8, Position> > mids;
-    map<Position, Position> finals;
-
-    for (auto it = cps.begin(); it != cps.end(); ++it) {
-        unichar b = lower(*it);
-        unichar e = upper(*it) + 1;
-
-        b = MAX(b, UTF_3CHAR_MIN);
-        e = MIN(e, UTF_4CHAR_MIN);
-
-        if (b >= e) {
-            continue; /* we're done here */
-        }
-
-        /* raise b to the start of the next tail byte boundary */
-        if (b & UTF_CONT_BYTE_VALUE_MASK) {
-            unichar bb = MIN(e, ROUNDUP_N(b, UTF_CONT_BYTE_RANGE));
-
-            u8 first_byte = UTF_THREE_BYTE_HEADER | (b >> (2 * UTF_CONT_SHIFT));
-            assert(first_byte >= 0xe0 && first_byte <= 0xef);
-            Position head = getHead(builder, first_byte);
-
-            u8 second_byte = makeContByte(b >> UTF_CONT_SHIFT);
-            Position mid = getMid(bs, mids, head, second_byte);
-
-            addToTail(bs, finals, mid, b, bb);
-
-            b = bb;
-        }
-
-        if (b == e) {
-            continue; /* we're done here */
-        }
-        assert(b < e);
-
-        /* lower e to the end of a tail byte boundary */
-        if (e & UTF_CONT_BYTE_VALUE_MASK) {
-            unichar ee = e & ~UTF_CONT_BYTE_VALUE_MASK;
-            assert(ee >= b);
-
-            u8 first_byte = UTF_THREE_BYTE_HEADER
-                          | (ee >> (2 * UTF_CONT_SHIFT));
-            assert(first_byte >= 0xe0 && first_byte <= 0xef);
-            Position head = getHead(builder, first_byte);
-
-            u8 second_byte = makeContByte(ee >> UTF_CONT_SHIFT);
-            Position mid = getMid(bs, mids, head, second_byte);
-
-            addToTail(bs, finals, mid, ee, e);
-
-            e = ee;
-        }
-
-        if (b == e) {
-            continue; /* we're done here */
-        }
-        assert(b < e);
-
-        /* from here on in the last byte is always full */
-        ensureDotTrailer(bs);
-
-        /* raise b to the start of the next mid byte boundary */
-        if (b & ((1 << (2 * UTF_CONT_SHIFT)) - 1)) {
-            unichar bb = MIN(e, ROUNDUP_N(b, 1 << (2 * UTF_CONT_SHIFT)));
-
-            u8 first_byte = UTF_THREE_BYTE_HEADER | (b >> (2 * UTF_CONT_SHIFT));
-            Position head = getHead(builder, first_byte);
-
-            Position mid = builder.makePositions(1);
-            bs.addSuccessor(head, mid);
-            bs.addSuccessor(mid, one_dot_trailer);
-            /* no report id as mid can not be directly wired to accept,
-             * not adding to mids as we are completely filling its downstream */
-            u8 second_min = makeContByte(b >> UTF_CONT_SHIFT);
-            u8 second_max = makeContByte((bb - 1) >> UTF_CONT_SHIFT);
-
-            builder.addCharReach(mid, CharReach(second_min, second_max));
-
-            b = bb;
-        }
-
-        if (b == e) {
-            continue; /* we're done here */
-        }
-        assert(b < e);
-
-        /* lower e to the end of a mid byte boundary */
-        if (e & ((1 << (2 * UTF_CONT_SHIFT)) - 1)) {
-            unichar ee = e & ~((1 << (2 * UTF_CONT_SHIFT)) - 1);
-            assert(ee >= b);
-
-            u8 first_byte = UTF_THREE_BYTE_HEADER
-                          | (ee >> (2 * UTF_CONT_SHIFT));
-            Position head = getHead(builder, first_byte);
-
-            Position mid = builder.makePositions(1);
-            bs.addSuccessor(head, mid);
-            bs.addSuccessor(mid, one_dot_trailer);
-            /* no report id as mid can not be directly wired to accept,
-             * not adding to mids as we are completely filling its downstream */
-            u8 second_min = makeContByte(ee >> UTF_CONT_SHIFT);
-            u8 second_max = makeContByte((e - 1) >> UTF_CONT_SHIFT);
-
-            builder.addCharReach(mid, CharReach(second_min, second_max));
-
-            e = ee;
-        }
-
-        if (b == e) {
-            continue; /* we're done here */
-        }
-        assert(b < e);
-
-        /* now we just have to wire head to a common dot trailer */
-        ensureTwoDotTrailer(bs);
-        if (three_char_dot_head == GlushkovBuildState::POS_UNINITIALIZED) {
-            three_char_dot_head = builder.makePositions(1);
-            bs.addSuccessor(three_char_dot_head, two_dot_trailer);
-        }
-
-        u8 min_first_byte =  UTF_THREE_BYTE_HEADER
-                          | (b >> (2 * UTF_CONT_SHIFT));
-        u8 max_first_byte =  UTF_THREE_BYTE_HEADER
-                          | ((e - 1) >> (2 * UTF_CONT_SHIFT));
-
-        assert(min_first_byte > 0xdf && min_first_byte <= 0xef);
-        assert(max_first_byte > 0xdf && max_first_byte <= 0xef);
-
-        builder.addCharReach(three_char_dot_head,
-                             CharReach(min_first_byte, max_first_byte));
+u32 Utf8Automaton::addNode(const map<u32, CharReach> &out) {
+    vector<pair<u32, CharReach>> key(out.begin(), out.end());
+    auto it = nodeIds.find(key);
+    if (it != nodeIds.end()) {
+        return it->second;
     }
-}
 
-static
-u8 makeFirstByteOfFour(unichar raw) {
-    u8 first_byte = UTF_FOUR_BYTE_HEADER | (raw >> (3 * UTF_CONT_SHIFT));
-    assert(first_byte > 0xef && first_byte <= 0xf7);
-    return first_byte;
+    u32 id = verify_u32(edges.size());
+    edges.push_back(key);
+    nodeIds.emplace(move(key), id);
+    return id;
 }
 
+/** \brief Creates (or reuses) a position for each out-edge of \a node and
+ * returns them. An edge's position depends only on its reach and target, so
+ * edges that agree on both share a position wherever they appear. */
 static
-bool isTwoContAligned(unichar raw) {
-    return !(raw & ((1 << (2 * UTF_CONT_SHIFT)) - 1));
-}
-
-static
-bool isThreeContAligned(unichar raw) {
-    return !(raw & ((1 << (3 * UTF_CONT_SHIFT)) - 1));
-}
-
-void UTF8ComponentClass::buildFourByte(GlushkovBuildState &bs) {
+vector<Position> wireNode(GlushkovBuildState &bs, const Utf8Automaton &a,
+                          u32 node, map<pair<u32, CharReach>, Position> &built,
+                          set<Position> &tails) {
     NFABuilder &builder = bs.getBuilder();
-    map<Position, map<u8, Position> > mids;
-    map<Position, Position> finals;
-
-    for (auto it = cps.begin(); it != cps.end(); ++it) {
-        unichar b = lower(*it);
-        unichar e = upper(*it) + 1;
-
-        b = MAX(b, UTF_4CHAR_MIN);
-        e = MIN(e, MAX_UNICODE + 1);
-
-        if (b >= e) {
+    vector<Position> rv;
+    for (const auto &e : a.edges[node]) {
+        auto it = built.find(e);
+        if (it != built.end()) {
+            rv.push_back(it->second);
             continue;
         }
 
-        /* raise b to the start of the next tail byte boundary */
-        if (b & UTF_CONT_BYTE_VALUE_MASK) {
-            unichar bb = MIN(e, ROUNDUP_N(b, UTF_CONT_BYTE_RANGE));
-
-            u8 first_byte = makeFirstByteOfFour(b);
-            Position head = getHead(builder, first_byte);
-
-            u8 second_byte = makeContByte(b >> (2 * UTF_CONT_SHIFT));
-            Position mid1 = getMid(bs, mids, head, second_byte);
-
-            u8 third_byte = makeContByte(b >> UTF_CONT_SHIFT);
-            Position mid2 = getMid(bs, mids, mid1, third_byte);
-
-            addToTail(bs, finals, mid2, b, bb);
-
-            b = bb;
-        }
-
-        if (b == e) {
-            continue; /* we're done here */
-        }
-        assert(b < e);
-
-        /* lower e to the end of a tail byte boundary */
-        if (e & UTF_CONT_BYTE_VALUE_MASK) {
-            unichar ee = e & ~UTF_CONT_BYTE_VALUE_MASK;
-            assert(ee >= b);
-
-            u8 first_byte = makeFirstByteOfFour(ee);
-            Position head = getHead(builder, first_byte);
-
-            u8 second_byte = makeContByte(ee >> (2 * UTF_CONT_SHIFT));
-            Position mid1 = getMid(bs, mids, head, second_byte);
-
-            u8 third_byte = makeContByte(ee >> UTF_CONT_SHIFT);
-            Position mid2 = getMid(bs, mids, mid1, third_byte);
-
-            addToTail(bs, finals, mid2, ee, e);
-
-            e = ee;
-        }
-
-        if (b == e) {
-            continue; /* we're done here */
-        }
-        assert(b < e);
-
-        /* from here on in the last byte is always full */
-        ensureDotTrailer(bs);
-
-        /* raise b to the start of the next mid byte boundary */
-        if (!isTwoContAligned(b)) {
-            unichar bb = MIN(e, ROUNDUP_N(b, 1 << (2 * UTF_CONT_SHIFT)));
-
-            u8 first_byte = makeFirstByteOfFour(b);
-            Position head = getHead(builder, first_byte);
-
-            u8 second_byte = makeContByte(b >> (2 * UTF_CONT_SHIFT));
-            Position mid1 = getMid(bs, mids, head, second_byte);
-
-            Position mid2 = builder.makePositions(1);
-            bs.addSuccessor(mid1, mid2);
-            bs.addSuccessor(mid2, one_dot_trailer);
-            /* no report id as mid can not be directly wired to accept,
-             * not adding to mids as we are completely filling its downstream */
-            u8 byte_min = makeContByte(b >> UTF_CONT_SHIFT);
-            u8 byte_max = makeContByte((bb - 1) >> UTF_CONT_SHIFT);
-
-            builder.addCharReach(mid2, CharReach(byte_min, byte_max));
-
-            b = bb;
-        }
-
-        if (b == e) {
-            continue; /* we're done here */
-        }
-        assert(b < e);
-
-        /* lower e to the end of a mid byte boundary */
-        if (!isTwoContAligned(e)) {
-            unichar ee = e & ~((1 << (2 * UTF_CONT_SHIFT)) - 1);
-            assert(ee >= b);
-
-            u8 first_byte = makeFirstByteOfFour(ee);
-            Position head = getHead(builder, first_byte);
-
-            u8 second_byte = makeContByte(ee >> (2 * UTF_CONT_SHIFT));
-            Position mid1 = getMid(bs, mids, head, second_byte);
-
-            Position mid2 = builder.makePositions(1);
-            bs.addSuccessor(mid1, mid2);
-            bs.addSuccessor(mid2, one_dot_trailer);
-            /* no report id as mid can not be directly wired to accept,
-             * not adding to mids as we are completely filling its downstream */
-            u8 byte_min = makeContByte(ee >> UTF_CONT_SHIFT);
-            u8 byte_max = makeContByte((e - 1) >> UTF_CONT_SHIFT);
-
-            builder.addCharReach(mid2, CharReach(byte_min, byte_max));
-
-            e = ee;
-        }
-
-        if (b == e) {
-            continue; /* we're done here */
-        }
-        assert(b < e);
-
-        ensureTwoDotTrailer(bs);
-
-        /* raise b to the next byte boundary */
-        if (!isThreeContAligned(b)) {
-            unichar bb = MIN(e, ROUNDUP_N(b, 1 << (3 * UTF_CONT_SHIFT)));
-
-            u8 first_byte = makeFirstByteOfFour(b);
-            Position head = getHead(builder, first_byte);
-
-            Position mid1 = builder.makePositions(1);
-            bs.addSuccessor(head, mid1);
-            bs.addSuccessor(mid1, two_dot_trailer);
-            /* no report id as mid can not be directly wired to accept,
-             * not adding to mids as we are completely filling its downstream */
-            u8 byte_min = makeContByte(b >> (2 * UTF_CONT_SHIFT));
-            u8 byte_max = makeContByte((bb - 1) >> (2 * UTF_CONT_SHIFT));
-
-            builder.addCharReach(mid1, CharReach(byte_min, byte_max));
-
-            b = bb;
-        }
-
-        if (b == e) {
-            continue; /* we're done here */
-        }
-        assert(b < e);
-
-        /* lower e to the next byte boundary */
-        if (!isThreeContAligned(e)) {
-            unichar ee = e & ~((1 << (3 * UTF_CONT_SHIFT)) - 1);
-            assert(ee >= b);
-
-            u8 first_byte = makeFirstByteOfFour(ee);
-            Position head = getHead(builder, first_byte);
-            Position mid1 = builder.makePositions(1);
-            bs.addSuccessor(head, mid1);
-            bs.addSuccessor(mid1, two_dot_trailer);
-            /* no report id as mid can not be directly wired to accept,
-             * not adding to mids as we are completely filling its downstream */
-            u8 byte_min = makeContByte(ee >> (2 * UTF_CONT_SHIFT));
-            u8 byte_max = makeContByte((e - 1) >> (2 * UTF_CONT_SHIFT));
-
-            builder.addCharReach(mid1, CharReach(byte_min, byte_max));
-
-            e = ee;
-        }
-
-        if (b == e) {
-            continue; /* we're done here */
-        }
-        assert(b < e);
-
-        /* now we just have to wire head to a common dot trailer */
-        ensureThreeDotTrailer(bs);
-        if (four_char_dot_head == GlushkovBuildState::POS_UNINITIALIZED) {
-            four_char_dot_head = builder.makePositions(1);
-            bs.addSuccessor(four_char_dot_head, three_dot_trailer);
+        Position pos = builder.makePositions(1);
+        builder.addCharReach(pos, e.second);
+        if (e.first == Utf8Automaton::ACCEPT) {
+            builder.setNodeReportID(pos, 0 /* offset adj */);
+            tails.insert(pos);
+        } else {
+            for (Position succ : wireNode(bs, a, e.first, built, tails)) {
+                bs.addSuccessor(pos, succ);
+            }
         }
-
-        u8 min_first_byte = makeFirstByteOfFour(b);
-        u8 max_first_byte = makeFirstByteOfFour(e - 1);
-
-        builder.addCharReach(four_char_dot_head,
-                             CharReach(min_first_byte, max_first_byte));
+        built.emplace(e, pos);
+        rv.push_back(pos);
     }
+    return rv;
 }
 
+} // namespace
+
 void UTF8ComponentClass::notePositions(GlushkovBuildState &bs) {
     // We should always be finalized by now.
     assert(finalized);
@@ -1122,19 +769,21 @@ void UTF8ComponentClass::notePositions(GlushkovBuildState &bs) {
     // connected graph) and pick it up later on.
     if (class_empty()) {
         DEBUG_PRINTF("empty class!\n");
-        assert(single_pos == GlushkovBuildState::POS_UNINITIALIZED);
+        assert(heads.empty());
         NFABuilder &builder = bs.getBuilder();
-        single_pos = builder.makePositions(1);
-        builder.setNodeReportID(single_pos, 0 /* offset adj */);
-        builder.addCharReach(single_pos, CharReach());
-        tails.insert(single_pos);
+        Position pos = builder.makePositions(1);
+        builder.setNodeReportID(pos, 0 /* offset adj */);
+        builder.addCharReach(pos, CharReach());
+        heads.push_back(pos);
+        tails.insert(pos);
         return;
     }
 
-    buildOneByte(bs);
-    buildTwoByte(bs);
-    buildThreeByte(bs);
-    buildFourByte(bs);
+    Utf8Automaton a(cps);
+    DEBUG_PRINTF("byte automaton has %zu nodes\n", a.edges.size());
+
+    map<pair<u32, CharReach>, Position> built;
+    heads = wireNode(bs, a, a.root, built, tails);
 }
 
 void UTF8ComponentClass::buildFollowSet(GlushkovBuildState &,
@@ -1143,24 +792,7 @@ void UTF8ComponentClass::buildFollowSet(GlushkovBuildState &,
 }
 
 vector<PositionInfo> UTF8ComponentClass::first(void) const {
-    vector<PositionInfo> rv;
-    if (single_pos != GlushkovBuildState::POS_UNINITIALIZED) {
-        rv.push_back(single_pos);
-    }
-    if (two_char_dot_head != GlushkovBuildState::POS_UNINITIALIZED) {
-        rv.push_back(two_char_dot_head);
-    }
-    if (three_char_dot_head != GlushkovBuildState::POS_UNINITIALIZED) {
-        rv.push_back(three_char_dot_head);
-    }
-    if (four_char_dot_head != GlushkovBuildState::POS_UNINITIALIZED) {
-        rv.push_back(four_char_dot_head);
-    }
-
-    for (auto it = heads.begin(); it != heads.end(); ++it) {
-        rv.push_back(it->second);
-    }
-    return rv;
+    return vector<PositionInfo>(heads.begin(), heads.end());
 }
 
 vector<PositionInfo> UTF8ComponentClass::last(void) const {
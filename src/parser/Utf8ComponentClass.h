@@ -37,7 +37,6 @@
 #include "ue2common.h"
 #include "util/unicode_set.h"
 
-#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -81,28 +80,12 @@ protected:
     void createRange(unichar to) override;
 
 private:
-    Position getHead(NFABuilder &builder, u8 first_byte);
-    void addToTail(GlushkovBuildState &bs, std::map<Position, Position> &finals,
-                   Position prev, unichar b, unichar e);
-    void ensureDotTrailer(GlushkovBuildState &bs);
-    void ensureTwoDotTrailer(GlushkovBuildState &bs);
-    void ensureThreeDotTrailer(GlushkovBuildState &bs);
-    void buildOneByte(GlushkovBuildState &bs);
-    void buildTwoByte(GlushkovBuildState &bs);
-    void buildThreeByte(GlushkovBuildState &bs);
-    void buildFourByte(GlushkovBuildState &bs);
-
     CodePointSet cps;
 
-    std::map<u8, Position> heads;
-    Position single_pos;
-    Position one_dot_trailer;
-    Position two_dot_trailer;
-    Position three_dot_trailer;
+    /** \brief Positions matching the first byte of an encoding. */
+    std::vector<Position> heads;
 
-    Position two_char_dot_head;
-    Position three_char_dot_head;
-    Position four_char_dot_head;
+    /** \brief Positions matching the last byte of an encoding. */
     std::set<Position> tails;
 };
 
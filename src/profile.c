@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Scan cost profiling API.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "database.h"
+#include "hs_profile.h"
+#include "profile.h"
+#include "scratch.h"
+#include "ue2common.h"
+#include "rose/rose_internal.h"
+
+#ifdef PROFILE_SUPPORT
+
+static
+char validProfile(const struct hs_profile *p) {
+    return p && p->magic == PROFILE_MAGIC;
+}
+
+static
+const u32 *getProvenanceList(const struct RoseEngine *t, u32 bounds_offset,
+                             u32 i, u32 *len) {
+    const struct RoseProvenance *prov = getProvenance(t);
+    const u32 *bounds = (const u32 *)((const char *)t + bounds_offset);
+    const u32 *owners = (const u32 *)((const char *)t + prov->ownerOffset);
+    *len = bounds[i + 1] - bounds[i];
+    return owners + bounds[i];
+}
+
+static
+int cmpId(const void *a, const void *b) {
+    u32 x = *(const u32 *)a;
+    u32 y = *(const u32 *)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static
+int cmpEntryId(const void *key, const void *elem) {
+    u32 id = *(const u32 *)key;
+    const hs_profile_entry_t *e = elem;
+    return id < e->id ? -1 : id > e->id ? 1 : 0;
+}
+
+static
+int cmpEntryCost(const void *a, const void *b) {
+    const hs_profile_entry_t *x = a;
+    const hs_profile_entry_t *y = b;
+    if (x->cycles != y->cycles) {
+        return x->cycles > y->cycles ? -1 : 1;
+    }
+    if (x->events != y->events) {
+        return x->events > y->events ? -1 : 1;
+    }
+    return x->id < y->id ? -1 : x->id > y->id ? 1 : 0;
+}
+
+/** \brief Splits one literal's or engine's cost evenly between its owners. */
+static
+void chargeOwners(hs_profile_entry_t *entries, u32 entry_count,
+                  const u32 *owners, u32 len, u64a cycles, u64a events) {
+    if (!len || (!cycles && !events)) {
+        return;
+    }
+
+    u64a share = cycles / len;
+    u64a rem = cycles - share * len;
+    for (u32 i = 0; i < len; i++) {
+        hs_profile_entry_t *e = bsearch(&owners[i], entries, entry_count,
+                                        sizeof(*entries), cmpEntryId);
+        assert(e);
+        e->cycles += share + (i < rem ? 1 : 0);
+        e->events += events;
+    }
+}
+
+#endif // PROFILE_SUPPORT
+
+HS_PUBLIC_API
+hs_error_t hs_alloc_profile(const hs_database_t *db, hs_profile_t **profile) {
+#ifdef PROFILE_SUPPORT
+    if (!profile) {
+        return HS_INVALID;
+    }
+    *profile = NULL;
+
+    hs_error_t ret = validDatabase(db);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    const struct RoseProvenance *prov = getProvenance(rose);
+    if (!prov) {
+        DEBUG_PRINTF("database has no provenance table\n");
+        return HS_INVALID;
+    }
+
+    size_t counters = 2 * ((size_t)prov->literalCount + prov->queueCount);
+    size_t size = sizeof(struct hs_profile) + counters * sizeof(u64a);
+    struct hs_profile *p = hs_misc_alloc(size);
+    ret = hs_check_alloc(p);
+    if (ret != HS_SUCCESS) {
+        hs_misc_free(p);
+        return ret;
+    }
+
+    memset(p, 0, size);
+    p->magic = PROFILE_MAGIC;
+    p->rose = rose;
+    p->literalCount = prov->literalCount;
+    p->queueCount = prov->queueCount;
+    p->litCycles = (u64a *)(p + 1);
+    p->litEvents = p->litCycles + p->literalCount;
+    p->queueCycles = p->litEvents + p->literalCount;
+    p->queueEvents = p->queueCycles + p->queueCount;
+
+    *profile = p;
+    return HS_SUCCESS;
+#else
+    if (profile) {
+        *profile = NULL;
+    }
+    (void)db;
+    return HS_INVALID;
+#endif
+}
+
+HS_PUBLIC_API
+hs_error_t hs_free_profile(hs_profile_t *profile) {
+#ifdef PROFILE_SUPPORT
+    if (profile) {
+        if (!validProfile(profile)) {
+            return HS_INVALID;
+        }
+        profile->magic = 0;
+        hs_misc_free(profile);
+    }
+    return HS_SUCCESS;
+#else
+    return profile ? HS_INVALID : HS_SUCCESS;
+#endif
+}
+
+HS_PUBLIC_API
+hs_error_t hs_reset_profile(hs_profile_t *profile) {
+#ifdef PROFILE_SUPPORT
+    if (!validProfile(profile)) {
+        return HS_INVALID;
+    }
+
+    size_t counters =
+        2 * ((size_t)profile->literalCount + profile->queueCount);
+    memset(profile->litCycles, 0, counters * sizeof(u64a));
+    profile->child = 0;
+    return HS_SUCCESS;
+#else
+    (void)profile;
+    return HS_INVALID;
+#endif
+}
+
+HS_PUBLIC_API
+hs_error_t hs_set_scratch_profile(hs_scratch_t *scratch,
+                                  hs_profile_t *profile) {
+#ifdef PROFILE_SUPPORT
+    if (!scratch || !ISALIGNED_CL(scratch) || scratch->magic != SCRATCH_MAGIC) {
+        return HS_INVALID;
+    }
+    if (profile && !validProfile(profile)) {
+        return HS_INVALID;
+    }
+
+    scratch->profile = profile;
+    return HS_SUCCESS;
+#else
+    (void)scratch;
+    (void)profile;
+    return HS_INVALID;
+#endif
+}
+
+HS_PUBLIC_API
+hs_error_t hs_profile_top(const hs_profile_t *profile, unsigned int max,
+                          hs_profile_entry_t *entries, unsigned int *count) {
+#ifdef PROFILE_SUPPORT
+    if (!validProfile(profile) || !count || (max && !entries)) {
+        return HS_INVALID;
+    }
+    *count = 0;
+
+    const struct RoseEngine *t = profile->rose;
+    const struct RoseProvenance *prov = getProvenance(t);
+    assert(prov);
+    // The queue lists follow the literal lists in the owner array, so the
+    // last queue bound is the length of the whole array.
+    u32 owner_count = ((const u32 *)((const char *)t +
+                                     prov->queueBoundsOffset))[prov->queueCount];
+    if (!owner_count) {
+        return HS_SUCCESS;
+    }
+
+    const u32 *owners = (const u32 *)((const char *)t + prov->ownerOffset);
+    u32 *ids = hs_misc_alloc(owner_count * sizeof(u32));
+    hs_error_t ret = hs_check_alloc(ids);
+    if (ret != HS_SUCCESS) {
+        hs_misc_free(ids);
+        return ret;
+    }
+    memcpy(ids, owners, owner_count * sizeof(u32));
+    qsort(ids, owner_count, sizeof(u32), cmpId);
+
+    // One entry per distinct expression id, sorted by id.
+    hs_profile_entry_t *all = hs_misc_alloc(owner_count * sizeof(*all));
+    ret = hs_check_alloc(all);
+    if (ret != HS_SUCCESS) {
+        hs_misc_free(all);
+        hs_misc_free(ids);
+        return ret;
+    }
+
+    u32 entry_count = 0;
+    for (u32 i = 0; i < owner_count; i++) {
+        if (!i || ids[i] != ids[i - 1]) {
+            memset(&all[entry_count], 0, sizeof(*all));
+            all[entry_count].id = ids[i];
+            entry_count++;
+        }
+    }
+    hs_misc_free(ids);
+
+    for (u32 i = 0; i < profile->literalCount; i++) {
+        u32 len;
+        const u32 *list = getProvenanceList(t, prov->literalBoundsOffset, i,
+                                            &len);
+        chargeOwners(all, entry_count, list, len, profile->litCycles[i],
+                     profile->litEvents[i]);
+    }
+
+    for (u32 i = 0; i < profile->queueCount; i++) {
+        u32 len;
+        const u32 *list = getProvenanceList(t, prov->queueBoundsOffset, i,
+                                            &len);
+        chargeOwners(all, entry_count, list, len, profile->queueCycles[i],
+                     profile->queueEvents[i]);
+    }
+
+    qsort(all, entry_count, sizeof(*all), cmpEntryCost);
+
+    u32 n = MIN(max, entry_count);
+    memcpy(entries, all, n * sizeof(*all));
+    *count = n;
+
+    hs_misc_free(all);
+    return HS_SUCCESS;
+#else
+    (void)profile;
+    (void)max;
+    (void)entries;
+    if (count) {
+        *count = 0;
+    }
+    return HS_INVALID;
+#endif
+}
+
+HS_PUBLIC_API
+hs_error_t hs_profile_engine(const hs_profile_t *profile, unsigned int index,
+                             unsigned long long *cycles,
+                             unsigned long long *events) {
+#ifdef PROFILE_SUPPORT
+    if (!validProfile(profile) || !cycles || !events) {
+        return HS_INVALID;
+    }
+    if (index >= profile->queueCount) {
+        return HS_INVALID;
+    }
+
+    *cycles = profile->queueCycles[index];
+    *events = profile->queueEvents[index];
+    return HS_SUCCESS;
+#else
+    (void)profile;
+    (void)index;
+    (void)cycles;
+    (void)events;
+    return HS_INVALID;
+#endif
+}
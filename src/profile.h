@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Scan cost profiling: runtime counters and timing hooks.
+ *
+ * Only compiled in when the library is configured with PROFILE_SUPPORT; see
+ * hs_profile.h for the API.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "ue2common.h"
+
+#ifdef PROFILE_SUPPORT
+
+#include "util/simd_types.h" // for __rdtsc
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define PROFILE_MAGIC 0x50524f46
+
+struct RoseEngine;
+
+struct hs_profile {
+    u32 magic;
+    const struct RoseEngine *rose; /**< database the profile was built for */
+    u32 literalCount;
+    u32 queueCount;
+    u64a child; /**< cycles spent in sections nested inside the open one */
+    u64a *litCycles; /**< exclusive cycles, indexed by literal id */
+    u64a *litEvents; /**< role walks, indexed by literal id */
+    u64a *queueCycles; /**< exclusive cycles, indexed by queue */
+    u64a *queueEvents; /**< engine executions, indexed by queue */
+};
+
+/** \brief State saved across a timed section. */
+struct profile_section {
+    u64a start;
+    u64a parent_child; /**< profile::child of the enclosing section */
+};
+
+static really_inline
+u64a profileNow(void) {
+    return __rdtsc();
+}
+
+static really_inline
+void profileBegin(struct hs_profile *prof, struct profile_section *ps) {
+    ps->parent_child = prof->child;
+    prof->child = 0;
+    ps->start = profileNow();
+}
+
+/** \brief Closes a section, charging its elapsed time less that of any nested
+ * sections to \a cycles[idx]. */
+static really_inline
+void profileEnd(struct hs_profile *prof, const struct profile_section *ps,
+                u64a *cycles, u64a *events, u32 idx) {
+    u64a elapsed = profileNow() - ps->start;
+    cycles[idx] += elapsed - MIN(elapsed, prof->child);
+    events[idx]++;
+    prof->child = ps->parent_child + elapsed;
+}
+
+static really_inline
+void profileEndLiteral(struct hs_profile *prof,
+                       const struct profile_section *ps, u32 id) {
+    if (id < prof->literalCount) {
+        profileEnd(prof, ps, prof->litCycles, prof->litEvents, id);
+    } else {
+        prof->child = ps->parent_child + (profileNow() - ps->start);
+    }
+}
+
+static really_inline
+void profileEndQueue(struct hs_profile *prof,
+                     const struct profile_section *ps, u32 qi) {
+    if (qi < prof->queueCount) {
+        profileEnd(prof, ps, prof->queueCycles, prof->queueEvents, qi);
+    } else {
+        prof->child = ps->parent_child + (profileNow() - ps->start);
+    }
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif // PROFILE_SUPPORT
+
+#endif // PROFILE_H
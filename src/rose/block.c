@@ -34,6 +34,9 @@
 #include "nfa/nfa_rev_api.h"
 #include "nfa/mcclellan.h"
 #include "util/fatbit.h"
+#include "util/partial_store.h"
+#include "util/simd_utils.h"
+#include "util/unaligned.h"
 #include "rose_sidecar_runtime.h"
 #include "rose.h"
 #include "rose_common.h"
@@ -78,6 +81,71 @@ void runAnchoredTableBlock(const struct RoseEngine *t, const void *atable,
     } while (1);
 }
 
+/** \brief Masked compare of \a len bytes of data against a literal stored
+ * in an anchored literal table (bytes and masks both padded to 16). */
+static really_inline
+char anchoredLitMatches(const u8 *data, const u8 *lit, u32 len) {
+    const u32 padded = ROUNDUP_N(len, 16);
+    const u8 *mask = lit + padded;
+    for (u32 i = 0; i < len; i += 16) {
+        u32 n = MIN(16, len - i);
+        m128 v = n == 16 ? loadu128(data + i) : loadbytes128(data + i, n);
+        if (diff128(and128(v, load128(mask + i)), load128(lit + i))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static rose_inline
+void runAnchoredLitTableBlock(const struct anchored_lit_table *alt,
+                              struct hs_scratch *scratch) {
+    const u8 *buffer = scratch->core_info.buf;
+    const size_t length = scratch->core_info.len;
+    const char *base = (const char *)alt;
+    const u32 *starts = (const u32 *)(base + alt->startsOffset);
+    const u32 *buckets = (const u32 *)(base + alt->bucketsOffset);
+    const struct anchored_lit_entry *entries
+        = (const struct anchored_lit_entry *)(base + alt->entriesOffset);
+    const u32 prefix_len = alt->prefixLen;
+
+    DEBUG_PRINTF("BEGIN ANCHORED LIT TABLE (%u entries)\n", alt->entryCount);
+
+    for (u32 i = 0; i < alt->startCount; i++) {
+        const u32 start = starts[i];
+        if (start + prefix_len > length) {
+            break; /* starts are in ascending order */
+        }
+
+        const u8 *data = buffer + start;
+        const size_t avail = length - start;
+        u64a prefix = avail >= 8 ? unaligned_load_u64a(data)
+                                 : partial_load_u64a(data, avail);
+        prefix &= anchoredLitPrefixMask(prefix_len);
+
+        u32 b = anchoredLitBucket(prefix, start, alt->bucketCount);
+        for (u32 j = buckets[b]; j < buckets[b + 1]; j++) {
+            const struct anchored_lit_entry *e = &entries[j];
+            if (e->start != start || (prefix & e->prefixMask) != e->prefix
+                || e->len > avail) {
+                continue;
+            }
+
+            if (!anchoredLitMatches(data, (const u8 *)base + e->litOffset,
+                                    e->len)) {
+                continue;
+            }
+
+            DEBUG_PRINTF("lit %u matched [%u,%u)\n", e->id, start,
+                         start + e->len);
+            if (roseAnchoredCallback(start + e->len, e->id, &scratch->tctxt)
+                == MO_HALT_MATCHING) {
+                return;
+            }
+        }
+    }
+}
+
 static really_inline
 void init_sidecar(const struct RoseEngine *t, struct hs_scratch *scratch) {
     if (!t->smatcherOffset) {
@@ -225,8 +293,9 @@ void roseBlockExec_i(const struct RoseEngine *t, struct hs_scratch *scratch,
     }
 
     const void *atable = getALiteralMatcher(t);
+    const struct anchored_lit_table *altable = getALiteralTable(t);
 
-    if (atable) {
+    if (atable || altable) {
         if (t->amatcherMaxBiAnchoredWidth != ROSE_BOUND_INF
             && length > t->amatcherMaxBiAnchoredWidth) {
             goto skip_atable;
@@ -236,11 +305,20 @@ void roseBlockExec_i(const struct RoseEngine *t, struct hs_scratch *scratch,
             goto skip_atable;
         }
 
+        if (altable) {
+            runAnchoredLitTableBlock(altable, scratch);
+
+            if (can_stop_matching(scratch)) {
+                goto exit;
+            }
+        }
 
-        runAnchoredTableBlock(t, atable, scratch);
+        if (atable) {
+            runAnchoredTableBlock(t, atable, scratch);
 
-        if (can_stop_matching(scratch)) {
-            goto exit;
+            if (can_stop_matching(scratch)) {
+                goto exit;
+            }
         }
 
         resetAnchoredLog(t, scratch);
@@ -33,9 +33,11 @@
 #include "miracle.h"
 #include "rose_sidecar_runtime.h"
 #include "rose.h"
+#include "profile.h"
 #include "som/som_runtime.h"
 #include "util/bitutils.h"
 #include "util/fatbit.h"
+#include "util/unaligned.h"
 
 #if defined(DEBUG) || defined(DUMP_SUPPORT)
 #include "util/compare.h"
@@ -150,6 +152,46 @@ int roseCheckLiteralBenefits(u64a end, size_t mask_rewind, u32 id,
                              lbi->expected.e8);
 }
 
+/** \brief Adds delayed literal index \a idx to delay slot \a slot_index. */
+static rose_inline
+void pushDelaySlot(struct RoseContext *tctxt, u32 slot_index, u32 idx) {
+    struct hs_scratch *scratch = tctxtToScratch(tctxt);
+    u32 delay_count = tctxt->t->delay_count;
+    struct delay_list *dl = getDelayLists(scratch) + slot_index;
+    u8 *slot = getDelaySlots(scratch)
+             + tctxt->t->delay_slot_size * slot_index;
+
+    DEBUG_PRINTF("pushing tab %u into slot %u\n", idx, slot_index);
+    if (!(tctxt->filledDelayedSlots & (1U << slot_index))) {
+        tctxt->filledDelayedSlots |= 1U << slot_index;
+        dl->count = 0;
+    }
+
+    if (dl->count == DELAY_LIST_OVERFLOW) {
+        mmbit_set(slot, delay_count, idx);
+        return;
+    }
+
+    for (u32 i = 0; i < dl->count; i++) {
+        if (dl->ids[i] == idx) {
+            return;
+        }
+    }
+
+    if (dl->count < DELAY_LIST_MAX) {
+        dl->ids[dl->count++] = idx;
+        return;
+    }
+
+    DEBUG_PRINTF("slot %u list full, switching to multibit\n", slot_index);
+    mmbit_clear(slot, delay_count);
+    for (u32 i = 0; i < dl->count; i++) {
+        mmbit_set(slot, delay_count, dl->ids[i]);
+    }
+    mmbit_set(slot, delay_count, idx);
+    dl->count = DELAY_LIST_OVERFLOW;
+}
+
 static rose_inline
 void pushDelayedMatches(const struct RoseLiteral *tl, u64a offset,
                         struct RoseContext *tctxt) {
@@ -158,9 +200,6 @@ void pushDelayedMatches(const struct RoseLiteral *tl, u64a offset,
         return;
     }
 
-    u32 delay_count = tctxt->t->delay_count;
-    u8 *delaySlotBase = getDelaySlots(tctxtToScratch(tctxt));
-    size_t delaySlotSize = tctxt->t->delay_slot_size;
     assert(tl->delayIdsOffset != ROSE_OFFSET_INVALID);
     const u32 *delayIds = getByOffset(tctxt->t, tl->delayIdsOffset);
     assert(ISALIGNED(delayIds));
@@ -168,25 +207,66 @@ void pushDelayedMatches(const struct RoseLiteral *tl, u64a offset,
     while (delay_mask) {
         u32 src_slot_index = findAndClearLSB_32(&delay_mask);
         u32 slot_index = (src_slot_index + offset) & DELAY_MASK;
-        u8 *slot = delaySlotBase + delaySlotSize * slot_index;
 
         if (offset + src_slot_index <= tctxt->delayLastEndOffset) {
             DEBUG_PRINTF("skip too late\n");
             goto next;
         }
 
-        DEBUG_PRINTF("pushing tab %u into slot %u\n", *delayIds, slot_index);
-        if (!(tctxt->filledDelayedSlots & (1U << slot_index))) {
-            tctxt->filledDelayedSlots |= 1U << slot_index;
-            mmbit_clear(slot, delay_count);
-        }
-
-        mmbit_set(slot, delay_count, *delayIds);
+        pushDelaySlot(tctxt, slot_index, *delayIds);
     next:
         delayIds++;
     }
 }
 
+char roseSaveDelayedLiterals(struct RoseContext *tctxt, u64a end) {
+    const struct RoseEngine *t = tctxt->t;
+    assert(t->stateOffsets.delayedLiterals);
+    const struct delay_list *lists = getDelayLists(tctxtToScratch(tctxt));
+    u8 *out = tctxt->state + t->stateOffsets.delayedLiterals;
+    u8 *entry = out + 1;
+    u32 count = 0;
+
+    u32 filled = tctxt->filledDelayedSlots;
+    while (filled) {
+        u32 slot_index = findAndClearLSB_32(&filled);
+        const struct delay_list *dl = &lists[slot_index];
+        if (dl->count == DELAY_LIST_OVERFLOW
+            || count + dl->count > DELAY_SAVE_MAX) {
+            DEBUG_PRINTF("too many pending delayed literals to save\n");
+            return 0;
+        }
+
+        /* all pending slots lie after the end of this write */
+        u32 dist = (slot_index - (u32)end) & DELAY_MASK;
+        assert(dist);
+        for (u32 i = 0; i < dl->count; i++) {
+            *entry = (u8)dist;
+            unaligned_store_u32(entry + 1, dl->ids[i]);
+            entry += 5;
+        }
+        count += dl->count;
+    }
+
+    DEBUG_PRINTF("saved %u pending delayed literals\n", count);
+    *out = (u8)count;
+    return 1;
+}
+
+void roseRestoreDelayedLiterals(struct RoseContext *tctxt, u64a offset) {
+    const struct RoseEngine *t = tctxt->t;
+    assert(t->stateOffsets.delayedLiterals);
+    const u8 *in = tctxt->state + t->stateOffsets.delayedLiterals;
+    u32 count = *in++;
+    assert(count <= DELAY_SAVE_MAX);
+
+    DEBUG_PRINTF("restoring %u pending delayed literals\n", count);
+    for (u32 i = 0; i < count; i++, in += 5) {
+        u32 slot_index = (u32)(offset + *in) & DELAY_MASK;
+        pushDelaySlot(tctxt, slot_index, unaligned_load_u32(in + 1));
+    }
+}
+
 hwlmcb_rv_t roseDelayRebuildCallback(size_t start, size_t end, u32 id,
                                      void *ctx) {
     struct hs_scratch *scratch = ctx;
@@ -1684,9 +1764,21 @@ int roseAnchoredCallback(u64a end, u32 id, void *ctx) {
     }
 
     /* anchored literals are root only */
+#ifdef PROFILE_SUPPORT
+    struct hs_profile *prof = tctxtToScratch(tctxt)->profile;
+    struct profile_section ps = {0, 0};
+    if (unlikely(prof != NULL)) {
+        profileBegin(prof, &ps);
+    }
+#endif
     if (!roseWalkRootRoles(t, tl, real_end, tctxt, 1, 0)) {
         rv = HWLM_TERMINATE_MATCHING;
     }
+#ifdef PROFILE_SUPPORT
+    if (unlikely(prof != NULL)) {
+        profileEndLiteral(prof, &ps, id);
+    }
+#endif
 
     DEBUG_PRINTF("DONE depth=%u, groups=0x%016llx\n", tctxt->depth,
                  tctxt->groups);
@@ -1802,22 +1894,65 @@ root_roles:
 }
 
 
+/* As roseProcessMatch_i, but charges the work to the literal in the attached
+ * scan cost profile, if any. */
+static really_inline
+hwlmcb_rv_t roseProcessMatch_p(const struct RoseEngine *t, u64a end, u32 id,
+                               struct RoseContext *tctxt, char do_group_check,
+                               char in_delay_play, char in_anch_playback) {
+#ifdef PROFILE_SUPPORT
+    struct hs_profile *prof = tctxtToScratch(tctxt)->profile;
+    if (unlikely(prof != NULL)) {
+        struct profile_section ps;
+        profileBegin(prof, &ps);
+        hwlmcb_rv_t rv = roseProcessMatch_i(t, end, id, tctxt, do_group_check,
+                                            in_delay_play, in_anch_playback);
+        profileEndLiteral(prof, &ps, id);
+        return rv;
+    }
+#endif
+    return roseProcessMatch_i(t, end, id, tctxt, do_group_check, in_delay_play,
+                              in_anch_playback);
+}
+
 static never_inline
 hwlmcb_rv_t roseProcessDelayedMatch(const struct RoseEngine *t, u64a end, u32 id,
                                     struct RoseContext *tctxt) {
-    return roseProcessMatch_i(t, end, id, tctxt, 1, 1, 0);
+    return roseProcessMatch_p(t, end, id, tctxt, 1, 1, 0);
 }
 
 static never_inline
 hwlmcb_rv_t roseProcessDelayedAnchoredMatch(const struct RoseEngine *t, u64a end,
                                             u32 id, struct RoseContext *tctxt) {
-    return roseProcessMatch_i(t, end, id, tctxt, 0, 0, 1);
+    return roseProcessMatch_p(t, end, id, tctxt, 0, 0, 1);
 }
 
 static really_inline
 hwlmcb_rv_t roseProcessMainMatch(const struct RoseEngine *t, u64a end, u32 id,
                                  struct RoseContext *tctxt) {
-    return roseProcessMatch_i(t, end, id, tctxt, 1, 0, 0);
+    return roseProcessMatch_p(t, end, id, tctxt, 1, 0, 0);
+}
+
+static rose_inline
+hwlmcb_rv_t playDelayedLiteral(struct RoseContext *tctxt, u32 idx,
+                               u64a offset) {
+    u32 literal_id = tctxt->t->delay_base_id + idx;
+
+    UNUSED rose_group old_groups = tctxt->groups;
+
+    DEBUG_PRINTF("DELAYED MATCH id=%u offset=%llu\n", literal_id, offset);
+    hwlmcb_rv_t rv = roseProcessDelayedMatch(tctxt->t, offset, literal_id,
+                                             tctxt);
+    DEBUG_PRINTF("DONE depth=%u, groups=0x%016llx\n", tctxt->depth,
+                 tctxt->groups);
+
+    /* delayed literals can't safely set groups, squashing may from side.
+     * However we may be setting groups that successors already have
+     * worked out that we don't need to match the group */
+    DEBUG_PRINTF("groups in %016llx out %016llx\n", old_groups,
+                 tctxt->groups);
+
+    return rv;
 }
 
 static rose_inline
@@ -1826,6 +1961,8 @@ hwlmcb_rv_t playDelaySlot(struct RoseContext *tctxt, const u8 *delaySlotBase,
     /* assert(!tctxt->in_anchored); */
     assert(vicIndex < DELAY_SLOT_COUNT);
     const u8 *vicSlot = delaySlotBase + delaySlotSize * vicIndex;
+    const struct delay_list *dl
+        = getDelayLists(tctxtToScratch(tctxt)) + vicIndex;
     u32 delay_count = tctxt->t->delay_count;
 
     if (offset < tctxt->t->floatingMinLiteralMatchOffset) {
@@ -1836,25 +1973,31 @@ hwlmcb_rv_t playDelaySlot(struct RoseContext *tctxt, const u8 *delaySlotBase,
     roseFlushLastByteHistory(tctxt->t, tctxt->state, offset, tctxt);
     tctxt->lastEndOffset = offset;
 
-    for (u32 it = mmbit_iterate(vicSlot, delay_count, MMB_INVALID);
-         it != MMB_INVALID; it = mmbit_iterate(vicSlot, delay_count, it)) {
-        u32 literal_id = tctxt->t->delay_base_id + it;
-
-        UNUSED rose_group old_groups = tctxt->groups;
-
-        DEBUG_PRINTF("DELAYED MATCH id=%u offset=%llu\n", literal_id, offset);
-        hwlmcb_rv_t rv = roseProcessDelayedMatch(tctxt->t, offset, literal_id,
-                                                 tctxt);
-        DEBUG_PRINTF("DONE depth=%u, groups=0x%016llx\n", tctxt->depth,
-                     tctxt->groups);
+    if (dl->count != DELAY_LIST_OVERFLOW) {
+        /* play in ascending order, as the multibit would */
+        u32 ids[DELAY_LIST_MAX];
+        u32 count = dl->count;
+        for (u32 i = 0; i < count; i++) {
+            u32 v = dl->ids[i];
+            u32 j = i;
+            for (; j && ids[j - 1] > v; j--) {
+                ids[j] = ids[j - 1];
+            }
+            ids[j] = v;
+        }
 
-        /* delayed literals can't safely set groups, squashing may from side.
-         * However we may be setting groups that successors already have
-         * worked out that we don't need to match the group */
-        DEBUG_PRINTF("groups in %016llx out %016llx\n", old_groups,
-                     tctxt->groups);
+        for (u32 i = 0; i < count; i++) {
+            if (playDelayedLiteral(tctxt, ids[i], offset)
+                == HWLM_TERMINATE_MATCHING) {
+                return HWLM_TERMINATE_MATCHING;
+            }
+        }
+        return HWLM_CONTINUE_MATCHING;
+    }
 
-        if (rv == HWLM_TERMINATE_MATCHING) {
+    for (u32 it = mmbit_iterate(vicSlot, delay_count, MMB_INVALID);
+         it != MMB_INVALID; it = mmbit_iterate(vicSlot, delay_count, it)) {
+        if (playDelayedLiteral(tctxt, it, offset) == HWLM_TERMINATE_MATCHING) {
             return HWLM_TERMINATE_MATCHING;
         }
     }
@@ -221,6 +221,15 @@ char isZombie(const struct RoseEngine *t, const u8 *state,
 
 hwlmcb_rv_t flushQueuedLiterals_i(struct RoseContext *tctxt, u64a end);
 
+/** \brief Stores the pending delayed literals in stream state so that the
+ * next write need not rebuild them from history. Returns 0 if there are too
+ * many to store. */
+char roseSaveDelayedLiterals(struct RoseContext *tctxt, u64a end);
+
+/** \brief Repopulates the delay slots from the pending delayed literals
+ * stored by roseSaveDelayedLiterals(). */
+void roseRestoreDelayedLiterals(struct RoseContext *tctxt, u64a offset);
+
 static really_inline
 hwlmcb_rv_t flushQueuedLiterals(struct RoseContext *tctxt, u64a end) {
     if (tctxt->delayLastEndOffset == end) {
@@ -248,11 +257,17 @@ hwlmcb_rv_t cleanUpDelayed(size_t length, u64a offset, struct RoseContext *tctxt
         return HWLM_TERMINATE_MATCHING;
     }
 
-    if (tctxt->filledDelayedSlots) {
+    if (!tctxt->filledDelayedSlots) {
+        *status &= ~(DELAY_FLOAT_DIRTY | DELAY_FLOAT_SAVED);
+    } else if (tctxt->t->stateOffsets.delayedLiterals
+               && roseSaveDelayedLiterals(tctxt, length + offset)) {
+        DEBUG_PRINTF("saved\n");
+        *status &= ~DELAY_FLOAT_DIRTY;
+        *status |= DELAY_FLOAT_SAVED;
+    } else {
         DEBUG_PRINTF("dirty\n");
+        *status &= ~DELAY_FLOAT_SAVED;
         *status |= DELAY_FLOAT_DIRTY;
-    } else {
-        *status &= ~DELAY_FLOAT_DIRTY;
     }
 
     tctxt->filledDelayedSlots = 0;
@@ -72,6 +72,13 @@ void roseBlockExec(const struct RoseEngine *t, struct hs_scratch *scratch,
         return;
     }
 
+    // No EOD match is possible if the block extends more than a byte past the
+    // last offset at which any pattern can match.
+    if (t->maxMatchOffset != MAX_OFFSET && length - 1 > t->maxMatchOffset) {
+        DEBUG_PRINTF("bailing, block is past maxMatchOffset\n");
+        return;
+    }
+
     if (can_stop_matching(scratch)) {
         DEBUG_PRINTF("bailing, already halted\n");
         return;
@@ -114,7 +114,9 @@ public:
                          bool eod) = 0;
 
     /** \brief Construct a runtime implementation. */
-    virtual ue2::aligned_unique_ptr<RoseEngine> buildRose(u32 minWidth) = 0;
+    virtual ue2::aligned_unique_ptr<RoseEngine> buildRose(u32 minWidth,
+                                                          u32 maxWidth,
+                                                          u64a maxOffset) = 0;
 
     virtual std::unique_ptr<RoseDedupeAux> generateDedupeAux() const = 0;
 
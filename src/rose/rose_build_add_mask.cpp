@@ -87,7 +87,11 @@ void findMaskLiteral(const vector<CharReach> &mask, bool streaming,
             fail = true;
         }
 
-        if (!fail && streaming && (end >= grey.maxHistoryAvailable + 1)) {
+        /* A literal at the start of the mask needs no prefix, so it can be
+         * longer than history: the literal matcher tracks it across stream
+         * writes. Anything later must be checked against history. */
+        if (!fail && streaming && begin &&
+            (end >= grey.maxHistoryAvailable + 1)) {
             DEBUG_PRINTF("hit literal limit, resetting at %zu\n", i);
             fail = true;
         }
@@ -678,7 +682,8 @@ bool checkAllowMask(const vector<CharReach> &mask, ue2_literal *lit,
     DEBUG_PRINTF("mask lit '%s', len=%zu at offset=%u\n",
                  dumpString(*lit).c_str(), lit->length(), lit_offset);
 
-    assert(!cc.streaming || lit->length() <= cc.grey.maxHistoryAvailable + 1);
+    assert(!cc.streaming || !lit_offset ||
+           lit_offset + lit->length() <= cc.grey.maxHistoryAvailable + 1);
 
     /* literal is included in the prefix nfa so that matches from the prefix
      * can't occur in the history buffer - probably should tweak the NFA API
@@ -687,8 +692,10 @@ bool checkAllowMask(const vector<CharReach> &mask, ue2_literal *lit,
     *suffix_len = mask.size() - *prefix_len;
     DEBUG_PRINTF("prefix_len=%u, suffix_len=%u\n", *prefix_len, *suffix_len);
 
-    /* check if we can backtrack sufficiently */
-    if (cc.streaming && *prefix_len > cc.grey.maxHistoryAvailable + 1) {
+    /* check if we can backtrack sufficiently; with nothing before the
+     * literal, doAddMask() builds no prefix and there is nothing to check */
+    if (cc.streaming && lit_offset &&
+        *prefix_len > cc.grey.maxHistoryAvailable + 1) {
         DEBUG_PRINTF("too much lag\n");
         return false;
     }
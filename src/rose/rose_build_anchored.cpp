@@ -44,6 +44,7 @@
 #include "util/alloc.h"
 #include "util/bitfield.h"
 #include "util/charreach.h"
+#include "util/compare.h"
 #include "util/compile_context.h"
 #include "util/compile_error.h"
 #include "util/container.h"
@@ -55,12 +56,17 @@
 #include "util/ue2string.h"
 #include "util/verify_types.h"
 
+#include <algorithm>
 #include <map>
 #include <queue>
 #include <set>
+#include <string>
 #include <vector>
 
+#include <boost/range/adaptor/map.hpp>
+
 using namespace std;
+using boost::adaptors::map_keys;
 
 namespace ue2 {
 
@@ -812,6 +818,178 @@ size_t buildNfas(vector<unique_ptr<raw_dfa>> &anchored_dfas,
     return total_size;
 }
 
+namespace {
+/** \brief Build-time form of an anchored_lit_entry. */
+struct AnchoredTableLit {
+    AnchoredTableLit(u32 start_in, u32 id_in) : start(start_in), id(id_in) {}
+    u32 start;
+    u32 id;
+    string bytes; //!< literal bytes, upper-cased where caseless
+    string masks; //!< 0xdf for caseless alphas, 0xff otherwise
+    u64a prefix = 0;
+    u64a prefixMask = 0;
+    u32 bucket = 0;
+};
+}
+
+/** \brief True if this anchored literal must start at a single fixed offset
+ * and can therefore live in the anchored literal table. */
+static
+bool isFixedOffsetLiteral(const simple_anchored_info &sai) {
+    return sai.min_bound == sai.max_bound && !sai.literal.empty();
+}
+
+static
+u64a loadPrefix(const string &s, u32 len) {
+    u64a rv = 0;
+    for (u32 i = 0; i < len; i++) {
+        rv |= (u64a)(u8)s[i] << (i * 8);
+    }
+    return rv;
+}
+
+aligned_unique_ptr<anchored_lit_table>
+buildAnchoredLiteralTable(RoseBuildImpl &tbi, size_t *alsize) {
+    const CompileContext &cc = tbi.cc;
+    *alsize = 0;
+
+    // The table carries no stream state, so literals straddling a write
+    // boundary would be missed; streaming mode keeps using the DFAs.
+    if (!cc.grey.allowAnchoredLitTable || cc.streaming) {
+        return nullptr;
+    }
+
+    size_t candidates = 0;
+    for (const auto &sai : tbi.anchored_simple | map_keys) {
+        if (isFixedOffsetLiteral(sai)) {
+            candidates++;
+        }
+    }
+
+    if (!candidates || candidates < cc.grey.minAnchoredLitTable) {
+        DEBUG_PRINTF("%zu candidates, leaving them in the dfas\n",
+                     candidates);
+        return nullptr;
+    }
+
+    vector<AnchoredTableLit> lits;
+    set<u32> starts;
+    u32 prefix_len = 8;
+
+    for (auto it = tbi.anchored_simple.begin();
+         it != tbi.anchored_simple.end();) {
+        const simple_anchored_info &sai = it->first;
+        if (!isFixedOffsetLiteral(sai)) {
+            ++it;
+            continue;
+        }
+
+        string bytes, masks;
+        for (const auto &e : sai.literal) {
+            bool caseless = e.nocase && ourisalpha(e.c);
+            bytes.push_back(caseless ? mytoupper(e.c) : e.c);
+            masks.push_back(caseless ? (char)0xdf : (char)0xff);
+        }
+
+        set<u32> final_ids;
+        for (auto lit_id : it->second) {
+            final_ids.insert(tbi.literal_info[lit_id].final_id);
+        }
+
+        for (auto id : final_ids) {
+            lits.emplace_back(sai.min_bound, id);
+            lits.back().bytes = bytes;
+            lits.back().masks = masks;
+        }
+
+        starts.insert(sai.min_bound);
+        prefix_len = min(prefix_len, verify_u32(bytes.size()));
+        tbi.anchored_simple.erase(it++);
+    }
+
+    assert(!lits.empty());
+    assert(prefix_len >= 1);
+
+    u32 bucket_count = 1;
+    while (bucket_count < lits.size()) {
+        bucket_count *= 2;
+    }
+
+    const u64a len_mask = anchoredLitPrefixMask(prefix_len);
+    for (auto &lit : lits) {
+        lit.prefixMask = loadPrefix(lit.masks, prefix_len) & len_mask;
+        lit.prefix = loadPrefix(lit.bytes, prefix_len) & lit.prefixMask;
+        lit.bucket = anchoredLitBucket(lit.prefix, lit.start, bucket_count);
+    }
+
+    stable_sort(lits.begin(), lits.end(),
+                [](const AnchoredTableLit &a, const AnchoredTableLit &b) {
+                    return a.bucket < b.bucket;
+                });
+
+    size_t starts_offset = sizeof(anchored_lit_table);
+    size_t buckets_offset = starts_offset + sizeof(u32) * starts.size();
+    size_t entries_offset = ROUNDUP_N(buckets_offset
+                                      + sizeof(u32) * (bucket_count + 1), 8);
+    size_t lit_offset = ROUNDUP_N(entries_offset
+                                  + sizeof(anchored_lit_entry) * lits.size(),
+                                  16);
+    size_t total_size = lit_offset;
+    for (const auto &lit : lits) {
+        total_size += 2 * ROUNDUP_N(lit.bytes.size(), 16);
+    }
+    total_size = ROUNDUP_CL(total_size);
+
+    auto table = aligned_zmalloc_unique<anchored_lit_table>(total_size);
+    char *base = (char *)table.get();
+
+    table->startCount = verify_u32(starts.size());
+    table->bucketCount = bucket_count;
+    table->entryCount = verify_u32(lits.size());
+    table->prefixLen = prefix_len;
+    table->startsOffset = verify_u32(starts_offset);
+    table->bucketsOffset = verify_u32(buckets_offset);
+    table->entriesOffset = verify_u32(entries_offset);
+
+    copy(starts.begin(), starts.end(), (u32 *)(base + starts_offset));
+
+    u32 *buckets = (u32 *)(base + buckets_offset);
+    anchored_lit_entry *entries = (anchored_lit_entry *)(base
+                                                          + entries_offset);
+    size_t curr = lit_offset;
+    for (u32 i = 0; i < lits.size(); i++) {
+        const AnchoredTableLit &lit = lits[i];
+        anchored_lit_entry &e = entries[i];
+        e.prefix = lit.prefix;
+        e.prefixMask = lit.prefixMask;
+        e.start = lit.start;
+        e.len = verify_u32(lit.bytes.size());
+        e.litOffset = verify_u32(curr);
+        e.id = lit.id;
+
+        size_t padded = ROUNDUP_N(lit.bytes.size(), 16);
+        memcpy(base + curr, lit.bytes.data(), lit.bytes.size());
+        memcpy(base + curr + padded, lit.masks.data(), lit.masks.size());
+        curr += 2 * padded;
+    }
+
+    // buckets[b] is the first entry in bucket b; buckets[bucket_count] is
+    // the entry count.
+    u32 entry = 0;
+    for (u32 b = 0; b <= bucket_count; b++) {
+        while (entry < lits.size() && lits[entry].bucket < b) {
+            entry++;
+        }
+        buckets[b] = entry;
+    }
+
+    DEBUG_PRINTF("built anchored literal table: %zu lits, %zu starts, "
+                 "prefix len %u, %zu bytes\n", lits.size(), starts.size(),
+                 prefix_len, total_size);
+    *alsize = total_size;
+    return table;
+}
+
 aligned_unique_ptr<void> buildAnchoredAutomataMatcher(RoseBuildImpl &tbi,
                                                       size_t *asize) {
     const CompileContext &cc = tbi.cc;
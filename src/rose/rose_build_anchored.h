@@ -39,6 +39,7 @@
 #include <set>
 
 struct RoseEngine;
+struct anchored_lit_table;
 
 namespace ue2 {
 
@@ -48,6 +49,17 @@ struct Grey;
 
 aligned_unique_ptr<void> buildAnchoredAutomataMatcher(RoseBuildImpl &tbi,
                                                       size_t *asize);
+
+/**
+ * \brief Builds the anchored literal table from the fixed-offset simple
+ * anchored literals, if there are enough of them to warrant it.
+ *
+ * Literals placed in the table are removed from RoseBuildImpl::anchored_simple
+ * so they are not also built into the anchored DFAs; must therefore be called
+ * before buildAnchoredAutomataMatcher().
+ */
+aligned_unique_ptr<anchored_lit_table>
+buildAnchoredLiteralTable(RoseBuildImpl &tbi, size_t *alsize);
 u32 anchoredStateSize(const void *atable);
 bool anchoredIsMulti(const RoseEngine &engine);
 
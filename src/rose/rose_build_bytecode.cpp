@@ -33,6 +33,7 @@
 #include "hs_compile.h" // for HS_MODE_*
 #include "rose_build_add_internal.h"
 #include "rose_build_anchored.h"
+#include "rose_build_exclusive.h"
 #include "rose_build_infix.h"
 #include "rose_build_lookaround.h"
 #include "rose_build_scatter.h"
@@ -47,6 +48,7 @@
 #include "nfa/nfa_build_util.h"
 #include "nfa/nfa_internal.h"
 #include "nfa/shufticompile.h"
+#include "nfa/tamaramacompile.h"
 #include "nfagraph/ng_holder.h"
 #include "nfagraph/ng_lbr.h"
 #include "nfagraph/ng_limex.h"
@@ -333,7 +335,8 @@ void fillStateOffsets(const RoseBuildImpl &tbi, const sidecar *side,
                       u32 rolesWithStateCount, u32 anchorStateSize,
                       u32 activeArrayCount, u32 activeLeftCount,
                       u32 laggedRoseCount, u32 floatingStreamStateRequired,
-                      u32 historyRequired, RoseStateOffsets *so) {
+                      u32 historyRequired, u32 delayCount,
+                      RoseStateOffsets *so) {
     /* runtime state (including role state) first and needs to be u32-aligned */
     u32 curr_offset = sizeof(RoseRuntimeState)
                     + mmbit_size(rolesWithStateCount);
@@ -400,6 +403,15 @@ void fillStateOffsets(const RoseBuildImpl &tbi, const sidecar *side,
         so->somWritable = 0;
     }
 
+    // Pending delayed literals carried over write boundaries (streaming
+    // only; block mode never crosses a write).
+    if (tbi.cc.streaming && delayCount) {
+        so->delayedLiterals = curr_offset;
+        curr_offset += DELAY_SAVE_SIZE;
+    } else {
+        so->delayedLiterals = 0;
+    }
+
     // note: state space for mask nfas is allocated later
     so->end = curr_offset;
 }
@@ -649,17 +661,6 @@ void findInfixTriggers(const RoseBuildImpl &build,
     }
 }
 
-static
-vector<CharReach> as_cr_seq(const rose_literal_id &lit) {
-    vector<CharReach> rv = as_cr_seq(lit.s);
-    for (u32 i = 0; i < lit.delay; i++) {
-        rv.push_back(CharReach::dot());
-    }
-
-    /* TODO: take into account cmp/msk */
-    return rv;
-}
-
 /**
  * \brief Returns a map of trigger literals as sequences of CharReach, grouped
  * by top index.
@@ -1013,7 +1014,8 @@ void prepMpv(RoseBuildImpl &tbi, vector<aligned_unique_ptr<NFA>> *built_nfas,
 
     assert(mpv->chained);
     assert(!mpv->nfa);
-    auto nfa = mpvCompile(mpv->puffettes, mpv->triggered_puffettes);
+    auto nfa = mpvCompile(mpv->puffettes, mpv->triggered_puffettes,
+                          tbi.cc.grey);
     assert(nfa);
     if (!nfa) {
         throw CompileError("Unable to generate bytecode.");
@@ -1102,11 +1104,18 @@ bool prepOutfixes(RoseBuildImpl &tbi,
     return true;
 }
 
+/**
+ * \brief Assigns a queue to each suffix. Groups of mutually exclusive suffixes
+ * share a queue, and are returned in \a exclusive_groups keyed by queue.
+ */
 static
 void findSuffixes(const RoseBuildImpl &tbi, QueueIndexFactory &qif,
-                  map<suffix_id, u32> *suffixes) {
+                  map<suffix_id, u32> *suffixes,
+                  map<u32, vector<suffix_id>> *exclusive_groups) {
     const RoseGraph &g = tbi.g;
 
+    vector<suffix_id> ordered;
+    ue2::unordered_set<suffix_id> seen;
     for (auto v : vertices_range(g)) {
         if (!g[v].suffix) {
             continue;
@@ -1116,12 +1125,37 @@ void findSuffixes(const RoseBuildImpl &tbi, QueueIndexFactory &qif,
 
         DEBUG_PRINTF("vertex %zu triggers suffix %p\n", g[v].idx, s.graph());
 
-        // We may have already built this NFA.
-        if (contains(*suffixes, s)) {
-            continue;
+        // We may have already seen this NFA.
+        if (seen.insert(s).second) {
+            ordered.push_back(s);
+        }
+    }
+
+    map<suffix_id, size_t> group_of;
+    vector<vector<suffix_id>> groups;
+    if (tbi.cc.grey.allowTamarama) {
+        groups = findExclusiveSuffixes(tbi, ordered);
+        for (size_t i = 0; i < groups.size(); i++) {
+            for (const auto &s : groups[i]) {
+                group_of.emplace(s, i);
+            }
+        }
+    }
+
+    map<size_t, u32> group_queue;
+    for (const auto &s : ordered) {
+        u32 queue;
+        if (!contains(group_of, s)) {
+            queue = qif.get_queue();
+        } else {
+            size_t group = group_of.at(s);
+            if (!contains(group_queue, group)) {
+                group_queue[group] = qif.get_queue();
+                (*exclusive_groups)[group_queue[group]] = groups[group];
+            }
+            queue = group_queue[group];
         }
 
-        u32 queue = qif.get_queue();
         DEBUG_PRINTF("assigning %p to queue %u\n", s.graph(), queue);
         suffixes->insert(make_pair(s, queue));
     }
@@ -1146,14 +1180,63 @@ void setSuffixProperties(NFA &n, const suffix_id &suff,
     n.maxOffset = max_offset_value;
 }
 
+/**
+ * \brief Wraps each group of exclusive suffixes in a Tamarama, filling in
+ * \a suffix_events with the container event for each (suffix, top) pair.
+ */
+static
+void buildTamaramas(const map<u32, vector<suffix_id>> &exclusive_groups,
+                    const map<suffix_id, set<PredTopPair>> &suffixTriggers,
+                    map<suffix_id, aligned_unique_ptr<NFA>> &subengines,
+                    vector<aligned_unique_ptr<NFA>> *built_nfas,
+                    map<pair<suffix_id, u32>, u32> *suffix_events) {
+    for (const auto &e : exclusive_groups) {
+        const u32 queue = e.first;
+        const vector<suffix_id> &group = e.second;
+
+        TamaInfo tamaInfo;
+        for (const auto &s : group) {
+            set<u32> tops;
+            for (const auto &ptp : suffixTriggers.at(s)) {
+                tops.insert(ptp.top);
+            }
+            tamaInfo.add(subengines.at(s).get(), tops);
+        }
+
+        map<pair<const NFA *, u32>, u32> top_remap;
+        auto n = buildTamarama(tamaInfo, queue, top_remap);
+        DEBUG_PRINTF("queue %u: tamarama with %zu subengines\n", queue,
+                     group.size());
+
+        for (const auto &s : group) {
+            const NFA *sub = subengines.at(s).get();
+            for (const auto &ptp : suffixTriggers.at(s)) {
+                (*suffix_events)[make_pair(s, ptp.top)] =
+                    top_remap.at(make_pair(sub, ptp.top));
+            }
+        }
+
+        if (built_nfas->size() <= queue) {
+            built_nfas->resize(queue + 1);
+        }
+
+        (*built_nfas)[queue] = move(n);
+    }
+}
+
 static
 bool buildSuffixes(const RoseBuildImpl &tbi,
                    vector<aligned_unique_ptr<NFA>> *built_nfas,
                    map<suffix_id, u32> *suffixes,
+                   const map<u32, vector<suffix_id>> &exclusive_groups,
+                   map<pair<suffix_id, u32>, u32> *suffix_events,
                    set<u32> *no_retrigger_queues) {
     map<suffix_id, set<PredTopPair> > suffixTriggers;
     findSuffixTriggers(tbi, &suffixTriggers);
 
+    // Subengines to be placed in Tamaramas.
+    map<suffix_id, aligned_unique_ptr<NFA>> subengines;
+
     for (const auto &e : *suffixes) {
         const suffix_id &s = e.first;
         const u32 queue = e.second;
@@ -1177,10 +1260,17 @@ bool buildSuffixes(const RoseBuildImpl &tbi,
         if (s.graph() && nfaStuckOn(*s.graph())) { /* todo: have corresponding
                                                     * haig analysis */
             assert(!s.haig());
+            // Exclusive analysis never groups suffixes that stick on.
+            assert(!contains(exclusive_groups, queue));
             DEBUG_PRINTF("%u sticks on\n", queue);
             no_retrigger_queues->insert(queue);
         }
 
+        if (contains(exclusive_groups, queue)) {
+            subengines.emplace(s, move(n));
+            continue;
+        }
+
         if (built_nfas->size() <= queue) {
             built_nfas->resize(queue + 1);
         }
@@ -1188,6 +1278,9 @@ bool buildSuffixes(const RoseBuildImpl &tbi,
         (*built_nfas)[queue] = move(n);
     }
 
+    buildTamaramas(exclusive_groups, suffixTriggers, subengines, built_nfas,
+                   suffix_events);
+
     return true;
 }
 
@@ -1303,11 +1396,14 @@ static
 bool buildNfas(RoseBuildImpl &tbi, QueueIndexFactory &qif,
                vector<aligned_unique_ptr<NFA>> *built_nfas,
                map<suffix_id, u32> *suffixes,
+               map<pair<suffix_id, u32>, u32> *suffix_events,
                map<RoseVertex, left_build_info> *leftfix_info,
                set<u32> *no_retrigger_queues, u32 *leftfixBeginQueue) {
-    findSuffixes(tbi, qif, suffixes);
+    map<u32, vector<suffix_id>> exclusive_groups;
+    findSuffixes(tbi, qif, suffixes, &exclusive_groups);
 
-    if (!buildSuffixes(tbi, built_nfas, suffixes, no_retrigger_queues)) {
+    if (!buildSuffixes(tbi, built_nfas, suffixes, exclusive_groups,
+                       suffix_events, no_retrigger_queues)) {
         return false;
     }
 
@@ -2007,20 +2103,29 @@ void fillHamsterLiteralList(const RoseBuildImpl &tbi, rose_literal_table table,
             }
         } else {
             const std::string &s = lit.get_string();
-            const bool nocase = lit.any_nocase();
+            // Mixed-case literals are matched exactly using per-char case
+            // sensitivity, unless we are confirming them with benefits.
+            vector<bool> nocase(lit.length(), lit.any_nocase());
+            if (tbi.cc.grey.hamsterMixedCase) {
+                nocase.clear();
+                for (const auto &c : lit) {
+                    nocase.push_back(c.nocase);
+                }
+            }
 
             DEBUG_PRINTF("id=%u, s='%s', nocase=%d, noruns=%d, msk=%s, "
                          "cmp=%s\n",
-                         final_id, escapeString(s).c_str(), (int)nocase, noruns,
-                         dumpMask(msk).c_str(), dumpMask(cmp).c_str());
+                         final_id, escapeString(s).c_str(),
+                         (int)lit.any_nocase(), noruns, dumpMask(msk).c_str(),
+                         dumpMask(cmp).c_str());
 
             if (!maskIsConsistent(s, nocase, msk, cmp)) {
                 DEBUG_PRINTF("msk/cmp for literal can't match, skipping\n");
                 continue;
             }
 
-            hl->push_back(hwlmLiteral(lit.get_string(), lit.any_nocase(),
-                                      noruns, final_id, groups, msk, cmp));
+            hl->push_back(hwlmLiteral(s, nocase, noruns, final_id, groups, msk,
+                                      cmp));
         }
     }
 }
@@ -2312,7 +2417,9 @@ u32 copyInNFAs(const RoseBuildImpl &tbi, vector<RoseRole> *roleTable,
                const vector<aligned_unique_ptr<NFA>> &built_nfas,
                const set<u32> &no_retrigger_queues, NfaInfo *infos,
                u32 base_nfa_offset,
-               const map<suffix_id, u32> &suffixes, char *ptr) {
+               const map<suffix_id, u32> &suffixes,
+               const map<pair<suffix_id, u32>, u32> &suffix_events,
+               char *ptr) {
     const RoseGraph &g = tbi.g;
     const CompileContext &cc = tbi.cc;
 
@@ -2360,9 +2467,15 @@ u32 copyInNFAs(const RoseBuildImpl &tbi, vector<RoseRole> *roleTable,
         RoseRole &tr = (*roleTable)[g[v].role];
         tr.suffixOffset = suffix_base[nfa_index];
 
-        // DFAs/Puffs have no MQE_TOP_N support, so they get a classic TOP
-        // event.
-        if (classic_top[nfa_index]) {
+        // Suffixes inside a Tamarama use the container's event for their top.
+        auto it = suffix_events.find(make_pair(suffix_id(g[v].suffix),
+                                               (u32)g[v].suffix.top));
+        if (it != suffix_events.end()) {
+            assert(isContainerType(built_nfas[nfa_index]->type));
+            tr.suffixEvent = it->second;
+        } else if (classic_top[nfa_index]) {
+            // DFAs/Puffs have no MQE_TOP_N support, so they get a classic TOP
+            // event.
             assert(!g[v].suffix.graph || onlyOneTop(*g[v].suffix.graph));
             tr.suffixEvent = MQE_TOP;
         } else {
@@ -2487,10 +2600,15 @@ void buildSuffixEkeyLists(const RoseBuildImpl &tbi, build_context &bc,
 
     map<u32, vector<u32> > qi_to_ekeys; /* for determinism */
 
+    /* suffixes in a Tamarama share a queue */
+    map<u32, set<ReportID>> qi_to_reports;
     for (const auto &e : suffixes) {
-        const suffix_id &s = e.first;
-        u32 qi = e.second;
-        set<u32> ekeys = reportsToEkeys(all_reports(s), tbi.rm);
+        insert(&qi_to_reports[e.second], all_reports(e.first));
+    }
+
+    for (const auto &e : qi_to_reports) {
+        u32 qi = e.first;
+        set<u32> ekeys = reportsToEkeys(e.second, tbi.rm);
 
         if (!ekeys.empty()) {
             qi_to_ekeys[qi] = {ekeys.begin(), ekeys.end()};
@@ -2585,11 +2703,16 @@ void populateNfaInfoBasics(NfaInfo *infos, const vector<OutfixInfo> &outfixes,
         infos[qi].ekeyListOffset = ekeyListOffsets[qi];
     }
 
+    /* suffixes in a Tamarama share a queue */
+    map<u32, set<ReportID>> qi_to_reports;
     for (const auto &e : suffixes) {
-        const suffix_id &s = e.first;
-        u32 qi = e.second;
+        insert(&qi_to_reports[e.second], all_reports(e.first));
+    }
+
+    for (const auto &e : qi_to_reports) {
+        u32 qi = e.first;
 
-        if (!hasInternalReport(all_reports(s), rm)) {
+        if (!hasInternalReport(e.second, rm)) {
             infos[qi].only_external = 1;
         }
 
@@ -3844,15 +3967,176 @@ void fillMatcherDistances(const RoseBuildImpl &build, RoseEngine *engine) {
     }
 }
 
-aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
+#ifdef PROFILE_SUPPORT
+/** \brief Adds the expression ids that own report \a r. Chain reports are
+ * owned by whatever the MPV they trigger can report. */
+static
+void addReportOwners(const ReportManager &rm, const set<u32> &chain_owners,
+                     ReportID r, set<u32> *owners) {
+    const Report &ir = rm.getReport(r);
+    if (isExternalReport(ir)) {
+        owners->insert(ir.onmatch);
+    } else if (ir.type == INTERNAL_ROSE_CHAIN) {
+        insert(owners, chain_owners);
+    }
+}
+
+/** \brief Returns the expression ids reachable from the given vertices,
+ * through their own reports, their suffixes and all their descendants. */
+static
+set<u32> findVertexOwners(const RoseBuildImpl &build,
+                          const set<u32> &chain_owners,
+                          vector<RoseVertex> pending) {
+    const RoseGraph &g = build.g;
+    set<u32> owners;
+    set<RoseVertex> seen;
+
+    while (!pending.empty()) {
+        RoseVertex v = pending.back();
+        pending.pop_back();
+        if (!seen.insert(v).second) {
+            continue;
+        }
+
+        for (ReportID r : g[v].reports) {
+            addReportOwners(build.rm, chain_owners, r, &owners);
+        }
+        if (g[v].suffix) {
+            for (ReportID r : all_reports(suffix_id(g[v].suffix))) {
+                addReportOwners(build.rm, chain_owners, r, &owners);
+            }
+        }
+        insert(&pending, pending.end(), adjacent_vertices(v, g));
+    }
+
+    return owners;
+}
+
+/** \brief Writes the owner lists for one kind of entity into \a owners and
+ * returns their bounds. */
+static
+vector<u32> flattenOwnerLists(const vector<set<u32>> &lists,
+                              vector<u32> *owners) {
+    vector<u32> bounds;
+    bounds.reserve(lists.size() + 1);
+    for (const auto &list : lists) {
+        bounds.push_back(verify_u32(owners->size()));
+        insert(owners, owners->end(), list);
+    }
+    bounds.push_back(verify_u32(owners->size()));
+    return bounds;
+}
+
+/** \brief Builds the RoseProvenance table used by the scan cost profiler.
+ *
+ * Each literal is owned by the expressions reachable from the roles it
+ * drives (and from the roles of its delayed forms); each engine queue by the
+ * expressions it can report, or for leftfixes, by the expressions reachable
+ * from the roles they guard. */
+static
+u32 buildProvenance(const RoseBuildImpl &build, build_context &bc,
+                    const map<suffix_id, u32> &suffixes,
+                    u32 outfixBeginQueue, u32 literalCount, u32 queueCount) {
+    const ReportManager &rm = build.rm;
+
+    set<u32> chain_owners;
+    for (const auto &out : build.outfixes) {
+        if (out.chained && out.is_nonempty_mpv()) {
+            for (ReportID r : all_reports(out)) {
+                addReportOwners(rm, set<u32>(), r, &chain_owners);
+            }
+        }
+    }
+
+    vector<set<u32>> lit_owners(literalCount);
+    for (u32 final_id = 0; final_id < literalCount; final_id++) {
+        auto it = build.final_id_to_literal.find(final_id);
+        if (it == build.final_id_to_literal.end()) {
+            continue;
+        }
+
+        vector<RoseVertex> roots;
+        for (u32 lit_id : it->second) {
+            const rose_literal_info &info = build.literal_info.at(lit_id);
+            insert(&roots, roots.end(), info.vertices);
+            for (u32 delayed_id : info.delayed_ids) {
+                insert(&roots, roots.end(),
+                       build.literal_info.at(delayed_id).vertices);
+            }
+        }
+        lit_owners[final_id] = findVertexOwners(build, chain_owners, roots);
+    }
+
+    vector<set<u32>> queue_owners(queueCount);
+
+    // Outfixes take consecutive queues from outfixBeginQueue in build order;
+    // the MPV was given its queue up front.
+    u32 qi = outfixBeginQueue;
+    for (const auto &out : build.outfixes) {
+        if (out.chained) {
+            if (out.nfa) {
+                assert(out.nfa->queueIndex < queueCount);
+                queue_owners[out.nfa->queueIndex] = chain_owners;
+            }
+            continue;
+        }
+        assert(qi < queueCount);
+        for (ReportID r : all_reports(out)) {
+            addReportOwners(rm, chain_owners, r, &queue_owners[qi]);
+        }
+        qi++;
+    }
+
+    for (const auto &e : suffixes) {
+        assert(e.second < queueCount);
+        for (ReportID r : all_reports(e.first)) {
+            addReportOwners(rm, chain_owners, r, &queue_owners[e.second]);
+        }
+    }
+
+    for (const auto &e : bc.leftfix_info) {
+        const left_build_info &lbi = e.second;
+        if (lbi.has_lookaround) {
+            continue;
+        }
+        assert(lbi.queue < queueCount);
+        insert(&queue_owners[lbi.queue],
+               findVertexOwners(build, chain_owners, {e.first}));
+    }
+
+    vector<u32> owners;
+    vector<u32> lit_bounds = flattenOwnerLists(lit_owners, &owners);
+    vector<u32> queue_bounds = flattenOwnerLists(queue_owners, &owners);
+
+    DEBUG_PRINTF("provenance: %u literals, %u queues, %zu owner entries\n",
+                 literalCount, queueCount, owners.size());
+
+    RoseProvenance prov;
+    memset(&prov, 0, sizeof(prov));
+    prov.literalCount = literalCount;
+    prov.queueCount = queueCount;
+    prov.literalBoundsOffset =
+        add_to_engine_blob(bc, lit_bounds.begin(), lit_bounds.end());
+    prov.queueBoundsOffset =
+        add_to_engine_blob(bc, queue_bounds.begin(), queue_bounds.end());
+    prov.ownerOffset = add_to_engine_blob(bc, owners.begin(), owners.end());
+    return add_to_engine_blob(bc, prov);
+}
+#endif // PROFILE_SUPPORT
+
+aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth,
+                                                               u32 maxWidth,
+                                                               u64a maxOffset) {
     DerivedBoundaryReports dboundary(boundary);
 
     // Build literal matchers
-    size_t asize = 0, fsize = 0, ssize = 0, esize = 0, sbsize = 0;
+    size_t asize = 0, alsize = 0, fsize = 0, ssize = 0, esize = 0, sbsize = 0;
 
     size_t floatingStreamStateRequired = 0;
     size_t historyRequired = calcHistoryRequired(); // Updated by HWLM.
 
+    aligned_unique_ptr<anchored_lit_table> altable =
+        buildAnchoredLiteralTable(*this, &alsize);
     aligned_unique_ptr<void> atable =
         buildAnchoredAutomataMatcher(*this, &asize);
     aligned_unique_ptr<HWLM> ftable = buildFloatingMatcher(
@@ -3867,6 +4151,7 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     // Build NFAs
     vector<aligned_unique_ptr<NFA>> built_nfas;
     map<suffix_id, u32> suffixes;
+    map<pair<suffix_id, u32>, u32> suffix_events;
     set<u32> no_retrigger_queues;
     bool mpv_as_outfix;
     prepMpv(*this, &built_nfas, &historyRequired, &mpv_as_outfix);
@@ -3877,8 +4162,9 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     u32 outfixEndQueue = qif.allocated_count();
     u32 leftfixBeginQueue = outfixEndQueue;
 
-    if (!buildNfas(*this, qif, &built_nfas, &suffixes, &bc.leftfix_info,
-                   &no_retrigger_queues, &leftfixBeginQueue)) {
+    if (!buildNfas(*this, qif, &built_nfas, &suffixes, &suffix_events,
+                   &bc.leftfix_info, &no_retrigger_queues,
+                   &leftfixBeginQueue)) {
         return nullptr;
     }
     buildCountingMiracles(*this, bc);
@@ -3933,12 +4219,20 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
 
     u32 lastByteOffset = buildLastByteIter(g, bc);
 
+    u32 provenanceOffset = 0;
+#ifdef PROFILE_SUPPORT
+    provenanceOffset = buildProvenance(*this, bc, suffixes, outfixBeginQueue,
+                                       verify_u32(literalTable.size()),
+                                       queue_count);
+#endif
+
     // Enforce role table resource limit.
     if (bc.roleTable.size() > cc.grey.limitRoseRoleCount) {
         throw ResourceLimitError();
     }
 
     u32 amatcherOffset = 0;
+    u32 altableOffset = 0;
     u32 fmatcherOffset = 0;
     u32 smatcherOffset = 0;
     u32 ematcherOffset = 0;
@@ -3968,6 +4262,12 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
         currOffset += (u32)asize;
     }
 
+    if (altable) {
+        currOffset = ROUNDUP_CL(currOffset);
+        altableOffset = currOffset;
+        currOffset += (u32)alsize;
+    }
+
     if (ftable) {
         currOffset = ROUNDUP_CL(currOffset);
         fmatcherOffset = currOffset;
@@ -4048,8 +4348,8 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     u32 anchoredReportInverseMapOffset = currOffset;
     currOffset += arit.size() * sizeof(u32);
 
-    /* sidecar may contain sse in silly cases */
-    currOffset = ROUNDUP_N(currOffset, 16);
+    /* sidecar may contain sse/avx in silly cases */
+    currOffset = ROUNDUP_N(currOffset, alignof(m256));
     u32 sideSuccListOffset = currOffset;
     map<set<u32>, set<RoseVertex> > sidecar_succ_map;
     markSideEnablers(*this, &sidecar_succ_map);
@@ -4092,6 +4392,7 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     fillStateOffsets(*this, stable.get(), bc.numStates, anchorStateSize,
                      activeArrayCount, activeLeftCount, laggedRoseCount,
                      floatingStreamStateRequired, historyRequired,
+                     verify_u32(literalTable.size() - delay_base_id),
                      &stateOffsets);
 
     scatter_plan_raw state_scatter;
@@ -4120,6 +4421,11 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
         assert(amatcherOffset);
         memcpy(ptr + amatcherOffset, atable.get(), asize);
     }
+    if (altable) {
+        assert(altableOffset >= base_nfa_offset);
+        assert(altableOffset);
+        memcpy(ptr + altableOffset, altable.get(), alsize);
+    }
     if (ftable) {
         assert(fmatcherOffset);
         assert(fmatcherOffset >= base_nfa_offset);
@@ -4199,6 +4505,7 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     engine->eodIterMapOffset = eodIterMapOffset;
 
     engine->lastByteHistoryIterOffset = lastByteOffset;
+    engine->provenanceOffset = provenanceOffset;
 
     u32 delay_count = verify_u32(literalTable.size() - delay_base_id);
     engine->delay_count = delay_count;
@@ -4231,6 +4538,7 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     engine->smallWriteOffset = 0;
 
     engine->amatcherOffset = amatcherOffset;
+    engine->altableOffset = altableOffset;
     engine->ematcherOffset = ematcherOffset;
     engine->sbmatcherOffset = sbmatcherOffset;
     engine->fmatcherOffset = fmatcherOffset;
@@ -4247,6 +4555,8 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     engine->floatingMinLiteralMatchOffset = findMinFloatingLiteralMatch(*this);
 
     engine->maxBiAnchoredWidth = findMaxBAWidth(*this);
+    engine->maxMatchWidth = maxWidth;
+    engine->maxMatchOffset = maxOffset;
     engine->noFloatingRoots = hasNoFloatingRoots();
     engine->hasFloatingDirectReports = floating_direct_report;
     engine->requiresEodCheck = hasEodAnchors(*this, built_nfas,
@@ -4263,6 +4573,7 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     engine->initialGroups = getInitialGroups();
     engine->totalNumLiterals = verify_u32(literalTable.size());
     engine->asize = verify_u32(asize);
+    engine->altableSize = verify_u32(alsize);
     engine->ematcherRegionSize = ematcher_region_size;
     engine->floatingStreamState = verify_u32(floatingStreamStateRequired);
     populateBoundaryReports(engine.get(), boundary, dboundary, boundary_out);
@@ -4300,7 +4611,8 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     engine->nfaRegionBegin = base_nfa_offset;
     engine->nfaRegionEnd = copyInNFAs(*this, &bc.roleTable, built_nfas,
                                       no_retrigger_queues, nfa_infos,
-                                      base_nfa_offset, suffixes, ptr);
+                                      base_nfa_offset, suffixes,
+                                      suffix_events, ptr);
     // We're done with the NFAs.
     built_nfas.clear();
 
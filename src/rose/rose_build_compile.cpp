@@ -369,6 +369,11 @@ bool limited_explosion(const ue2_literal &s) {
 }
 
 void RoseBuildImpl::handleMixedSensitivity(void) {
+    if (cc.grey.hamsterMixedCase) {
+        DEBUG_PRINTF("mixed-case literals handled by the literal matcher\n");
+        return;
+    }
+
     for (const auto &e : literals.right) {
         u32 id = e.first;
         const rose_literal_id &lit = e.second;
@@ -2611,7 +2616,9 @@ void normaliseRoles(RoseBuildImpl &build) {
     }
 }
 
-aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildRose(u32 minWidth) {
+aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildRose(u32 minWidth,
+                                                        u32 maxWidth,
+                                                        u64a maxOffset) {
     dumpRoseGraph(*this, nullptr, "rose_early.dot");
 
     // Early check for Rose implementability.
@@ -2732,7 +2739,7 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildRose(u32 minWidth) {
     // requires this at present.
     normaliseRoles(*this);
 
-    return buildFinalEngine(minWidth);
+    return buildFinalEngine(minWidth, maxWidth, maxOffset);
 }
 
 } // namespace ue2
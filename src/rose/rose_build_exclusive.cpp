@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** \file
+ * \brief Rose build: mutual exclusion analysis for suffix engines.
+ *
+ * Engine A is killed safely by engine B if, whenever B's trigger literal
+ * completes while A is alive, A can raise no further matches. We check this by
+ * walking A's trigger literal and then A's graph, tracking at each step which
+ * prefixes of B's trigger literal could have just been seen. If B's literal
+ * can complete at a point where A can still go on to match, the pair is not
+ * exclusive.
+ */
+
+#include "rose_build_exclusive.h"
+
+#include "grey.h"
+#include "rose_build_impl.h"
+#include "nfagraph/ng_holder.h"
+#include "util/clique.h"
+#include "util/compile_context.h"
+#include "util/container.h"
+#include "util/graph_range.h"
+#include "util/report_manager.h"
+#include "util/ue2_containers.h"
+
+#include <algorithm>
+#include <deque>
+
+using namespace std;
+
+namespace ue2 {
+
+/** \brief Only the last this many characters of a trigger literal are used. */
+#define MAX_TRIGGER_LEN 63
+
+/** \brief Cap on the states explored when checking a single pair. */
+#define MAX_EXCLUSIVE_STATES 50000
+
+/** \brief Cap on the number of engines considered for exclusive analysis. */
+#define MAX_EXCLUSIVE_CANDIDATES 1000
+
+namespace {
+
+/**
+ * \brief Tracks how much of a trigger literal may have just been seen, as a
+ * bitmask with bit i set if the last i characters could be its first i.
+ */
+class TriggerTracker {
+public:
+    explicit TriggerTracker(const vector<CharReach> &lit_in)
+        : lit(lit_in), mask((1ULL << lit.size()) - 1) {
+        assert(!lit.empty() && lit.size() <= MAX_TRIGGER_LEN);
+    }
+
+    /** \brief Nothing is known about the preceding text. */
+    u64a init() const { return mask; }
+
+    /** \brief Advance over a character from \a cr. */
+    u64a step(u64a m, const CharReach &cr) const {
+        u64a ext = 0;
+        for (size_t i = 0; i < lit.size(); i++) {
+            if ((lit[i] & cr).any()) {
+                ext |= 1ULL << i;
+            }
+        }
+        return 1 | ((m & ext) << 1);
+    }
+
+    /** \brief True if the whole literal may have just been seen. */
+    bool complete(u64a m) const { return m & ~mask; }
+
+    u64a clear(u64a m) const { return m & mask; }
+
+private:
+    const vector<CharReach> &lit;
+    const u64a mask;
+};
+
+} // namespace
+
+static
+vector<CharReach> triggerTail(const vector<CharReach> &lit) {
+    if (lit.size() <= MAX_TRIGGER_LEN) {
+        return lit;
+    }
+    return vector<CharReach>(lit.end() - MAX_TRIGGER_LEN, lit.end());
+}
+
+/**
+ * \brief Returns the vertices from which a predecessor of accept can be
+ * reached along at least one edge: an engine with one of these on can still go
+ * on to raise a match later.
+ */
+static
+ue2::unordered_set<NFAVertex> findLiveVertices(const NGHolder &g) {
+    ue2::unordered_set<NFAVertex> live;
+    vector<NFAVertex> work;
+    insert(&work, work.end(), inv_adjacent_vertices(g.accept, g));
+
+    while (!work.empty()) {
+        NFAVertex v = work.back();
+        work.pop_back();
+        for (auto u : inv_adjacent_vertices_range(v, g)) {
+            if (u != g.accept && live.insert(u).second) {
+                work.push_back(u);
+            }
+        }
+    }
+
+    return live;
+}
+
+/**
+ * \brief True if B's trigger \a lit_b can never complete while a copy of A
+ * triggered by \a lit_a on the given top is alive.
+ */
+static
+bool killsSafely(const NGHolder &g, const ue2::unordered_set<NFAVertex> &live,
+                 u32 top, const vector<CharReach> &lit_a_in,
+                 const vector<CharReach> &lit_b_in) {
+    const vector<CharReach> lit_a = triggerTail(lit_a_in);
+    const vector<CharReach> lit_b = triggerTail(lit_b_in);
+    if (lit_a.empty() || lit_b.empty()) {
+        return false;
+    }
+
+    TriggerTracker tt(lit_b);
+
+    // Walk A's trigger. B's trigger completing before A's is not our concern
+    // here, but both completing together is.
+    u64a m = tt.init();
+    for (const auto &cr : lit_a) {
+        m = tt.step(m, cr);
+        if (tt.complete(m) && &cr == &lit_a.back() && contains(live, g.start)) {
+            DEBUG_PRINTF("triggers can complete together\n");
+            return false;
+        }
+        m = tt.clear(m);
+    }
+
+    // Walk A's graph from its top.
+    set<pair<NFAVertex, u64a>> seen;
+    deque<pair<NFAVertex, u64a>> work;
+
+    auto visit = [&](NFAVertex v, u64a m_prev) {
+        if (is_special(v, g) || !contains(live, v)) {
+            return true; // A can't match after this point on this path.
+        }
+        u64a m_next = tt.step(m_prev, g[v].char_reach);
+        if (tt.complete(m_next)) {
+            DEBUG_PRINTF("trigger completes at live vertex %u\n", g[v].index);
+            return false;
+        }
+        m_next = tt.clear(m_next);
+        if (seen.emplace(v, m_next).second) {
+            work.emplace_back(v, m_next);
+        }
+        return seen.size() <= MAX_EXCLUSIVE_STATES;
+    };
+
+    for (const auto &e : out_edges_range(g.start, g)) {
+        if (g[e].top == top && !visit(target(e, g), m)) {
+            return false;
+        }
+    }
+
+    while (!work.empty()) {
+        NFAVertex u = work.front().first;
+        u64a m_cur = work.front().second;
+        work.pop_front();
+        for (auto v : adjacent_vertices_range(u, g)) {
+            if (!visit(v, m_cur)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static
+bool killsSafely(const ExclusiveInfo &a,
+                 const ue2::unordered_set<NFAVertex> &live_a,
+                 const ExclusiveInfo &b) {
+    assert(a.graph && b.graph);
+    for (const auto &trig_a : a.triggers) {
+        const u32 top = trig_a.first;
+        for (const auto &lit_a : trig_a.second) {
+            for (const auto &trig_b : b.triggers) {
+                for (const auto &lit_b : trig_b.second) {
+                    if (!killsSafely(*a.graph, live_a, top, lit_a, lit_b)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool killsSafely(const ExclusiveInfo &a, const ExclusiveInfo &b) {
+    return killsSafely(a, findLiveVertices(*a.graph), b);
+}
+
+vector<vector<u32>> findExclusiveGroups(const vector<ExclusiveInfo> &info,
+                                        const Grey &grey) {
+    vector<vector<u32>> groups;
+    const size_t chunk = grey.tamaChunkSize;
+    if (info.size() < 2 || chunk < 2) {
+        return groups;
+    }
+
+    vector<ue2::unordered_set<NFAVertex>> live;
+    for (const auto &ei : info) {
+        live.push_back(findLiveVertices(*ei.graph));
+    }
+
+    CliqueGraph cg;
+    vector<CliqueVertex> vertices;
+    for (u32 i = 0; i < info.size(); i++) {
+        vertices.push_back(add_vertex(CliqueVertexProps(i), cg));
+    }
+
+    for (u32 i = 0; i < info.size(); i++) {
+        for (u32 j = i + 1; j < info.size(); j++) {
+            if (killsSafely(info[i], live[i], info[j]) &&
+                killsSafely(info[j], live[j], info[i])) {
+                DEBUG_PRINTF("engines %u and %u are exclusive\n", i, j);
+                add_edge(vertices[i], vertices[j], cg);
+            }
+        }
+    }
+
+    for (auto &clique : findCliques(cg)) {
+        sort(clique.begin(), clique.end());
+        for (auto it = clique.begin(); it != clique.end();) {
+            auto end = it + min(chunk, (size_t)(clique.end() - it));
+            if (end - it >= 2) {
+                groups.emplace_back(it, end);
+            }
+            it = end;
+        }
+    }
+
+    return groups;
+}
+
+/** \brief True if the suffix on vertex \a v may be placed in a Tamarama. */
+static
+bool isExclusiveCandidate(const RoseBuildImpl &build, RoseVertex v,
+                          const suffix_id &s) {
+    const RoseGraph &g = build.g;
+
+    if (!s.graph()) {
+        return false;
+    }
+
+    if (has_eod_accepts(s)) {
+        DEBUG_PRINTF("suffix has eod accepts\n");
+        return false;
+    }
+
+    if (build.isVirtualVertex(v) || build.isInETable(v)) {
+        return false;
+    }
+
+    if (g[v].literals.empty()) {
+        return false;
+    }
+
+    for (u32 id : g[v].literals) {
+        const rose_literal_id &lit = build.literals.right.at(id);
+        if (lit.table == ROSE_EVENT || lit.s.empty()) {
+            return false;
+        }
+    }
+
+    for (ReportID r : all_reports(s)) {
+        if (build.rm.getReport(r).type == INTERNAL_ROSE_CHAIN) {
+            DEBUG_PRINTF("suffix triggers the mpv\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+vector<vector<suffix_id>>
+findExclusiveSuffixes(const RoseBuildImpl &build,
+                      const vector<suffix_id> &suffixes) {
+    const RoseGraph &g = build.g;
+
+    map<suffix_id, ExclusiveInfo> infoBySuffix;
+    set<suffix_id> bad;
+    for (auto v : vertices_range(g)) {
+        if (!g[v].suffix) {
+            continue;
+        }
+
+        const suffix_id s(g[v].suffix);
+        if (contains(bad, s)) {
+            continue;
+        }
+
+        if (!isExclusiveCandidate(build, v, s)) {
+            bad.insert(s);
+            infoBySuffix.erase(s);
+            continue;
+        }
+
+        ExclusiveInfo &ei = infoBySuffix[s];
+        ei.graph = s.graph();
+        auto &lits = ei.triggers[g[v].suffix.top];
+        for (u32 id : g[v].literals) {
+            lits.push_back(as_cr_seq(build.literals.right.at(id)));
+        }
+    }
+
+    vector<suffix_id> candidates;
+    vector<ExclusiveInfo> info;
+    for (const auto &s : suffixes) {
+        if (info.size() >= MAX_EXCLUSIVE_CANDIDATES) {
+            break;
+        }
+        if (contains(infoBySuffix, s)) {
+            candidates.push_back(s);
+            info.push_back(infoBySuffix.at(s));
+        }
+    }
+
+    DEBUG_PRINTF("%zu of %zu suffixes are candidates\n", candidates.size(),
+                 suffixes.size());
+
+    vector<vector<suffix_id>> rv;
+    for (const auto &group : findExclusiveGroups(info, build.cc.grey)) {
+        rv.push_back(vector<suffix_id>());
+        for (u32 i : group) {
+            rv.back().push_back(candidates[i]);
+        }
+    }
+
+    return rv;
+}
+
+} // namespace ue2
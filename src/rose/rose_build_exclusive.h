@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** \file
+ * \brief Rose build: mutual exclusion analysis for suffix engines.
+ *
+ * Two suffixes are exclusive if, whenever one of them is triggered, the other
+ * can no longer produce a match. Groups of pairwise exclusive suffixes can
+ * then share a single queue and state region inside a Tamarama container.
+ */
+
+#ifndef ROSE_BUILD_EXCLUSIVE_H
+#define ROSE_BUILD_EXCLUSIVE_H
+
+#include "rose_build_impl.h"
+#include "ue2common.h"
+#include "util/charreach.h"
+
+#include <map>
+#include <vector>
+
+namespace ue2 {
+
+class NGHolder;
+class RoseBuildImpl;
+struct Grey;
+
+/** \brief An engine to be considered for exclusive analysis. */
+struct ExclusiveInfo {
+    /** \brief The engine's graph. */
+    const NGHolder *graph = nullptr;
+
+    /** \brief Literal sequences that trigger each top of the engine. */
+    std::map<u32, std::vector<std::vector<CharReach>>> triggers;
+};
+
+/**
+ * \brief True if triggering engine \a b guarantees that engine \a a can raise
+ * no further matches after the trigger location.
+ */
+bool killsSafely(const ExclusiveInfo &a, const ExclusiveInfo &b);
+
+/**
+ * \brief Partition the given engines into groups of mutually exclusive
+ * engines, each group with at least two and at most \ref
+ * Grey::tamaChunkSize members. Engines are referred to by index.
+ */
+std::vector<std::vector<u32>>
+findExclusiveGroups(const std::vector<ExclusiveInfo> &info, const Grey &grey);
+
+/**
+ * \brief Find groups of mutually exclusive suffixes among the given suffixes.
+ */
+std::vector<std::vector<suffix_id>>
+findExclusiveSuffixes(const RoseBuildImpl &build,
+                      const std::vector<suffix_id> &suffixes);
+
+} // namespace ue2
+
+#endif // ROSE_BUILD_EXCLUSIVE_H
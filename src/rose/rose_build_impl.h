@@ -270,6 +270,10 @@ bool operator<(const rose_literal_id &a, const rose_literal_id &b) {
     return 0;
 }
 
+/** \brief The literal as a sequence of character classes, padded with a dot
+ * for each byte of delay. */
+std::vector<CharReach> as_cr_seq(const rose_literal_id &lit);
+
 // Literals are stored in a map from (string, nocase) -> ID
 typedef boost::bimap<rose_literal_id, u32> RoseLiteralMap;
 
@@ -382,8 +386,11 @@ public:
                  bool eod) override;
 
     // Construct a runtime implementation.
-    aligned_unique_ptr<RoseEngine> buildRose(u32 minWidth) override;
-    aligned_unique_ptr<RoseEngine> buildFinalEngine(u32 minWidth);
+    aligned_unique_ptr<RoseEngine> buildRose(u32 minWidth, u32 maxWidth,
+                                             u64a maxOffset) override;
+    aligned_unique_ptr<RoseEngine> buildFinalEngine(u32 minWidth,
+                                                    u32 maxWidth,
+                                                    u64a maxOffset);
 
     void setSom() override { hasSom = true; }
 
@@ -462,6 +462,16 @@ rose_literal_id::rose_literal_id(const ue2_literal &s_in,
     normaliseLiteralMask(s, msk, cmp);
 }
 
+vector<CharReach> as_cr_seq(const rose_literal_id &lit) {
+    vector<CharReach> rv = as_cr_seq(lit.s);
+    for (u32 i = 0; i < lit.delay; i++) {
+        rv.push_back(CharReach::dot());
+    }
+
+    /* TODO: take into account cmp/msk */
+    return rv;
+}
+
 u32 RoseBuildImpl::getLiteralId(const ue2_literal &s, const vector<u8> &msk,
                                 const vector<u8> &cmp, u32 delay,
                                 rose_literal_table table) {
@@ -623,6 +623,12 @@ void roseDumpText(const RoseEngine *t, FILE *f) {
     fprintf(f, "total engine size    : %u bytes\n", t->size);
     fprintf(f, " - anchored matcher  : %u bytes over %u bytes\n", t->asize,
             t->anchoredDistance);
+    if (t->altableOffset) {
+        const anchored_lit_table *alt = getALiteralTable(t);
+        fprintf(f, " - anchored lit table: %u bytes, %u literals at %u "
+                "offsets\n", t->altableSize, alt->entryCount,
+                alt->startCount);
+    }
     fprintf(f, " - floating matcher  : %zu bytes%s",
             ftable ? hwlmSize(ftable) : 0, t->noFloatingRoots ? " (cond)":"");
     if (t->floatingMinDistance) {
@@ -745,6 +751,13 @@ void roseDumpText(const RoseEngine *t, FILE *f) {
             t->minWidthExcludingBoundaries);
     fprintf(f, "  maxBiAnchoredWidth          : %s\n",
             rose_off(t->maxBiAnchoredWidth).str().c_str());
+    fprintf(f, "  maxMatchWidth               : %s\n",
+            rose_off(t->maxMatchWidth).str().c_str());
+    if (t->maxMatchOffset == MAX_OFFSET) {
+        fprintf(f, "  maxMatchOffset              : inf\n");
+    } else {
+        fprintf(f, "  maxMatchOffset              : %llu\n", t->maxMatchOffset);
+    }
     fprintf(f, "  maxSafeAnchoredDROffset     : %s\n",
             rose_off(t->maxSafeAnchoredDROffset).str().c_str());
     fprintf(f, "  minFloatLitMatchOffset      : %s\n",
@@ -814,6 +827,7 @@ void roseDumpStructRaw(const RoseEngine *t, FILE *f) {
     DUMP_U32(t, tStateSize);
     DUMP_U32(t, smallWriteOffset);
     DUMP_U32(t, amatcherOffset);
+    DUMP_U32(t, altableOffset);
     DUMP_U32(t, ematcherOffset);
     DUMP_U32(t, fmatcherOffset);
     DUMP_U32(t, smatcherOffset);
@@ -849,6 +863,7 @@ void roseDumpStructRaw(const RoseEngine *t, FILE *f) {
     DUMP_U32(t, minWidth);
     DUMP_U32(t, minWidthExcludingBoundaries);
     DUMP_U32(t, maxBiAnchoredWidth);
+    DUMP_U32(t, maxMatchWidth);
     DUMP_U32(t, anchoredDistance);
     DUMP_U32(t, anchoredMinDistance);
     DUMP_U32(t, floatingDistance);
@@ -860,6 +875,7 @@ void roseDumpStructRaw(const RoseEngine *t, FILE *f) {
     DUMP_U32(t, anchoredReportMapOffset);
     DUMP_U32(t, anchoredReportInverseMapOffset);
     DUMP_U64(t, initialGroups);
+    DUMP_U64(t, maxMatchOffset);
     DUMP_U32(t, size);
     DUMP_U32(t, anchoredMatches);
     DUMP_U32(t, delay_count);
@@ -885,12 +901,14 @@ void roseDumpStructRaw(const RoseEngine *t, FILE *f) {
     DUMP_U32(t, stateOffsets.somLocation);
     DUMP_U32(t, stateOffsets.somValid);
     DUMP_U32(t, stateOffsets.somWritable);
+    DUMP_U32(t, stateOffsets.delayedLiterals);
     DUMP_U32(t, stateOffsets.end);
     DUMP_U32(t, boundary.reportEodOffset);
     DUMP_U32(t, boundary.reportZeroOffset);
     DUMP_U32(t, boundary.reportZeroEodOffset);
     DUMP_U32(t, totalNumLiterals);
     DUMP_U32(t, asize);
+    DUMP_U32(t, altableSize);
     DUMP_U32(t, initSideEnableOffset);
     DUMP_U32(t, outfixBeginQueue);
     DUMP_U32(t, outfixEndQueue);
@@ -907,6 +925,7 @@ void roseDumpStructRaw(const RoseEngine *t, FILE *f) {
     DUMP_U32(t, group_weak_end);
     DUMP_U32(t, floatingStreamState);
     DUMP_U32(t, eodLiteralId);
+    DUMP_U32(t, provenanceOffset);
     fprintf(f, "}\n");
     fprintf(f, "sizeof(RoseEngine) = %zu\n", sizeof(RoseEngine));
 }
@@ -49,6 +49,35 @@ typedef u64a rose_group;
 #define DELAY_MASK                  (DELAY_SLOT_COUNT - 1)
 
 #define DELAY_FLOAT_DIRTY      (1U << 7) /* delay literal matched in history */
+#define DELAY_FLOAT_SAVED      (1U << 6) /* pending delayed literals stored in
+                                          * stream state */
+
+/** \brief Max literal indices held in a delay slot's list before the slot
+ * switches over to its multibit. */
+#define DELAY_LIST_MAX              7
+#define DELAY_LIST_OVERFLOW         (~0U)
+
+/** \brief Max pending delayed literals that can be carried over a stream
+ * write boundary in stream state; beyond this, they are rebuilt from
+ * history on the next write. */
+#define DELAY_SAVE_MAX              4
+
+/** \brief Stream state needed to carry pending delayed literals: a u8 count
+ * followed by (u8 distance, u32 delay index) pairs. */
+#define DELAY_SAVE_SIZE             (1 + DELAY_SAVE_MAX * 5)
+
+/**
+ * \brief Sparse contents of a delay slot.
+ *
+ * Most delay slots only ever hold a handful of literals, so they are kept as
+ * a short unsorted list of delay indices. Once a slot holds more than
+ * DELAY_LIST_MAX, it switches to the slot's multibit and count is set to
+ * DELAY_LIST_OVERFLOW.
+ */
+struct delay_list {
+    u32 count;
+    u32 ids[DELAY_LIST_MAX];
+};
 
 // Direct report stuff
 #define LITERAL_DR_FLAG   (1U << 31)
@@ -414,6 +443,10 @@ struct RoseStateOffsets {
     /** Multibit guarding SOM location slots. */
     u32 somWritable;
 
+    /** Pending delayed literals carried over a stream write boundary, see
+     * DELAY_SAVE_SIZE. Zero if not present. */
+    u32 delayedLiterals;
+
     /** Total size of Rose state, in bytes. */
     u32 end;
 };
@@ -511,6 +544,7 @@ struct RoseEngine {
                            * used for sizing scratch only. */
     u32 smallWriteOffset; /**< offset of small-write matcher */
     u32 amatcherOffset; // offset of the anchored literal matcher (bytes)
+    u32 altableOffset; // offset of the anchored literal table (bytes)
     u32 ematcherOffset; // offset of the eod-anchored literal matcher (bytes)
     u32 fmatcherOffset; // offset of the floating literal matcher (bytes)
     u32 smatcherOffset; // offset of the sidecar literal matcher (bytes)
@@ -568,6 +602,9 @@ struct RoseEngine {
 
     u32 maxBiAnchoredWidth; /* ROSE_BOUND_INF if any non bianchored patterns
                              * present */
+    u32 maxMatchWidth; /* longest match any pattern can produce, or
+                        * ROSE_BOUND_INF if unbounded or if some pattern's
+                        * matches depend on context outside the match */
     u32 anchoredDistance; // region to run the anchored table over
     u32 anchoredMinDistance; /* start of region to run anchored table over */
     u32 floatingDistance; /* end of region to run the floating table over
@@ -585,6 +622,8 @@ struct RoseEngine {
     u32 anchoredReportMapOffset; /* am_log index --> reportid */
     u32 anchoredReportInverseMapOffset; /*  reportid --> am_log index */
     rose_group initialGroups;
+    u64a maxMatchOffset; /* last offset at which any pattern can report a
+                          * match, or MAX_OFFSET if unbounded */
     u32 size; // (bytes)
     u32 anchoredMatches; /* number of anchored roles generating matches */
     u32 delay_count; /* number of delayed literal ids. */
@@ -605,6 +644,7 @@ struct RoseEngine {
     struct RoseBoundaryReports boundary;
     u32 totalNumLiterals; /* total number of literals including dr */
     u32 asize; /* size of the atable */
+    u32 altableSize; /* size of the anchored literal table */
     u32 initSideEnableOffset; /* sidecar literals enabled initially */
     u32 outfixBeginQueue; /* first outfix queue */
     u32 outfixEndQueue; /* one past the last outfix queue */
@@ -622,10 +662,29 @@ struct RoseEngine {
     u32 group_weak_end; /* end of weak groups, debugging only */
     u32 floatingStreamState; // size in bytes
     u32 eodLiteralId; // literal ID for eod ROSE_EVENT if used, otherwise 0.
+    u32 provenanceOffset; /**< offset of RoseProvenance, or 0 if the database
+                           * was not built with profiling support */
 
     struct scatter_full_plan state_init;
 };
 
+/**
+ * \brief Scan cost provenance, used to attribute profiled scan cost back to
+ * patterns.
+ *
+ * Maps each literal id (below RoseEngine::literalCount) and each engine queue
+ * to the sorted list of expression ids whose matches it can contribute to.
+ * List i of a kind runs from bounds[i] to bounds[i + 1] in the owner array.
+ * All offsets are relative to the RoseEngine.
+ */
+struct RoseProvenance {
+    u32 literalCount; /**< number of literal lists */
+    u32 queueCount; /**< number of queue lists */
+    u32 literalBoundsOffset; /**< u32[literalCount + 1] list bounds */
+    u32 queueBoundsOffset; /**< u32[queueCount + 1] list bounds */
+    u32 ownerOffset; /**< u32 array of expression ids */
+};
+
 struct lit_benefits {
     union {
         u64a a64[MAX_MASK2_WIDTH/sizeof(u64a)];
@@ -670,6 +729,74 @@ const struct anchored_matcher_info *getALiteralMatcher(
     return (const struct anchored_matcher_info *)lt;
 }
 
+/**
+ * \brief Header for the anchored literal table.
+ *
+ * Large sets of literals that must start at a fixed offset from the start of
+ * the data (e.g. /^GET \/index\.html/) are matched in block mode by this
+ * table rather than being compiled into the anchored DFAs. Each distinct start
+ * offset is looked up in a hash table keyed on the first prefixLen bytes of
+ * the data there, and candidates are confirmed with a masked vector compare.
+ *
+ * Followed in memory by:
+ * -# u32 starts[startCount]: distinct literal start offsets, ascending
+ * -# u32 buckets[bucketCount + 1]: index of the first entry in each bucket
+ * -# struct anchored_lit_entry entries[entryCount], grouped by bucket
+ * -# literal bytes and masks for each entry, 16-byte aligned and padded
+ */
+struct ALIGN_CL_DIRECTIVE anchored_lit_table {
+    u32 startCount; /**< number of distinct literal start offsets */
+    u32 bucketCount; /**< number of hash buckets, a power of two */
+    u32 entryCount; /**< number of entries */
+    u32 prefixLen; /**< bytes hashed at each start offset, 1 to 8 */
+    u32 startsOffset; /**< offset to starts array, relative to this */
+    u32 bucketsOffset; /**< offset to buckets array, relative to this */
+    u32 entriesOffset; /**< offset to entries array, relative to this */
+};
+
+/** \brief A single literal in the anchored literal table. */
+struct anchored_lit_entry {
+    u64a prefix; /**< first prefixLen bytes of the literal, masked */
+    u64a prefixMask; /**< mask applied to the data before prefix compare */
+    u32 start; /**< offset of the literal's first byte */
+    u32 len; /**< literal length */
+    u32 litOffset; /**< offset of literal bytes (followed by masks of the same
+                    * padded length), relative to the table */
+    u32 id; /**< final literal id, as reported by the anchored DFAs */
+};
+
+/** \brief Mask selecting the low \a prefix_len bytes of a u64a. */
+static really_inline
+u64a anchoredLitPrefixMask(u32 prefix_len) {
+    assert(prefix_len && prefix_len <= 8);
+    return prefix_len == 8 ? ~0ULL : (1ULL << (prefix_len * 8)) - 1;
+}
+
+/**
+ * \brief Bucket for the given data prefix and start offset.
+ *
+ * Bit 5 of each byte is ignored so that caseless literals hash identically in
+ * either case; collisions this introduces are resolved by the entry compare.
+ */
+static really_inline
+u32 anchoredLitBucket(u64a prefix, u32 start, u32 bucket_count) {
+    u64a key = (prefix & 0xdfdfdfdfdfdfdfdfULL)
+             ^ ((u64a)start * 0xc2b2ae3d27d4eb4fULL);
+    key *= 0x9e3779b97f4a7c15ULL;
+    return (u32)(key >> 32) & (bucket_count - 1);
+}
+
+static really_inline
+const struct anchored_lit_table *getALiteralTable(const struct RoseEngine *t) {
+    if (!t->altableOffset) {
+        return NULL;
+    }
+
+    const char *lt = (const char *)t + t->altableOffset;
+    assert(ISALIGNED_CL(lt));
+    return (const struct anchored_lit_table *)lt;
+}
+
 struct HWLM;
 
 static really_inline
@@ -815,6 +942,16 @@ const struct LeftNfaInfo *getLeftInfoByQueue(const struct RoseEngine *t,
     return &infos[queueToLeftIndex(t, qi)];
 }
 
+static really_inline
+const struct RoseProvenance *getProvenance(const struct RoseEngine *t) {
+    if (!t->provenanceOffset) {
+        return NULL;
+    }
+
+    return (const struct RoseProvenance *)((const char *)t +
+                                           t->provenanceOffset);
+}
+
 struct SmallWriteEngine;
 
 static really_inline
@@ -521,22 +521,23 @@ void roseStreamExec(const struct RoseEngine *t, u8 *state,
 
         size_t hlength = scratch->core_info.hlen;
 
+        char delay_live = t->maxFloatingDelayedMatch == ROSE_BOUND_INF
+                          || offset < t->maxFloatingDelayedMatch;
         char rebuild = hlength && (delay_rb_status & DELAY_FLOAT_DIRTY)
-            && (t->maxFloatingDelayedMatch == ROSE_BOUND_INF
-                || offset < t->maxFloatingDelayedMatch);
-        DEBUG_PRINTF("**rebuild %hhd status %hhu mfdm %u, offset %llu\n",
-                     rebuild, delay_rb_status, t->maxFloatingDelayedMatch,
-                     offset);
-
-        if (!flen) {
-            if (rebuild) { /* rebuild floating delayed match stuff */
-                do_rebuild(t, ftable, scratch);
-            }
-            goto flush_delay_and_exit;
-        }
+            && delay_live;
+        char restore = (delay_rb_status & DELAY_FLOAT_SAVED) && delay_live;
+        DEBUG_PRINTF("**rebuild %hhd restore %hhd status %hhu mfdm %u, "
+                     "offset %llu\n", rebuild, restore, delay_rb_status,
+                     t->maxFloatingDelayedMatch, offset);
 
         if (rebuild) { /* rebuild floating delayed match stuff */
             do_rebuild(t, ftable, scratch);
+        } else if (restore) { /* saved at the end of the last write */
+            roseRestoreDelayedLiterals(tctxt, offset);
+        }
+
+        if (!flen) {
+            goto flush_delay_and_exit;
         }
 
         if (flen + offset <= t->floatingMinDistance) {
@@ -59,7 +59,7 @@
 #define DEDUPE_MATCHES
 
 static really_inline
-void prefetch_data(const char *data, unsigned length) {
+void prefetch_data(const char *data, size_t length) {
     __builtin_prefetch(data);
     __builtin_prefetch(data + length/2);
     __builtin_prefetch(data + length - 24);
@@ -170,6 +170,36 @@ void setBroken(char *state, u8 broken) {
     ts->broken = broken;
 }
 
+/** \brief True if no pattern can match once \a offset bytes have been seen,
+ * including at EOD.
+ *
+ * A match at maxMatchOffset may still need one more byte to be resolved (e.g.
+ * a trailing word boundary, or a '$' before a final newline), so the horizon
+ * lies one byte past it. */
+static really_inline
+char pastMatchHorizon(const struct RoseEngine *rose, u64a offset) {
+    return rose->maxMatchOffset != MAX_OFFSET
+        && offset > rose->maxMatchOffset + 1;
+}
+
+/** \brief Returns the number of bytes of a write of \a length bytes at
+ * \a offset that must be scanned before no further match is possible.
+ *
+ * We stop one byte past the horizon so that the scanned data always extends
+ * beyond any offset at which an EOD match could occur. */
+static really_inline
+size_t matchHorizonLength(const struct RoseEngine *rose, u64a offset,
+                          size_t length) {
+    if (rose->maxMatchOffset == MAX_OFFSET) {
+        return length;
+    }
+    u64a end = rose->maxMatchOffset + 2;
+    if (offset >= end) {
+        return 0;
+    }
+    return MIN(length, end - offset);
+}
+
 static really_inline
 int roseAdaptor_i(u64a offset, ReportID id, void *context, char is_simple,
                   char do_som) {
@@ -739,6 +769,7 @@ void soleOutfixBlockExec(const struct RoseEngine *t,
     initSomState(t, (u8 *)scratch->core_info.state);
     assert(t->outfixEndQueue == 1);
     assert(!t->amatcherOffset);
+    assert(!t->altableOffset);
     assert(!t->ematcherOffset);
     assert(!t->fmatcherOffset);
 
@@ -760,14 +791,138 @@ void soleOutfixBlockExec(const struct RoseEngine *t,
 
     char rv = nfaQueueExec(q->nfa, q, scratch->core_info.len);
 
-    if (rv && nfaAcceptsEod(nfa) && len == scratch->core_info.len) {
+    if (rv && nfaAcceptsEod(nfa) && len == scratch->core_info.len
+        && !pastMatchHorizon(t, len)) {
         nfaCheckFinalState(nfa, q->state, q->streamState, q->length,
                         q->cb, q->som_cb, scratch);
     }
 }
 
+static really_inline
+void runSmallWriteNfa(const struct NFA *nfa, u32 start_offset,
+                      const u8 *buffer, size_t length, NfaCallback cb,
+                      void *ctxt) {
+    size_t local_alen = length - start_offset;
+    const u8 *local_buffer = buffer + start_offset;
+
+    assert(isMcClellanType(nfa->type));
+    if (nfa->type == MCCLELLAN_NFA_8) {
+        nfaExecMcClellan8_B(nfa, start_offset, local_buffer, local_alen, cb,
+                            ctxt);
+    } else {
+        nfaExecMcClellan16_B(nfa, start_offset, local_buffer, local_alen, cb,
+                             ctxt);
+    }
+}
+
+/** \brief Match collection context used by a multi-DFA small write engine. */
+struct smwr_collector {
+    struct smwr_match *matches;
+    u32 count;
+    u32 capacity;
+    char overflow;
+};
+
+static
+int smwrCollectMatch(u64a offset, ReportID id, void *context) {
+    struct smwr_collector *coll = context;
+    if (coll->count == coll->capacity) {
+        DEBUG_PRINTF("match buffer full\n");
+        coll->overflow = 1;
+        return MO_HALT_MATCHING;
+    }
+
+    coll->matches[coll->count].offset = offset;
+    coll->matches[coll->count].id = id;
+    coll->count++;
+    return MO_CONTINUE_MATCHING;
+}
+
+/**
+ * \brief Run a small write engine containing several DFAs.
+ *
+ * Each DFA is run over the buffer in turn with its matches collected into
+ * scratch; the per-DFA match lists (each already in offset order) are then
+ * merged so that matches are delivered in order.
+ *
+ * The DFAs are run one after another rather than interleaved byte by byte.
+ * Each run goes through the normal McClellan block scan, which skips ahead
+ * with acceleration from its own accel states. An interleaved loop would
+ * have to step every DFA at the same offset and so could not accelerate any
+ * of them. With at most SMWR_MAX_NFAS DFAs over a buffer no larger than the
+ * small write region, later passes re-read data that is already in L1. The
+ * only extra work is collecting and merging the matches.
+ *
+ * Returns zero without raising any matches if the match buffer overflowed,
+ * in which case the caller must fall back to the full Rose path.
+ */
+static never_inline
+char runSmallWriteMulti(const struct SmallWriteEngine *smwr,
+                        struct hs_scratch *scratch) {
+    const u8 *buffer = scratch->core_info.buf;
+    size_t length = scratch->core_info.len;
+    const struct RoseEngine *rose = scratch->core_info.rose;
+
+    assert(smwr->nfaCount > 1 && smwr->nfaCount <= SMWR_MAX_NFAS);
+
+    struct smwr_collector coll;
+    coll.matches = scratch->smwr_matches;
+    coll.count = 0;
+    coll.capacity = scratch->smwrMatchCount;
+    coll.overflow = 0;
+
+    u32 pos[SMWR_MAX_NFAS];
+    u32 end[SMWR_MAX_NFAS];
+
+    for (u32 i = 0; i < smwr->nfaCount; i++) {
+        pos[i] = coll.count;
+        if (length > smwr->start_offset[i]) {
+            runSmallWriteNfa(getSmwrNfa(smwr, i), smwr->start_offset[i],
+                             buffer, length, smwrCollectMatch, &coll);
+            if (coll.overflow) {
+                return 0;
+            }
+        }
+        end[i] = coll.count;
+    }
+
+    DEBUG_PRINTF("collected %u matches\n", coll.count);
+
+    RoseCallback cb = selectAdaptor(rose);
+    const struct smwr_match *m = coll.matches;
+    for (;;) {
+        u32 best = SMWR_MAX_NFAS;
+        for (u32 i = 0; i < smwr->nfaCount; i++) {
+            if (pos[i] == end[i]) {
+                continue;
+            }
+            if (best == SMWR_MAX_NFAS
+                || m[pos[i]].offset < m[pos[best]].offset) {
+                best = i;
+            }
+        }
+
+        if (best == SMWR_MAX_NFAS) {
+            break;
+        }
+
+        const struct smwr_match *next = &m[pos[best]++];
+        if (cb(next->offset, next->id, scratch) == MO_HALT_MATCHING) {
+            break;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * \brief Run the small write engine over the current block.
+ *
+ * Returns zero if the engine could not handle this block, in which case no
+ * matches have been raised and the caller must use the full Rose path.
+ */
 static rose_inline
-void runSmallWriteEngine(const struct SmallWriteEngine *smwr,
+char runSmallWriteEngine(const struct SmallWriteEngine *smwr,
                          struct hs_scratch *scratch) {
     assert(smwr);
     assert(scratch);
@@ -777,32 +932,26 @@ void runSmallWriteEngine(const struct SmallWriteEngine *smwr,
 
     DEBUG_PRINTF("USING SMALL WRITE\n");
 
-    if (length <= smwr->start_offset) {
-        DEBUG_PRINTF("too short\n");
-        return;
+    if (smwr->nfaCount > 1) {
+        return runSmallWriteMulti(smwr, scratch);
     }
 
-    const struct NFA *nfa = getSmwrNfa(smwr);
+    if (length <= smwr->start_offset[0]) {
+        DEBUG_PRINTF("too short\n");
+        return 1;
+    }
 
     const struct RoseEngine *rose = scratch->core_info.rose;
-
-    size_t local_alen = length - smwr->start_offset;
-    const u8 *local_buffer = buffer + smwr->start_offset;
-
-    assert(isMcClellanType(nfa->type));
-    if (nfa->type == MCCLELLAN_NFA_8) {
-        nfaExecMcClellan8_B(nfa, smwr->start_offset, local_buffer,
-                            local_alen, selectAdaptor(rose), scratch);
-    } else {
-        nfaExecMcClellan16_B(nfa, smwr->start_offset, local_buffer,
-                             local_alen, selectAdaptor(rose), scratch);
-    }
+    runSmallWriteNfa(getSmwrNfa(smwr, 0), smwr->start_offset[0], buffer,
+                     length, selectAdaptor(rose), scratch);
+    return 1;
 }
 
-HS_PUBLIC_API
-hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
-                   unsigned flags, hs_scratch_t *scratch,
-                   match_event_handler onEvent, void *userCtx) {
+static really_inline
+hs_error_t hs_scan_internal(const hs_database_t *db, const char *data,
+                            size_t length, unsigned flags,
+                            hs_scratch_t *scratch, match_event_handler onEvent,
+                            void *userCtx) {
     if (unlikely(!scratch || !data)) {
         return HS_INVALID;
     }
@@ -826,7 +975,7 @@ hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
     }
 
     if (rose->minWidth > length) {
-        DEBUG_PRINTF("minwidth=%u > length=%u\n", rose->minWidth, length);
+        DEBUG_PRINTF("minwidth=%u > length=%zu\n", rose->minWidth, length);
         return HS_SUCCESS;
     }
 
@@ -851,7 +1000,7 @@ hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
     }
 
     if (rose->minWidthExcludingBoundaries > length) {
-        DEBUG_PRINTF("minWidthExcludingBoundaries=%u > length=%u\n",
+        DEBUG_PRINTF("minWidthExcludingBoundaries=%u > length=%zu\n",
                      rose->minWidthExcludingBoundaries, length);
         goto done_scan;
     }
@@ -860,7 +1009,7 @@ hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
     // of bi-anchored patterns).
     if (rose->maxBiAnchoredWidth != ROSE_BOUND_INF
         && length > rose->maxBiAnchoredWidth) {
-        DEBUG_PRINTF("block len=%u longer than maxBAWidth=%u\n", length,
+        DEBUG_PRINTF("block len=%zu longer than maxBAWidth=%u\n", length,
                      rose->maxBiAnchoredWidth);
         goto done_scan;
     }
@@ -873,13 +1022,23 @@ hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
         // Apply the small write engine if and only if the block (buffer) is
         // small enough. Otherwise, we allow rose &co to deal with it.
         if (length < smwr->largestBuffer) {
-            DEBUG_PRINTF("Attempting small write of block %u bytes long.\n",
+            DEBUG_PRINTF("Attempting small write of block %zu bytes long.\n",
                          length);
-            runSmallWriteEngine(smwr, scratch);
-            goto done_scan;
+            if (runSmallWriteEngine(smwr, scratch)) {
+                goto done_scan;
+            }
+            DEBUG_PRINTF("small write engine bailed, using rose\n");
         }
     }
 
+    // No pattern can match beyond maxMatchOffset, so there is no need to scan
+    // the tail of a long block.
+    scratch->core_info.len = matchHorizonLength(rose, 0, length);
+    if (scratch->core_info.len < length) {
+        DEBUG_PRINTF("block len=%zu trimmed to %zu by maxMatchOffset=%llu\n",
+                     length, scratch->core_info.len, rose->maxMatchOffset);
+    }
+
     switch (rose->runtimeImpl) {
     default:
         assert(0);
@@ -916,6 +1075,22 @@ set_retval:
     return told_to_stop_matching(scratch) ? HS_SCAN_TERMINATED : HS_SUCCESS;
 }
 
+HS_PUBLIC_API
+hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
+                   unsigned flags, hs_scratch_t *scratch,
+                   match_event_handler onEvent, void *userCtx) {
+    return hs_scan_internal(db, data, length, flags, scratch, onEvent,
+                            userCtx);
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scan64(const hs_database_t *db, const char *data, size_t length,
+                     unsigned flags, hs_scratch_t *scratch,
+                     match_event_handler onEvent, void *userCtx) {
+    return hs_scan_internal(db, data, length, flags, scratch, onEvent,
+                            userCtx);
+}
+
 static really_inline
 void maintainHistoryBuffer(const struct RoseEngine *rose, char *state,
                            const char *buffer, size_t length) {
@@ -1040,6 +1215,7 @@ void soleOutfixEodExec(hs_stream_t *id, hs_scratch_t *scratch) {
 
     assert(t->outfixEndQueue == 1);
     assert(!t->amatcherOffset);
+    assert(!t->altableOffset);
     assert(!t->ematcherOffset);
     assert(!t->fmatcherOffset);
 
@@ -1261,6 +1437,7 @@ void soleOutfixStreamExec(struct hs_stream *stream_state,
     const struct RoseEngine *t = stream_state->rose;
     assert(t->outfixEndQueue == 1);
     assert(!t->amatcherOffset);
+    assert(!t->altableOffset);
     assert(!t->ematcherOffset);
     assert(!t->fmatcherOffset);
 
@@ -1289,7 +1466,7 @@ void soleOutfixStreamExec(struct hs_stream *stream_state,
 
 static inline
 hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
-                                   unsigned length, UNUSED unsigned flags,
+                                   size_t length, UNUSED unsigned flags,
                                    hs_scratch_t *scratch,
                                    match_event_handler onEvent, void *context) {
     if (unlikely(!id || !scratch || !data || !validScratch(id->rose, scratch))) {
@@ -1319,6 +1496,16 @@ hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
         return HS_SUCCESS;
     }
 
+    // Only scan up to the point beyond which no pattern can match; the stream
+    // is marked exhausted below once we get there.
+    length = matchHorizonLength(rose, id->offset, length);
+    if (unlikely(length == 0)) {
+        DEBUG_PRINTF("stream is past maxMatchOffset=%llu\n",
+                     rose->maxMatchOffset);
+        setBroken(state, BROKEN_EXHAUSTED);
+        return HS_SUCCESS;
+    }
+
     u32 historyAmount = getHistoryAmount(rose, id->offset);
     populateCoreInfo(scratch, rose, state, onEvent, context, data, length,
                      getHistory(state, rose, id->offset), historyAmount,
@@ -1365,6 +1552,11 @@ hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
         if (rose->somLocationCount) {
             storeSomToStream(scratch, id->offset);
         }
+
+        if (pastMatchHorizon(rose, id->offset)) {
+            DEBUG_PRINTF("no match possible past offset %llu\n", id->offset);
+            setBroken(state, BROKEN_EXHAUSTED);
+        }
     } else if (told_to_stop_matching(scratch)) {
         return HS_SCAN_TERMINATED;
     } else { /* exhausted */
@@ -1382,6 +1574,14 @@ hs_error_t hs_scan_stream(hs_stream_t *id, const char *data, unsigned length,
                                        onEvent, context);
 }
 
+HS_PUBLIC_API
+hs_error_t hs_scan_stream64(hs_stream_t *id, const char *data, size_t length,
+                            unsigned flags, hs_scratch_t *scratch,
+                            match_event_handler onEvent, void *context) {
+    return hs_scan_stream_internal(id, data, length, flags, scratch,
+                                       onEvent, context);
+}
+
 HS_PUBLIC_API
 hs_error_t hs_close_stream(hs_stream_t *id, hs_scratch_t *scratch,
                            match_event_handler onEvent, void *context) {
@@ -1449,6 +1649,28 @@ hs_error_t hs_stream_size(const hs_database_t *db, size_t *stream_size) {
     return HS_SUCCESS;
 }
 
+HS_PUBLIC_API
+hs_error_t hs_database_max_width(const hs_database_t *db,
+                                 unsigned int *max_width) {
+    if (!max_width) {
+        return HS_INVALID;
+    }
+
+    hs_error_t ret = validDatabase(db);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (!ISALIGNED_16(rose)) {
+        return HS_INVALID;
+    }
+
+    // ROSE_BOUND_INF is all-ones, i.e. UINT_MAX.
+    *max_width = rose->maxMatchWidth;
+    return HS_SUCCESS;
+}
+
 #if defined(DEBUG) || defined(DUMP_SUPPORT)
 #include "util/compare.h"
 // A debugging crutch: print a hex-escaped version of the match for our
@@ -1468,12 +1690,17 @@ void dumpData(const char *data, size_t len) {
 }
 #endif
 
-HS_PUBLIC_API
-hs_error_t hs_scan_vector(const hs_database_t *db, const char * const * data,
-                          const unsigned int *length, unsigned int count,
-                          UNUSED unsigned int flags, hs_scratch_t *scratch,
-                          match_event_handler onEvent, void *context) {
-    if (unlikely(!scratch || !data || !length)) {
+/** Vectored scan; exactly one of \a length32 and \a length64 supplies the
+ * block lengths. */
+static really_inline
+hs_error_t hs_scan_vector_internal(const hs_database_t *db,
+                                   const char * const * data,
+                                   const unsigned int *length32,
+                                   const size_t *length64, unsigned int count,
+                                   hs_scratch_t *scratch,
+                                   match_event_handler onEvent,
+                                   void *context) {
+    if (unlikely(!scratch || !data || (!length32 && !length64))) {
         return HS_INVALID;
     }
 
@@ -1500,14 +1727,15 @@ hs_error_t hs_scan_vector(const hs_database_t *db, const char * const * data,
     init_stream(id, rose); /* open stream */
 
     for (u32 i = 0; i < count; i++) {
-        DEBUG_PRINTF("block %u/%u offset=%llu len=%u\n", i, count, id->offset,
-                     length[i]);
+        size_t len = length64 ? length64[i] : length32[i];
+        DEBUG_PRINTF("block %u/%u offset=%llu len=%zu\n", i, count, id->offset,
+                     len);
 #ifdef DEBUG
-        dumpData(data[i], length[i]);
+        dumpData(data[i], len);
 #endif
         hs_error_t ret
-            = hs_scan_stream_internal(id, data[i], length[i], 0, scratch,
-                                      onEvent, context);
+            = hs_scan_stream_internal(id, data[i], len, 0, scratch, onEvent,
+                                      context);
         if (ret != HS_SUCCESS) {
             return ret;
         }
@@ -1524,3 +1752,27 @@ hs_error_t hs_scan_vector(const hs_database_t *db, const char * const * data,
 
     return HS_SUCCESS;
 }
+
+HS_PUBLIC_API
+hs_error_t hs_scan_vector(const hs_database_t *db, const char * const * data,
+                          const unsigned int *length, unsigned int count,
+                          UNUSED unsigned int flags, hs_scratch_t *scratch,
+                          match_event_handler onEvent, void *context) {
+    if (unlikely(!length)) {
+        return HS_INVALID;
+    }
+    return hs_scan_vector_internal(db, data, length, NULL, count, scratch,
+                                   onEvent, context);
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scan_vector64(const hs_database_t *db, const char * const * data,
+                            const size_t *length, unsigned int count,
+                            UNUSED unsigned int flags, hs_scratch_t *scratch,
+                            match_event_handler onEvent, void *context) {
+    if (unlikely(!length)) {
+        return HS_INVALID;
+    }
+    return hs_scan_vector_internal(db, data, NULL, length, count, scratch,
+                                   onEvent, context);
+}
@@ -44,6 +44,7 @@
 #include "nfa/nfa_api_queue.h"
 #include "sidecar/sidecar.h"
 #include "rose/rose_internal.h"
+#include "smallwrite/smallwrite_internal.h"
 #include "util/fatbit.h"
 #include "util/multibit.h"
 
@@ -83,6 +84,9 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
     anchored_literal_region_size = ROUNDUP_N(anchored_literal_region_size, 8);
 
     size_t delay_size = mmbit_size(proto->delay_count) * DELAY_SLOT_COUNT;
+    size_t delay_list_size = sizeof(struct delay_list) * DELAY_SLOT_COUNT;
+
+    size_t smwr_match_size = proto->smwrMatchCount * sizeof(struct smwr_match);
 
     size_t nfa_context_size = 2 * sizeof(struct NFAContext512) + 127;
 
@@ -98,11 +102,13 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
                   + 2 * sizeof(u64a) * deduperCount /* start offsets for som */
                   + anchored_region_size
                   + anchored_literal_region_size + qmpq_size + delay_size
+                  + delay_list_size
                   + som_store_size
                   + som_now_size
                   + som_attempted_size
                   + som_attempted_store_size
-                  + proto->sideScratchSize + 15;
+                  + smwr_match_size
+                  + proto->sideScratchSize + 31;
 
     /* the struct plus the allocated stuff plus padding for cacheline
      * alignment */
@@ -122,6 +128,7 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
     *s = *proto;
 
     s->magic = SCRATCH_MAGIC;
+    s->profile = NULL; /* profiles are never shared between scratch regions */
     s->scratchSize = alloc_size;
     s->scratch_alloc = (char *)s_tmp;
 
@@ -142,6 +149,13 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
     s->som_attempted_store = (u64a *)current;
     current += som_attempted_store_size;
 
+    s->smwr_matches = (struct smwr_match *)current;
+    current += smwr_match_size;
+
+    assert(ISALIGNED_N(current, 4));
+    s->delay_lists = (struct delay_list *)current;
+    current += delay_list_size;
+
     s->delay_slots = (u8 *)current;
     current += delay_size;
 
@@ -214,7 +228,8 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
     s->som_attempted_set = (struct fatbit *)current;
     current += som_attempted_size;
 
-    current = ROUNDUP_PTR(current, 16);
+    /* sidecar match records may hold 256-bit state */
+    current = ROUNDUP_PTR(current, alignof(m256));
     s->side_scratch = (void *)current;
     current += proto->sideScratchSize;
 
@@ -334,6 +349,13 @@ hs_error_t hs_alloc_scratch(const hs_database_t *db, hs_scratch_t **scratch) {
         proto->sideScratchSize = sidecarScratchSize(side);
     }
 
+    const struct SmallWriteEngine *smwr = getSmallWrite(rose);
+    if (smwr && smwr->nfaCount > 1
+        && SMWR_MATCH_BUF_SIZE > proto->smwrMatchCount) {
+        resize = 1;
+        proto->smwrMatchCount = SMWR_MATCH_BUF_SIZE;
+    }
+
     u32 som_store_count = rose->somLocationCount;
     if (som_store_count > proto->som_store_count) {
         resize = 1;
@@ -49,10 +49,13 @@ extern "C"
 UNUSED static const u32 SCRATCH_MAGIC = 0x544F4259;
 #define FDR_TEMP_BUF_SIZE 200
 
+struct delay_list;
 struct fatbit;
+struct hs_profile;
 struct hs_scratch;
 struct RoseEngine;
 struct mq;
+struct smwr_match;
 
 struct queue_match {
     /** \brief used to store the current location of an (suf|out)fix match in
@@ -168,6 +171,7 @@ struct ALIGN_CL_DIRECTIVE hs_scratch {
     struct fatbit *aqa; /**< active queue array; fatbit of queues that are valid
                          * & active */
     u8 *delay_slots;
+    struct delay_list *delay_lists; /**< sparse form of delay_slots */
     u8 **am_log;
     u8 **al_log;
     u64a am_log_sum;
@@ -198,6 +202,11 @@ struct ALIGN_CL_DIRECTIVE hs_scratch {
     struct mmbit_sparse_state sparse_iter_state[MAX_SPARSE_ITER_STATES];
     union sidecar_enabled_any ALIGN_CL_DIRECTIVE side_enabled;
     struct sidecar_scratch *side_scratch;
+    u32 smwrMatchCount; /**< capacity of smwr_matches */
+    struct smwr_match *smwr_matches; /**< used to order matches from a
+                                      * multi-dfa small write engine */
+    struct hs_profile *profile; /**< attached scan cost profile, or NULL;
+                                 * only used in PROFILE_SUPPORT builds */
 };
 
 static really_inline
@@ -222,6 +231,11 @@ u8 *getDelaySlots(struct hs_scratch *scratch) {
     return scratch->delay_slots;
 }
 
+static really_inline
+struct delay_list *getDelayLists(struct hs_scratch *scratch) {
+    return scratch->delay_lists;
+}
+
 static really_inline
 char told_to_stop_matching(const struct hs_scratch *scratch) {
     return scratch->core_info.broken == BROKEN_FROM_USER;
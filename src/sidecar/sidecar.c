@@ -82,6 +82,26 @@ u32 findAndClearLSB_256(m256 *v) {
     return rv;
 }
 
+static never_inline
+u32 findAndClearLSB_512(m512 *v) {
+    union {
+        u32 words[sizeof(m512)/sizeof(u32)];
+        m512 simd;
+    } s;
+    s.simd = *v;
+    u32 rv = 0;
+    for (u32 i = 0; i < ARRAY_LENGTH(s.words); i++) {
+        u32 *w = &s.words[i];
+        if (*w) {
+            rv = findAndClearLSB_32(w) + 32 * i;
+            break;
+        }
+    }
+
+    *v = s.simd;
+    return rv;
+}
+
 #define DO_DEAD_CHECK 1
 
 #define TAG 8
@@ -104,6 +124,10 @@ u32 findAndClearLSB_256(m256 *v) {
 #define STATE_T m256
 #include "sidecar_generic.h"
 
+#define TAG 512
+#define STATE_T m512
+#include "sidecar_generic.h"
+
 
 static never_inline
 void sidecarExec_N(const struct sidecar_N *n, const u8 *b, size_t len,
@@ -232,6 +256,7 @@ void sidecarExec(const struct sidecar *n, const u8 *buffer, size_t len,
         EXEC_CASE(64)
         EXEC_CASE(128)
         EXEC_CASE(256)
+        EXEC_CASE(512)
         EXEC_CASE(N)
         EXEC_CASE(S)
     default:
@@ -259,6 +284,9 @@ void sidecarEnabledInit(const struct sidecar *n,
     case SIDECAR_256:
         sidecarEnabledInit_256(enabled);
         break;
+    case SIDECAR_512:
+        sidecarEnabledInit_512(enabled);
+        break;
     case SIDECAR_N:
         sidecarEnabledInit_N(enabled);
         break;
@@ -289,6 +317,9 @@ u32 sidecarScratchSize(const struct sidecar *n) {
     case SIDECAR_256:
         width = sizeof(struct sidecar_mr_256);
         break;
+    case SIDECAR_512:
+        width = sizeof(struct sidecar_mr_512);
+        break;
     case SIDECAR_N:
         return 0; /* no scratch required for N */
     case SIDECAR_S:
@@ -337,6 +368,9 @@ void sidecarEnabledUnion(const struct sidecar *n, struct sidecar_enabled *dest,
     case SIDECAR_256:
         sidecarEnabledUnion_256(dest, src);
         break;
+    case SIDECAR_512:
+        sidecarEnabledUnion_512(dest, src);
+        break;
     case SIDECAR_N:
         sidecarEnabledUnion_N(dest, src);
         break;
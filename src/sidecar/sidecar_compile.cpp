@@ -96,6 +96,11 @@ void set_bit(m256 *a, size_t i) {
     setbit256(a, i);
 }
 
+static really_inline
+void set_bit(m512 *a, size_t i) {
+    setbit512(a, i);
+}
+
 template<typename s>
 static really_inline
 void flip(s *v) {
@@ -112,6 +117,11 @@ void flip(m256 *v) {
     *v = not256(*v);
 }
 
+static really_inline
+void flip(m512 *v) {
+    *v = not512(*v);
+}
+
 template<typename s>
 static really_inline
 void or_into_mask(s *a, const s b) {
@@ -128,6 +138,11 @@ void or_into_mask(m256 *a, const m256 b) {
     *a = or256(*a, b);
 }
 
+static really_inline
+void or_into_mask(m512 *a, const m512 b) {
+    *a = or512(*a, b);
+}
+
 template<u8 s_type> struct sidecar_traits { };
 #define MAKE_TRAITS(type_id, base_type_in, mask_bits) \
     template<> struct sidecar_traits<type_id> {       \
@@ -142,6 +157,7 @@ MAKE_TRAITS(SIDECAR_32,  u32,  32)
 MAKE_TRAITS(SIDECAR_64,  u64a, 64)
 MAKE_TRAITS(SIDECAR_128, m128, 128)
 MAKE_TRAITS(SIDECAR_256, m256, 256)
+MAKE_TRAITS(SIDECAR_512, m512, 512)
 
 template<> struct sidecar_traits<SIDECAR_N> {
     typedef sidecar_N impl_type;
@@ -423,6 +439,8 @@ constructWithHint(int hint, const vector<CharReach> &classes,
         return construct<SIDECAR_128>(classes, impl_classes, true);
     case SIDECAR_256:
         return construct<SIDECAR_256>(classes, impl_classes, true);
+    case SIDECAR_512:
+        return construct<SIDECAR_512>(classes, impl_classes, true);
     case SIDECAR_N:
         return construct<SIDECAR_N>(classes, impl_classes, true);
     case SIDECAR_S:
@@ -487,7 +505,8 @@ aligned_unique_ptr<sidecar> sidecarCompile(const vector<CharReach> &classes,
         construct<SIDECAR_32>,
         construct<SIDECAR_64>,
         construct<SIDECAR_128>,
-        construct<SIDECAR_256>
+        construct<SIDECAR_256>,
+        construct<SIDECAR_512>
     };
 
     for (u32 i = 0; i < ARRAY_LENGTH(facts); i++) {
@@ -523,6 +542,8 @@ u32 sidecarEnabledSize(const sidecar *n) {
         return sizeof(struct sidecar_enabled_128);
     case SIDECAR_256:
         return sizeof(struct sidecar_enabled_256);
+    case SIDECAR_512:
+        return sizeof(struct sidecar_enabled_512);
     case SIDECAR_N:
         return sizeof(struct sidecar_enabled_N);
     case SIDECAR_S:
@@ -586,6 +607,9 @@ void sidecarEnabledAdd(const sidecar *n, struct sidecar_enabled *enabled,
     case SIDECAR_256:
         sidecarEnabledAdd_int<SIDECAR_256>(n, enabled, id);
         break;
+    case SIDECAR_512:
+        sidecarEnabledAdd_int<SIDECAR_512>(n, enabled, id);
+        break;
     case SIDECAR_N:
         sidecarEnabledAdd_int<SIDECAR_N>(n, enabled, id);
         break;
@@ -79,6 +79,9 @@ void sidecarDump(const sidecar *s, FILE *f) {
     case SIDECAR_256:
         type = "256";
         break;
+    case SIDECAR_512:
+        type = "512";
+        break;
     case SIDECAR_N:
         type = "N";
         break;
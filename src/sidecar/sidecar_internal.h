@@ -38,6 +38,7 @@
 #define SIDECAR_256 4
 #define SIDECAR_N   5
 #define SIDECAR_S   6
+#define SIDECAR_512 7
 
 struct sidecar_id_offset {
     u32 first_offset; /* from base of sidecar */
@@ -80,6 +81,7 @@ SIDECAR_SPEC(32,  u32)
 SIDECAR_SPEC(64,  u64a)
 SIDECAR_SPEC(128, m128)
 SIDECAR_SPEC(256, m256)
+SIDECAR_SPEC(512, m512)
 
 struct sidecar_enabled {
     u8 null;
@@ -105,6 +107,10 @@ struct sidecar_enabled_256 {
     m256 bits;
 };
 
+struct sidecar_enabled_512 {
+    m512 bits;
+};
+
 struct sidecar_enabled_N {
     u8 bits;
 };
@@ -120,6 +126,7 @@ union sidecar_enabled_any {
     struct sidecar_enabled_64  e64;
     struct sidecar_enabled_128 e128;
     struct sidecar_enabled_256 e256;
+    struct sidecar_enabled_512 e512;
     struct sidecar_enabled_N eN;
     struct sidecar_enabled_S eS;
 };
@@ -87,8 +87,9 @@ m128 mainLoop(m128 mask_lo, m128 mask_hi, m128 chars, const m128 low4bits) {
     return t;
 }
 
-u8 sidecarExec_S_int(const struct sidecar_S *n, const u8 *b,
-                     size_t len, u8 state) {
+static really_inline
+u8 sidecarExec_S_int128(const struct sidecar_S *n, const u8 *b, size_t len,
+                        u8 state) {
     const m128 low4bits = _mm_set1_epi8(0xf);
     const u8 *b_end = b + len;
     m128 mask_lo = n->lo;
@@ -125,3 +126,69 @@ u8 sidecarExec_S_int(const struct sidecar_S *n, const u8 *b,
 
     return squash(t);
 }
+
+#if defined(__AVX2__)
+
+#define GET_LO_4_256(chars) and256(chars, low4bits)
+#define GET_HI_4_256(chars) rshift4x64(andnot256(low4bits, chars), 4)
+
+static really_inline
+u8 squash256(m256 t) {
+    return squash(and128(movdq_lo(t), movdq_hi(t)));
+}
+
+static really_inline
+m256 mainLoop256(m256 mask_lo, m256 mask_hi, m256 chars, const m256 low4bits) {
+    m256 c_lo  = vpshufb(mask_lo, GET_LO_4_256(chars));
+    m256 c_hi  = vpshufb(mask_hi, GET_HI_4_256(chars));
+    return or256(c_lo, c_hi);
+}
+
+/* As above, but 32 bytes at a time: the 16-byte shufti masks are duplicated
+ * into both lanes and the two lanes are folded together in squash256(). */
+u8 sidecarExec_S_int(const struct sidecar_S *n, const u8 *b,
+                     size_t len, u8 state) {
+    if (len < 32) {
+        return sidecarExec_S_int128(n, b, len, state);
+    }
+
+    const m256 low4bits = set32x8(0xf);
+    const u8 *b_end = b + len;
+    m256 mask_lo = set2x128(n->lo);
+    m256 mask_hi = set2x128(n->hi);
+
+    DEBUG_PRINTF("warmup %02hhx\n", state);
+    m256 chars = loadu256(b);
+    m256 t = set32x8(state);
+    t = and256(t, mainLoop256(mask_lo, mask_hi, chars, low4bits));
+    b = ROUNDUP_PTR(b + 1, 32);
+
+    DEBUG_PRINTF("main %02hhx\n", state);
+    const u8 *last_block = b_end - 32;
+    while (b < last_block) {
+        m256 lchars = load256(b);
+        m256 rv = mainLoop256(mask_lo, mask_hi, lchars, low4bits);
+        t = and256(t, rv);
+        b += 32;
+        if (!squash256(t)) {
+            return 0;
+        }
+    }
+
+    DEBUG_PRINTF("cool down %02hhx\n", state);
+    assert(b <= b_end && b >= b_end - 32);
+    chars = loadu256(b_end - 32);
+    m256 rv = mainLoop256(mask_lo, mask_hi, chars, low4bits);
+    t = and256(t, rv);
+
+    return squash256(t);
+}
+
+#else
+
+u8 sidecarExec_S_int(const struct sidecar_S *n, const u8 *b,
+                     size_t len, u8 state) {
+    return sidecarExec_S_int128(n, b, len, state);
+}
+
+#endif
@@ -74,12 +74,16 @@ public:
     void add(const ue2_literal &literal, ReportID r) override;
 
     bool determiniseLiterals();
+    bool addDfa(unique_ptr<raw_dfa> r);
 
     const ReportManager &rm;
     const CompileContext &cc;
 
-    unique_ptr<raw_dfa> rdfa;
+    /** \brief DFAs making up the engine; a new one is started whenever a
+     * merge into the last one would exceed DFA_MERGE_MAX_STATES. */
+    vector<unique_ptr<raw_dfa>> rdfas;
     vector<pair<ue2_literal, ReportID> > cand_literals;
+    u32 max_region; //!< largest buffer we may consider a small write
     bool poisoned;
 };
 
@@ -90,8 +94,43 @@ SmallWriteBuild::~SmallWriteBuild() { }
 SmallWriteBuildImpl::SmallWriteBuildImpl(const ReportManager &rm_in,
                                          const CompileContext &cc_in)
     : rm(rm_in), cc(cc_in),
+      max_region(max(cc.grey.smallWriteLargestBuffer,
+                     cc.grey.smallWriteLargestBufferAccel)),
       /* small write is block mode only */
-      poisoned(!cc.grey.allowSmallWrite || cc.streaming) {
+      poisoned(!cc.grey.allowSmallWrite || cc.streaming
+               || !cc.grey.smallWriteMaxDFAs) {
+}
+
+/**
+ * \brief Add a DFA to the engine, merging it into the most recent DFA if
+ * possible and starting a new one otherwise.
+ *
+ * Returns false if the DFA could not be merged and we already have as many
+ * DFAs as we are allowed.
+ */
+bool SmallWriteBuildImpl::addDfa(unique_ptr<raw_dfa> r) {
+    assert(r);
+
+    if (!rdfas.empty()) {
+        // do a merge of the new dfa with the most recent dfa
+        auto merged = mergeTwoDfas(rdfas.back().get(), r.get(),
+                                   DFA_MERGE_MAX_STATES, &rm, cc.grey);
+        if (merged) {
+            DEBUG_PRINTF("merge succeeded, built %p\n", merged.get());
+            rdfas.back() = move(merged);
+            return true;
+        }
+        DEBUG_PRINTF("merge failed\n");
+    }
+
+    if (rdfas.size() >= min(cc.grey.smallWriteMaxDFAs, (u32)SMWR_MAX_NFAS)) {
+        DEBUG_PRINTF("already have %zu dfas\n", rdfas.size());
+        return false;
+    }
+
+    DEBUG_PRINTF("starting dfa %zu\n", rdfas.size());
+    rdfas.push_back(move(r));
+    return true;
 }
 
 void SmallWriteBuildImpl::add(const NGWrapper &w) {
@@ -117,7 +156,7 @@ void SmallWriteBuildImpl::add(const NGWrapper &w) {
     // then we don't need to build a SmallWrite version.
     // However, we don't poison this case either, since it is simply a case,
     // where we know the resulting graph won't match.
-    if (findMinWidth(*h) > depth(cc.grey.smallWriteLargestBuffer)) {
+    if (findMinWidth(*h) > depth(max_region)) {
         return;
     }
 
@@ -133,21 +172,10 @@ void SmallWriteBuildImpl::add(const NGWrapper &w) {
         return;
     }
 
-    prune_overlong(*r, cc.grey.smallWriteLargestBuffer);
+    prune_overlong(*r, max_region);
 
-    if (rdfa) {
-        // do a merge of the new dfa with the existing dfa
-        auto merged = mergeTwoDfas(rdfa.get(), r.get(), DFA_MERGE_MAX_STATES,
-                                   &rm, cc.grey);
-        if (!merged) {
-            DEBUG_PRINTF("merge failed\n");
-            poisoned = true;
-            return;
-        }
-        DEBUG_PRINTF("merge succeeded, built %p\n", merged.get());
-        rdfa = move(merged);
-    } else {
-        rdfa = move(r);
+    if (!addDfa(move(r))) {
+        poisoned = true;
     }
 }
 
@@ -158,7 +186,7 @@ void SmallWriteBuildImpl::add(const ue2_literal &literal, ReportID r) {
         return;
     }
 
-    if (literal.length() > cc.grey.smallWriteLargestBuffer) {
+    if (literal.length() > max_region) {
         return; /* too long */
     }
 
@@ -204,58 +232,42 @@ bool SmallWriteBuildImpl::determiniseLiterals() {
         }
     }
 
-    if (!rdfa && temp_dfas.size() == 1) {
-        /* no need to merge there is only one dfa */
-        rdfa = move(temp_dfas[0]);
-        return true;
-    }
-
-    /* do a merge of the new dfas */
+    /* do a merge of the new dfas, a chunk at a time. Each merged chunk is
+     * then handed to addDfa(), which will start a new dfa if it cannot be
+     * merged with the current one. */
 
-    vector<const raw_dfa *> to_merge;
+    for (auto it = temp_dfas.begin(); it != temp_dfas.end();) {
+        auto chunk_end = it + min<size_t>(LITERAL_MERGE_CHUNK_SIZE,
+                                          distance(it, temp_dfas.end()));
 
-    if (rdfa) {/* also include the existing dfa */
-        to_merge.push_back(rdfa.get());
-    }
-
-    for (const auto &d : temp_dfas) {
-        to_merge.push_back(d.get());
-    }
-
-    assert(to_merge.size() > 1);
-
-    while (to_merge.size() > LITERAL_MERGE_CHUNK_SIZE) {
         vector<const raw_dfa *> small_merge;
-        small_merge.insert(small_merge.end(), to_merge.begin(),
-                           to_merge.begin() + LITERAL_MERGE_CHUNK_SIZE);
+        for (auto jt = it; jt != chunk_end; ++jt) {
+            small_merge.push_back(jt->get());
+        }
 
-        temp_dfas.push_back(
-            mergeAllDfas(small_merge, DFA_MERGE_MAX_STATES, &rm, cc.grey));
+        unique_ptr<raw_dfa> merged;
+        if (small_merge.size() == 1) {
+            merged = move(*it);
+        } else {
+            merged = mergeAllDfas(small_merge, DFA_MERGE_MAX_STATES, &rm,
+                                  cc.grey);
+        }
 
-        if (!temp_dfas.back()) {
+        if (!merged) {
             DEBUG_PRINTF("merge failed\n");
             poisoned = true;
             return false;
         }
 
-        to_merge.erase(to_merge.begin(),
-                       to_merge.begin() + LITERAL_MERGE_CHUNK_SIZE);
-        to_merge.push_back(temp_dfas.back().get());
-    }
-
-    auto merged = mergeAllDfas(to_merge, DFA_MERGE_MAX_STATES, &rm, cc.grey);
+        if (!addDfa(move(merged))) {
+            poisoned = true;
+            return false;
+        }
 
-    if (!merged) {
-        DEBUG_PRINTF("merge failed\n");
-        poisoned = true;
-        return false;
+        it = chunk_end;
     }
 
-    DEBUG_PRINTF("merge succeeded, built %p\n", merged.get());
-
-    // Replace our only DFA with the merged one
-    rdfa = move(merged);
-
+    DEBUG_PRINTF("literals placed, now have %zu dfas\n", rdfas.size());
     return true;
 }
 
@@ -301,51 +313,108 @@ bool is_slow(const raw_dfa &rdfa, const set<dstate_id_t> &accel,
     return true;
 }
 
+/**
+ * \brief Returns the largest small write region suitable for this DFA, based
+ * on how quickly it can get into acceleration.
+ *
+ * A DFA whose start state is itself accelerable will spend most of its time
+ * in acceleration, and so stays competitive with Rose over much longer
+ * buffers than one which is running at raw DFA speed.
+ *
+ * The default for such DFAs, Grey::smallWriteLargestBufferAccel (256), is not
+ * a measured crossover. It was picked to cover most of the 200-400 byte
+ * payloads that small writes are meant to serve, and it stays well below the
+ * point where Rose's fixed setup cost is no longer the dominant cost. It is
+ * a grey knob so that it can be tuned with hsbench against a real corpus. The
+ * region is chosen per DFA from its acceleration structure rather than by
+ * timing at compile time, as the compiler has no means of measuring scan
+ * speed.
+ */
 static
-aligned_unique_ptr<NFA> prepEngine(raw_dfa &rdfa, u32 roseQuality,
-                                   const CompileContext &cc, u32 *start_offset,
-                                   u32 *small_region) {
-    *start_offset = remove_leading_dots(rdfa);
+u32 chooseRegion(const raw_dfa &rdfa, const set<dstate_id_t> &accel,
+                 u32 roseQuality, const Grey &grey) {
+    if (is_slow(rdfa, accel, roseQuality)) {
+        return grey.smallWriteLargestBufferBad;
+    }
 
-    // Unleash the McClellan!
-    set<dstate_id_t> accel_states;
+    if (contains(accel, rdfa.start_anchored)) {
+        return max(grey.smallWriteLargestBuffer,
+                   grey.smallWriteLargestBufferAccel);
+    }
+
+    return grey.smallWriteLargestBuffer;
+}
+
+static
+aligned_unique_ptr<NFA> prepEngine(raw_dfa &rdfa, u32 start_offset,
+                                   u32 small_region, const CompileContext &cc) {
+    assert(small_region > start_offset);
+    prune_overlong(rdfa, small_region - start_offset);
+    if (rdfa.start_anchored == DEAD_STATE) {
+        DEBUG_PRINTF("all patterns pruned out\n");
+        return nullptr;
+    }
 
-    auto nfa = mcclellanCompile(rdfa, cc, &accel_states);
+    // Unleash the McClellan!
+    auto nfa = mcclellanCompile(rdfa, cc);
     if (!nfa) {
         DEBUG_PRINTF("mcclellan compile failed for smallwrite NFA\n");
         return nullptr;
     }
 
-    if (is_slow(rdfa, accel_states, roseQuality)) {
-        *small_region = cc.grey.smallWriteLargestBufferBad;
-        if (*small_region <= *start_offset) {
-            return nullptr;
+    assert(isMcClellanType(nfa->type));
+    nfa->queueIndex = 0; /* dummy, small write API does not use queue */
+    return nfa;
+}
+
+/**
+ * \brief Compile all our DFAs for the given small write region.
+ *
+ * DFAs which can never match in a buffer of that size are dropped. Returns
+ * false if any DFA could not be compiled or if the engine would be too large.
+ */
+static
+bool prepEngines(vector<unique_ptr<raw_dfa>> &rdfas,
+                 const vector<u32> &start_offsets, u32 small_region,
+                 const CompileContext &cc,
+                 vector<pair<aligned_unique_ptr<NFA>, u32>> *out) {
+    out->clear();
+
+    size_t total_size = 0;
+    for (size_t i = 0; i < rdfas.size(); i++) {
+        if (small_region <= start_offsets[i]) {
+            DEBUG_PRINTF("dfa %zu cannot match in %u bytes\n", i,
+                         small_region);
+            continue;
         }
-        prune_overlong(rdfa, *small_region - *start_offset);
-        if (rdfa.start_anchored == DEAD_STATE) {
-            DEBUG_PRINTF("all patterns pruned out\n");
-            return nullptr;
+
+        if (rdfas[i]->start_anchored == DEAD_STATE) {
+            continue;
         }
 
-        nfa = mcclellanCompile(rdfa, cc, &accel_states);
+        auto nfa = prepEngine(*rdfas[i], start_offsets[i], small_region, cc);
         if (!nfa) {
-            DEBUG_PRINTF("mcclellan compile failed for smallwrite NFA\n");
-            assert(0); /* we were able to build orig dfa but not the trimmed? */
-            return nullptr;
+            if (rdfas[i]->start_anchored == DEAD_STATE) {
+                continue;
+            }
+            return false;
         }
-    } else {
-        *small_region = cc.grey.smallWriteLargestBuffer;
-    }
 
-    assert(isMcClellanType(nfa->type));
-    if (nfa->length > cc.grey.limitSmallWriteOutfixSize
-        || nfa->length > cc.grey.limitDFASize) {
-        DEBUG_PRINTF("smallwrite outfix size too large\n");
-        return nullptr; /* this is just a soft failure - don't build smwr */
+        if (nfa->length > cc.grey.limitDFASize) {
+            DEBUG_PRINTF("smallwrite dfa too large\n");
+            return false;
+        }
+
+        total_size += nfa->length;
+        if (total_size > cc.grey.limitSmallWriteOutfixSize) {
+            DEBUG_PRINTF("smallwrite outfix size too large\n");
+            return false;
+        }
+
+        out->push_back(make_pair(move(nfa), start_offsets[i]));
     }
 
-    nfa->queueIndex = 0; /* dummy, small write API does not use queue */
-    return nfa;
+    return true;
 }
 
 // SmallWriteBuild factory
@@ -356,7 +425,7 @@ unique_ptr<SmallWriteBuild> makeSmallWriteBuilder(const ReportManager &rm,
 
 aligned_unique_ptr<SmallWriteEngine>
 SmallWriteBuildImpl::build(u32 roseQuality) {
-    if (!rdfa && cand_literals.empty()) {
+    if (rdfas.empty() && cand_literals.empty()) {
         DEBUG_PRINTF("no smallwrite engine\n");
         poisoned = true;
         return nullptr;
@@ -372,30 +441,79 @@ SmallWriteBuildImpl::build(u32 roseQuality) {
         return nullptr;
     }
 
-    DEBUG_PRINTF("building rdfa %p\n", rdfa.get());
+    DEBUG_PRINTF("building %zu rdfas\n", rdfas.size());
+    assert(!rdfas.empty());
+    assert(rdfas.size() <= SMWR_MAX_NFAS);
 
-    u32 start_offset;
-    u32 small_region;
-    auto nfa = prepEngine(*rdfa, roseQuality, cc, &start_offset, &small_region);
-    if (!nfa) {
-        DEBUG_PRINTF("some smallwrite outfix could not be prepped\n");
-        /* just skip the smallwrite optimization */
+    /* The small write region is shared by the whole engine, so it is set by
+     * the DFA which is least suited to scanning long buffers. */
+    vector<u32> start_offsets;
+    u32 small_region = max_region;
+    for (auto &rdfa : rdfas) {
+        start_offsets.push_back(remove_leading_dots(*rdfa));
+
+        set<dstate_id_t> accel_states;
+        auto nfa = mcclellanCompile(*rdfa, cc, &accel_states);
+        if (!nfa) {
+            DEBUG_PRINTF("mcclellan compile failed for smallwrite NFA\n");
+            poisoned = true;
+            return nullptr;
+        }
+
+        small_region = min(small_region,
+                           chooseRegion(*rdfa, accel_states, roseQuality,
+                                        cc.grey));
+    }
+
+    vector<pair<aligned_unique_ptr<NFA>, u32>> nfas;
+    if (!prepEngines(rdfas, start_offsets, small_region, cc, &nfas)) {
+        if (small_region <= cc.grey.smallWriteLargestBufferBad) {
+            DEBUG_PRINTF("some smallwrite outfix could not be prepped\n");
+            /* just skip the smallwrite optimization */
+            poisoned = true;
+            return nullptr;
+        }
+
+        /* retry with a smaller region, which will result in smaller dfas */
+        small_region = cc.grey.smallWriteLargestBufferBad;
+        if (!prepEngines(rdfas, start_offsets, small_region, cc, &nfas)) {
+            DEBUG_PRINTF("some smallwrite outfix could not be prepped\n");
+            poisoned = true;
+            return nullptr;
+        }
+    }
+
+    if (nfas.empty()) {
+        DEBUG_PRINTF("all patterns pruned out\n");
         poisoned = true;
         return nullptr;
     }
 
-    u32 size = sizeof(SmallWriteEngine) + nfa->length;
+    u32 size = sizeof(SmallWriteEngine);
+    for (const auto &m : nfas) {
+        size = ROUNDUP_CL(size) + m.first->length;
+    }
+
     auto smwr = aligned_zmalloc_unique<SmallWriteEngine>(size);
 
     smwr->size = size;
-    smwr->start_offset = start_offset;
     smwr->largestBuffer = small_region;
+    smwr->nfaCount = verify_u32(nfas.size());
+
+    /* copy in nfas after the smwr */
+    u32 curr = sizeof(SmallWriteEngine);
+    for (u32 i = 0; i < smwr->nfaCount; i++) {
+        const NFA *nfa = nfas[i].first.get();
+        curr = ROUNDUP_CL(curr);
+        smwr->nfaOffset[i] = curr;
+        smwr->start_offset[i] = nfas[i].second;
+        memcpy((char *)smwr.get() + curr, nfa, nfa->length);
+        curr += nfa->length;
+    }
+    assert(curr == size);
 
-    /* copy in nfa after the smwr */
-    assert(ISALIGNED_CL(smwr.get() + 1));
-    memcpy(smwr.get() + 1, nfa.get(), nfa->length);
-
-    DEBUG_PRINTF("smallwrite done %p\n", smwr.get());
+    DEBUG_PRINTF("smallwrite done %p, %u dfas, region %u\n", smwr.get(),
+                 smwr->nfaCount, small_region);
     return smwr;
 }
 
@@ -52,14 +52,17 @@ void smwrDumpText(const SmallWriteEngine *smwr, FILE *f) {
         return;
     }
 
-    const struct NFA *n = getSmwrNfa(smwr);
-
     fprintf(f, "SmallWrite:\n\n");
-    fprintf(f, "%s\n", describe(*n).c_str());
-    fprintf(f, "States: %u\n", n->nPositions);
-    fprintf(f, "Length: %u\n", n->length);
     fprintf(f, "Largest Short Buffer: %u\n", smwr->largestBuffer);
-    fprintf(f, "Start Offset: %u\n", smwr->start_offset);
+    fprintf(f, "DFAs: %u\n", smwr->nfaCount);
+
+    for (u32 i = 0; i < smwr->nfaCount; i++) {
+        const struct NFA *n = getSmwrNfa(smwr, i);
+        fprintf(f, "\nDFA %u: %s\n", i, describe(*n).c_str());
+        fprintf(f, "States: %u\n", n->nPositions);
+        fprintf(f, "Length: %u\n", n->length);
+        fprintf(f, "Start Offset: %u\n", smwr->start_offset[i]);
+    }
 }
 
 void smwrDumpNFA(const SmallWriteEngine *smwr, bool dump_raw,
@@ -69,21 +72,29 @@ void smwrDumpNFA(const SmallWriteEngine *smwr, bool dump_raw,
         return;
     }
 
-    const struct NFA *n = getSmwrNfa(smwr);
-    FILE *f;
+    for (u32 i = 0; i < smwr->nfaCount; i++) {
+        const struct NFA *n = getSmwrNfa(smwr, i);
+        FILE *f;
 
-    f = fopen((base + "smallwrite_nfa.dot").c_str(), "w");
-    nfaDumpDot(n, f);
-    fclose(f);
+        /* the first dfa keeps its historical file names */
+        string name = base + "smallwrite_nfa";
+        if (i) {
+            name += "_" + to_string(i);
+        }
 
-    f = fopen((base + "smallwrite_nfa.txt").c_str(), "w");
-    nfaDumpText(n, f);
-    fclose(f);
+        f = fopen((name + ".dot").c_str(), "w");
+        nfaDumpDot(n, f);
+        fclose(f);
 
-    if (dump_raw) {
-        f = fopen((base + "smallwrite_nfa.raw").c_str(), "w");
-        fwrite(n, 1, n->length, f);
+        f = fopen((name + ".txt").c_str(), "w");
+        nfaDumpText(n, f);
         fclose(f);
+
+        if (dump_raw) {
+            f = fopen((name + ".raw").c_str(), "w");
+            fwrite(n, 1, n->length, f);
+            fclose(f);
+        }
     }
 }
 
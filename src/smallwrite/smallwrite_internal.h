@@ -31,20 +31,43 @@
 
 #include "ue2common.h"
 
+/** \brief Maximum number of DFAs that a SmallWrite engine may be split
+ * into. */
+#define SMWR_MAX_NFAS 4
+
+/** \brief Capacity of the scratch buffer used to order matches when the
+ * SmallWrite engine contains more than one DFA. */
+#define SMWR_MATCH_BUF_SIZE 256
+
 // Runtime structure header for SmallWrite.
 struct ALIGN_CL_DIRECTIVE SmallWriteEngine {
     u32 largestBuffer; /**< largest buffer that can be considered small write */
-    u32 start_offset; /**< where to start scanning in the buffer. */
     u32 size; /**< size of the small write engine in bytes (including the nfa) */
+    u32 nfaCount; /**< number of DFAs, between 1 and SMWR_MAX_NFAS */
+
+    /** \brief where to start scanning in the buffer, per DFA. */
+    u32 start_offset[SMWR_MAX_NFAS];
+
+    /** \brief offset of each DFA, relative to the start of this structure. */
+    u32 nfaOffset[SMWR_MAX_NFAS];
+};
+
+/** \brief A match recorded by a multi-DFA SmallWrite engine before it is
+ * delivered in offset order. */
+struct smwr_match {
+    u64a offset;
+    ReportID id;
 };
 
 struct NFA;
 
 static really_inline
-const struct NFA *getSmwrNfa(const struct SmallWriteEngine *smwr) {
+const struct NFA *getSmwrNfa(const struct SmallWriteEngine *smwr, u32 i) {
     assert(smwr);
+    assert(i < smwr->nfaCount);
+    assert(smwr->nfaOffset[i]);
     const struct NFA *n
-        = (const struct NFA *)((const char *)smwr + sizeof(*smwr));
+        = (const struct NFA *)((const char *)smwr + smwr->nfaOffset[i]);
     assert(ISALIGNED_CL(n));
     return n;
 }
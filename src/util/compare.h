@@ -166,6 +166,35 @@ int cmpForward(const u8 *p1, const u8 *p2, size_t len, char nocase) {
     return 0;
 }
 
+/** \brief Compares \a len bytes at \a p1 against \a p2 after masking with
+ * \a msk, byte by byte; returns 1 on mismatch, like \ref cmpForward. */
+static really_inline
+int cmpForwardMasked(const u8 *p1, const u8 *p2, const u8 *msk, size_t len) {
+    if (len < CMP_SIZE) {
+        for (const u8 *pEnd = p1 + len; p1 < pEnd; p1++, p2++, msk++) {
+            if ((*p1 & *msk) != *p2) {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    const u8 *p1_end = p1 + len - CMP_SIZE;
+    const u8 *p2_end = p2 + len - CMP_SIZE;
+    const u8 *msk_end = msk + len - CMP_SIZE;
+
+    for (; p1 < p1_end; p1 += CMP_SIZE, p2 += CMP_SIZE, msk += CMP_SIZE) {
+        if ((ULOAD(p1) & ULOAD(msk)) != ULOAD(p2)) {
+            return 1;
+        }
+    }
+    if ((ULOAD(p1_end) & ULOAD(msk_end)) != ULOAD(p2_end)) {
+        return 1;
+    }
+
+    return 0;
+}
+
 #undef CMP_T
 #undef ULOAD
 #undef TOUPPER
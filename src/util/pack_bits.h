@@ -34,6 +34,7 @@
 #define UTIL_PACK_BITS_H
 
 #include "ue2common.h"
+#include "bitutils.h"
 #include "unaligned.h"
 #include "partial_store.h"
 
@@ -87,6 +88,21 @@ static really_inline
 void unpack_bits_64(u64a *v, const u8 *in, const u32 *bits,
                     const unsigned int elements);
 
+/**
+ * \brief Unpack bits into an array of 64-bit words, given the bit offset in
+ * \a in of each element as well as its length.
+ *
+ * \param v Output array.
+ * \param in Packed input array.
+ * \param bits Number of bits to unpack into the corresponding element of \a v.
+ * \param offsets Bit offset in \a in of the corresponding element of \a v.
+ * These must be increasing, with each element packed directly after the last.
+ * \param elements Size of the \a v, \a bits and \a offsets arrays.
+ */
+static really_inline
+void unpack_bits_64_at(u64a *v, const u8 *in, const u8 *bits,
+                       const u16 *offsets, const unsigned int elements);
+
 /*
  * Inline implementations follow.
  */
@@ -186,41 +202,76 @@ void unpack_bits_32(u32 *v, const u8 *in, const u32 *bits,
     }
 }
 
+/** \brief Returns the low \a n bits of \a x, for n <= 64. */
+static really_inline
+u64a low_bits_64(u64a x, u32 n) {
+    assert(n <= 64);
+#if defined(ARCH_X86_64) && defined(__BMI2__)
+    // BMI2 has a single instruction for this operation.
+    return _bzhi_u64(x, n);
+#else
+    return n == 64 ? x : x & ((1ULL << n) - 1);
+#endif
+}
+
+/**
+ * \brief Reads \a b bits starting at bit \a idx of \a in, which is \a len
+ * bytes long.
+ *
+ * We read a whole (unaligned) 64-bit word rather than assembling it a byte at
+ * a time, taking care not to read past the end of the packed region.
+ */
+static really_inline
+u64a unpack_bits_64_one(const u8 *in, u32 len, u32 idx, u32 b) {
+    assert(b <= 64);
+    if (!b) {
+        return 0;
+    }
+
+    u32 byte = idx / 8;
+    u32 shift = idx % 8;
+    u32 avail = len - byte;
+    assert(avail > 0);
+
+    u64a word = avail >= 8 ? unaligned_load_u64a(in + byte)
+                           : partial_load_u64a(in + byte, avail);
+    word >>= shift;
+    if (shift + b > 64) {
+        // The last few bits of this element live in a ninth byte.
+        assert(avail > 8);
+        word |= (u64a)in[byte + 8] << (64 - shift);
+    }
+
+    return low_bits_64(word, b);
+}
+
 static really_inline
 void unpack_bits_64(u64a *v, const u8 *in, const u32 *bits,
                     const unsigned int elements) {
-    u32 used = 0; // bits used from *in
-
+    u32 total = 0;
     for (unsigned int i = 0; i < elements; i++) {
         assert(bits[i] <= 64);
-        u64a v_out = 0;  // accumulator for v[i]
-        u32 b = bits[i]; // bits left to read for v[i]
-        u32 vidx = 0;    // bits written to v[i]
-
-        while (b) {
-            u64a read = *in >> used;
-            u32 bits_read = 8 - used;
+        total += bits[i];
+    }
+    const u32 len = (total + 7) / 8;
 
-            if (b <= bits_read) {
-                u64a mask = read & ((1U << b) - 1);
-                v_out |= mask << vidx;
-                vidx += b;
-                used += b;
-                b = 0;
-                if (used < 8) {
-                    continue; // more from this *in
-                }
-            } else {
-                v_out |= read << vidx;
-                vidx += bits_read;
-                b -= bits_read;
-            }
+    u32 idx = 0; // bits consumed from *in
+    for (unsigned int i = 0; i < elements; i++) {
+        v[i] = unpack_bits_64_one(in, len, idx, bits[i]);
+        idx += bits[i];
+    }
+}
 
-            used = 0;
-            in++;
-        }
+static really_inline
+void unpack_bits_64_at(u64a *v, const u8 *in, const u8 *bits,
+                       const u16 *offsets, const unsigned int elements) {
+    assert(elements);
+    const u32 len = (offsets[elements - 1] + bits[elements - 1] + 7) / 8;
 
-        v[i] = v_out;
+    // Each element's position is known, so there is no dependency from one
+    // element to the next.
+    for (unsigned int i = 0; i < elements; i++) {
+        v[i] = unpack_bits_64_one(in, len, offsets[i], bits[i]);
     }
 }
 
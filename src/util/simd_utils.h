@@ -157,6 +157,7 @@ static really_inline unsigned short cmpmsk8(m128 a, m128 b) {
 
 #define shift2x64(a, b)  _mm_slli_epi64((a), (b))
 #define rshift2x64(a, b) _mm_srli_epi64((a), (b))
+#define add2x64(a, b)    _mm_add_epi64((a), (b))
 #define eq128(a, b)      _mm_cmpeq_epi8((a), (b))
 #define movemask128(a)  ((u32)_mm_movemask_epi8((a)))
 
@@ -176,6 +177,14 @@ static really_inline m128 set16x8(u8 c) {
 #endif
 }
 
+static really_inline m128 set4x32(u32 c) {
+    return _mm_set1_epi32((int)c);
+}
+
+static really_inline m128 set2x64(u64a c) {
+    return _mm_set1_epi64x((long long)c);
+}
+
 static really_inline u32 movd(const m128 in) {
     return _mm_cvtsi128_si32(in);
 }
@@ -234,6 +243,30 @@ static really_inline m128 andnot128(m128 a, m128 b) {
 // Intel SIMD.
 #define shift128(a, b)  _mm_slli_epi64((a), (b))
 
+/** \brief Shift the whole 128-bit value left by a variable number of bits,
+ * which must be less than 128. */
+static really_inline m128 lshift128_var(m128 a, unsigned b) {
+    assert(b < 128);
+    m128 lo_to_hi = _mm_slli_si128(a, 8);
+    if (b >= 64) {
+        return _mm_sll_epi64(lo_to_hi, _mm_cvtsi32_si128(b - 64));
+    }
+    m128 carry = _mm_srl_epi64(lo_to_hi, _mm_cvtsi32_si128(64 - b));
+    return or128(_mm_sll_epi64(a, _mm_cvtsi32_si128(b)), carry);
+}
+
+/** \brief Shift the whole 128-bit value right by a variable number of bits,
+ * which must be less than 128. */
+static really_inline m128 rshift128_var(m128 a, unsigned b) {
+    assert(b < 128);
+    m128 hi_to_lo = _mm_srli_si128(a, 8);
+    if (b >= 64) {
+        return _mm_srl_epi64(hi_to_lo, _mm_cvtsi32_si128(b - 64));
+    }
+    m128 carry = _mm_sll_epi64(hi_to_lo, _mm_cvtsi32_si128(64 - b));
+    return or128(_mm_srl_epi64(a, _mm_cvtsi32_si128(b)), carry);
+}
+
 // aligned load
 static really_inline m128 load128(const void *ptr) {
     assert(ISALIGNED_N(ptr, alignof(m128)));
@@ -602,3 +602,132 @@ void loadcompressed512(m512 *x, const void *ptr, const m512 *m,
     *x = loadcompressed512_32bit(ptr, *m);
 #endif
 }
+
+/*
+ * 128- to 512-bit store/load with a precomputed mask layout.
+ */
+
+#if defined(ARCH_64_BIT)
+static really_inline
+void storecompressed_chunks_64bit(void *ptr, const void *xvec,
+                                  const void *mvec,
+                                  const struct compress_chunks *c,
+                                  const u32 chunks) {
+    assert(chunks <= 8);
+
+    // First, decompose our vectors into 64-bit chunks.
+    u64a x[8];
+    memcpy(x, xvec, chunks * sizeof(u64a));
+    u64a m[8];
+    memcpy(m, mvec, chunks * sizeof(u64a));
+
+    // Compress each 64-bit chunk individually. The bit counts were computed
+    // at compile time.
+    u64a v[8];
+    u32 bits[8];
+    for (u32 i = 0; i < chunks; i++) {
+        assert(c->bits[i] == popcount64(m[i]));
+        v[i] = compress64(x[i], m[i]);
+        bits[i] = c->bits[i];
+    }
+
+    // Write packed data out.
+    pack_bits_64(ptr, v, bits, chunks);
+}
+
+static really_inline
+void loadcompressed_chunks_64bit(void *xvec, const void *ptr,
+                                 const void *mvec,
+                                 const struct compress_chunks *c,
+                                 const u32 chunks) {
+    assert(chunks <= 8);
+
+    u64a m[8];
+    memcpy(m, mvec, chunks * sizeof(u64a));
+
+    // Each chunk's offset in the packed data is known, so the chunks can be
+    // unpacked independently.
+    u64a v[8];
+    unpack_bits_64_at(v, (const u8 *)ptr, c->bits, c->offset, chunks);
+
+    u64a x[8];
+    for (u32 i = 0; i < chunks; i++) {
+        assert(c->bits[i] == popcount64(m[i]));
+        x[i] = expand64(v[i], m[i]);
+    }
+
+    memcpy(xvec, x, chunks * sizeof(u64a));
+}
+#endif
+
+void storecompressed128_chunks(void *ptr, const m128 *x, const m128 *m,
+                               UNUSED const struct compress_chunks *c) {
+#if defined(ARCH_64_BIT)
+    storecompressed_chunks_64bit(ptr, x, m, c, 2);
+#else
+    storecompressed128_32bit(ptr, *x, *m);
+#endif
+}
+
+void loadcompressed128_chunks(m128 *x, const void *ptr, const m128 *m,
+                              UNUSED const struct compress_chunks *c) {
+#if defined(ARCH_64_BIT)
+    loadcompressed_chunks_64bit(x, ptr, m, c, 2);
+#else
+    *x = loadcompressed128_32bit(ptr, *m);
+#endif
+}
+
+void storecompressed256_chunks(void *ptr, const m256 *x, const m256 *m,
+                               UNUSED const struct compress_chunks *c) {
+#if defined(ARCH_64_BIT)
+    storecompressed_chunks_64bit(ptr, x, m, c, 4);
+#else
+    storecompressed256_32bit(ptr, *x, *m);
+#endif
+}
+
+void loadcompressed256_chunks(m256 *x, const void *ptr, const m256 *m,
+                              UNUSED const struct compress_chunks *c) {
+#if defined(ARCH_64_BIT)
+    loadcompressed_chunks_64bit(x, ptr, m, c, 4);
+#else
+    *x = loadcompressed256_32bit(ptr, *m);
+#endif
+}
+
+void storecompressed384_chunks(void *ptr, const m384 *x, const m384 *m,
+                               UNUSED const struct compress_chunks *c) {
+#if defined(ARCH_64_BIT)
+    storecompressed_chunks_64bit(ptr, x, m, c, 6);
+#else
+    storecompressed384_32bit(ptr, *x, *m);
+#endif
+}
+
+void loadcompressed384_chunks(m384 *x, const void *ptr, const m384 *m,
+                              UNUSED const struct compress_chunks *c) {
+#if defined(ARCH_64_BIT)
+    loadcompressed_chunks_64bit(x, ptr, m, c, 6);
+#else
+    *x = loadcompressed384_32bit(ptr, *m);
+#endif
+}
+
+void storecompressed512_chunks(void *ptr, const m512 *x, const m512 *m,
+                               UNUSED const struct compress_chunks *c) {
+#if defined(ARCH_64_BIT)
+    storecompressed_chunks_64bit(ptr, x, m, c, 8);
+#else
+    storecompressed512_32bit(ptr, *x, *m);
+#endif
+}
+
+void loadcompressed512_chunks(m512 *x, const void *ptr, const m512 *m,
+                              UNUSED const struct compress_chunks *c) {
+#if defined(ARCH_64_BIT)
+    loadcompressed_chunks_64bit(x, ptr, m, c, 8);
+#else
+    *x = loadcompressed512_32bit(ptr, *m);
+#endif
+}
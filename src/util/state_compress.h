@@ -61,6 +61,42 @@ void loadcompressed384(m384 *x, const void *ptr, const m384 *m, u32 bytes);
 void storecompressed512(void *ptr, const m512 *x, const m512 *m, u32 bytes);
 void loadcompressed512(m512 *x, const void *ptr, const m512 *m, u32 bytes);
 
+/**
+ * \brief Layout of state compressed under one 128- to 512-bit mask.
+ *
+ * For each 64-bit chunk of the mask, the number of bits it keeps and the bit
+ * offset at which those bits are packed. Engines compute these at compile
+ * time for each mask they use, so that the runtime does not have to count
+ * bits in the mask on every store and load.
+ */
+struct compress_chunks {
+    u8 bits[8];
+    u16 offset[8];
+};
+
+/* As storecompressedN/loadcompressedN, with the layout of the mask \a m
+ * given by \a c. */
+
+void storecompressed128_chunks(void *ptr, const m128 *x, const m128 *m,
+                               const struct compress_chunks *c);
+void loadcompressed128_chunks(m128 *x, const void *ptr, const m128 *m,
+                              const struct compress_chunks *c);
+
+void storecompressed256_chunks(void *ptr, const m256 *x, const m256 *m,
+                               const struct compress_chunks *c);
+void loadcompressed256_chunks(m256 *x, const void *ptr, const m256 *m,
+                              const struct compress_chunks *c);
+
+void storecompressed384_chunks(void *ptr, const m384 *x, const m384 *m,
+                               const struct compress_chunks *c);
+void loadcompressed384_chunks(m384 *x, const void *ptr, const m384 *m,
+                              const struct compress_chunks *c);
+
+void storecompressed512_chunks(void *ptr, const m512 *x, const m512 *m,
+                               const struct compress_chunks *c);
+void loadcompressed512_chunks(m512 *x, const void *ptr, const m512 *m,
+                              const struct compress_chunks *c);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Output sinks for the benchmark corpus generator.
+ */
+
+#include "config.h"
+
+#include "corpus_writer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <arpa/inet.h>
+
+using namespace std;
+
+CorpusWriter::~CorpusWriter() {}
+
+namespace {
+
+static const size_t OUTPUT_BUFFER_SIZE = 1 << 22;
+
+/** Thin wrapper around a stdio stream with a large buffer. */
+class OutputFile {
+public:
+    explicit OutputFile(const string &path)
+        : f(fopen(path.c_str(), "wb")), buf(OUTPUT_BUFFER_SIZE) {
+        if (!f) {
+            throw runtime_error("Unable to open output file " + path);
+        }
+        setvbuf(f, buf.data(), _IOFBF, buf.size());
+    }
+
+    ~OutputFile() {
+        if (f) {
+            fclose(f);
+        }
+    }
+
+    void write(const void *data, size_t len) {
+        if (len && fwrite(data, 1, len, f) != len) {
+            throw runtime_error("Write to output file failed");
+        }
+    }
+
+    void close() {
+        int rv = fclose(f);
+        f = nullptr;
+        if (rv) {
+            throw runtime_error("Unable to close output file");
+        }
+    }
+
+private:
+    FILE *f;
+    vector<char> buf;
+};
+
+class RawWriter : public CorpusWriter {
+public:
+    explicit RawWriter(const string &path) : out(path) {}
+
+    void writePacket(const string &payload, u32) override {
+        out.write(payload.data(), payload.size());
+    }
+
+    void close() override { out.close(); }
+
+private:
+    OutputFile out;
+};
+
+// pcap file format, see pcap-savefile(5). Headers are written in host byte
+// order, which readers detect from the magic number.
+struct PcapFileHeader {
+    u32 magic;
+    u16 version_major;
+    u16 version_minor;
+    s32 thiszone;
+    u32 sigfigs;
+    u32 snaplen;
+    u32 linktype;
+};
+
+struct PcapRecordHeader {
+    u32 ts_sec;
+    u32 ts_usec;
+    u32 incl_len;
+    u32 orig_len;
+};
+
+static const u32 PCAP_MAGIC = 0xa1b2c3d4;
+static const u32 LINKTYPE_ETHERNET = 1;
+static const size_t ETH_LEN = 14;
+static const size_t IP_LEN = 20;
+static const size_t UDP_LEN = 8;
+static const size_t HEADERS_LEN = ETH_LEN + IP_LEN + UDP_LEN;
+
+static
+u16 ipChecksum(const u8 *hdr, size_t len) {
+    u32 sum = 0;
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        sum += (u32)hdr[i] << 8 | hdr[i + 1];
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return (u16)~sum;
+}
+
+class PcapWriter : public CorpusWriter {
+public:
+    explicit PcapWriter(const string &path) : out(path), usec(0) {
+        PcapFileHeader hdr;
+        hdr.magic = PCAP_MAGIC;
+        hdr.version_major = 2;
+        hdr.version_minor = 4;
+        hdr.thiszone = 0;
+        hdr.sigfigs = 0;
+        hdr.snaplen = 65535 + ETH_LEN;
+        hdr.linktype = LINKTYPE_ETHERNET;
+        out.write(&hdr, sizeof(hdr));
+    }
+
+    void writePacket(const string &payload, u32 flow) override {
+        if (payload.size() > CORPUS_MAX_PCAP_PAYLOAD) {
+            throw runtime_error("Payload too large for a pcap packet");
+        }
+
+        PcapRecordHeader rec;
+        rec.ts_sec = (u32)(usec / 1000000);
+        rec.ts_usec = (u32)(usec % 1000000);
+        rec.incl_len = rec.orig_len = (u32)(HEADERS_LEN + payload.size());
+        usec++;
+
+        u8 hdr[HEADERS_LEN];
+        memset(hdr, 0, sizeof(hdr));
+
+        // Ethernet: locally administered MACs, IPv4 ethertype.
+        u8 *eth = hdr;
+        eth[0] = 0x02;
+        eth[5] = 0x01;
+        eth[6] = 0x02;
+        eth[11] = 0x02;
+        eth[12] = 0x08;
+        eth[13] = 0x00;
+
+        // IPv4, 10.0.0.1 -> 10.0.0.2, UDP.
+        u8 *ip = hdr + ETH_LEN;
+        u16 ip_len = htons((u16)(IP_LEN + UDP_LEN + payload.size()));
+        ip[0] = 0x45;
+        memcpy(ip + 2, &ip_len, sizeof(ip_len));
+        ip[8] = 64; // ttl
+        ip[9] = 17; // UDP
+        u32 src = htonl(0x0a000001), dst = htonl(0x0a000002);
+        memcpy(ip + 12, &src, sizeof(src));
+        memcpy(ip + 16, &dst, sizeof(dst));
+        u16 csum = htons(ipChecksum(ip, IP_LEN));
+        memcpy(ip + 10, &csum, sizeof(csum));
+
+        // UDP: the flow index selects the source port, checksum omitted.
+        u8 *udp = ip + IP_LEN;
+        u16 sport = htons((u16)(1024 + flow % 64000));
+        u16 dport = htons(80);
+        u16 udp_len = htons((u16)(UDP_LEN + payload.size()));
+        memcpy(udp, &sport, sizeof(sport));
+        memcpy(udp + 2, &dport, sizeof(dport));
+        memcpy(udp + 4, &udp_len, sizeof(udp_len));
+
+        out.write(&rec, sizeof(rec));
+        out.write(hdr, sizeof(hdr));
+        out.write(payload.data(), payload.size());
+    }
+
+    void close() override { out.close(); }
+
+private:
+    OutputFile out;
+    u64a usec; //!< synthetic timestamp, one microsecond per packet
+};
+
+} // namespace
+
+unique_ptr<CorpusWriter> makeRawWriter(const string &path) {
+    return unique_ptr<CorpusWriter>(new RawWriter(path));
+}
+
+unique_ptr<CorpusWriter> makePcapWriter(const string &path) {
+    return unique_ptr<CorpusWriter>(new PcapWriter(path));
+}
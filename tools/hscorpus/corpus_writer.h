@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Output sinks for the benchmark corpus generator.
+ *
+ * Packets are written as they are produced so that corpora much larger than
+ * memory can be generated.
+ */
+
+#ifndef CORPUS_WRITER_H
+#define CORPUS_WRITER_H
+
+#include "ue2common.h"
+
+#include <memory>
+#include <string>
+
+/** \brief Abstract sink for generated packets. */
+class CorpusWriter {
+public:
+    virtual ~CorpusWriter();
+
+    /** \brief Append one packet payload, belonging to stream \a flow. */
+    virtual void writePacket(const std::string &payload, u32 flow) = 0;
+
+    /** \brief Flush and close the output; throws on I/O failure. */
+    virtual void close() = 0;
+};
+
+/** \brief Writes payloads back to back with no framing. */
+std::unique_ptr<CorpusWriter> makeRawWriter(const std::string &path);
+
+/** \brief Writes an Ethernet/IPv4/UDP pcap file, one flow per UDP source
+ * port, readable by the pcapscan example. */
+std::unique_ptr<CorpusWriter> makePcapWriter(const std::string &path);
+
+/** \brief Largest payload a single pcap packet can carry. */
+#define CORPUS_MAX_PCAP_PAYLOAD (65535 - 20 - 8)
+
+#endif
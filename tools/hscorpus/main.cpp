@@ -0,0 +1,611 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Benchmark corpus generator.
+ *
+ * Builds large scanning corpora from a pattern set. Matching strings for each
+ * pattern come from the corpus generator in util/; truncations of them that
+ * no longer match any pattern are used as near misses, which hit the literal
+ * matchers without producing a match and so exercise confirm paths. These are
+ * planted at configurable rates per megabyte into random background data,
+ * along with optional single-byte flood segments, and the result is cut into
+ * packets with a weighted size distribution and written out as it is built,
+ * either as a raw byte stream or as a pcap file.
+ *
+ * Every planted string is checked against a compiled database, and each
+ * packet is scanned in block mode as it is written so that the match rate
+ * actually achieved is reported alongside the requested one.
+ */
+
+#include "config.h"
+
+#include "corpus_writer.h"
+#include "expressions.h"
+#include "ExpressionParser.h"
+#include "ng_corpus_generator.h"
+#include "ng_corpus_properties.h"
+
+#include "hs.h"
+#include "compiler/compiler.h"
+#include "grey.h"
+#include "nfagraph/ng.h"
+#include "util/compile_context.h"
+#include "util/compile_error.h"
+#include "util/report_manager.h"
+#include "util/target_info.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace ue2;
+
+namespace {
+
+static const double MEGABYTE = 1024.0 * 1024.0;
+
+struct Options {
+    string exprFile;
+    string outFile;
+    bool pcap = false;
+    bool text = false;
+    u64a size = 1ULL << 30;
+    double matchRate = 10.0;  //!< planted matches per megabyte
+    double nearRate = 100.0;  //!< planted near misses per megabyte
+    double floodPercent = 1.0; //!< percentage of packets carrying a flood
+    u32 floodMin = 64;
+    u32 floodMax = 4096;
+    vector<pair<u32, u32>> sizes = {{1500, 1}}; //!< (size, weight) pairs
+    u32 flows = 16;
+    u32 perPattern = 100;
+    u32 seed = 0;
+};
+
+struct Pattern {
+    unsigned id;
+    string expr;
+    unsigned flags;
+    hs_expr_ext ext;
+    vector<string> matches;
+    vector<string> nearMisses;
+};
+
+/** Compiled block-mode database over the pattern set, used to check planted
+ * strings and to measure the matches in each packet. */
+class Checker {
+public:
+    explicit Checker(vector<Pattern> &pats) {
+        for (;;) {
+            vector<const char *> exprs;
+            vector<unsigned> flags, ids;
+            vector<const hs_expr_ext *> exts;
+            for (const auto &p : pats) {
+                exprs.push_back(p.expr.c_str());
+                flags.push_back(p.flags);
+                ids.push_back(p.id);
+                exts.push_back(&p.ext);
+            }
+            if (exprs.empty()) {
+                throw runtime_error("No usable patterns");
+            }
+
+            hs_compile_error_t *err = nullptr;
+            if (hs_compile_ext_multi(exprs.data(), flags.data(), ids.data(),
+                                     exts.data(), exprs.size(),
+                                     HS_MODE_BLOCK, nullptr, &db, &err)
+                == HS_SUCCESS) {
+                break;
+            }
+
+            // Drop the offending pattern and try again.
+            if (err->expression < 0) {
+                string msg = string("Compile failed: ") + err->message;
+                hs_free_compile_error(err);
+                throw runtime_error(msg);
+            }
+            fprintf(stderr, "Skipping pattern %u: %s\n",
+                    pats[err->expression].id, err->message);
+            pats.erase(pats.begin() + err->expression);
+            hs_free_compile_error(err);
+        }
+
+        if (hs_alloc_scratch(db, &scratch) != HS_SUCCESS) {
+            hs_free_database(db);
+            throw runtime_error("Unable to allocate scratch");
+        }
+    }
+
+    ~Checker() {
+        hs_free_scratch(scratch);
+        hs_free_database(db);
+    }
+
+    /** Returns the number of matches in \a data; if \a found is non-null,
+     * sets it to whether pattern \a want matched. */
+    size_t scan(const string &data, unsigned want = ~0U,
+                bool *found = nullptr) {
+        Context ctx = {0, want, false};
+        hs_scan(db, data.data(), data.size(), 0, scratch, onMatch, &ctx);
+        if (found) {
+            *found = ctx.found;
+        }
+        return ctx.count;
+    }
+
+private:
+    struct Context {
+        size_t count;
+        unsigned want;
+        bool found;
+    };
+
+    static
+    int onMatch(unsigned id, unsigned long long, unsigned long long,
+                unsigned, void *c) {
+        Context *ctx = (Context *)c;
+        ctx->count++;
+        ctx->found |= id == ctx->want;
+        return 0;
+    }
+
+    hs_database_t *db = nullptr;
+    hs_scratch_t *scratch = nullptr;
+};
+
+static
+vector<Pattern> loadPatterns(const Options &opts) {
+    ExpressionMap exprMap;
+    loadExpressionsFromFile(opts.exprFile, exprMap);
+    if (exprMap.empty()) {
+        throw runtime_error("No expressions loaded from " + opts.exprFile);
+    }
+
+    vector<Pattern> pats;
+    for (const auto &m : exprMap) {
+        Pattern p;
+        p.id = m.first;
+        memset(&p.ext, 0, sizeof(p.ext));
+        if (!readExpression(m.second, p.expr, &p.flags, &p.ext)) {
+            fprintf(stderr, "Skipping pattern %u: unable to parse\n", p.id);
+            continue;
+        }
+        pats.push_back(move(p));
+    }
+    return pats;
+}
+
+static
+void generateStrings(const Options &opts, vector<Pattern> &pats,
+                     Checker &checker) {
+    const size_t maxLen = opts.pcap ? CORPUS_MAX_PCAP_PAYLOAD : ~(size_t)0;
+
+    for (auto &p : pats) {
+        CompileContext cc(false, false, get_current_target(), Grey());
+        ReportManager rm(cc.grey);
+        vector<string> corpora;
+        try {
+            ParsedExpression parsed(0, p.expr.c_str(), p.flags, 0);
+            auto g = buildWrapper(rm, cc, parsed);
+            if (!g) {
+                fprintf(stderr, "Skipping pattern %u: no graph\n", p.id);
+                continue;
+            }
+            CorpusProperties props;
+            props.corpusLimit = opts.perPattern;
+            props.setCycleLimit(1, 3);
+            props.seed(opts.seed + p.id);
+            makeCorpusGenerator(*g, props)->generateCorpus(corpora);
+        } catch (const CompileError &e) {
+            fprintf(stderr, "Skipping pattern %u: %s\n", p.id,
+                    e.reason.c_str());
+            continue;
+        }
+
+        for (const auto &s : corpora) {
+            if (s.empty() || s.size() > maxLen) {
+                continue;
+            }
+            bool found = false;
+            checker.scan(s, p.id, &found);
+            if (!found) {
+                continue;
+            }
+            p.matches.push_back(s);
+
+            // Near miss: the longest short truncation that no longer
+            // produces any match.
+            for (size_t k = 1; k <= 4 && k < s.size(); k++) {
+                string t = s.substr(0, s.size() - k);
+                if (!checker.scan(t)) {
+                    p.nearMisses.push_back(move(t));
+                    break;
+                }
+            }
+        }
+    }
+}
+
+class CorpusBuilder {
+public:
+    CorpusBuilder(const Options &opts_in, const vector<Pattern> &pats,
+                  Checker &checker_in)
+        : opts(opts_in), checker(checker_in), rng(opts.seed) {
+        for (const auto &p : pats) {
+            for (const auto &s : p.matches) {
+                matches.push_back(&s);
+            }
+            for (const auto &s : p.nearMisses) {
+                nearMisses.push_back(&s);
+            }
+        }
+        vector<double> weights;
+        for (const auto &sz : opts.sizes) {
+            weights.push_back(sz.second);
+        }
+        sizeDist = discrete_distribution<size_t>(weights.begin(),
+                                                 weights.end());
+    }
+
+    void run(CorpusWriter &out) {
+        u64a written = 0;
+        u64a nextProgress = 1ULL << 30;
+        double matchCredit = 0, nearCredit = 0;
+        string payload;
+
+        while (written < opts.size) {
+            u64a n = min((u64a)opts.sizes[sizeDist(rng)].first,
+                         opts.size - written);
+            matchCredit += n * opts.matchRate / MEGABYTE;
+            nearCredit += n * opts.nearRate / MEGABYTE;
+
+            vector<const string *> pieces;
+            size_t used = 0;
+            take(matches, n, &matchCredit, &used, &pieces, &plantedMatches);
+            take(nearMisses, n, &nearCredit, &used, &pieces,
+                 &plantedNearMisses);
+
+            string flood;
+            if (!matches.empty() && used < n &&
+                uniform_real_distribution<double>(0, 100)(rng)
+                    < opts.floodPercent) {
+                // Flood with a byte that appears in the patterns so that
+                // the literal matchers see it.
+                const string &src = *pick(matches);
+                char c = src[uniform_int_distribution<size_t>(
+                                 0, src.size() - 1)(rng)];
+                size_t len = uniform_int_distribution<size_t>(
+                    opts.floodMin, opts.floodMax)(rng);
+                flood.assign(min(len, (size_t)n - used), c);
+                used += flood.size();
+                pieces.push_back(&flood);
+                floods++;
+            }
+
+            shuffle(pieces.begin(), pieces.end(), rng);
+            assemble(n - used, pieces, payload);
+            assert(payload.size() == n);
+
+            observedMatches += checker.scan(payload);
+            out.writePacket(payload,
+                            uniform_int_distribution<u32>(
+                                0, opts.flows - 1)(rng));
+            packets++;
+            written += n;
+
+            if (written >= nextProgress) {
+                fprintf(stderr, "%llu MB written\n",
+                        (unsigned long long)(written >> 20));
+                nextProgress += 1ULL << 30;
+            }
+        }
+    }
+
+    void report() const {
+        double mb = opts.size / MEGABYTE;
+        printf("Bytes:               %llu\n", (unsigned long long)opts.size);
+        printf("Packets:             %llu\n", (unsigned long long)packets);
+        printf("Planted matches:     %llu (%.2f/MB, requested %.2f/MB)\n",
+               (unsigned long long)plantedMatches, plantedMatches / mb,
+               opts.matchRate);
+        printf("Planted near misses: %llu (%.2f/MB, requested %.2f/MB)\n",
+               (unsigned long long)plantedNearMisses, plantedNearMisses / mb,
+               opts.nearRate);
+        printf("Floods:              %llu\n", (unsigned long long)floods);
+        printf("Dropped (too long):  %llu\n", (unsigned long long)dropped);
+        printf("Observed matches:    %llu (%.2f/MB, per-packet block "
+               "scan)\n", (unsigned long long)observedMatches,
+               observedMatches / mb);
+    }
+
+private:
+    const string *pick(const vector<const string *> &v) {
+        return v[uniform_int_distribution<size_t>(0, v.size() - 1)(rng)];
+    }
+
+    /** Consume whole units of \a credit from \a pool, adding the strings
+     * that fit in the packet to \a pieces. */
+    void take(const vector<const string *> &pool, size_t n, double *credit,
+              size_t *used, vector<const string *> *pieces, u64a *count) {
+        if (pool.empty()) {
+            *credit = 0;
+            return;
+        }
+        for (; *credit >= 1.0; *credit -= 1.0) {
+            const string *s = pick(pool);
+            if (*used + s->size() > n) {
+                dropped++;
+                continue;
+            }
+            *used += s->size();
+            pieces->push_back(s);
+            (*count)++;
+        }
+    }
+
+    /** Lay out the pieces in order, separated by random-length runs of
+     * background data totalling \a background bytes. */
+    void assemble(size_t background, const vector<const string *> &pieces,
+                  string &out) {
+        vector<size_t> cuts;
+        uniform_int_distribution<size_t> cutDist(0, background);
+        for (size_t i = 0; i < pieces.size(); i++) {
+            cuts.push_back(cutDist(rng));
+        }
+        sort(cuts.begin(), cuts.end());
+        cuts.push_back(background);
+
+        out.clear();
+        size_t prev = 0;
+        for (size_t i = 0; i < cuts.size(); i++) {
+            fill(out, cuts[i] - prev);
+            prev = cuts[i];
+            if (i < pieces.size()) {
+                out += *pieces[i];
+            }
+        }
+    }
+
+    void fill(string &out, size_t len) {
+        static const char printable[] =
+            "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+            " \n\t.,;:!?'\"()[]{}<>/\\|-_=+*&^%$#@~`";
+        const size_t nprint = sizeof(printable) - 1;
+        size_t base = out.size();
+        out.resize(base + len);
+        for (size_t i = 0; i < len; i += 4) {
+            u32 r = rng();
+            for (size_t j = i; j < min(len, i + 4); j++, r >>= 8) {
+                out[base + j] = opts.text ? printable[(r & 0xff) % nprint]
+                                          : (char)(r & 0xff);
+            }
+        }
+    }
+
+    const Options &opts;
+    Checker &checker;
+    mt19937 rng;
+    discrete_distribution<size_t> sizeDist;
+    vector<const string *> matches;
+    vector<const string *> nearMisses;
+
+    u64a packets = 0;
+    u64a plantedMatches = 0;
+    u64a plantedNearMisses = 0;
+    u64a floods = 0;
+    u64a dropped = 0;
+    u64a observedMatches = 0;
+};
+
+static
+bool parseSize(const char *arg, u64a *out) {
+    char *end;
+    unsigned long long val = strtoull(arg, &end, 10);
+    switch (*end) {
+    case 'G': case 'g': val <<= 10; // fall through
+    case 'M': case 'm': val <<= 10; // fall through
+    case 'K': case 'k': val <<= 10; end++; break;
+    default: break;
+    }
+    if (end == arg || *end) {
+        return false;
+    }
+    *out = val;
+    return true;
+}
+
+static
+bool parseSizes(const char *arg, vector<pair<u32, u32>> *out) {
+    out->clear();
+    istringstream in(arg);
+    string tok;
+    while (getline(in, tok, ',')) {
+        u32 size, weight = 1;
+        char sep;
+        istringstream conv(tok);
+        if (!(conv >> size) || !size) {
+            return false;
+        }
+        if (conv >> sep) {
+            if (sep != ':' || !(conv >> weight)) {
+                return false;
+            }
+        }
+        out->push_back(make_pair(size, weight));
+    }
+    return !out->empty();
+}
+
+static
+bool parseRange(const char *arg, u32 *lo, u32 *hi) {
+    char sep;
+    istringstream conv(arg);
+    if (!(conv >> *lo)) {
+        return false;
+    }
+    *hi = *lo;
+    if (conv >> sep) {
+        if (sep != ':' || !(conv >> *hi)) {
+            return false;
+        }
+    }
+    return *lo && *lo <= *hi;
+}
+
+static
+void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s -e EXPRFILE -o OUTFILE [options]\n"
+            "  -e EXPRFILE   patterns, one ID:/regex/flags per line\n"
+            "  -o OUTFILE    output file\n"
+            "  -P            write a pcap file rather than raw bytes\n"
+            "  -s SIZE       corpus size in bytes, K/M/G suffixes allowed "
+            "(default 1G)\n"
+            "  -m RATE       planted matches per MB (default 10)\n"
+            "  -n RATE       planted near misses per MB (default 100)\n"
+            "  -F PERCENT    percentage of packets with a flood (default 1)\n"
+            "  -L MIN:MAX    flood length range (default 64:4096)\n"
+            "  -p SIZES      packet sizes as SIZE[:WEIGHT],... "
+            "(default 1500)\n"
+            "  -c FLOWS      number of pcap flows (default 16)\n"
+            "  -g COUNT      strings generated per pattern (default 100)\n"
+            "  -t            printable text background rather than "
+            "random bytes\n"
+            "  -S SEED       random seed (default 0)\n",
+            name);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options opts;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "e:o:Ps:m:n:F:L:p:c:g:tS:h")) != -1) {
+        bool ok = true;
+        switch (opt) {
+        case 'e':
+            opts.exprFile = optarg;
+            break;
+        case 'o':
+            opts.outFile = optarg;
+            break;
+        case 'P':
+            opts.pcap = true;
+            break;
+        case 's':
+            ok = parseSize(optarg, &opts.size);
+            break;
+        case 'm':
+            opts.matchRate = atof(optarg);
+            break;
+        case 'n':
+            opts.nearRate = atof(optarg);
+            break;
+        case 'F':
+            opts.floodPercent = atof(optarg);
+            break;
+        case 'L':
+            ok = parseRange(optarg, &opts.floodMin, &opts.floodMax);
+            break;
+        case 'p':
+            ok = parseSizes(optarg, &opts.sizes);
+            break;
+        case 'c':
+            opts.flows = atoi(optarg);
+            ok = opts.flows > 0;
+            break;
+        case 'g':
+            opts.perPattern = atoi(optarg);
+            ok = opts.perPattern > 0;
+            break;
+        case 't':
+            opts.text = true;
+            break;
+        case 'S':
+            opts.seed = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+        if (!ok) {
+            fprintf(stderr, "Bad argument for -%c: '%s'\n", opt, optarg);
+            return 1;
+        }
+    }
+
+    if (opts.exprFile.empty() || opts.outFile.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (opts.pcap) {
+        for (const auto &sz : opts.sizes) {
+            if (sz.first > CORPUS_MAX_PCAP_PAYLOAD) {
+                fprintf(stderr, "Packet size %u too large for pcap\n",
+                        sz.first);
+                return 1;
+            }
+        }
+    }
+
+    try {
+        vector<Pattern> pats = loadPatterns(opts);
+        Checker checker(pats);
+        generateStrings(opts, pats, checker);
+
+        size_t nMatch = 0, nNear = 0;
+        for (const auto &p : pats) {
+            nMatch += p.matches.size();
+            nNear += p.nearMisses.size();
+        }
+        fprintf(stderr, "%zu patterns, %zu matching strings, "
+                "%zu near misses\n", pats.size(), nMatch, nNear);
+
+        auto out = opts.pcap ? makePcapWriter(opts.outFile)
+                             : makeRawWriter(opts.outFile);
+        CorpusBuilder builder(opts, pats, checker);
+        builder.run(*out);
+        out->close();
+        builder.report();
+    } catch (const exception &e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
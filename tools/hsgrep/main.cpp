@@ -0,0 +1,443 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief hsgrep: a multi-threaded, mmap-based grep.
+ *
+ * Each input file is mapped read-only and scanned in streaming mode in
+ * fixed-size chunks, so files of any size can be searched without copying
+ * them and without the 4GB limit of a single hs_scan call. Files are shared
+ * among worker threads through a work-stealing pool: each worker takes files
+ * from the back of its own queue and, when that runs dry, steals from the
+ * front of another worker's.
+ *
+ * The pattern is compiled with HS_FLAG_MULTILINE, and every line containing
+ * the end of a match is printed once, prefixed by the file name and line
+ * number. Output for each file is gathered by its worker and written in
+ * batches of whole lines, so a line is never split, although batches from
+ * files scanned by different workers may interleave. With -s, throughput
+ * figures are reported on stderr, making this a convenient file scanning
+ * benchmark.
+ */
+
+#include "config.h"
+
+#include "hs.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+/** Flush a file's pending output once it grows beyond this. */
+static const size_t OUTPUT_FLUSH_SIZE = 1 << 20;
+
+struct Options {
+    string pattern;
+    vector<string> files;
+    unsigned int flags = HS_FLAG_MULTILINE;
+    unsigned int threads = 0;
+    size_t chunkSize = 1 << 20;
+    bool stats = false;
+};
+
+/** Serialises writes to stdout. */
+static mutex outputLock;
+
+static
+void writeOutput(string &out) {
+    if (out.empty()) {
+        return;
+    }
+    lock_guard<mutex> lock(outputLock);
+    fwrite(out.data(), 1, out.size(), stdout);
+    out.clear();
+}
+
+/** A read-only mapping of an input file. */
+class MappedFile {
+public:
+    explicit MappedFile(const string &name) {
+        int fd = open(name.c_str(), O_RDONLY);
+        if (fd < 0) {
+            err = strerror(errno);
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            err = strerror(errno);
+        } else if (!S_ISREG(st.st_mode)) {
+            err = "not a regular file";
+        } else if (st.st_size) {
+            void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd,
+                           0);
+            if (p == MAP_FAILED) {
+                err = strerror(errno);
+            } else {
+                data = (const char *)p;
+                size = st.st_size;
+                madvise(p, size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data) {
+            munmap(const_cast<char *>(data), size);
+        }
+    }
+
+    const char *data = nullptr;
+    size_t size = 0;
+    const char *err = nullptr;
+};
+
+/** Per-file match state: turns match offsets into printed lines. */
+struct LineContext {
+    LineContext(const string &name_in, const MappedFile &f_in, string &out_in)
+        : name(name_in), f(f_in), out(out_in) {}
+
+    const string &name;
+    const MappedFile &f;
+    string &out;
+    size_t counted = 0;   //!< newlines before this offset are in lineNo
+    size_t lineNo = 1;
+    size_t lineStart = 0;
+    bool printed = false; //!< have we printed the line ending at lineEnd?
+    size_t lineEnd = 0;
+    size_t matches = 0;
+};
+
+static
+int onMatch(unsigned int, unsigned long long, unsigned long long to,
+            unsigned int, void *ctx_in) {
+    LineContext &ctx = *(LineContext *)ctx_in;
+    ctx.matches++;
+
+    // The line containing the last byte of the match. Matches arrive in
+    // order of end offset, so we only ever move forwards.
+    size_t pos = to ? to - 1 : 0;
+    if (pos >= ctx.f.size || (ctx.printed && pos <= ctx.lineEnd)) {
+        return 0;
+    }
+
+    const char *base = ctx.f.data;
+    for (const char *p = base + ctx.counted, *e = base + pos; p < e;) {
+        p = (const char *)memchr(p, '\n', e - p);
+        if (!p) {
+            break;
+        }
+        ctx.lineNo++;
+        ctx.lineStart = ++p - base;
+    }
+    ctx.counted = pos;
+
+    const char *nl = (const char *)memchr(base + pos, '\n', ctx.f.size - pos);
+    ctx.lineEnd = nl ? nl - base : ctx.f.size;
+    ctx.printed = true;
+
+    ctx.out += ctx.name;
+    ctx.out += ':';
+    ctx.out += to_string(ctx.lineNo);
+    ctx.out += ':';
+    ctx.out.append(base + ctx.lineStart, ctx.lineEnd - ctx.lineStart);
+    ctx.out += '\n';
+    if (ctx.out.size() >= OUTPUT_FLUSH_SIZE) {
+        writeOutput(ctx.out);
+    }
+    return 0;
+}
+
+/** Work-stealing pool of file indices. */
+class FilePool {
+public:
+    FilePool(size_t numFiles, unsigned int numWorkers)
+        : queues(numWorkers) {
+        for (size_t i = 0; i < numFiles; i++) {
+            queues[i % numWorkers].items.push_back(i);
+        }
+    }
+
+    /** Take the next file for \a worker; false when all work is done. */
+    bool get(unsigned int worker, size_t *file) {
+        if (queues[worker].popBack(file)) {
+            return true;
+        }
+        for (size_t i = 1; i < queues.size(); i++) {
+            if (queues[(worker + i) % queues.size()].popFront(file)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Queue {
+        mutex m;
+        deque<size_t> items;
+
+        bool popBack(size_t *v) {
+            lock_guard<mutex> lock(m);
+            if (items.empty()) {
+                return false;
+            }
+            *v = items.back();
+            items.pop_back();
+            return true;
+        }
+
+        bool popFront(size_t *v) {
+            lock_guard<mutex> lock(m);
+            if (items.empty()) {
+                return false;
+            }
+            *v = items.front();
+            items.pop_front();
+            return true;
+        }
+    };
+
+    vector<Queue> queues;
+};
+
+struct Totals {
+    atomic<unsigned long long> bytes{0};
+    atomic<unsigned long long> files{0};
+    atomic<unsigned long long> matches{0};
+    atomic<bool> failed{false};
+};
+
+class Grep {
+public:
+    Grep(const Options &opts_in, const hs_database_t *db_in,
+         hs_scratch_t *proto_in)
+        : opts(opts_in), db(db_in), proto(proto_in),
+          pool(opts.files.size(), opts.threads) {}
+
+    void worker(unsigned int id) {
+        hs_scratch_t *scratch = nullptr;
+        if (hs_clone_scratch(proto, &scratch) != HS_SUCCESS) {
+            fprintf(stderr, "ERROR: Unable to clone scratch space.\n");
+            totals.failed = true;
+            return;
+        }
+
+        size_t i;
+        while (pool.get(id, &i)) {
+            scanFile(opts.files[i], scratch);
+        }
+        hs_free_scratch(scratch);
+    }
+
+    Totals totals;
+
+private:
+    void scanFile(const string &name, hs_scratch_t *scratch) {
+        MappedFile f(name);
+        if (f.err) {
+            fprintf(stderr, "%s: %s\n", name.c_str(), f.err);
+            totals.failed = true;
+            return;
+        }
+
+        hs_stream_t *stream = nullptr;
+        if (hs_open_stream(db, 0, &stream) != HS_SUCCESS) {
+            fprintf(stderr, "ERROR: Unable to open stream.\n");
+            totals.failed = true;
+            return;
+        }
+
+        string out;
+        LineContext ctx(name, f, out);
+        hs_error_t err = HS_SUCCESS;
+        const size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t released = 0; // prefix of the mapping already released
+        for (size_t off = 0; off < f.size && err == HS_SUCCESS;
+             off += opts.chunkSize) {
+            size_t len = min(opts.chunkSize, f.size - off);
+            err = hs_scan_stream(stream, f.data + off, (unsigned int)len, 0,
+                                 scratch, onMatch, &ctx);
+            // Release the pages before this chunk. The chunk itself stays
+            // resident, as a line printed for a match in the next chunk may
+            // start in it. Only the pages not already released are advised,
+            // so the total work stays linear in the file size.
+            size_t done = off & ~(size_t)(pageSize - 1);
+            if (done > released) {
+                madvise(const_cast<char *>(f.data) + released, done - released,
+                        MADV_DONTNEED);
+                released = done;
+            }
+        }
+        if (err == HS_SUCCESS) {
+            err = hs_close_stream(stream, scratch, onMatch, &ctx);
+        } else {
+            hs_close_stream(stream, scratch, nullptr, nullptr);
+        }
+        if (err != HS_SUCCESS) {
+            fprintf(stderr, "%s: scan failed (error %d)\n", name.c_str(),
+                    err);
+            totals.failed = true;
+        }
+
+        writeOutput(out);
+        totals.bytes += f.size;
+        totals.files++;
+        totals.matches += ctx.matches;
+    }
+
+    const Options &opts;
+    const hs_database_t *db;
+    hs_scratch_t *proto;
+    FilePool pool;
+};
+
+static
+void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s [-i] [-s] [-j THREADS] [-c CHUNK] PATTERN FILE...\n"
+            "  -i          case-insensitive matching\n"
+            "  -s          report throughput statistics on stderr\n"
+            "  -j THREADS  worker threads (default: number of CPUs)\n"
+            "  -c CHUNK    bytes passed to each hs_scan_stream call "
+            "(default 1048576)\n",
+            name);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options opts;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "isj:c:h")) != -1) {
+        switch (opt) {
+        case 'i':
+            opts.flags |= HS_FLAG_CASELESS;
+            break;
+        case 's':
+            opts.stats = true;
+            break;
+        case 'j':
+            opts.threads = atoi(optarg);
+            if (!opts.threads) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'c':
+            opts.chunkSize = strtoull(optarg, nullptr, 0);
+            if (!opts.chunkSize || opts.chunkSize > (1U << 30)) {
+                fprintf(stderr, "Chunk size must be between 1 and 2^30\n");
+                return 2;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    if (argc - optind < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    opts.pattern = argv[optind];
+    opts.files.assign(argv + optind + 1, argv + argc);
+
+    if (!opts.threads) {
+        opts.threads = max(1U, thread::hardware_concurrency());
+    }
+    opts.threads = min(opts.threads, (unsigned int)opts.files.size());
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compileErr = nullptr;
+    if (hs_compile(opts.pattern.c_str(), opts.flags, HS_MODE_STREAM, nullptr,
+                   &db, &compileErr) != HS_SUCCESS) {
+        fprintf(stderr, "ERROR: Unable to compile pattern \"%s\": %s\n",
+                opts.pattern.c_str(), compileErr->message);
+        hs_free_compile_error(compileErr);
+        return 2;
+    }
+
+    hs_scratch_t *scratch = nullptr;
+    if (hs_alloc_scratch(db, &scratch) != HS_SUCCESS) {
+        fprintf(stderr, "ERROR: Unable to allocate scratch space.\n");
+        hs_free_database(db);
+        return 2;
+    }
+
+    auto start = chrono::steady_clock::now();
+
+    Grep grep(opts, db, scratch);
+    vector<thread> workers;
+    for (unsigned int i = 0; i < opts.threads; i++) {
+        workers.emplace_back(&Grep::worker, &grep, i);
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+    fflush(stdout);
+
+    double secs = chrono::duration<double>(chrono::steady_clock::now()
+                                           - start).count();
+    if (opts.stats) {
+        unsigned long long bytes = grep.totals.bytes;
+        fprintf(stderr, "%llu files, %llu bytes, %llu matches in %.3f "
+                "seconds on %u threads: %.2f MB/s\n",
+                (unsigned long long)grep.totals.files, bytes,
+                (unsigned long long)grep.totals.matches, secs, opts.threads,
+                secs > 0 ? bytes / secs / 1000000 : 0.0);
+    }
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+
+    if (grep.totals.failed) {
+        return 2;
+    }
+    return grep.totals.matches ? 0 : 1;
+}
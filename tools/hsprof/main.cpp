@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief hsprof: names the patterns that cost the most to scan.
+ *
+ * Compiles a pattern set, scans a corpus file once with a scan cost profile
+ * attached to the scratch, and prints the patterns charged the most cycles.
+ * This replaces finding expensive patterns by recompiling the set with each
+ * pattern removed in turn. The library must be built with PROFILE_SUPPORT.
+ *
+ * The corpus is scanned in block mode as a whole, or with -s in streaming
+ * mode in writes of the given size.
+ */
+
+#include "config.h"
+
+#include "expressions.h"
+#include "ExpressionParser.h"
+
+#include "hs.h"
+#include "hs_profile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+struct Options {
+    string exprFile;
+    string corpusFile;
+    unsigned int top = 20;
+    size_t streamBlock = 0; // zero for block mode
+    unsigned int repeats = 1;
+};
+
+struct Pattern {
+    string expr;
+    unsigned int flags;
+    hs_expr_ext ext;
+};
+
+static
+map<unsigned int, Pattern> loadPatterns(const string &fname) {
+    ExpressionMap exprMap;
+    loadExpressionsFromFile(fname, exprMap);
+    if (exprMap.empty()) {
+        throw runtime_error("No expressions loaded from " + fname);
+    }
+
+    map<unsigned int, Pattern> pats;
+    for (const auto &m : exprMap) {
+        Pattern p;
+        memset(&p.ext, 0, sizeof(p.ext));
+        if (!readExpression(m.second, p.expr, &p.flags, &p.ext)) {
+            throw runtime_error("Unable to parse expression " +
+                                to_string(m.first) + ": " + m.second);
+        }
+        pats.emplace(m.first, move(p));
+    }
+    return pats;
+}
+
+static
+hs_database_t *compilePatterns(const map<unsigned int, Pattern> &pats,
+                               unsigned int mode) {
+    vector<const char *> exprs;
+    vector<unsigned int> flags;
+    vector<unsigned int> ids;
+    vector<const hs_expr_ext *> exts;
+    for (const auto &m : pats) {
+        exprs.push_back(m.second.expr.c_str());
+        flags.push_back(m.second.flags);
+        ids.push_back(m.first);
+        exts.push_back(&m.second.ext);
+    }
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *err = nullptr;
+    if (hs_compile_ext_multi(exprs.data(), flags.data(), ids.data(),
+                             exts.data(), exprs.size(), mode, nullptr, &db,
+                             &err) != HS_SUCCESS) {
+        string msg = "Compile failed";
+        if (err->expression >= 0) {
+            msg += " for expression " + to_string(ids[err->expression]);
+        }
+        msg += string(": ") + err->message;
+        hs_free_compile_error(err);
+        throw runtime_error(msg);
+    }
+    return db;
+}
+
+static
+string readCorpus(const string &fname) {
+    ifstream in(fname.c_str(), ios::binary);
+    if (!in) {
+        throw runtime_error("Unable to open corpus " + fname);
+    }
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+static
+int onMatch(unsigned int, unsigned long long, unsigned long long, unsigned int,
+            void *ctx) {
+    (*(unsigned long long *)ctx)++;
+    return 0;
+}
+
+static
+void check(hs_error_t err, const char *what) {
+    if (err != HS_SUCCESS) {
+        throw runtime_error(string(what) + " failed with error " +
+                            to_string(err));
+    }
+}
+
+static
+unsigned long long scanCorpus(const Options &opts, const hs_database_t *db,
+                              hs_scratch_t *scratch, const string &corpus) {
+    unsigned long long matches = 0;
+    for (unsigned int i = 0; i < opts.repeats; i++) {
+        if (!opts.streamBlock) {
+            check(hs_scan64(db, corpus.data(), corpus.size(), 0, scratch,
+                            onMatch, &matches), "hs_scan64");
+            continue;
+        }
+
+        hs_stream_t *stream = nullptr;
+        check(hs_open_stream(db, 0, &stream), "hs_open_stream");
+        for (size_t off = 0; off < corpus.size(); off += opts.streamBlock) {
+            size_t len = min(opts.streamBlock, corpus.size() - off);
+            check(hs_scan_stream64(stream, corpus.data() + off, len, 0,
+                                   scratch, onMatch, &matches),
+                  "hs_scan_stream64");
+        }
+        check(hs_close_stream(stream, scratch, onMatch, &matches),
+              "hs_close_stream");
+    }
+    return matches;
+}
+
+static
+void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s -e EXPRFILE -c CORPUS [options]\n"
+            "  -e EXPRFILE   patterns, one ID:/regex/flags per line\n"
+            "  -c CORPUS     file to scan\n"
+            "  -n TOP        number of patterns to list (default 20)\n"
+            "  -s SIZE       scan in streaming mode in writes of SIZE bytes\n"
+            "  -r REPEATS    scan the corpus this many times (default 1)\n",
+            name);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options opts;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "e:c:n:s:r:h")) != -1) {
+        bool ok = true;
+        switch (opt) {
+        case 'e':
+            opts.exprFile = optarg;
+            break;
+        case 'c':
+            opts.corpusFile = optarg;
+            break;
+        case 'n':
+            opts.top = atoi(optarg);
+            ok = opts.top > 0;
+            break;
+        case 's':
+            opts.streamBlock = strtoull(optarg, nullptr, 10);
+            ok = opts.streamBlock > 0;
+            break;
+        case 'r':
+            opts.repeats = atoi(optarg);
+            ok = opts.repeats > 0;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+        if (!ok) {
+            fprintf(stderr, "Bad argument for -%c: '%s'\n", opt, optarg);
+            return 1;
+        }
+    }
+
+    if (opts.exprFile.empty() || opts.corpusFile.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    hs_database_t *db = nullptr;
+    hs_scratch_t *scratch = nullptr;
+    hs_profile_t *profile = nullptr;
+
+    try {
+        auto pats = loadPatterns(opts.exprFile);
+        string corpus = readCorpus(opts.corpusFile);
+
+        db = compilePatterns(pats, opts.streamBlock ? HS_MODE_STREAM
+                                                    : HS_MODE_BLOCK);
+        check(hs_alloc_scratch(db, &scratch), "hs_alloc_scratch");
+        if (hs_alloc_profile(db, &profile) != HS_SUCCESS) {
+            throw runtime_error("Unable to profile: the library must be "
+                                "built with PROFILE_SUPPORT");
+        }
+        check(hs_set_scratch_profile(scratch, profile),
+              "hs_set_scratch_profile");
+
+        auto start = chrono::steady_clock::now();
+        unsigned long long matches = scanCorpus(opts, db, scratch, corpus);
+        auto end = chrono::steady_clock::now();
+        double secs = chrono::duration<double>(end - start).count();
+
+        // Fetch every pattern, so that shares are of the total charged to any
+        // pattern rather than including unattributed literal matcher time.
+        vector<hs_profile_entry_t> entries(pats.size());
+        unsigned int count = 0;
+        check(hs_profile_top(profile, entries.size(), entries.data(), &count),
+              "hs_profile_top");
+        entries.resize(count);
+        unsigned long long total = 0;
+        for (const auto &e : entries) {
+            total += e.cycles;
+        }
+        if (entries.size() > opts.top) {
+            entries.resize(opts.top);
+        }
+
+        double bytes = (double)corpus.size() * opts.repeats;
+        printf("Scanned %.0f bytes in %.3f s (%.2f Mbit/s), %llu matches\n",
+               bytes, secs, secs > 0 ? bytes * 8 / secs / 1e6 : 0.0,
+               matches);
+        printf("%4s %8s %16s %7s %12s  %s\n", "rank", "id", "cycles",
+               "share", "events", "expression");
+        for (size_t i = 0; i < entries.size(); i++) {
+            const auto &e = entries[i];
+            auto it = pats.find(e.id);
+            printf("%4zu %8u %16llu %6.2f%% %12llu  %s\n", i + 1, e.id,
+                   e.cycles, total ? 100.0 * e.cycles / total : 0.0,
+                   e.events, it != pats.end() ? it->second.expr.c_str() : "?");
+        }
+    } catch (const exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        hs_free_scratch(scratch);
+        hs_free_profile(profile);
+        hs_free_database(db);
+        return 1;
+    }
+
+    hs_set_scratch_profile(scratch, nullptr);
+    hs_free_profile(profile);
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+    return 0;
+}
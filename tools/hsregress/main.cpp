@@ -0,0 +1,589 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief hsregress: correctness and throughput regression harness.
+ *
+ * Compiles a pattern set and scans a corpus with it in block, streaming and
+ * vectored mode. The streaming and vectored scans cut the corpus into writes
+ * of random length (reproducible from a seed). The match sets from all three
+ * modes must be identical, and must agree with those of the reference matcher
+ * in util/ng_find_matches.h for every pattern that it can check.
+ *
+ * Each mode is then timed over repeated scans. The results can be saved as a
+ * baseline (-o) and a later run, typically with a different build of the
+ * library, compared against it (-b): a mode whose match set differs from the
+ * baseline, or whose throughput has dropped by more than the threshold, fails
+ * the run. The exit status is zero only if every check passed.
+ */
+
+#include "config.h"
+
+#include "expressions.h"
+#include "ExpressionParser.h"
+#include "ng_find_matches.h"
+
+#include "hs.h"
+#include "compiler/compiler.h"
+#include "grey.h"
+#include "nfagraph/ng.h"
+#include "util/compile_context.h"
+#include "util/compile_error.h"
+#include "util/report_manager.h"
+#include "util/target_info.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace ue2;
+
+namespace {
+
+struct Options {
+    string exprFile;
+    string corpusFile;
+    string baselineIn;
+    string baselineOut;
+    double threshold = 5.0; //!< permitted throughput drop, in percent
+    unsigned int repeats = 10;
+    size_t maxWrite = 4096; //!< largest random write in streaming modes
+    unsigned int seed = 0;
+    bool reference = true;
+};
+
+struct Pattern {
+    unsigned int id;
+    string expr;
+    unsigned int flags;
+    hs_expr_ext ext;
+};
+
+/** (id, start of match, end of match); the start is zero unless the pattern
+ * requested start of match reporting. */
+typedef tuple<unsigned int, unsigned long long, unsigned long long> Match;
+
+enum ScanMode { MODE_BLOCK, MODE_STREAM, MODE_VECTORED };
+static const char *modeNames[] = {"block", "stream", "vectored"};
+static const size_t MODE_COUNT = 3;
+
+struct ModeResult {
+    set<Match> matches;
+    unsigned long long digest = 0;
+    double mbps = 0;
+};
+
+static
+vector<Pattern> loadPatterns(const string &fname) {
+    ExpressionMap exprMap;
+    loadExpressionsFromFile(fname, exprMap);
+    if (exprMap.empty()) {
+        throw runtime_error("No expressions loaded from " + fname);
+    }
+
+    vector<Pattern> pats;
+    for (const auto &m : exprMap) {
+        Pattern p;
+        p.id = m.first;
+        memset(&p.ext, 0, sizeof(p.ext));
+        if (!readExpression(m.second, p.expr, &p.flags, &p.ext)) {
+            throw runtime_error("Unable to parse expression " +
+                                to_string(m.first) + ": " + m.second);
+        }
+        pats.push_back(move(p));
+    }
+    return pats;
+}
+
+static
+hs_database_t *compilePatterns(const vector<Pattern> &pats,
+                               unsigned int mode) {
+    vector<const char *> exprs;
+    vector<unsigned int> flags;
+    vector<unsigned int> ids;
+    vector<const hs_expr_ext *> exts;
+    for (const auto &p : pats) {
+        exprs.push_back(p.expr.c_str());
+        flags.push_back(p.flags);
+        ids.push_back(p.id);
+        exts.push_back(&p.ext);
+    }
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *err = nullptr;
+    if (hs_compile_ext_multi(exprs.data(), flags.data(), ids.data(),
+                             exts.data(), exprs.size(), mode, nullptr, &db,
+                             &err) != HS_SUCCESS) {
+        string msg = "Compile failed";
+        if (err->expression >= 0) {
+            msg += " for expression " + to_string(ids[err->expression]);
+        }
+        msg += string(": ") + err->message;
+        hs_free_compile_error(err);
+        throw runtime_error(msg);
+    }
+    return db;
+}
+
+static
+string readCorpus(const string &fname) {
+    ifstream in(fname.c_str(), ios::binary);
+    if (!in) {
+        throw runtime_error("Unable to open corpus " + fname);
+    }
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+static
+void check(hs_error_t err, const char *what) {
+    if (err != HS_SUCCESS) {
+        throw runtime_error(string(what) + " failed with error " +
+                            to_string(err));
+    }
+}
+
+static
+int collectMatch(unsigned int id, unsigned long long from,
+                 unsigned long long to, unsigned int, void *ctx) {
+    ((set<Match> *)ctx)->insert(make_tuple(id, from, to));
+    return 0;
+}
+
+static
+int countMatch(unsigned int, unsigned long long, unsigned long long,
+               unsigned int, void *ctx) {
+    (*(unsigned long long *)ctx)++;
+    return 0;
+}
+
+/** FNV-1a over the match set, which is ordered. */
+static
+unsigned long long digestMatches(const set<Match> &matches) {
+    unsigned long long h = 14695981039346656037ULL;
+    auto mix = [&h](unsigned long long v) {
+        for (unsigned int i = 0; i < 8; i++) {
+            h ^= (v >> (i * 8)) & 0xff;
+            h *= 1099511628211ULL;
+        }
+    };
+    for (const auto &m : matches) {
+        mix(get<0>(m));
+        mix(get<1>(m));
+        mix(get<2>(m));
+    }
+    return h;
+}
+
+/** A compiled database for one scan mode, with the writes to use. */
+class Scanner {
+public:
+    Scanner(ScanMode mode_in, const vector<Pattern> &pats,
+            const string &corpus_in, const vector<size_t> &writes)
+        : mode(mode_in), corpus(corpus_in) {
+        static const unsigned int hsModes[] = {HS_MODE_BLOCK, HS_MODE_STREAM,
+                                               HS_MODE_VECTORED};
+        db = compilePatterns(pats, hsModes[mode]);
+        check(hs_alloc_scratch(db, &scratch), "hs_alloc_scratch");
+
+        size_t off = 0;
+        for (size_t len : writes) {
+            data.push_back(corpus.data() + off);
+            lengths.push_back(len);
+            off += len;
+        }
+    }
+
+    ~Scanner() {
+        hs_free_scratch(scratch);
+        hs_free_database(db);
+    }
+
+    void scan(match_event_handler onEvent, void *ctx) {
+        switch (mode) {
+        case MODE_BLOCK:
+            check(hs_scan64(db, corpus.data(), corpus.size(), 0, scratch,
+                            onEvent, ctx), "hs_scan64");
+            break;
+        case MODE_STREAM: {
+            hs_stream_t *stream = nullptr;
+            check(hs_open_stream(db, 0, &stream), "hs_open_stream");
+            for (size_t i = 0; i < data.size(); i++) {
+                check(hs_scan_stream(stream, data[i], lengths[i], 0, scratch,
+                                     onEvent, ctx), "hs_scan_stream");
+            }
+            check(hs_close_stream(stream, scratch, onEvent, ctx),
+                  "hs_close_stream");
+            break;
+        }
+        case MODE_VECTORED:
+            check(hs_scan_vector(db, data.data(), lengths.data(), data.size(),
+                                 0, scratch, onEvent, ctx), "hs_scan_vector");
+            break;
+        }
+    }
+
+private:
+    ScanMode mode;
+    const string &corpus;
+    hs_database_t *db = nullptr;
+    hs_scratch_t *scratch = nullptr;
+    vector<const char *> data;
+    vector<unsigned int> lengths;
+};
+
+/** Cuts the corpus into writes of random length, from 1 to \a max bytes. */
+static
+vector<size_t> randomWrites(size_t total, size_t max, unsigned int seed) {
+    mt19937 rng(seed);
+    uniform_int_distribution<size_t> dist(1, max);
+    vector<size_t> writes;
+    for (size_t off = 0; off < total;) {
+        size_t len = min(dist(rng), total - off);
+        writes.push_back(len);
+        off += len;
+    }
+    return writes;
+}
+
+/** Drops the start of match from patterns that did not ask for it. */
+static
+set<Match> normalise(const set<Match> &matches, const set<unsigned int> &som) {
+    set<Match> out;
+    for (const auto &m : matches) {
+        unsigned int id = get<0>(m);
+        out.insert(make_tuple(id, som.count(id) ? get<1>(m) : 0,
+                              get<2>(m)));
+    }
+    return out;
+}
+
+/** Runs the reference matcher over the corpus for each pattern it can
+ * check, and returns the ids of those it checked. */
+static
+set<unsigned int> referenceMatches(const vector<Pattern> &pats,
+                                   const string &corpus, set<Match> &out) {
+    set<unsigned int> checked;
+    for (const auto &p : pats) {
+        // The reference matcher knows nothing of these.
+        if (p.flags & (HS_FLAG_SINGLEMATCH | HS_FLAG_PREFILTER) ||
+            p.ext.flags) {
+            continue;
+        }
+
+        CompileContext cc(false, false, get_current_target(), Grey());
+        ReportManager rm(cc.grey);
+        set<pair<size_t, size_t>> matches;
+        try {
+            ParsedExpression parsed(0, p.expr.c_str(), p.flags, 0);
+            auto g = buildWrapper(rm, cc, parsed);
+            if (!g) {
+                continue;
+            }
+            bool som = p.flags & HS_FLAG_SOM_LEFTMOST;
+            bool utf8 = p.flags & HS_FLAG_UTF8;
+            findMatches(*g, rm, corpus, matches, false, som, utf8);
+        } catch (const CompileError &) {
+            continue;
+        }
+
+        checked.insert(p.id);
+        bool som = p.flags & HS_FLAG_SOM_LEFTMOST;
+        for (const auto &m : matches) {
+            out.insert(make_tuple(p.id, som ? m.first : 0, m.second));
+        }
+    }
+    return checked;
+}
+
+static
+string describeMatch(const Match &m) {
+    ostringstream oss;
+    oss << "id " << get<0>(m) << " at (" << get<1>(m) << ", " << get<2>(m)
+        << ")";
+    return oss.str();
+}
+
+/** Reports the differences between two match sets; returns false if there
+ * are any. */
+static
+bool compareMatches(const char *what, const set<Match> &expected,
+                    const set<Match> &actual) {
+    vector<Match> missing, extra;
+    set_difference(expected.begin(), expected.end(), actual.begin(),
+                   actual.end(), back_inserter(missing));
+    set_difference(actual.begin(), actual.end(), expected.begin(),
+                   expected.end(), back_inserter(extra));
+    if (missing.empty() && extra.empty()) {
+        return true;
+    }
+
+    static const size_t MAX_SHOWN = 10;
+    printf("FAIL %s: %zu missing, %zu extra matches\n", what, missing.size(),
+           extra.size());
+    for (size_t i = 0; i < min(missing.size(), MAX_SHOWN); i++) {
+        printf("  missing %s\n", describeMatch(missing[i]).c_str());
+    }
+    for (size_t i = 0; i < min(extra.size(), MAX_SHOWN); i++) {
+        printf("  extra   %s\n", describeMatch(extra[i]).c_str());
+    }
+    return false;
+}
+
+struct BaselineEntry {
+    unsigned long long count;
+    unsigned long long digest;
+    double mbps;
+};
+
+static
+map<string, BaselineEntry> readBaseline(const string &fname) {
+    ifstream in(fname.c_str());
+    if (!in) {
+        throw runtime_error("Unable to open baseline " + fname);
+    }
+
+    map<string, BaselineEntry> baseline;
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        istringstream iss(line);
+        string mode;
+        BaselineEntry e;
+        if (!(iss >> mode >> e.count >> hex >> e.digest >> dec >> e.mbps)) {
+            throw runtime_error("Malformed baseline line: " + line);
+        }
+        baseline[mode] = e;
+    }
+    return baseline;
+}
+
+static
+void writeBaseline(const string &fname, const Options &opts,
+                   const ModeResult *results) {
+    FILE *f = fopen(fname.c_str(), "w");
+    if (!f) {
+        throw runtime_error("Unable to write baseline " + fname);
+    }
+    fprintf(f, "# hsregress baseline: %s on %s, %u repeats\n",
+            opts.exprFile.c_str(), opts.corpusFile.c_str(), opts.repeats);
+    fprintf(f, "# mode matches digest mbit/s\n");
+    for (size_t m = 0; m < MODE_COUNT; m++) {
+        fprintf(f, "%s %zu %016llx %.2f\n", modeNames[m],
+                results[m].matches.size(), results[m].digest,
+                results[m].mbps);
+    }
+    fclose(f);
+}
+
+static
+void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s -e EXPRFILE -c CORPUS [options]\n"
+            "  -e EXPRFILE   patterns, one ID:/regex/flags per line\n"
+            "  -c CORPUS     file to scan\n"
+            "  -b BASELINE   compare against a baseline written by -o\n"
+            "  -o BASELINE   write the results of this run as a baseline\n"
+            "  -t PERCENT    permitted throughput drop against the baseline\n"
+            "                (default 5)\n"
+            "  -r REPEATS    timed scans per mode (default 10)\n"
+            "  -w MAXWRITE   largest random write in stream and vectored\n"
+            "                modes (default 4096)\n"
+            "  -s SEED       seed for the random writes (default 0)\n"
+            "  -N            skip the reference matcher check\n",
+            name);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options opts;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "e:c:b:o:t:r:w:s:Nh")) != -1) {
+        bool ok = true;
+        switch (opt) {
+        case 'e':
+            opts.exprFile = optarg;
+            break;
+        case 'c':
+            opts.corpusFile = optarg;
+            break;
+        case 'b':
+            opts.baselineIn = optarg;
+            break;
+        case 'o':
+            opts.baselineOut = optarg;
+            break;
+        case 't':
+            opts.threshold = atof(optarg);
+            ok = opts.threshold >= 0;
+            break;
+        case 'r':
+            opts.repeats = atoi(optarg);
+            ok = opts.repeats > 0;
+            break;
+        case 'w':
+            opts.maxWrite = strtoull(optarg, nullptr, 10);
+            ok = opts.maxWrite > 0;
+            break;
+        case 's':
+            opts.seed = strtoul(optarg, nullptr, 10);
+            break;
+        case 'N':
+            opts.reference = false;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+        if (!ok) {
+            fprintf(stderr, "Bad argument for -%c: '%s'\n", opt, optarg);
+            return 1;
+        }
+    }
+
+    if (opts.exprFile.empty() || opts.corpusFile.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    bool pass = true;
+    try {
+        vector<Pattern> pats = loadPatterns(opts.exprFile);
+        string corpus = readCorpus(opts.corpusFile);
+        vector<size_t> writes = randomWrites(corpus.size(), opts.maxWrite,
+                                             opts.seed);
+
+        set<unsigned int> som;
+        for (const auto &p : pats) {
+            if (p.flags & HS_FLAG_SOM_LEFTMOST) {
+                som.insert(p.id);
+            }
+        }
+
+        ModeResult results[MODE_COUNT];
+        for (size_t m = 0; m < MODE_COUNT; m++) {
+            Scanner scanner((ScanMode)m, pats, corpus, writes);
+
+            set<Match> matches;
+            scanner.scan(collectMatch, &matches);
+            results[m].matches = normalise(matches, som);
+            results[m].digest = digestMatches(results[m].matches);
+
+            unsigned long long count = 0;
+            auto start = chrono::steady_clock::now();
+            for (unsigned int i = 0; i < opts.repeats; i++) {
+                scanner.scan(countMatch, &count);
+            }
+            auto end = chrono::steady_clock::now();
+            double secs = chrono::duration<double>(end - start).count();
+            double bits = (double)corpus.size() * 8 * opts.repeats;
+            results[m].mbps = secs > 0 ? bits / secs / 1e6 : 0.0;
+
+            printf("%-9s %10zu matches %10.2f Mbit/s\n", modeNames[m],
+                   results[m].matches.size(), results[m].mbps);
+        }
+
+        for (size_t m = 1; m < MODE_COUNT; m++) {
+            string what = string(modeNames[m]) + " against block";
+            pass &= compareMatches(what.c_str(), results[MODE_BLOCK].matches,
+                                   results[m].matches);
+        }
+
+        if (opts.reference) {
+            set<Match> ref;
+            set<unsigned int> checked = referenceMatches(pats, corpus, ref);
+            set<Match> actual;
+            for (const auto &m : results[MODE_BLOCK].matches) {
+                if (checked.count(get<0>(m))) {
+                    actual.insert(m);
+                }
+            }
+            printf("reference: checked %zu of %zu patterns\n",
+                   checked.size(), pats.size());
+            pass &= compareMatches("block against reference", ref, actual);
+        }
+
+        if (!opts.baselineIn.empty()) {
+            auto baseline = readBaseline(opts.baselineIn);
+            for (size_t m = 0; m < MODE_COUNT; m++) {
+                auto it = baseline.find(modeNames[m]);
+                if (it == baseline.end()) {
+                    printf("FAIL %s: not in baseline\n", modeNames[m]);
+                    pass = false;
+                    continue;
+                }
+                const BaselineEntry &b = it->second;
+                if (b.count != results[m].matches.size() ||
+                    b.digest != results[m].digest) {
+                    printf("FAIL %s: match set differs from baseline "
+                           "(%llu matches before, %zu now)\n", modeNames[m],
+                           b.count, results[m].matches.size());
+                    pass = false;
+                }
+                double change = b.mbps > 0
+                    ? 100.0 * (results[m].mbps - b.mbps) / b.mbps : 0.0;
+                printf("%-9s %+.2f%% throughput against baseline\n",
+                       modeNames[m], change);
+                if (change < -opts.threshold) {
+                    printf("FAIL %s: throughput dropped from %.2f to %.2f "
+                           "Mbit/s\n", modeNames[m], b.mbps,
+                           results[m].mbps);
+                    pass = false;
+                }
+            }
+        }
+
+        if (!opts.baselineOut.empty()) {
+            writeBaseline(opts.baselineOut, opts, results);
+        }
+    } catch (const exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,581 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief hsreplay: deterministic replay of recorded scan traces.
+ *
+ * Re-executes a trace recorded with the scan trace layer (util/scan_trace.h)
+ * call for call, with the same interleaving of stream writes, and reports the
+ * time taken by each kind of call. If the library was built with
+ * PROFILE_SUPPORT, it also reports the engines that cost the most.
+ *
+ * By default the trace is replayed against the databases recorded in it, and
+ * any call whose result or number of matches differs from the recording is
+ * counted as a divergence. With -e, it is instead replayed against a database
+ * compiled from the given patterns, to measure the effect of a rule change on
+ * recorded traffic.
+ */
+
+#include "config.h"
+
+#include "expressions.h"
+#include "ExpressionParser.h"
+#include "scan_trace.h"
+
+#include "hs.h"
+#include "hs_layout.h"
+#include "hs_profile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+struct Options {
+    string traceFile;
+    string exprFile;
+    unsigned int top = 10;
+    unsigned int repeats = 1;
+};
+
+/** A recorded call, with its payload. */
+struct Call {
+    TraceRecord rec;
+    string data;
+};
+
+/** A database the trace is replayed against, and its per-database state. */
+struct Database {
+    hs_database_t *db = nullptr;
+    hs_scratch_t *scratch = nullptr;
+    hs_profile_t *profile = nullptr;
+};
+
+/** Time taken by one kind of call. */
+struct OpStats {
+    unsigned long long calls = 0;
+    unsigned long long bytes = 0;
+    double secs = 0;
+};
+
+/** Stops scanning at the same match as the recording did. */
+struct ReplayContext {
+    unsigned long long matches = 0;
+    unsigned long long limit = 0;
+    bool halt = false;
+};
+
+static
+int onMatch(unsigned int, unsigned long long, unsigned long long, unsigned int,
+            void *ctx) {
+    ReplayContext *rc = (ReplayContext *)ctx;
+    rc->matches++;
+    return rc->halt && rc->matches >= rc->limit ? 1 : 0;
+}
+
+static
+void check(hs_error_t err, const char *what) {
+    if (err != HS_SUCCESS) {
+        throw runtime_error(string(what) + " failed with error " +
+                            to_string(err));
+    }
+}
+
+static
+const char *opName(uint8_t op) {
+    switch (op) {
+    case TRACE_OPEN_STREAM:
+        return "open_stream";
+    case TRACE_SCAN_STREAM:
+        return "scan_stream";
+    case TRACE_CLOSE_STREAM:
+        return "close_stream";
+    case TRACE_RESET_STREAM:
+        return "reset_stream";
+    case TRACE_COPY_STREAM:
+        return "copy_stream";
+    case TRACE_SCAN:
+        return "scan";
+    default:
+        return "unknown";
+    }
+}
+
+static
+const char *roleName(unsigned int role) {
+    switch (role) {
+    case HS_ENGINE_ROLE_OUTFIX:
+        return "outfix";
+    case HS_ENGINE_ROLE_PREFIX:
+        return "prefix";
+    case HS_ENGINE_ROLE_INFIX:
+        return "infix";
+    case HS_ENGINE_ROLE_SUFFIX:
+        return "suffix";
+    case HS_ENGINE_ROLE_CHAINED:
+        return "chained";
+    case HS_ENGINE_ROLE_ANCHORED:
+        return "anchored";
+    case HS_ENGINE_ROLE_SMALL_WRITE:
+        return "small write";
+    default:
+        return "unknown";
+    }
+}
+
+static
+void loadTrace(const string &fname, vector<string> &databases,
+               vector<Call> &calls) {
+    TraceReader reader(fname);
+    Call c;
+    while (reader.next(c.rec, c.data)) {
+        if (c.rec.op == TRACE_DATABASE) {
+            if (c.rec.id != databases.size()) {
+                throw runtime_error("Databases out of order in " + fname);
+            }
+            databases.push_back(move(c.data));
+        } else {
+            calls.push_back(move(c));
+        }
+        c = Call();
+    }
+}
+
+static
+hs_database_t *compilePatterns(const string &fname, unsigned int mode) {
+    ExpressionMap exprMap;
+    loadExpressionsFromFile(fname, exprMap);
+    if (exprMap.empty()) {
+        throw runtime_error("No expressions loaded from " + fname);
+    }
+
+    vector<string> exprs;
+    vector<unsigned int> flags;
+    vector<unsigned int> ids;
+    vector<hs_expr_ext> exts;
+    for (const auto &m : exprMap) {
+        string expr;
+        unsigned int f = 0;
+        hs_expr_ext ext;
+        memset(&ext, 0, sizeof(ext));
+        if (!readExpression(m.second, expr, &f, &ext)) {
+            throw runtime_error("Unable to parse expression " +
+                                to_string(m.first) + ": " + m.second);
+        }
+        exprs.push_back(expr);
+        flags.push_back(f);
+        ids.push_back(m.first);
+        exts.push_back(ext);
+    }
+
+    vector<const char *> exprPtrs;
+    vector<const hs_expr_ext *> extPtrs;
+    for (size_t i = 0; i < exprs.size(); i++) {
+        exprPtrs.push_back(exprs[i].c_str());
+        extPtrs.push_back(&exts[i]);
+    }
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *err = nullptr;
+    if (hs_compile_ext_multi(exprPtrs.data(), flags.data(), ids.data(),
+                             extPtrs.data(), exprPtrs.size(), mode, nullptr,
+                             &db, &err) != HS_SUCCESS) {
+        string msg = "Compile failed";
+        if (err->expression >= 0) {
+            msg += " for expression " + to_string(ids[err->expression]);
+        }
+        msg += string(": ") + err->message;
+        hs_free_compile_error(err);
+        throw runtime_error(msg);
+    }
+    return db;
+}
+
+static
+void freeDatabases(vector<Database> &dbs) {
+    for (auto &d : dbs) {
+        if (d.scratch) {
+            hs_set_scratch_profile(d.scratch, nullptr);
+        }
+        hs_free_profile(d.profile);
+        hs_free_scratch(d.scratch);
+        hs_free_database(d.db);
+    }
+    dbs.clear();
+}
+
+static
+void prepareDatabases(const Options &opts, const vector<string> &recorded,
+                      vector<Database> &dbs) {
+    if (!opts.exprFile.empty() && recorded.size() > 1) {
+        throw runtime_error("Trace uses more than one database; it can only "
+                            "be replayed against the recorded ones");
+    }
+
+    for (const auto &bytes : recorded) {
+        dbs.push_back(Database());
+        Database &d = dbs.back();
+        check(hs_deserialize_database(bytes.data(), bytes.size(), &d.db),
+              "hs_deserialize_database");
+
+        if (!opts.exprFile.empty()) {
+            // Compile for the mode the recorded database was built for.
+            size_t stream_size;
+            unsigned int mode = hs_stream_size(d.db, &stream_size) ==
+                                HS_SUCCESS ? HS_MODE_STREAM : HS_MODE_BLOCK;
+            hs_free_database(d.db);
+            d.db = nullptr;
+            d.db = compilePatterns(opts.exprFile, mode);
+        }
+
+        check(hs_alloc_scratch(d.db, &d.scratch), "hs_alloc_scratch");
+        if (hs_alloc_profile(d.db, &d.profile) == HS_SUCCESS) {
+            check(hs_set_scratch_profile(d.scratch, d.profile),
+                  "hs_set_scratch_profile");
+        }
+    }
+}
+
+class Replayer {
+public:
+    Replayer(vector<Database> &dbs_in) : dbs(dbs_in) {}
+
+    ~Replayer() {
+        closeAll();
+    }
+
+    /** Replays every call once. */
+    void run(const vector<Call> &calls) {
+        for (const auto &c : calls) {
+            replay(c);
+        }
+        closeAll();
+    }
+
+    map<uint8_t, OpStats> stats;
+    unsigned long long divergences = 0;
+    unsigned long long skipped = 0;
+    unsigned long long matches = 0;
+
+private:
+    Database *database(uint32_t id) {
+        return id < dbs.size() ? &dbs[id] : nullptr;
+    }
+
+    hs_stream_t *stream(uint32_t id) {
+        auto it = streams.find(id);
+        return it != streams.end() ? it->second.first : nullptr;
+    }
+
+    Database *streamDatabase(uint32_t id) {
+        auto it = streams.find(id);
+        return it != streams.end() ? it->second.second : nullptr;
+    }
+
+    void closeAll() {
+        for (auto &m : streams) {
+            hs_close_stream(m.second.first, nullptr, nullptr, nullptr);
+        }
+        streams.clear();
+    }
+
+    void replay(const Call &c) {
+        const TraceRecord &rec = c.rec;
+        ReplayContext rc;
+        rc.limit = rec.matches;
+        rc.halt = rec.result == HS_SCAN_TERMINATED;
+
+        hs_error_t ret;
+        auto start = chrono::steady_clock::now();
+        switch (rec.op) {
+        case TRACE_OPEN_STREAM: {
+            Database *d = database(rec.aux);
+            if (!d || stream(rec.id)) {
+                skipped++;
+                return;
+            }
+            hs_stream_t *s = nullptr;
+            ret = hs_open_stream(d->db, rec.flags, &s);
+            if (ret == HS_SUCCESS) {
+                streams[rec.id] = make_pair(s, d);
+            }
+            break;
+        }
+        case TRACE_SCAN_STREAM: {
+            Database *d = streamDatabase(rec.id);
+            if (!d) {
+                skipped++;
+                return;
+            }
+            ret = hs_scan_stream(stream(rec.id), c.data.data(),
+                                 c.data.size(), rec.flags, d->scratch,
+                                 onMatch, &rc);
+            break;
+        }
+        case TRACE_CLOSE_STREAM: {
+            Database *d = streamDatabase(rec.id);
+            if (!d) {
+                skipped++;
+                return;
+            }
+            ret = hs_close_stream(stream(rec.id),
+                                  rec.aux ? d->scratch : nullptr,
+                                  rec.aux ? onMatch : nullptr, &rc);
+            streams.erase(rec.id);
+            break;
+        }
+        case TRACE_RESET_STREAM: {
+            Database *d = streamDatabase(rec.id);
+            if (!d) {
+                skipped++;
+                return;
+            }
+            ret = hs_reset_stream(stream(rec.id), rec.flags,
+                                  rec.aux ? d->scratch : nullptr,
+                                  rec.aux ? onMatch : nullptr, &rc);
+            break;
+        }
+        case TRACE_COPY_STREAM: {
+            Database *d = streamDatabase(rec.aux);
+            if (!d || stream(rec.id)) {
+                skipped++;
+                return;
+            }
+            hs_stream_t *s = nullptr;
+            ret = hs_copy_stream(&s, stream(rec.aux));
+            if (ret == HS_SUCCESS) {
+                streams[rec.id] = make_pair(s, d);
+            }
+            break;
+        }
+        case TRACE_SCAN: {
+            Database *d = database(rec.id);
+            if (!d) {
+                skipped++;
+                return;
+            }
+            ret = hs_scan(d->db, c.data.data(), c.data.size(), rec.flags,
+                          d->scratch, onMatch, &rc);
+            break;
+        }
+        default:
+            skipped++;
+            return;
+        }
+        auto end = chrono::steady_clock::now();
+
+        OpStats &s = stats[rec.op];
+        s.calls++;
+        s.bytes += c.data.size();
+        s.secs += chrono::duration<double>(end - start).count();
+        matches += rc.matches;
+
+        if (ret != rec.result || rc.matches != rec.matches) {
+            divergences++;
+        }
+    }
+
+    vector<Database> &dbs;
+
+    /** Live streams by trace stream number, with their database. */
+    map<uint32_t, pair<hs_stream_t *, Database *>> streams;
+};
+
+static
+void reportEngines(const Options &opts, const vector<Database> &dbs) {
+    for (size_t i = 0; i < dbs.size(); i++) {
+        const Database &d = dbs[i];
+        if (!d.profile) {
+            continue;
+        }
+
+        hs_database_layout_t *layout = nullptr;
+        check(hs_database_layout(d.db, &layout), "hs_database_layout");
+
+        struct EngineCost {
+            unsigned int index;
+            unsigned long long cycles;
+            unsigned long long events;
+        };
+        vector<EngineCost> costs;
+        unsigned long long total = 0;
+        for (unsigned int e = 0; e < layout->engine_count; e++) {
+            EngineCost ec;
+            ec.index = e;
+            if (hs_profile_engine(d.profile, e, &ec.cycles, &ec.events) !=
+                HS_SUCCESS) {
+                break;
+            }
+            total += ec.cycles;
+            costs.push_back(ec);
+        }
+        stable_sort(costs.begin(), costs.end(),
+                    [](const EngineCost &a, const EngineCost &b) {
+                        return a.cycles > b.cycles;
+                    });
+        if (costs.size() > opts.top) {
+            costs.resize(opts.top);
+        }
+
+        printf("\nDatabase %zu: costliest engines\n", i);
+        printf("%6s %-12s %-24s %16s %7s %12s\n", "engine", "role", "type",
+               "cycles", "share", "events");
+        for (const auto &ec : costs) {
+            const hs_engine_layout_t &e = layout->engines[ec.index];
+            printf("%6u %-12s %-24s %16llu %6.2f%% %12llu\n", ec.index,
+                   roleName(e.role), e.type, ec.cycles,
+                   total ? 100.0 * ec.cycles / total : 0.0, ec.events);
+        }
+
+        hs_free_database_layout(layout);
+    }
+}
+
+static
+void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s -t TRACE [options]\n"
+            "  -t TRACE      trace file to replay\n"
+            "  -e EXPRFILE   replay against these patterns instead of the\n"
+            "                recorded database\n"
+            "  -n TOP        number of engines to list (default 10)\n"
+            "  -r REPEATS    replay the trace this many times (default 1)\n",
+            name);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options opts;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:e:n:r:h")) != -1) {
+        bool ok = true;
+        switch (opt) {
+        case 't':
+            opts.traceFile = optarg;
+            break;
+        case 'e':
+            opts.exprFile = optarg;
+            break;
+        case 'n':
+            opts.top = atoi(optarg);
+            ok = opts.top > 0;
+            break;
+        case 'r':
+            opts.repeats = atoi(optarg);
+            ok = opts.repeats > 0;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+        if (!ok) {
+            fprintf(stderr, "Bad argument for -%c: '%s'\n", opt, optarg);
+            return 1;
+        }
+    }
+
+    if (opts.traceFile.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    vector<Database> dbs;
+    try {
+        vector<string> recorded;
+        vector<Call> calls;
+        loadTrace(opts.traceFile, recorded, calls);
+        if (recorded.empty()) {
+            throw runtime_error("Trace contains no database");
+        }
+        prepareDatabases(opts, recorded, dbs);
+
+        Replayer replayer(dbs);
+        for (unsigned int i = 0; i < opts.repeats; i++) {
+            replayer.run(calls);
+        }
+
+        double secs = 0;
+        unsigned long long bytes = 0;
+        for (const auto &m : replayer.stats) {
+            secs += m.second.secs;
+            bytes += m.second.bytes;
+        }
+
+        printf("Replayed %zu calls x %u: %llu bytes in %.3f s "
+               "(%.2f Mbit/s), %llu matches\n", calls.size(), opts.repeats,
+               bytes, secs, secs > 0 ? bytes * 8 / secs / 1e6 : 0.0,
+               replayer.matches);
+        printf("%-14s %12s %16s %12s %12s\n", "call", "count", "bytes",
+               "total ms", "mean us");
+        for (const auto &m : replayer.stats) {
+            const OpStats &s = m.second;
+            printf("%-14s %12llu %16llu %12.3f %12.3f\n", opName(m.first),
+                   s.calls, s.bytes, s.secs * 1e3,
+                   s.calls ? s.secs * 1e6 / s.calls : 0.0);
+        }
+        if (replayer.skipped) {
+            printf("%llu calls skipped: they refer to streams or databases "
+                   "not in the trace\n", replayer.skipped);
+        }
+        if (opts.exprFile.empty()) {
+            printf("%llu calls diverged from the recording\n",
+                   replayer.divergences);
+        }
+
+        bool profiled = false;
+        for (const auto &d : dbs) {
+            profiled |= d.profile != nullptr;
+        }
+        if (profiled) {
+            reportEngines(opts, dbs);
+        } else {
+            printf("Engine costs unavailable: the library must be built "
+                   "with PROFILE_SUPPORT\n");
+        }
+    } catch (const exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        freeDatabases(dbs);
+        return 1;
+    }
+
+    freeDatabases(dbs);
+    return 0;
+}
@@ -1285,6 +1285,92 @@ TEST(HyperscanArgChecks, ScanVectorNoHandler) {
     hs_free_database(db);
 }
 
+// hs_scan64: Call with no data
+TEST(HyperscanArgChecks, Scan64NoData) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_NOSTREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+    err = hs_scan64(db, nullptr, 4, 0, scratch, dummy_cb, nullptr);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_NE(HS_SCAN_TERMINATED, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_scan64: Call with a streaming database
+TEST(HyperscanArgChecks, Scan64StreamingDatabase) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+    err = hs_scan64(db, "data", 4, 0, scratch, dummy_cb, nullptr);
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_scan_stream64: Call with no stream id
+TEST(HyperscanArgChecks, ScanStream64NoStreamID) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+    err = hs_scan_stream64(nullptr, "data", 4, 0, scratch, dummy_cb, nullptr);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_NE(HS_SCAN_TERMINATED, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_scan_vector64: Call with no length array
+TEST(HyperscanArgChecks, ScanVector64NoLenArray) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_VECTORED, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    const char *data[] = {"data", "data"};
+    err = hs_scan_vector64(db, data, nullptr, 2, 0, scratch, dummy_cb,
+                           nullptr);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_NE(HS_SCAN_TERMINATED, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
 // hs_alloc_scratch: Call with no database
 TEST(HyperscanArgChecks, AllocScratchNoDatabase) {
     hs_scratch_t *scratch = nullptr;
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Streaming tests for delayed literals that are still pending at the
+ * end of a write, checked against block mode.
+ */
+
+#include "config.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hs.h"
+#include "test_util.h"
+
+using namespace std;
+using namespace testing;
+
+namespace /* anonymous */ {
+
+bool matchLess(const MatchRecord &a, const MatchRecord &b) {
+    return a.to < b.to || (a.to == b.to && a.id < b.id);
+}
+
+vector<MatchRecord> scanBlock(const hs_database_t *db, hs_scratch_t *scratch,
+                              const string &data) {
+    CallBackContext c;
+    hs_error_t err = hs_scan(db, data.c_str(), data.size(), 0, scratch,
+                             record_cb, (void *)&c);
+    EXPECT_EQ(HS_SUCCESS, err);
+    sort(c.matches.begin(), c.matches.end(), matchLess);
+    return c.matches;
+}
+
+/** Scans data as a stream, writing it in pieces that end at the given
+ * offsets. */
+vector<MatchRecord> scanStream(const hs_database_t *db, hs_scratch_t *scratch,
+                               const string &data,
+                               const vector<size_t> &splits) {
+    CallBackContext c;
+    hs_stream_t *stream = nullptr;
+    hs_error_t err = hs_open_stream(db, 0, &stream);
+    EXPECT_EQ(HS_SUCCESS, err);
+    if (!stream) {
+        return c.matches;
+    }
+
+    size_t prev = 0;
+    for (size_t split : splits) {
+        err = hs_scan_stream(stream, data.c_str() + prev, split - prev, 0,
+                             scratch, record_cb, (void *)&c);
+        EXPECT_EQ(HS_SUCCESS, err);
+        prev = split;
+    }
+    err = hs_scan_stream(stream, data.c_str() + prev, data.size() - prev, 0,
+                         scratch, record_cb, (void *)&c);
+    EXPECT_EQ(HS_SUCCESS, err);
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+    EXPECT_EQ(HS_SUCCESS, err);
+
+    sort(c.matches.begin(), c.matches.end(), matchLess);
+    return c.matches;
+}
+
+/** Checks that streaming gives the block mode results for each input, when
+ * written in two pieces split at every offset and one byte at a time. */
+void checkStreamMatchesBlock(const vector<pattern> &patterns,
+                             const vector<string> &corpora) {
+    hs_database_t *bdb = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, bdb);
+    hs_database_t *sdb = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, sdb);
+
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(bdb, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_alloc_scratch(sdb, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    for (const string &data : corpora) {
+        SCOPED_TRACE(data);
+        vector<MatchRecord> expected = scanBlock(bdb, scratch, data);
+        ASSERT_FALSE(expected.empty());
+
+        for (size_t split = 0; split <= data.size(); split++) {
+            SCOPED_TRACE(split);
+            EXPECT_EQ(expected, scanStream(sdb, scratch, data, {split}));
+        }
+
+        vector<size_t> bytes;
+        for (size_t i = 1; i < data.size(); i++) {
+            bytes.push_back(i);
+        }
+        EXPECT_EQ(expected, scanStream(sdb, scratch, data, bytes));
+    }
+
+    hs_free_scratch(scratch);
+    hs_free_database(bdb);
+    hs_free_database(sdb);
+}
+
+// A few delayed literals pending across a write boundary: few enough to be
+// carried over in stream state rather than rebuilt from history.
+TEST(DelayedLiterals, FewPendingAcrossWrites) {
+    vector<pattern> patterns;
+    patterns.push_back(pattern("hatstand.{3}", HS_FLAG_DOTALL, 1));
+    patterns.push_back(pattern("teakettle.{5}", HS_FLAG_DOTALL, 2));
+    patterns.push_back(pattern("badger.*brush", HS_FLAG_DOTALL, 3));
+
+    vector<string> corpora;
+    corpora.push_back("xxhatstandxxxxx");
+    corpora.push_back("hatstandteakettlexxxxxx");
+    corpora.push_back("badgerbrush hatstand!!!");
+    corpora.push_back("teakettlebadgerbrushxxhatstandyyy");
+
+    checkStreamMatchesBlock(patterns, corpora);
+}
+
+// More delayed literals due in the same slot than its short list holds, so
+// the slot spills into its multibit, and more pending at a write boundary
+// than can be carried over in stream state.
+TEST(DelayedLiterals, ManyPendingAcrossWrites) {
+    // Every literal is a suffix of the same string, so all of them end at the
+    // same offset and are delayed by the same amount.
+    const string base = "qwertyuiopasdfgh";
+    vector<pattern> patterns;
+    for (unsigned i = 0; i < 10; i++) {
+        patterns.push_back(pattern(base.substr(i) + ".{3}", HS_FLAG_DOTALL,
+                                   i));
+        patterns.push_back(pattern(base.substr(i) + ".*XYZ", HS_FLAG_DOTALL,
+                                   100 + i));
+    }
+
+    vector<string> corpora;
+    corpora.push_back(base + "XYZ");
+    corpora.push_back("zz" + base + "zzzzXYZ");
+    corpora.push_back(base + base + "XYZ" + base + "zz");
+
+    checkStreamMatchesBlock(patterns, corpora);
+}
+
+} // namespace
@@ -156,3 +156,93 @@ TEST(ExtParam, LargeMinLength) {
     hs_free_scratch(scratch);
     hs_free_database(db);
 }
+
+TEST(ExtParam, MaxOffsetStreamHorizon) {
+    hs_expr_ext ext;
+    memset(&ext, 0, sizeof(ext));
+    ext.max_offset = 10;
+    ext.flags = HS_EXT_FLAG_MAX_OFFSET;
+
+    // The trailing word boundary needs the byte after the match to resolve.
+    pattern p("foo\\b", 0, 0, ext);
+    hs_database_t *db = buildDB(p, HS_MODE_STREAM);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    CallBackContext c;
+
+    // A match ending exactly at max_offset must still be reported, even
+    // though the byte that resolves it arrives in a later write.
+    string data = "_______foo";
+    err = hs_scan_stream(stream, data.c_str(), data.length(), 0, scratch,
+                         record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(0U, c.matches.size());
+
+    data = " foo foo foo ";
+    err = hs_scan_stream(stream, data.c_str(), data.length(), 0, scratch,
+                         record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(10, 0), c.matches[0]);
+
+    // We're now past the horizon: nothing more can match.
+    data = "foo foo foo ";
+    err = hs_scan_stream(stream, data.c_str(), data.length(), 0, scratch,
+                         record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(ExtParam, MaxOffsetBlockHorizon) {
+    hs_expr_ext ext;
+    memset(&ext, 0, sizeof(ext));
+    ext.max_offset = 10;
+    ext.flags = HS_EXT_FLAG_MAX_OFFSET;
+
+    pattern p("foo$", 0, 0, ext);
+    hs_database_t *db = buildDB(p, HS_MODE_NOSTREAM);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    CallBackContext c;
+
+    // '$' may match before a trailing newline, one byte short of EOD.
+    string corpus = "_______foo\n";
+    err = hs_scan(db, corpus.c_str(), corpus.length(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(10, 0), c.matches[0]);
+
+    // A long block must not look like it ends just past the horizon.
+    c.clear();
+    corpus = "_______foo\n" + string(1000, '_') + "foo";
+    err = hs_scan(db, corpus.c_str(), corpus.length(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(0U, c.matches.size());
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hs.h"
+#include "hs_layout.h"
+#include "test_util.h"
+
+using namespace std;
+
+TEST(Layout, NoDatabase) {
+    hs_database_layout_t *layout = nullptr;
+    hs_error_t err = hs_database_layout(nullptr, &layout);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_TRUE(layout == nullptr);
+}
+
+TEST(Layout, NoLayout) {
+    hs_database_t *db = buildDB("foobar", 0, 1, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    hs_error_t err = hs_database_layout(db, nullptr);
+    ASSERT_NE(HS_SUCCESS, err);
+
+    hs_free_database(db);
+}
+
+TEST(Layout, FreeNull) {
+    hs_error_t err = hs_free_database_layout(nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+}
+
+TEST(Layout, BlockSizes) {
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foobar", 0, 1));
+    patterns.push_back(pattern("hatstand", 0, 2));
+    patterns.push_back(pattern("teakettle", 0, 3));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    hs_database_layout_t *layout = nullptr;
+    hs_error_t err = hs_database_layout(db, &layout);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(layout != nullptr);
+
+    size_t db_size = 0;
+    err = hs_database_size(db, &db_size);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(db_size, layout->database_size);
+    EXPECT_EQ(0U, layout->stream_size);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    size_t scratch_size = 0;
+    err = hs_scratch_size(scratch, &scratch_size);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(scratch_size, layout->scratch_size);
+
+    // Every literal lives in some literal matcher.
+    unsigned int literals = 0;
+    for (unsigned int i = 0; i < layout->matcher_count; i++) {
+        const hs_matcher_layout_t &m = layout->matchers[i];
+        EXPECT_LE(m.table, (unsigned int)HS_MATCHER_SMALL_BLOCK);
+        ASSERT_TRUE(m.type != nullptr);
+        ASSERT_TRUE(m.accel != nullptr);
+        EXPECT_LT(0U, m.literal_count);
+        EXPECT_LT(0U, m.size);
+        EXPECT_GT(layout->database_size, m.size);
+        literals += m.literal_count;
+    }
+    EXPECT_LE(3U, literals);
+
+    hs_free_scratch(scratch);
+    hs_free_database_layout(layout);
+    hs_free_database(db);
+}
+
+TEST(Layout, StreamSizes) {
+    hs_database_t *db = buildDB("foo.*bar", 0, 1, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+
+    hs_database_layout_t *layout = nullptr;
+    hs_error_t err = hs_database_layout(db, &layout);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(layout != nullptr);
+
+    size_t stream_size = 0;
+    err = hs_stream_size(db, &stream_size);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(stream_size, layout->stream_size);
+
+    // Streaming databases have no small write engine.
+    EXPECT_EQ(0U, layout->small_write_size);
+
+    hs_free_database_layout(layout);
+    hs_free_database(db);
+}
+
+TEST(Layout, Engines) {
+    vector<pattern> patterns;
+    patterns.push_back(pattern("^[a-f]+[0-9]{3,9}x", 0, 1));
+    patterns.push_back(pattern("hatstand[^\\n]{2,20}teakettle", 0, 2));
+    patterns.push_back(pattern("(foo|bar)baz[^z]*quux", 0, 3));
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+
+    hs_database_layout_t *layout = nullptr;
+    hs_error_t err = hs_database_layout(db, &layout);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(layout != nullptr);
+
+    // None of these patterns can be handled by literal matching alone.
+    ASSERT_LT(0U, layout->engine_count);
+
+    size_t engine_stream_state = 0;
+    for (unsigned int i = 0; i < layout->engine_count; i++) {
+        const hs_engine_layout_t &e = layout->engines[i];
+        EXPECT_LE(e.role, (unsigned int)HS_ENGINE_ROLE_SMALL_WRITE);
+        ASSERT_TRUE(e.type != nullptr);
+        ASSERT_TRUE(e.reverse_accel != nullptr);
+        EXPECT_LT(0U, e.size);
+        EXPECT_GT(layout->database_size, e.size);
+        engine_stream_state += e.stream_state_size;
+    }
+    EXPECT_GE(layout->stream_size, engine_stream_state);
+
+    hs_free_database_layout(layout);
+    hs_free_database(db);
+}
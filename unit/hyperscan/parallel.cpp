@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <climits>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hs.h"
+#include "test_util.h"
+#include "util/parallel_scan.h"
+
+using namespace std;
+using namespace testing;
+
+namespace /* anonymous */ {
+
+typedef tuple<unsigned long long, unsigned int, unsigned long long> Match;
+
+static
+int collect(unsigned int id, unsigned long long from, unsigned long long to,
+            unsigned int, void *ctx) {
+    ((vector<Match> *)ctx)->push_back(make_tuple(to, id, from));
+    return 0;
+}
+
+static
+int stopAfterTen(unsigned int, unsigned long long, unsigned long long,
+                 unsigned int, void *ctx) {
+    return ++*(size_t *)ctx == 10;
+}
+
+static
+unsigned int maxWidth(const vector<pattern> &patterns) {
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    EXPECT_NE(nullptr, db);
+    unsigned int width = 0;
+    EXPECT_EQ(HS_SUCCESS, hs_database_max_width(db, &width));
+    hs_free_database(db);
+    return width;
+}
+
+TEST(MaxWidth, Bounded) {
+    EXPECT_EQ(6U, maxWidth({pattern("foobar")}));
+    EXPECT_EQ(7U, maxWidth({pattern("a.{2,5}b", 0, 1), pattern("xyz", 0, 2)}));
+    EXPECT_EQ(5U, maxWidth({pattern("\\bfoo(d|ds)\\b", 0, 1)}));
+}
+
+TEST(MaxWidth, Unbounded) {
+    EXPECT_EQ(UINT_MAX, maxWidth({pattern("a.*b", HS_FLAG_DOTALL)}));
+    EXPECT_EQ(UINT_MAX, maxWidth({pattern("abc", 0, 1),
+                                  pattern("x+y", 0, 2)}));
+    EXPECT_EQ(UINT_MAX, maxWidth({pattern("abc", HS_FLAG_SINGLEMATCH)}));
+
+    hs_expr_ext ext;
+    memset(&ext, 0, sizeof(ext));
+    ext.flags = HS_EXT_FLAG_MIN_OFFSET;
+    ext.min_offset = 10;
+    EXPECT_EQ(UINT_MAX, maxWidth({pattern("abc", 0, 1, ext)}));
+}
+
+TEST(ParallelScan, SameMatchesAsScan) {
+    vector<pattern> patterns;
+    patterns.push_back(pattern("abc", 0, 1));
+    patterns.push_back(pattern("\\bab[a-c]{0,6}\\b", 0, 2));
+    patterns.push_back(pattern("^a", 0, 3));
+    patterns.push_back(pattern("c$", 0, 4));
+    patterns.push_back(pattern("b.{3}c\\B", HS_FLAG_DOTALL, 5));
+    patterns.push_back(pattern("(ca|b){2,4}", HS_FLAG_SOM_LEFTMOST, 6));
+
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db, &scratch));
+
+    mt19937 rng(17);
+    string data(1 << 20, '\0');
+    for (auto &c : data) {
+        c = "abc \n"[rng() % 5];
+    }
+    data.back() = 'c';
+
+    vector<Match> expected;
+    ASSERT_EQ(HS_SUCCESS, hs_scan(db, data.data(), data.size(), 0, scratch,
+                                  collect, &expected));
+    sort(expected.begin(), expected.end());
+    ASSERT_FALSE(expected.empty());
+
+    for (unsigned int threads = 1; threads <= 5; threads++) {
+        vector<Match> got;
+        ASSERT_EQ(HS_SUCCESS,
+                  hs_scan_parallel(db, data.data(), data.size(), threads,
+                                   scratch, collect, &got));
+        for (size_t i = 1; i < got.size(); i++) {
+            // Delivered in order of end offset.
+            ASSERT_LE(get<0>(got[i - 1]), get<0>(got[i]));
+        }
+        sort(got.begin(), got.end());
+        EXPECT_EQ(expected, got) << threads << " threads";
+    }
+
+    size_t count = 0;
+    EXPECT_EQ(HS_SCAN_TERMINATED,
+              hs_scan_parallel(db, data.data(), data.size(), 4, scratch,
+                               stopAfterTen, &count));
+    EXPECT_EQ(10U, count);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(ParallelScan, RejectsUnbounded) {
+    hs_database_t *db = buildDB("a.*b", 0, 1, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db, &scratch));
+
+    string data(1 << 20, 'a');
+    EXPECT_EQ(HS_INVALID, hs_scan_parallel(db, data.data(), data.size(), 4,
+                                           scratch, dummy_cb, nullptr));
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+} // namespace
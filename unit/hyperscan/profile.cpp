@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hs.h"
+#include "hs_profile.h"
+#include "test_util.h"
+
+using namespace std;
+
+TEST(Profile, AllocNoDatabase) {
+    hs_profile_t *profile = nullptr;
+    hs_error_t err = hs_alloc_profile(nullptr, &profile);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_TRUE(profile == nullptr);
+}
+
+TEST(Profile, AllocNoProfile) {
+    hs_database_t *db = buildDB("foobar", 0, 1, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    hs_error_t err = hs_alloc_profile(db, nullptr);
+    ASSERT_NE(HS_SUCCESS, err);
+
+    hs_free_database(db);
+}
+
+TEST(Profile, SetNoScratch) {
+    hs_error_t err = hs_set_scratch_profile(nullptr, nullptr);
+    ASSERT_NE(HS_SUCCESS, err);
+}
+
+TEST(Profile, EngineNoProfile) {
+    unsigned long long cycles = 0, events = 0;
+    hs_error_t err = hs_profile_engine(nullptr, 0, &cycles, &events);
+    ASSERT_NE(HS_SUCCESS, err);
+}
+
+#ifdef PROFILE_SUPPORT
+
+TEST(Profile, ChargesOwningPatterns) {
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo.*bar", 0, 10));
+    patterns.push_back(pattern("hatstand[^\\n]{2,20}teakettle", 0, 20));
+    patterns.push_back(pattern("neverpresent", 0, 30));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_profile_t *profile = nullptr;
+    err = hs_alloc_profile(db, &profile);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(profile != nullptr);
+
+    err = hs_set_scratch_profile(scratch, profile);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    string data;
+    for (size_t i = 0; i < 1000; i++) {
+        data += "foo hatstand xx teakettle bar ";
+    }
+
+    err = hs_scan(db, data.data(), data.size(), 0, scratch, dummy_cb,
+                  nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    vector<hs_profile_entry_t> entries(8);
+    unsigned int count = 0;
+    err = hs_profile_top(profile, entries.size(), entries.data(), &count);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_LE(count, 3U);
+    entries.resize(count);
+
+    // The patterns present in the data must have done some work; the one
+    // that is absent must have done none.
+    bool seen10 = false, seen20 = false;
+    for (const auto &e : entries) {
+        if (e.id == 10 || e.id == 20) {
+            EXPECT_LT(0ULL, e.events);
+            seen10 |= e.id == 10;
+            seen20 |= e.id == 20;
+        } else {
+            EXPECT_EQ(30U, e.id);
+            EXPECT_EQ(0ULL, e.events);
+            EXPECT_EQ(0ULL, e.cycles);
+        }
+    }
+    EXPECT_TRUE(seen10);
+    EXPECT_TRUE(seen20);
+
+    // Entries are ordered by decreasing cost.
+    for (size_t i = 1; i < entries.size(); i++) {
+        EXPECT_GE(entries[i - 1].cycles, entries[i].cycles);
+    }
+
+    // After a reset, nothing has been charged.
+    err = hs_reset_profile(profile);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_profile_top(profile, entries.size(), entries.data(), &count);
+    ASSERT_EQ(HS_SUCCESS, err);
+    for (unsigned int i = 0; i < count; i++) {
+        EXPECT_EQ(0ULL, entries[i].cycles);
+        EXPECT_EQ(0ULL, entries[i].events);
+    }
+
+    // A cloned scratch does not carry the profile.
+    hs_scratch_t *clone = nullptr;
+    err = hs_clone_scratch(scratch, &clone);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scan(db, data.data(), data.size(), 0, clone, dummy_cb, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_profile_top(profile, entries.size(), entries.data(), &count);
+    ASSERT_EQ(HS_SUCCESS, err);
+    for (unsigned int i = 0; i < count; i++) {
+        EXPECT_EQ(0ULL, entries[i].events);
+    }
+
+    hs_free_scratch(clone);
+    hs_set_scratch_profile(scratch, nullptr);
+    hs_free_profile(profile);
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(Profile, EngineOutOfRange) {
+    hs_database_t *db = buildDB("foo.*bar", 0, 10, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    hs_profile_t *profile = nullptr;
+    hs_error_t err = hs_alloc_profile(db, &profile);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(profile != nullptr);
+
+    unsigned long long cycles = 0, events = 0;
+    err = hs_profile_engine(profile, 0, nullptr, &events);
+    EXPECT_NE(HS_SUCCESS, err);
+
+    // Engine numbers past the last profiled engine are rejected.
+    err = hs_profile_engine(profile, ~0U, &cycles, &events);
+    EXPECT_EQ(HS_INVALID, err);
+
+    hs_free_profile(profile);
+    hs_free_database(db);
+}
+
+#else
+
+TEST(Profile, Unsupported) {
+    hs_database_t *db = buildDB("foobar", 0, 1, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    hs_profile_t *profile = nullptr;
+    hs_error_t err = hs_alloc_profile(db, &profile);
+    ASSERT_EQ(HS_INVALID, err);
+    EXPECT_TRUE(profile == nullptr);
+
+    hs_free_database(db);
+}
+
+#endif // PROFILE_SUPPORT
@@ -26,6 +26,8 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+#include <string>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -768,4 +770,96 @@ TEST(StreamUtil, StreamAllocUsage) {
     ASSERT_EQ(0, alloc3_called);
 }
 
+
+// Lowercase literal that never contains 'z', for the long literal tests.
+static
+string makeLongLiteral(size_t len) {
+    string lit;
+    unsigned seed = 1;
+    while (lit.size() < len) {
+        seed = seed * 1103515245 + 12345;
+        lit += (char)('a' + (seed >> 16) % 25);
+    }
+    return lit;
+}
+
+// Scans data in writes of write_len bytes and returns the matches.
+static
+vector<MatchRecord> scanInWrites(const hs_database_t *db, hs_scratch_t *scratch,
+                                 const string &data, size_t write_len) {
+    hs_stream_t *stream = nullptr;
+    hs_error_t err = hs_open_stream(db, 0, &stream);
+    EXPECT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    for (size_t off = 0; off < data.size(); off += write_len) {
+        size_t len = min(write_len, data.size() - off);
+        err = hs_scan_stream(stream, data.data() + off, len, 0, scratch,
+                             record_cb, (void *)&c);
+        EXPECT_EQ(HS_SUCCESS, err);
+    }
+    err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+    EXPECT_EQ(HS_SUCCESS, err);
+    return c.matches;
+}
+
+// A literal longer than the long literal hash window is tracked in stream
+// state, rather than kept whole in history.
+TEST(StreamUtil, long_literal_state) {
+    const string lit = makeLongLiteral(100);
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch(lit.c_str(), 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+    ASSERT_NE(nullptr, db);
+
+    size_t stream_size = 0;
+    ASSERT_EQ(HS_SUCCESS, hs_stream_size(db, &stream_size));
+    EXPECT_GT(lit.size(), stream_size);
+
+    string data = "zzz" + lit + "zzz";
+    for (const size_t write_len : {1, 7, 13, 64}) {
+        SCOPED_TRACE(write_len);
+        auto matches = scanInWrites(db, scratch, data, write_len);
+        ASSERT_EQ(1U, matches.size());
+        EXPECT_EQ(MatchRecord(3 + lit.size(), 0), matches[0]);
+
+        string bad = data;
+        bad[3 + lit.size() / 2] = 'z';
+        EXPECT_TRUE(scanInWrites(db, scratch, bad, write_len).empty());
+    }
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// A fixed-width pattern that starts with a literal longer than history keeps
+// the literal whole, rather than splitting it.
+TEST(StreamUtil, long_literal_mask) {
+    const string lit = makeLongLiteral(150);
+    const string expr = lit + "[0-9]{3}";
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch(expr.c_str(), 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+    ASSERT_NE(nullptr, db);
+
+    size_t stream_size = 0;
+    ASSERT_EQ(HS_SUCCESS, hs_stream_size(db, &stream_size));
+    EXPECT_GT(lit.size(), stream_size);
+
+    string data = "zzz" + lit + "123zzz" + lit + "12zzz";
+    for (const size_t write_len : {1, 7, 13, 64}) {
+        SCOPED_TRACE(write_len);
+        auto matches = scanInWrites(db, scratch, data, write_len);
+        ASSERT_EQ(1U, matches.size());
+        EXPECT_EQ(MatchRecord(3 + lit.size() + 3, 0), matches[0]);
+
+        string bad = data;
+        bad[3 + lit.size() / 2] = 'z';
+        EXPECT_TRUE(scanInWrites(db, scratch, bad, write_len).empty());
+    }
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
 }
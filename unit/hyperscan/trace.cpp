@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hs.h"
+#include "test_util.h"
+#include "util/scan_trace.h"
+
+using namespace std;
+
+namespace /* anonymous */ {
+
+static
+int stopAtFirst(unsigned int, unsigned long long, unsigned long long,
+                unsigned int, void *) {
+    return 1;
+}
+
+static
+vector<pair<TraceRecord, string>> readTrace(const string &fname) {
+    vector<pair<TraceRecord, string>> records;
+    TraceReader reader(fname);
+    TraceRecord rec;
+    string payload;
+    while (reader.next(rec, payload)) {
+        records.push_back(make_pair(rec, payload));
+    }
+    return records;
+}
+
+} // namespace
+
+TEST(ScanTrace, StartNoFile) {
+    hs_trace_t *trace = nullptr;
+    ASSERT_EQ(HS_INVALID, hs_trace_start(nullptr, &trace));
+    ASSERT_EQ(HS_INVALID, hs_trace_start("/nonexistent/dir/trace", &trace));
+    EXPECT_TRUE(trace == nullptr);
+}
+
+TEST(ScanTrace, Untraced) {
+    hs_database_t *db = buildDB("foobar", 0, 1, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db, &scratch));
+
+    CallBackContext c;
+    string data = "xxfoobarxx";
+    hs_error_t err = hs_trace_scan(nullptr, db, data.c_str(), data.size(), 0,
+                                   scratch, record_cb, &c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(1U, c.matches.size());
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(ScanTrace, RecordStreams) {
+    hs_database_t *db = buildDB("foo.*bar", 0, 1, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db, &scratch));
+
+    const string fname = "unit-hyperscan-trace.tmp";
+    hs_trace_t *trace = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_trace_start(fname.c_str(), &trace));
+
+    CallBackContext c;
+    hs_stream_t *stream = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_trace_open_stream(trace, db, 0, &stream));
+    ASSERT_EQ(HS_SUCCESS, hs_trace_scan_stream(trace, stream, "foo", 3, 0,
+                                               scratch, record_cb, &c));
+    hs_stream_t *copy = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_trace_copy_stream(trace, &copy, stream));
+    ASSERT_EQ(HS_SUCCESS, hs_trace_scan_stream(trace, stream, "bar", 3, 0,
+                                               scratch, record_cb, &c));
+    ASSERT_EQ(HS_SCAN_TERMINATED,
+              hs_trace_scan_stream(trace, copy, "barbar", 6, 0, scratch,
+                                   stopAtFirst, nullptr));
+    ASSERT_EQ(HS_SUCCESS, hs_trace_reset_stream(trace, stream, 0, nullptr,
+                                                nullptr, nullptr));
+    ASSERT_EQ(HS_SUCCESS, hs_trace_close_stream(trace, copy, nullptr,
+                                                nullptr, nullptr));
+    ASSERT_EQ(HS_SUCCESS, hs_trace_close_stream(trace, stream, scratch,
+                                                record_cb, &c));
+    ASSERT_EQ(HS_SUCCESS, hs_trace_stop(trace));
+    EXPECT_EQ(1U, c.matches.size());
+
+    auto records = readTrace(fname);
+    remove(fname.c_str());
+    ASSERT_EQ(9U, records.size());
+
+    // The database comes first, so that the trace can be replayed alone.
+    EXPECT_EQ(TRACE_DATABASE, records[0].first.op);
+    EXPECT_EQ(0U, records[0].first.id);
+    hs_database_t *db2 = nullptr;
+    ASSERT_EQ(HS_SUCCESS,
+              hs_deserialize_database(records[0].second.data(),
+                                      records[0].second.size(), &db2));
+    hs_free_database(db2);
+
+    EXPECT_EQ(TRACE_OPEN_STREAM, records[1].first.op);
+    EXPECT_EQ(0U, records[1].first.id);
+    EXPECT_EQ(0U, records[1].first.aux);
+
+    EXPECT_EQ(TRACE_SCAN_STREAM, records[2].first.op);
+    EXPECT_EQ("foo", records[2].second);
+    EXPECT_EQ(0U, records[2].first.matches);
+
+    EXPECT_EQ(TRACE_COPY_STREAM, records[3].first.op);
+    EXPECT_EQ(1U, records[3].first.id);
+    EXPECT_EQ(0U, records[3].first.aux);
+
+    EXPECT_EQ(TRACE_SCAN_STREAM, records[4].first.op);
+    EXPECT_EQ(0U, records[4].first.id);
+    EXPECT_EQ(1U, records[4].first.matches);
+
+    EXPECT_EQ(TRACE_SCAN_STREAM, records[5].first.op);
+    EXPECT_EQ(1U, records[5].first.id);
+    EXPECT_EQ(HS_SCAN_TERMINATED, records[5].first.result);
+    EXPECT_EQ(1U, records[5].first.matches);
+
+    EXPECT_EQ(TRACE_RESET_STREAM, records[6].first.op);
+    EXPECT_EQ(0U, records[6].first.aux);
+
+    EXPECT_EQ(TRACE_CLOSE_STREAM, records[7].first.op);
+    EXPECT_EQ(1U, records[7].first.id);
+    EXPECT_EQ(0U, records[7].first.aux);
+
+    EXPECT_EQ(TRACE_CLOSE_STREAM, records[8].first.op);
+    EXPECT_EQ(0U, records[8].first.id);
+    EXPECT_EQ(1U, records[8].first.aux);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
@@ -36,6 +36,7 @@
 #include "fdr/fdr_engine_description.h"
 #include "fdr/teddy_compile.h"
 #include "fdr/teddy_engine_description.h"
+#include "hwlm/hwlm_build.h"
 #include "util/alloc.h"
 
 #include "database.h"
@@ -530,6 +531,248 @@ TEST_P(FDRp, Stream1) {
     }
 }
 
+TEST_P(FDRp, MixedCase) {
+    const u32 hint = GetParam();
+    SCOPED_TRACE(hint);
+
+    const char data[] = "CONTENT-Length content-length Content-LENGTH "
+                        "cOnTeNt-Length XY xy Xy xY abcDEFGHIJKL ABCDEFGHIJKL "
+                        "ABCdefghijkl";
+
+    vector<bool> nc1(14, false), nc3(12, true);
+    fill(nc1.begin(), nc1.begin() + 8, true); // (?i:content-)Length
+    fill(nc3.begin(), nc3.begin() + 3, false); // ABC(?i:defghijkl)
+
+    vector<hwlmLiteral> lits;
+    lits.push_back(hwlmLiteral("content-Length", nc1, false, 1,
+                               HWLM_ALL_GROUPS, {}, {}));
+    lits.push_back(hwlmLiteral("xY", {true, false}, false, 2,
+                               HWLM_ALL_GROUPS, {}, {}));
+    lits.push_back(hwlmLiteral("ABCdefghijkl", nc3, false, 3,
+                               HWLM_ALL_GROUPS, {}, {}));
+    for (const auto &lit : lits) {
+        ASSERT_TRUE(lit.isMixedCase());
+    }
+
+    auto fdr = fdrBuildTableHinted(lits, false, hint, get_current_target(), Grey());
+    CHECK_WITH_TEDDY_OK_TO_FAIL(fdr, hint);
+
+    vector<match> matches;
+    fdrExec(fdr.get(), (const u8 *)data, sizeof(data) - 1, 0, decentCallback,
+            &matches, HWLM_ALL_GROUPS);
+    sort(matches.begin(), matches.end());
+
+    ASSERT_EQ(6U, matches.size());
+    EXPECT_EQ(match(0, 13, 1), matches[0]);
+    EXPECT_EQ(match(45, 58, 1), matches[1]);
+    EXPECT_EQ(match(60, 61, 2), matches[2]);
+    EXPECT_EQ(match(69, 70, 2), matches[3]);
+    EXPECT_EQ(match(85, 96, 3), matches[4]);
+    EXPECT_EQ(match(98, 109, 3), matches[5]);
+
+    // The case-sensitive prefix must also be confirmed against history.
+    const char hist1[] = "xxABCdef";
+    const char hist2[] = "xxABcdef";
+    const char data2[] = "GHIJKL";
+    for (const char *hist : {hist1, hist2}) {
+        matches.clear();
+        fdrExecStreaming(fdr.get(), (const u8 *)hist, strlen(hist),
+                         (const u8 *)data2, strlen(data2), 0, decentCallback,
+                         &matches, HWLM_ALL_GROUPS, nullptr);
+        if (hist == hist1) {
+            ASSERT_EQ(1U, matches.size());
+            EXPECT_EQ(5U, matches[0].end);
+            EXPECT_EQ(3U, matches[0].id);
+        } else {
+            EXPECT_TRUE(matches.empty());
+        }
+    }
+}
+
+TEST_P(FDRp, MixedCaseFlood) {
+    const u32 hint = GetParam();
+    SCOPED_TRACE(hint);
+
+    vector<hwlmLiteral> lits;
+    lits.push_back(hwlmLiteral("Aaaa", {false, true, true, true}, false, 1,
+                               HWLM_ALL_GROUPS, {}, {}));
+    lits.push_back(hwlmLiteral("bbbbbbbbbB", vector<bool>(10, true), false, 2,
+                               HWLM_ALL_GROUPS, {}, {}));
+
+    auto fdr = fdrBuildTableHinted(lits, false, hint, get_current_target(), Grey());
+    CHECK_WITH_TEDDY_OK_TO_FAIL(fdr, hint);
+
+    const size_t len = 256;
+    vector<match> matches;
+
+    // A flood of the wrong case never matches the case-sensitive char.
+    vector<u8> data(len, 'a');
+    fdrExec(fdr.get(), data.data(), len, 0, decentCallback, &matches,
+            HWLM_ALL_GROUPS);
+    EXPECT_TRUE(matches.empty());
+
+    data[100] = 'A';
+    fdrExec(fdr.get(), data.data(), len, 0, decentCallback, &matches,
+            HWLM_ALL_GROUPS);
+    ASSERT_EQ(1U, matches.size());
+    EXPECT_EQ(match(100, 103, 1), matches[0]);
+
+    // A flood of the right case matches everywhere.
+    matches.clear();
+    data.assign(len, 'A');
+    fdrExec(fdr.get(), data.data(), len, 0, decentCallback, &matches,
+            HWLM_ALL_GROUPS);
+    EXPECT_EQ(len - 3, matches.size());
+
+    // A literal that is caseless throughout is not mixed-case, and floods in
+    // either case.
+    EXPECT_FALSE(lits[1].isMixedCase());
+    matches.clear();
+    data.assign(len, 'b');
+    fdrExec(fdr.get(), data.data(), len, 0, decentCallback, &matches,
+            HWLM_ALL_GROUPS);
+    EXPECT_EQ(len - 9, matches.size());
+}
+
+/** Pseudo-random lowercase literal of \a len chars that never contains 'z'. */
+static
+string makeLongLiteral(size_t len) {
+    string lit;
+    u32 seed = 1;
+    while (lit.size() < len) {
+        seed = seed * 1103515245 + 12345;
+        lit += (char)('a' + (seed >> 16) % 25);
+    }
+    return lit;
+}
+
+TEST_P(FDRp, LongLiteralStreaming) {
+    const u32 hint = GetParam();
+    SCOPED_TRACE(hint);
+
+    // A literal much longer than the history we keep between writes.
+    const string long_lit = makeLongLiteral(200);
+
+    vector<hwlmLiteral> lits;
+    lits.push_back(hwlmLiteral("zzzz", false, 0));
+    lits.push_back(hwlmLiteral(long_lit, false, 1));
+
+    Grey grey;
+    hwlmStreamingControl ctl;
+    ctl.history_max = 60;
+    ctl.history_min = 0;
+    auto fdr = fdrBuildTableHinted(lits, false, hint, get_current_target(),
+                                   grey, &ctl);
+    CHECK_WITH_TEDDY_OK_TO_FAIL(fdr, hint);
+
+    // Only the hash window is needed in history, not the whole literal.
+    ASSERT_EQ(grey.fdrLongLitHashLen, ctl.literal_history_required);
+    ASSERT_LT(0U, ctl.literal_stream_state_required);
+    const size_t hist_len = ctl.literal_history_required;
+
+    string data = "zzzz" + long_lit + "zz";
+    for (const size_t write_len : {7, 13, 40}) {
+        for (bool mutate : {false, true}) {
+            string input = data;
+            if (mutate) {
+                input[4 + long_lit.size() / 2] = 'Q';
+            }
+
+            vector<match> matches;
+            vector<u8> state(ctl.literal_stream_state_required, 0);
+            for (size_t off = 0; off < input.size(); off += write_len) {
+                size_t hlen = min(off, hist_len);
+                size_t len = min(write_len, input.size() - off);
+                const u8 *buf = (const u8 *)input.data() + off;
+                vector<match> write_matches;
+                fdrExecStreaming(fdr.get(), buf - hlen, hlen, buf, len, 0,
+                                 decentCallback, &write_matches,
+                                 HWLM_ALL_GROUPS, state.data());
+                for (auto &m : write_matches) {
+                    if (m.id == 1) {
+                        matches.push_back(match(0, m.end + off, m.id));
+                    }
+                }
+            }
+
+            if (mutate) {
+                EXPECT_TRUE(matches.empty());
+            } else {
+                ASSERT_EQ(1U, matches.size());
+                EXPECT_EQ(4 + long_lit.size() - 1, matches[0].end);
+            }
+        }
+    }
+}
+
+TEST_P(FDRp, MixedCaseStreaming) {
+    const u32 hint = GetParam();
+    SCOPED_TRACE(hint);
+
+    // ABCDE(?i:fghijklmnopqrst): longer than the long literal hash window,
+    // but mixed-case literals must not go in the long literal table.
+    const string mixed_lit = "ABCDEfghijklmnopqrst";
+    vector<bool> nc(mixed_lit.size(), true);
+    fill(nc.begin(), nc.begin() + 5, false);
+
+    const string long_lit = makeLongLiteral(200);
+
+    vector<hwlmLiteral> lits;
+    lits.push_back(hwlmLiteral(mixed_lit, nc, false, 1, HWLM_ALL_GROUPS, {},
+                               {}));
+    lits.push_back(hwlmLiteral(long_lit, false, 2));
+    ASSERT_TRUE(lits[0].isMixedCase());
+
+    Grey grey;
+    ASSERT_LT(grey.fdrLongLitHashLen, mixed_lit.size());
+    hwlmStreamingControl ctl;
+    ctl.history_max = 60;
+    ctl.history_min = 0;
+    auto fdr = fdrBuildTableHinted(lits, false, hint, get_current_target(),
+                                   grey, &ctl);
+    CHECK_WITH_TEDDY_OK_TO_FAIL(fdr, hint);
+
+    // Enough history is kept to confirm the whole mixed-case literal.
+    ASSERT_LE(mixed_lit.size() - 1, ctl.literal_history_required);
+    const size_t hist_len = ctl.literal_history_required;
+
+    // The case-sensitive prefix is in history when the match is reported.
+    const string good1 = "ABCDEfghijklmnopqrst";
+    const string good2 = "ABCDEFGHIJKLMNOPQRST";
+    const string bad1 = "abcdefghijklmnopqrst";
+    const string bad2 = "ABCdEfghijklmnopqrst";
+    for (const string &lit : {good1, good2, bad1, bad2}) {
+        const bool expect_match = lit == good1 || lit == good2;
+        const string input = "zz" + lit + "zz";
+        for (const size_t write_len : {7, 13}) {
+            SCOPED_TRACE(lit);
+            SCOPED_TRACE(write_len);
+            vector<match> matches;
+            vector<u8> state(ctl.literal_stream_state_required, 0);
+            for (size_t off = 0; off < input.size(); off += write_len) {
+                size_t hlen = min(off, hist_len);
+                size_t len = min(write_len, input.size() - off);
+                const u8 *buf = (const u8 *)input.data() + off;
+                vector<match> write_matches;
+                fdrExecStreaming(fdr.get(), buf - hlen, hlen, buf, len, 0,
+                                 decentCallback, &write_matches,
+                                 HWLM_ALL_GROUPS, state.data());
+                for (auto &m : write_matches) {
+                    matches.push_back(match(0, m.end + off, m.id));
+                }
+            }
+
+            if (expect_match) {
+                ASSERT_EQ(1U, matches.size());
+                EXPECT_EQ(2 + mixed_lit.size() - 1, matches[0].end);
+                EXPECT_EQ(1U, matches[0].id);
+            } else {
+                EXPECT_TRUE(matches.empty());
+            }
+        }
+    }
+}
+
 INSTANTIATE_TEST_CASE_P(FDR, FDRp, ValuesIn(getValidFdrEngines()));
 
 typedef struct {
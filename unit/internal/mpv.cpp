@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "gtest/gtest.h"
+
+#include "grey.h"
+#include "nfa/mpv_internal.h"
+#include "nfa/mpvcompile.h"
+#include "nfa/nfa_api.h"
+#include "nfa/nfa_api_queue.h"
+#include "nfa/nfa_internal.h"
+#include "util/alloc.h"
+#include "util/charreach.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace ue2;
+
+typedef vector<pair<unsigned long long, ReportID>> MatchList;
+
+static
+int recordMatch(u64a offset, ReportID id, void *ctx) {
+    MatchList *matches = (MatchList *)ctx;
+    matches->push_back(make_pair(offset, id));
+    return MO_CONTINUE_MATCHING;
+}
+
+/* Two kilos of different reach, 21 puffettes in all. With the sentinels
+ * between them, neither kilo starts or ends on a four-lane boundary, and each
+ * mixes bounded and unbounded puffettes, including repeated thresholds. */
+static
+vector<raw_puff> makePuffs() {
+    vector<raw_puff> puffs;
+    const CharReach reach_a = ~CharReach('z');
+    for (u32 i = 1; i <= 12; i++) {
+        puffs.push_back(raw_puff(i, i % 3 == 0, 100 + i, reach_a));
+    }
+
+    const CharReach reach_b = ~CharReach('y');
+    const u32 repeats_b[] = {2, 3, 3, 5, 8, 9, 10, 13, 21};
+    for (u32 i = 0; i < ARRAY_LENGTH(repeats_b); i++) {
+        puffs.push_back(raw_puff(repeats_b[i], i % 2, 200 + i, reach_b));
+    }
+    return puffs;
+}
+
+static
+MatchList runMpv(const NFA *nfa, const string &corpus) {
+    auto full_state = aligned_zmalloc_unique<char>(nfa->scratchStateSize);
+    auto stream_state = aligned_zmalloc_unique<char>(nfa->streamStateSize);
+
+    MatchList matches;
+
+    struct mq q;
+    q.nfa = nfa;
+    q.cur = 0;
+    q.end = 0;
+    q.state = full_state.get();
+    q.streamState = stream_state.get();
+    q.offset = 0;
+    q.buffer = (const u8 *)corpus.c_str();
+    q.length = corpus.length();
+    q.history = nullptr;
+    q.hlength = 0;
+    q.scratch = nullptr; // not needed by MPV
+    q.report_current = 0;
+    q.cb = recordMatch;
+    q.som_cb = nullptr;
+    q.context = &matches;
+
+    u64a end = corpus.length();
+    nfaQueueInitState(nfa, &q);
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_TOP, 0);
+    pushQueue(&q, MQE_END, end);
+    nfaQueueExec(nfa, &q, end);
+
+    return matches;
+}
+
+TEST(MPV, BatchedReportsMatchScalar) {
+    const vector<raw_puff> puffs = makePuffs();
+    ASSERT_LE(16U, puffs.size());
+
+    Grey grey;
+    aligned_unique_ptr<NFA> batched = mpvCompile(puffs, {}, grey);
+    ASSERT_TRUE(batched != nullptr);
+    ASSERT_NE(0U, ((const mpv *)getImplNfa(batched.get()))->batch_offset);
+
+    grey.mpvBatchMinPuffettes = ~0U;
+    aligned_unique_ptr<NFA> scalar = mpvCompile(puffs, {}, grey);
+    ASSERT_TRUE(scalar != nullptr);
+    ASSERT_EQ(0U, ((const mpv *)getImplNfa(scalar.get()))->batch_offset);
+
+    // The second kilo dies at the 'y'; the first runs to the end.
+    const string corpus = string(17, 'a') + "y" + string(12, 'b');
+
+    MatchList expected = runMpv(scalar.get(), corpus);
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ(expected, runMpv(batched.get(), corpus));
+}
+
+TEST(MPV, BatchedReportsAfterEscape) {
+    const vector<raw_puff> puffs = makePuffs();
+
+    Grey grey;
+    aligned_unique_ptr<NFA> batched = mpvCompile(puffs, {}, grey);
+    ASSERT_TRUE(batched != nullptr);
+
+    grey.mpvBatchMinPuffettes = ~0U;
+    aligned_unique_ptr<NFA> scalar = mpvCompile(puffs, {}, grey);
+    ASSERT_TRUE(scalar != nullptr);
+
+    // An early 'z' kills the first kilo, leaving only the second to report.
+    for (size_t len = 0; len < 30; len++) {
+        const string corpus = "cc" + string("z") + string(len, 'c');
+        SCOPED_TRACE(len);
+        EXPECT_EQ(runMpv(scalar.get(), corpus),
+                  runMpv(batched.get(), corpus));
+    }
+}
@@ -160,3 +160,25 @@ TYPED_TEST(PackBits, Holes) {
         test_pack_and_unpack(v, bits);
     }
 }
+
+TYPED_TEST(PackBits, Mixed) {
+    const u32 max_bits = sizeof(TypeParam) * 8U;
+    for (u32 i = 1; i < 32; i++) {
+        SCOPED_TRACE(i);
+
+        // Distinct values in each word, with bit counts that leave elements
+        // straddling byte and word boundaries in the packed output. The
+        // pack functions expect only the low bits[j] bits to be set.
+        vector<TypeParam> v(i);
+        vector<u32> bits(i);
+        for (u32 j = 0; j < i; j++) {
+            bits[j] = (j * 7 + i) % (max_bits + 1);
+            v[j] = (TypeParam)(0x9e3779b97f4a7c15ULL * (j + 1));
+            if (bits[j] < max_bits) {
+                v[j] &= ((TypeParam)1U << bits[j]) - 1;
+            }
+        }
+
+        test_pack_and_unpack(v, bits);
+    }
+}
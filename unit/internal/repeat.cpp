@@ -184,6 +184,19 @@ static const RepeatTestInfo repeatTests[] = {
     { REPEAT_TRAILER, 50, 200 },
     { REPEAT_TRAILER, 50, 1000 },
     { REPEAT_TRAILER, 64, 1024 },
+    // {N,M} repeats -- window model
+    { REPEAT_WINDOW, 0, 8 },
+    { REPEAT_WINDOW, 1, 2 },
+    { REPEAT_WINDOW, 10, 20 },
+    { REPEAT_WINDOW, 64, 64 },
+    { REPEAT_WINDOW, 65, 100 },
+    { REPEAT_WINDOW, 100, 2000 },
+    { REPEAT_WINDOW, 127, 129 },
+    { REPEAT_WINDOW, 128, 128 },
+    { REPEAT_WINDOW, 129, 300 },
+    { REPEAT_WINDOW, 200, 1000 },
+    { REPEAT_WINDOW, 256, 256 },
+    { REPEAT_WINDOW, 256, 4000 },
     // {N,} repeats -- first model
     { REPEAT_FIRST, 0, depth::infinity() },
     { REPEAT_FIRST, 1, depth::infinity() },
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include "gtest/gtest.h"
+
+#include "database.h"
+#include "grey.h"
+#include "hs.h"
+#include "hs_internal.h"
+#include "rose/rose_internal.h"
+#include "util/compare.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace ue2;
+
+namespace {
+
+struct AnchoredPattern {
+    string expr;
+    unsigned flags;
+    string lit; //!< literal the pattern matches at the start of the data
+    bool nocase;
+};
+
+typedef pair<unsigned long long, unsigned> Match; // (to, id)
+
+int recordMatch(unsigned id, unsigned long long, unsigned long long to,
+                unsigned, void *ctx) {
+    ((vector<Match> *)ctx)->push_back(Match(to, id));
+    return 0;
+}
+
+hs_database_t *compileWithGrey(const vector<AnchoredPattern> &patterns,
+                               const Grey &grey) {
+    vector<const char *> exprs;
+    vector<unsigned> flags;
+    vector<unsigned> ids;
+    for (unsigned i = 0; i < patterns.size(); i++) {
+        exprs.push_back(patterns[i].expr.c_str());
+        flags.push_back(patterns[i].flags);
+        ids.push_back(i);
+    }
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_multi_int(exprs.data(), flags.data(),
+                                          ids.data(), nullptr, exprs.size(),
+                                          HS_MODE_BLOCK, nullptr, &db,
+                                          &compile_err, grey);
+    if (err != HS_SUCCESS) {
+        hs_free_compile_error(compile_err);
+        return nullptr;
+    }
+    return db;
+}
+
+const RoseEngine *getRose(const hs_database_t *db) {
+    return (const RoseEngine *)hs_get_bytecode(db);
+}
+
+vector<Match> scan(const hs_database_t *db, hs_scratch_t *scratch,
+                   const string &data) {
+    vector<Match> matches;
+    hs_error_t err = hs_scan(db, data.c_str(), data.size(), 0, scratch,
+                             recordMatch, &matches);
+    EXPECT_EQ(HS_SUCCESS, err);
+    sort(matches.begin(), matches.end());
+    return matches;
+}
+
+/** Literals with common prefixes and a spread of lengths, so that several
+ * share each hash bucket. Every third is caseless, and every fifth must start
+ * four bytes into the data. */
+vector<AnchoredPattern> makePatterns(unsigned count) {
+    vector<AnchoredPattern> patterns;
+    for (unsigned i = 0; i < count; i++) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "GET /%s%u", i % 2 ? "item" : "i", i);
+        AnchoredPattern p;
+        p.lit = buf;
+        p.nocase = i % 3 == 0;
+        p.flags = p.nocase ? HS_FLAG_CASELESS : 0;
+        string escaped = p.lit;
+        escaped.replace(escaped.find('/'), 1, "\\/");
+        if (i % 5 == 0) {
+            p.expr = "^.{4}" + escaped;
+            p.lit = "xxxx" + p.lit;
+            p.flags |= HS_FLAG_DOTALL;
+        } else {
+            p.expr = "^" + escaped;
+        }
+        patterns.push_back(p);
+    }
+    return patterns;
+}
+
+/** Matches expected for the data: each pattern whose literal starts it. */
+vector<Match> expectedMatches(const vector<AnchoredPattern> &patterns,
+                              const string &data) {
+    vector<Match> matches;
+    for (unsigned i = 0; i < patterns.size(); i++) {
+        const string &lit = patterns[i].lit;
+        if (lit.size() > data.size()) {
+            continue;
+        }
+        // The ".{4}" of offset patterns matches anything.
+        size_t skip = lit.compare(0, 4, "xxxx") ? 0 : 4;
+        if (!cmpForward((const u8 *)data.c_str() + skip,
+                        (const u8 *)lit.c_str() + skip, lit.size() - skip,
+                        patterns[i].nocase)) {
+            matches.push_back(Match(lit.size(), i));
+        }
+    }
+    sort(matches.begin(), matches.end());
+    return matches;
+}
+
+TEST(AnchoredLitTable, MatchesDfaPath) {
+    const auto patterns = makePatterns(100);
+
+    Grey grey_table;
+    grey_table.allowSmallWrite = false; // scan through Rose for short data
+    ASSERT_LE(grey_table.minAnchoredLitTable, patterns.size());
+    Grey grey_dfa = grey_table;
+    grey_dfa.allowAnchoredLitTable = false;
+
+    hs_database_t *db_table = compileWithGrey(patterns, grey_table);
+    ASSERT_NE(nullptr, db_table);
+    hs_database_t *db_dfa = compileWithGrey(patterns, grey_dfa);
+    ASSERT_NE(nullptr, db_dfa);
+
+    EXPECT_NE(0U, getRose(db_table)->altableOffset);
+    EXPECT_EQ(0U, getRose(db_dfa)->altableOffset);
+
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db_table, &scratch));
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db_dfa, &scratch));
+
+    vector<string> corpora;
+    for (const auto &p : patterns) {
+        string lower = p.lit;
+        transform(lower.begin(), lower.end(), lower.begin(), mytolower);
+        string mangled = p.lit;
+        mangled[mangled.size() - 1] ^= 0x40; // changes the last digit
+        for (const string &s : {p.lit, lower, mangled}) {
+            corpora.push_back(s);
+            corpora.push_back(s + "0");
+            corpora.push_back(s + " HTTP/1.1 and some padding here");
+            corpora.push_back("y" + s);
+        }
+    }
+
+    unsigned total = 0;
+    for (const string &data : corpora) {
+        SCOPED_TRACE(data);
+        auto expected = expectedMatches(patterns, data);
+        EXPECT_EQ(expected, scan(db_table, scratch, data));
+        EXPECT_EQ(expected, scan(db_dfa, scratch, data));
+        total += expected.size();
+    }
+    EXPECT_LT(0U, total);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db_table);
+    hs_free_database(db_dfa);
+}
+
+TEST(AnchoredLitTable, BelowThreshold) {
+    Grey grey;
+    grey.allowSmallWrite = false;
+    const auto patterns = makePatterns(grey.minAnchoredLitTable - 1);
+
+    hs_database_t *db = compileWithGrey(patterns, grey);
+    ASSERT_NE(nullptr, db);
+    EXPECT_EQ(0U, getRose(db)->altableOffset);
+
+    // Lowering the threshold through the grey box brings the table in.
+    grey.minAnchoredLitTable = patterns.size();
+    hs_database_t *db_table = compileWithGrey(patterns, grey);
+    ASSERT_NE(nullptr, db_table);
+    EXPECT_NE(0U, getRose(db_table)->altableOffset);
+
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db, &scratch));
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db_table, &scratch));
+    for (const auto &p : patterns) {
+        SCOPED_TRACE(p.lit);
+        auto expected = expectedMatches(patterns, p.lit);
+        ASSERT_FALSE(expected.empty());
+        EXPECT_EQ(expected, scan(db, scratch, p.lit));
+        EXPECT_EQ(expected, scan(db_table, scratch, p.lit));
+    }
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+    hs_free_database(db_table);
+}
+
+} // namespace
@@ -128,7 +128,8 @@ const u32 sidecarModels[] = {
     SIDECAR_128,
     SIDECAR_256,
     SIDECAR_N,
-    SIDECAR_S
+    SIDECAR_S,
+    SIDECAR_512
 };
 
 // Number of elements we can handle in each model
@@ -139,7 +140,8 @@ const u32 sidecarSizes[] = {
     128,
     256,
     1,
-    8
+    8,
+    512
 };
 
 // Parameterized test case for string of single-byte classes
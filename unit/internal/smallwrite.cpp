@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include "gtest/gtest.h"
+
+#include "database.h"
+#include "grey.h"
+#include "hs.h"
+#include "hs_internal.h"
+#include "rose/rose_internal.h"
+#include "smallwrite/smallwrite_internal.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace ue2;
+
+namespace {
+
+typedef pair<unsigned long long, unsigned> Match; // (to, id)
+
+int recordMatch(unsigned id, unsigned long long, unsigned long long to,
+                unsigned, void *ctx) {
+    ((vector<Match> *)ctx)->push_back(Match(to, id));
+    return 0;
+}
+
+hs_database_t *compileWithGrey(const vector<string> &exprs, unsigned flags,
+                               const Grey &grey) {
+    vector<const char *> expr_ptrs;
+    vector<unsigned> flag_vals;
+    vector<unsigned> ids;
+    for (unsigned i = 0; i < exprs.size(); i++) {
+        expr_ptrs.push_back(exprs[i].c_str());
+        flag_vals.push_back(flags);
+        ids.push_back(i);
+    }
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_multi_int(expr_ptrs.data(), flag_vals.data(),
+                                          ids.data(), nullptr,
+                                          expr_ptrs.size(), HS_MODE_BLOCK,
+                                          nullptr, &db, &compile_err, grey);
+    if (err != HS_SUCCESS) {
+        hs_free_compile_error(compile_err);
+        return nullptr;
+    }
+    return db;
+}
+
+const SmallWriteEngine *getSmwr(const hs_database_t *db) {
+    return getSmallWrite((const RoseEngine *)hs_get_bytecode(db));
+}
+
+vector<Match> scan(const hs_database_t *db, hs_scratch_t *scratch,
+                   const string &data) {
+    vector<Match> matches;
+    hs_error_t err = hs_scan(db, data.c_str(), data.size(), 0, scratch,
+                             recordMatch, &matches);
+    EXPECT_EQ(HS_SUCCESS, err);
+    return matches;
+}
+
+bool offsetOrdered(const vector<Match> &matches) {
+    for (size_t i = 1; i < matches.size(); i++) {
+        if (matches[i].first < matches[i - 1].first) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Random inputs over the given alphabet, of every length up to max_len. */
+vector<string> makeCorpora(const string &alphabet, size_t max_len) {
+    mt19937 rng(17);
+    uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+    vector<string> corpora;
+    for (size_t len = 1; len <= max_len; len++) {
+        for (u32 n = 0; n < 4; n++) {
+            string s(len, ' ');
+            for (char &c : s) {
+                c = alphabet[pick(rng)];
+            }
+            corpora.push_back(s);
+        }
+    }
+    return corpora;
+}
+
+/** Checks that a database built with small write gives the same matches as
+ * one built without it, over every input in the corpora. */
+void checkAgainstRose(const vector<string> &exprs, unsigned flags,
+                      const vector<string> &corpora) {
+    Grey grey_rose;
+    grey_rose.allowSmallWrite = false;
+
+    hs_database_t *db_smwr = compileWithGrey(exprs, flags, Grey());
+    ASSERT_NE(nullptr, db_smwr);
+    hs_database_t *db_rose = compileWithGrey(exprs, flags, grey_rose);
+    ASSERT_NE(nullptr, db_rose);
+    ASSERT_EQ(nullptr, getSmwr(db_rose));
+
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db_smwr, &scratch));
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db_rose, &scratch));
+
+    for (const string &data : corpora) {
+        SCOPED_TRACE(data);
+        auto smwr_matches = scan(db_smwr, scratch, data);
+        EXPECT_TRUE(offsetOrdered(smwr_matches));
+        auto rose_matches = scan(db_rose, scratch, data);
+        sort(smwr_matches.begin(), smwr_matches.end());
+        sort(rose_matches.begin(), rose_matches.end());
+        EXPECT_EQ(rose_matches, smwr_matches);
+    }
+
+    hs_free_scratch(scratch);
+    hs_free_database(db_smwr);
+    hs_free_database(db_rose);
+}
+
+// Each /x.{10}y/ needs a DFA of about 2^11 states to track recent x's, so no
+// two of them can be merged under DFA_MERGE_MAX_STATES.
+const vector<string> wideExprs = {"a.{10}X", "c.{10}Y", "e.{10}Z"};
+
+TEST(SmallWrite, MultiDfa) {
+    hs_database_t *db = compileWithGrey(wideExprs, HS_FLAG_DOTALL, Grey());
+    ASSERT_NE(nullptr, db);
+    const SmallWriteEngine *smwr = getSmwr(db);
+    ASSERT_NE(nullptr, smwr);
+    EXPECT_LT(1U, smwr->nfaCount);
+    EXPECT_GE((u32)SMWR_MAX_NFAS, smwr->nfaCount);
+    const size_t largest = smwr->largestBuffer;
+    hs_free_database(db);
+
+    // Inputs either side of the small write limit.
+    checkAgainstRose(wideExprs, HS_FLAG_DOTALL,
+                     makeCorpora("aceXYZ-", largest + 16));
+}
+
+TEST(SmallWrite, MultiDfaMatchOverflow) {
+    // Dense patterns matching at every byte fill the buffer used to order
+    // matches between DFAs, so the engine must hand the block back to Rose.
+    vector<string> exprs = wideExprs;
+    for (u32 i = 0; i < 8; i++) {
+        exprs.push_back(".");
+    }
+
+    hs_database_t *db = compileWithGrey(exprs, HS_FLAG_DOTALL, Grey());
+    ASSERT_NE(nullptr, db);
+    const SmallWriteEngine *smwr = getSmwr(db);
+    ASSERT_NE(nullptr, smwr);
+    EXPECT_LT(1U, smwr->nfaCount);
+    const size_t largest = smwr->largestBuffer;
+    hs_free_database(db);
+
+    ASSERT_LT((size_t)SMWR_MATCH_BUF_SIZE, (largest - 1) * 8);
+    checkAgainstRose(exprs, HS_FLAG_DOTALL,
+                     makeCorpora("aceXYZ-", largest - 1));
+}
+
+TEST(SmallWrite, ManyLiterals) {
+    // Enough literals that they are merged in several chunks.
+    mt19937 rng(5);
+    uniform_int_distribution<int> letter('a', 'h');
+    uniform_int_distribution<size_t> len(3, 6);
+    vector<string> exprs;
+    for (u32 i = 0; i < 120; i++) {
+        string s(len(rng), ' ');
+        for (char &c : s) {
+            c = (char)letter(rng);
+        }
+        exprs.push_back(s);
+    }
+
+    checkAgainstRose(exprs, 0, makeCorpora("abcdefgh", 80));
+}
+
+} // namespace
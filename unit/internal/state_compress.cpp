@@ -29,6 +29,7 @@
 #include "config.h"
 
 #include "gtest/gtest.h"
+#include "util/popcount.h"
 #include "util/state_compress.h"
 
 #include <vector>
@@ -36,6 +37,22 @@
 
 using namespace std;
 
+// Builds the layout that the LimEx compiler would precompute for this mask.
+static
+compress_chunks makeChunks(const void *mask, u32 chunks) {
+    compress_chunks c;
+    memset(&c, 0, sizeof(c));
+    u64a m[8];
+    memcpy(m, mask, chunks * sizeof(u64a));
+    u32 offset = 0;
+    for (u32 i = 0; i < chunks; i++) {
+        c.bits[i] = popcount64(m[i]);
+        c.offset[i] = offset;
+        offset += c.bits[i];
+    }
+    return c;
+}
+
 TEST(state_compress, u32) {
     char buf[sizeof(u32)] = { 0 };
     vector<tuple<u32, u32, int> > tests = {
@@ -408,3 +425,65 @@ TEST(state_compress, m512_2) {
         }
     }
 }
+
+TEST(state_compress, m128_chunks) {
+    char val_raw[16] = { '0', '1', '2', '3', '4', '5', '6', '7',
+                         '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
+    m128 val;
+    memcpy(&val, val_raw, sizeof(val));
+
+    for (u32 i = 0; i < 16; i++) {
+        char mask_raw[16];
+        memset(mask_raw, 0x5a, sizeof(mask_raw));
+        memset(mask_raw, 0, i);
+        mask_raw[15 - i] = 0xff;
+
+        m128 mask;
+        memcpy(&mask, mask_raw, sizeof(mask));
+        compress_chunks c = makeChunks(&mask, 2);
+
+        char buf[sizeof(m128)] = { 0 };
+        char buf_chunks[sizeof(m128)] = { 0 };
+        storecompressed128(&buf, &val, &mask, 0);
+        storecompressed128_chunks(&buf_chunks, &val, &mask, &c);
+        EXPECT_EQ(0, memcmp(buf, buf_chunks, sizeof(buf)));
+
+        m128 val_out;
+        loadcompressed128_chunks(&val_out, &buf, &mask, &c);
+        EXPECT_TRUE(!diff128(and128(val, mask), val_out));
+    }
+}
+
+TEST(state_compress, m512_chunks) {
+    char val_raw[64];
+    for (u32 i = 0; i < 64; i++) {
+        val_raw[i] = (i * 37) + 11;
+    }
+    m512 val;
+    memcpy(&val, val_raw, sizeof(val));
+
+    // Masks with empty, full and partial 64-bit chunks, so that the packed
+    // offsets are uneven.
+    for (u32 i = 0; i < 64; i++) {
+        char mask_raw[64];
+        for (u32 j = 0; j < 64; j++) {
+            mask_raw[j] = (j * 7 + i) % 3 ? 0xff >> (j % 8) : 0;
+        }
+        memset(mask_raw + (i / 8) * 8, 0, 8);
+        memset(mask_raw + ((i + 3) % 8) * 8, 0xff, 8);
+
+        m512 mask;
+        memcpy(&mask, mask_raw, sizeof(mask));
+        compress_chunks c = makeChunks(&mask, 8);
+
+        char buf[sizeof(m512)] = { 0 };
+        char buf_chunks[sizeof(m512)] = { 0 };
+        storecompressed512(&buf, &val, &mask, 0);
+        storecompressed512_chunks(&buf_chunks, &val, &mask, &c);
+        EXPECT_EQ(0, memcmp(buf, buf_chunks, sizeof(buf)));
+
+        m512 val_out;
+        loadcompressed512_chunks(&val_out, &buf, &mask, &c);
+        EXPECT_TRUE(!diff512(and512(val, mask), val_out));
+    }
+}
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "config.h"
+
+#include "gtest/gtest.h"
+
+#include "grey.h"
+#include "nfa/nfa_api.h"
+#include "nfa/nfa_api_queue.h"
+#include "nfa/nfa_internal.h"
+#include "nfa/limex_context.h"
+#include "nfa/tamaramacompile.h"
+#include "nfagraph/ng_holder.h"
+#include "nfagraph/ng_limex.h"
+#include "rose/rose_build_exclusive.h"
+#include "util/alloc.h"
+#include "util/compile_context.h"
+#include "util/make_unique.h"
+#include "util/report.h"
+#include "util/report_manager.h"
+#include "util/target_info.h"
+#include "scratch.h"
+
+#include <set>
+#include <vector>
+
+using namespace std;
+using namespace ue2;
+
+/* Builds the suffix /[loop]*end/, reporting the given report. */
+static
+unique_ptr<NGHolder> makeSuffix(const CharReach &loop, char end,
+                                ReportID report) {
+    auto h = ue2::make_unique<NGHolder>(NFA_SUFFIX);
+    NGHolder &g = *h;
+
+    NFAVertex u = add_vertex(g);
+    g[u].char_reach = loop;
+    NFAVertex v = add_vertex(g);
+    g[v].char_reach = CharReach(end);
+    g[v].reports.insert(report);
+
+    add_edge(g.start, u, g);
+    add_edge(g.start, v, g);
+    add_edge(u, u, g);
+    add_edge(u, v, g);
+    add_edge(v, g.accept, g);
+
+    return h;
+}
+
+static
+vector<CharReach> crSeq(const string &s) {
+    vector<CharReach> rv;
+    for (char c : s) {
+        rv.push_back(CharReach(c));
+    }
+    return rv;
+}
+
+static
+ExclusiveInfo makeInfo(const NGHolder &g, const string &trigger) {
+    ExclusiveInfo info;
+    info.graph = &g;
+    info.triggers[0].push_back(crSeq(trigger));
+    return info;
+}
+
+TEST(TamaramaExclusive, Pair) {
+    // Neither suffix can survive the other's trigger.
+    auto a = makeSuffix(~CharReach('Z'), 'X', 0);
+    auto b = makeSuffix(~CharReach('A'), 'Y', 1);
+    auto c = makeSuffix(CharReach::dot(), 'W', 2);
+
+    vector<ExclusiveInfo> info;
+    info.push_back(makeInfo(*a, "AAA"));
+    info.push_back(makeInfo(*b, "ZZZ"));
+    info.push_back(makeInfo(*c, "CCC"));
+
+    EXPECT_TRUE(killsSafely(info[0], info[1]));
+    EXPECT_TRUE(killsSafely(info[1], info[0]));
+
+    // c's dot loop lives through any trigger, and no trigger rules out 'C'.
+    EXPECT_FALSE(killsSafely(info[2], info[0]));
+    EXPECT_FALSE(killsSafely(info[0], info[2]));
+
+    Grey grey;
+    auto groups = findExclusiveGroups(info, grey);
+    ASSERT_EQ(1U, groups.size());
+    EXPECT_EQ(vector<u32>({0, 1}), groups[0]);
+}
+
+TEST(TamaramaExclusive, SimultaneousTriggers) {
+    // a can never see 'A' once triggered, so only b's trigger completing at
+    // the same offset as a's matters.
+    auto a = makeSuffix(~CharReach(string("AZ")), 'X', 0);
+    auto b = makeSuffix(~CharReach(string("AZ")), 'Y', 1);
+
+    ExclusiveInfo ia = makeInfo(*a, "ZZAA");
+    EXPECT_FALSE(killsSafely(ia, makeInfo(*b, "AA")));
+    EXPECT_TRUE(killsSafely(ia, makeInfo(*b, "ZA")));
+}
+
+TEST(TamaramaExclusive, ChunkSize) {
+    const CharReach triggers("ABCD");
+    vector<unique_ptr<NGHolder>> graphs;
+    vector<ExclusiveInfo> info;
+    for (u32 i = 0; i < 4; i++) {
+        graphs.push_back(makeSuffix(~triggers, 'X', i));
+        info.push_back(makeInfo(*graphs.back(), string(3, 'A' + i)));
+    }
+
+    Grey grey;
+    auto groups = findExclusiveGroups(info, grey);
+    ASSERT_EQ(1U, groups.size());
+    EXPECT_EQ(vector<u32>({0, 1, 2, 3}), groups[0]);
+
+    grey.tamaChunkSize = 2;
+    groups = findExclusiveGroups(info, grey);
+    ASSERT_EQ(2U, groups.size());
+    EXPECT_EQ(vector<u32>({0, 1}), groups[0]);
+    EXPECT_EQ(vector<u32>({2, 3}), groups[1]);
+
+    grey.tamaChunkSize = 3;
+    groups = findExclusiveGroups(info, grey);
+    ASSERT_EQ(1U, groups.size());
+    EXPECT_EQ(vector<u32>({0, 1, 2}), groups[0]);
+}
+
+static
+int onMatch(u64a offset, ReportID id, void *ctx) {
+    auto *matches = (vector<pair<u64a, ReportID>> *)ctx;
+    matches->push_back(make_pair(offset, id));
+    return MO_CONTINUE_MATCHING;
+}
+
+class TamaramaTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        CompileContext cc(true, false, get_current_target(), Grey());
+        ReportManager rm(cc.grey);
+        reportA = rm.getInternalId(makeCallback(10, 0));
+        reportB = rm.getInternalId(makeCallback(20, 0));
+
+        auto a = makeSuffix(~CharReach('Z'), 'X', reportA);
+        auto b = makeSuffix(~CharReach('A'), 'Y', reportB);
+
+        const map<u32, u32> fixed_depth_tops;
+        const map<u32, vector<vector<CharReach>>> triggers;
+        subA = constructNFA(*a, &rm, fixed_depth_tops, triggers, false, cc);
+        subB = constructNFA(*b, &rm, fixed_depth_tops, triggers, false, cc);
+        ASSERT_TRUE(subA != nullptr);
+        ASSERT_TRUE(subB != nullptr);
+
+        TamaInfo tamaInfo;
+        tamaInfo.add(subA.get(), {0});
+        tamaInfo.add(subB.get(), {0});
+        map<pair<const NFA *, u32>, u32> top_remap;
+        nfa = buildTamarama(tamaInfo, 0, top_remap);
+        ASSERT_TRUE(nfa != nullptr);
+        ASSERT_EQ(TAMARAMA_NFA_0, nfa->type);
+        topA = top_remap.at(make_pair(subA.get(), 0U));
+        topB = top_remap.at(make_pair(subB.get(), 0U));
+        ASSERT_NE(topA, topB);
+
+        full_state = aligned_zmalloc_unique<char>(nfa->scratchStateSize);
+        stream_state = aligned_zmalloc_unique<char>(nfa->streamStateSize);
+        nfa_context = aligned_zmalloc_unique<void>(sizeof(NFAContext512));
+        scratch = aligned_zmalloc_unique<hs_scratch>(sizeof(struct hs_scratch));
+        scratch->nfaContext = nfa_context.get();
+    }
+
+    void initQueue(const string &data) {
+        q.nfa = nfa.get();
+        q.cur = 0;
+        q.end = 0;
+        q.state = full_state.get();
+        q.streamState = stream_state.get();
+        q.offset = 0;
+        q.buffer = (const u8 *)data.c_str();
+        q.length = data.size();
+        q.history = nullptr;
+        q.hlength = 0;
+        q.scratch = scratch.get();
+        q.report_current = 0;
+        q.cb = onMatch;
+        q.som_cb = nullptr;
+        q.context = &matches;
+    }
+
+    ReportID reportA, reportB;
+    u32 topA, topB;
+    aligned_unique_ptr<NFA> subA, subB, nfa;
+    aligned_unique_ptr<char> full_state;
+    aligned_unique_ptr<char> stream_state;
+    aligned_unique_ptr<void> nfa_context;
+    aligned_unique_ptr<hs_scratch> scratch;
+    vector<pair<u64a, ReportID>> matches;
+    struct mq q;
+};
+
+// Subengine A is triggered at 3 and matches on each 'X'; B's top at 13 kills
+// it, and B then matches on each 'Y'.
+static const string TAMA_DATA = "AAA_b_X_X_ZZZ_Y_X_Y";
+
+TEST_F(TamaramaTest, QueueExec) {
+    initQueue(TAMA_DATA);
+    nfaQueueInitState(nfa.get(), &q);
+
+    const s64a end = TAMA_DATA.size();
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, topA, 3);
+    pushQueue(&q, topB, 13);
+    pushQueue(&q, MQE_END, end);
+
+    char rv = nfaQueueExec(nfa.get(), &q, end);
+    EXPECT_NE(0, rv);
+
+    vector<pair<u64a, ReportID>> expected = {
+        {7, reportA}, {9, reportA}, {15, reportB}, {19, reportB}};
+    EXPECT_EQ(expected, matches);
+}
+
+TEST_F(TamaramaTest, QueueExecInPieces) {
+    initQueue(TAMA_DATA);
+    nfaQueueInitState(nfa.get(), &q);
+
+    const s64a end = TAMA_DATA.size();
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, topA, 3);
+    pushQueue(&q, topB, 13);
+    pushQueue(&q, MQE_END, end);
+
+    // Stop part way through A's run, then before B's top.
+    nfaQueueExec(nfa.get(), &q, 8);
+    EXPECT_EQ(1U, matches.size());
+    EXPECT_EQ(MQE_START, q.items[q.cur].type);
+    EXPECT_EQ(8, q.items[q.cur].location);
+
+    nfaQueueExec(nfa.get(), &q, 12);
+    EXPECT_EQ(2U, matches.size());
+
+    nfaQueueExec(nfa.get(), &q, end);
+
+    vector<pair<u64a, ReportID>> expected = {
+        {7, reportA}, {9, reportA}, {15, reportB}, {19, reportB}};
+    EXPECT_EQ(expected, matches);
+}
+
+TEST_F(TamaramaTest, QueueExecToMatch) {
+    initQueue(TAMA_DATA);
+    nfaQueueInitState(nfa.get(), &q);
+
+    const s64a end = TAMA_DATA.size();
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, topA, 3);
+    pushQueue(&q, topB, 13);
+    pushQueue(&q, MQE_END, end);
+
+    // Run to each match in turn, reporting each with reportCurrent.
+    vector<s64a> locs;
+    while (nfaQueueExecToMatch(nfa.get(), &q, end) == MO_MATCHES_PENDING) {
+        locs.push_back(q.items[q.cur].location);
+        nfaReportCurrentMatches(nfa.get(), &q);
+    }
+
+    EXPECT_EQ(vector<s64a>({7, 9, 15, 19}), locs);
+    vector<pair<u64a, ReportID>> expected = {
+        {7, reportA}, {9, reportA}, {15, reportB}, {19, reportB}};
+    EXPECT_EQ(expected, matches);
+}
+
+TEST_F(TamaramaTest, InAccept) {
+    initQueue(TAMA_DATA);
+    nfaQueueInitState(nfa.get(), &q);
+
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, topA, 3);
+    pushQueue(&q, topB, 13);
+    pushQueue(&q, MQE_END, 15);
+
+    q.context = nullptr;
+    q.cb = nullptr;
+    EXPECT_NE(0, nfaQueueExecRose(nfa.get(), &q, reportB));
+
+    // Nothing active before the first top.
+    initQueue(TAMA_DATA);
+    nfaQueueInitState(nfa.get(), &q);
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_END, 3);
+    q.context = nullptr;
+    q.cb = nullptr;
+    EXPECT_EQ(0, nfaQueueExecRose(nfa.get(), &q, reportA));
+}
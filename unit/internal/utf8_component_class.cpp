@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include "gtest/gtest.h"
+
+#include "compiler/compiler.h"
+#include "grey.h"
+#include "hs_compile.h"
+#include "nfagraph/ng.h"
+#include "parser/Parser.h"
+#include "parser/Utf8ComponentClass.h"
+#include "util/compile_context.h"
+#include "util/ng_find_matches.h"
+#include "util/report_manager.h"
+#include "util/target_info.h"
+#include "util/unicode_def.h"
+#include "util/unicode_set.h"
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace ue2;
+
+namespace {
+
+/** Encodes a code point as (possibly surrogate) UTF-8. */
+string encode(unichar c) {
+    string s;
+    if (c < UTF_2CHAR_MIN) {
+        s.push_back((char)c);
+    } else if (c < UTF_3CHAR_MIN) {
+        s.push_back((char)(UTF_TWO_BYTE_HEADER | (c >> 6)));
+        s.push_back((char)(UTF_CONT_BYTE_HEADER | (c & 0x3f)));
+    } else if (c < UTF_4CHAR_MIN) {
+        s.push_back((char)(UTF_THREE_BYTE_HEADER | (c >> 12)));
+        s.push_back((char)(UTF_CONT_BYTE_HEADER | ((c >> 6) & 0x3f)));
+        s.push_back((char)(UTF_CONT_BYTE_HEADER | (c & 0x3f)));
+    } else {
+        s.push_back((char)(UTF_FOUR_BYTE_HEADER | (c >> 18)));
+        s.push_back((char)(UTF_CONT_BYTE_HEADER | ((c >> 12) & 0x3f)));
+        s.push_back((char)(UTF_CONT_BYTE_HEADER | ((c >> 6) & 0x3f)));
+        s.push_back((char)(UTF_CONT_BYTE_HEADER | (c & 0x3f)));
+    }
+    return s;
+}
+
+bool inSet(const CodePointSet &cps, unichar c) {
+    CodePointSet one;
+    one.set(c);
+    return cps.isSubset(one);
+}
+
+/** Code points either side of each encoding length boundary, the ends of the
+ * surrogate range, and a sample of everything else. */
+vector<unichar> probePoints(const CodePointSet &cps) {
+    set<unichar> points = {0, 'a', 'b', 0x7f, 0x80, 0x7ff, 0x800, 0xd7ff,
+                           UNICODE_SURROGATE_MIN, UNICODE_SURROGATE_MAX,
+                           0xe000, 0xfffd, 0xffff, 0x10000, 0x10ffff};
+    for (unichar c = 0; c <= MAX_UNICODE; c += 997) {
+        points.insert(c);
+    }
+    // The edges of every interval in the class.
+    for (const auto &i : cps) {
+        for (unichar c : {lower(i), upper(i)}) {
+            points.insert(c);
+            if (c) {
+                points.insert(c - 1);
+            }
+            if (c < MAX_UNICODE) {
+                points.insert(c + 1);
+            }
+        }
+    }
+    return vector<unichar>(points.begin(), points.end());
+}
+
+/** Byte sequences that are not UTF-8: overlong encodings, lead bytes that
+ * never start a character and encodings beyond U+10FFFF. */
+const vector<string> invalidSequences = {
+    "\xc0\x80", "\xc1\xbf", "\xe0\x80\x80", "\xe0\x9f\xbf",
+    "\xf0\x80\x80\x80", "\xf0\x8f\xbf\xbf", "\xf4\x90\x80\x80",
+    "\xf5\x80\x80\x80", "\xf7\xbf\xbf\xbf", "\xf8\x88\x80\x80\x80",
+    "\xff", "\x80", "\xbf",
+};
+
+/** Builds /^cls/ in UTF-8 mode and checks that it accepts the encoding of
+ * exactly the code points in \a expected, and no invalid sequence. */
+void checkClass(const string &cls, const CodePointSet &expected) {
+    SCOPED_TRACE(cls);
+    const string expr = "^" + cls;
+    const unsigned flags = HS_FLAG_UTF8;
+
+    CompileContext cc(false, false, get_current_target(), Grey());
+    ReportManager rm(cc.grey);
+    ParsedExpression parsed(0, expr.c_str(), flags, 0);
+    auto g = buildWrapper(rm, cc, parsed);
+    ASSERT_TRUE(g != nullptr);
+
+    for (unichar c : probePoints(expected)) {
+        const string input = encode(c);
+        set<pair<size_t, size_t>> matches;
+        findMatches(*g, rm, input, matches, false, false, true);
+        bool accepted = false;
+        for (const auto &m : matches) {
+            EXPECT_EQ(input.size(), m.second) << "partial match of " << c;
+            accepted |= m.second == input.size();
+        }
+        EXPECT_EQ(inSet(expected, c), accepted) << "code point " << c;
+    }
+
+    for (const string &input : invalidSequences) {
+        set<pair<size_t, size_t>> matches;
+        findMatches(*g, rm, input, matches, false, false, true);
+        EXPECT_TRUE(matches.empty()) << "lead byte " << (u32)(u8)input[0];
+    }
+}
+
+TEST(Utf8ComponentClass, PropertyLetter) {
+    ParseMode mode(HS_FLAG_UTF8);
+    checkClass("\\p{L}", getPredefinedCodePointSet(CLASS_UCP_L, mode));
+}
+
+TEST(Utf8ComponentClass, NegatedSingle) {
+    CodePointSet cps;
+    cps.set('a');
+    cps.flip();
+    checkClass("[^a]", cps);
+}
+
+TEST(Utf8ComponentClass, SingleAstral) {
+    CodePointSet cps;
+    cps.set(0x1f600);
+    checkClass("[\\x{1f600}]", cps);
+}
+
+TEST(Utf8ComponentClass, TwoToThreeByteBoundary) {
+    CodePointSet cps;
+    cps.setRange(0x7ff, 0x800);
+    checkClass("[\\x{7ff}-\\x{800}]", cps);
+}
+
+} // namespace
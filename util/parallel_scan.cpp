@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Multi-threaded block mode scanning of a single large buffer.
+ *
+ * Chunk i covers the matches ending in (start_i, end_i] (the first chunk also
+ * takes offset zero). It is scanned through a window that begins W + 1 bytes
+ * before start_i and ends two bytes after end_i, where W is the maximum match
+ * width: every match ending in the chunk then lies wholly inside the window
+ * along with the byte either side of it used by assertions, and any spurious
+ * match caused by the window's artificial start or end (anchors, \\b, $ before
+ * a final newline) lands outside the chunk and is discarded.
+ */
+
+#include "config.h"
+
+#include "parallel_scan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+/** Chunks are never smaller than this, to amortise the per-scan overhead. */
+static const size_t MIN_CHUNK = 1 << 16;
+
+/** Bytes of trailing context beyond each chunk. */
+static const size_t RIGHT_CONTEXT = 2;
+
+struct Match {
+    unsigned long long from;
+    unsigned long long to;
+    unsigned int id;
+    unsigned int flags;
+};
+
+struct Chunk {
+    size_t start; //!< matches must end after this offset ...
+    size_t end;   //!< ... and no later than this one
+    size_t windowStart;
+    size_t windowEnd;
+    vector<Match> matches;
+    hs_error_t err = HS_SUCCESS;
+    bool done = false;
+};
+
+class ParallelScan {
+public:
+    ParallelScan(const hs_database_t *db_in, const char *data_in,
+                 vector<Chunk> &chunks_in)
+        : db(db_in), data(data_in), chunks(chunks_in) {}
+
+    /** Worker body: claim and scan chunks until none are left. */
+    void work(hs_scratch_t *scratch) {
+        for (;;) {
+            size_t i = next++;
+            if (i >= chunks.size() || stop) {
+                break;
+            }
+            Chunk &c = chunks[i];
+            ChunkContext ctx = {&c, i == 0};
+            c.err = hs_scan64(db, data + c.windowStart,
+                              c.windowEnd - c.windowStart, 0, scratch,
+                              onMatch, &ctx);
+            stable_sort(c.matches.begin(), c.matches.end(),
+                        [](const Match &a, const Match &b) {
+                            return a.to < b.to;
+                        });
+
+            lock_guard<mutex> lock(m);
+            c.done = true;
+            cv.notify_all();
+        }
+    }
+
+    /** Wait for chunk \a i to be scanned. */
+    void wait(size_t i) {
+        unique_lock<mutex> lock(m);
+        cv.wait(lock, [&] { return chunks[i].done; });
+    }
+
+    /** Stop workers from claiming any more chunks. */
+    void cancel() { stop = true; }
+
+private:
+    struct ChunkContext {
+        Chunk *chunk;
+        bool first;
+    };
+
+    static
+    int onMatch(unsigned int id, unsigned long long from,
+                unsigned long long to, unsigned int flags, void *ctx_in) {
+        const ChunkContext *ctx = (const ChunkContext *)ctx_in;
+        Chunk &c = *ctx->chunk;
+        if (from) {
+            from += c.windowStart; // zero means no SOM was requested
+        }
+        to += c.windowStart;
+        if ((to > c.start || ctx->first) && to <= c.end) {
+            c.matches.push_back(Match{from, to, id, flags});
+        }
+        return 0;
+    }
+
+    const hs_database_t *db;
+    const char *data;
+    vector<Chunk> &chunks;
+    atomic<size_t> next{0};
+    atomic<bool> stop{false};
+    mutex m;
+    condition_variable cv;
+};
+
+} // namespace
+
+hs_error_t hs_scan_parallel(const hs_database_t *db, const char *data,
+                            size_t length, unsigned int threads,
+                            hs_scratch_t *scratch, match_event_handler onEvent,
+                            void *context) {
+    if (!db || !scratch || !threads || (!data && length)) {
+        return HS_INVALID;
+    }
+
+    unsigned int width;
+    hs_error_t err = hs_database_max_width(db, &width);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+    if (width == UINT_MAX) {
+        return HS_INVALID;
+    }
+
+    // One chunk per thread where possible, but keep the overlap small
+    // relative to the chunk.
+    size_t chunkSize = (length + threads - 1) / threads;
+    chunkSize = max(chunkSize, max(MIN_CHUNK, (size_t)width * 4));
+
+    if (length <= chunkSize) {
+        return hs_scan64(db, data, length, 0, scratch, onEvent, context);
+    }
+
+    vector<Chunk> chunks((length + chunkSize - 1) / chunkSize);
+    for (size_t i = 0; i < chunks.size(); i++) {
+        Chunk &c = chunks[i];
+        c.start = i * chunkSize;
+        c.end = min(c.start + chunkSize, length);
+        c.windowStart = c.start > (size_t)width + 1 ? c.start - width - 1 : 0;
+        c.windowEnd = min(c.end + RIGHT_CONTEXT, length);
+    }
+
+    size_t numWorkers = min((size_t)threads, chunks.size());
+    vector<hs_scratch_t *> scratches(numWorkers, nullptr);
+    for (auto &s : scratches) {
+        err = hs_clone_scratch(scratch, &s);
+        if (err != HS_SUCCESS) {
+            for (auto &t : scratches) {
+                hs_free_scratch(t);
+            }
+            return err;
+        }
+    }
+
+    ParallelScan scan(db, data, chunks);
+    vector<thread> workers;
+    for (auto s : scratches) {
+        workers.emplace_back(&ParallelScan::work, &scan, s);
+    }
+
+    // Deliver each chunk's matches as soon as it and all its predecessors
+    // are done, releasing them as we go.
+    err = HS_SUCCESS;
+    for (size_t i = 0; i < chunks.size() && err == HS_SUCCESS; i++) {
+        scan.wait(i);
+        Chunk &c = chunks[i];
+        if (c.err != HS_SUCCESS) {
+            err = c.err;
+            break;
+        }
+        if (onEvent) {
+            for (const auto &m : c.matches) {
+                if (onEvent(m.id, m.from, m.to, m.flags, context)) {
+                    err = HS_SCAN_TERMINATED;
+                    break;
+                }
+            }
+        }
+        vector<Match>().swap(c.matches);
+    }
+
+    scan.cancel();
+    for (auto &t : workers) {
+        t.join();
+    }
+    for (auto s : scratches) {
+        hs_free_scratch(s);
+    }
+    return err;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Multi-threaded block mode scanning of a single large buffer.
+ *
+ * Layered over the public API: the buffer is cut into chunks which are
+ * scanned on several threads, each through a window that overlaps its
+ * neighbours by the database's maximum match width (see
+ * \ref hs_database_max_width).
+ */
+
+#ifndef PARALLEL_SCAN_H
+#define PARALLEL_SCAN_H
+
+#include "hs.h"
+
+#include <cstddef>
+
+/**
+ * Scan a block of data of arbitrary length on up to \a threads threads.
+ *
+ * Matches are identical to those from a single \ref hs_scan call over the
+ * whole block: each is reported exactly once, even though the windows of
+ * adjacent chunks overlap. They are delivered on the calling thread, chunk by
+ * chunk in buffer order and sorted by end offset within each chunk, so the
+ * callback need not be thread-safe. If the callback asks for scanning to stop,
+ * no further matches are delivered and HS_SCAN_TERMINATED is returned.
+ *
+ * The database must be a block mode database with a bounded maximum match
+ * width; others are rejected with HS_INVALID. Scratch space for each worker
+ * thread is cloned from \a scratch, which must not be in use elsewhere.
+ */
+hs_error_t hs_scan_parallel(const hs_database_t *db, const char *data,
+                            size_t length, unsigned int threads,
+                            hs_scratch_t *scratch, match_event_handler onEvent,
+                            void *context);
+
+#endif
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Recording of scan calls to a trace file, and reading them back.
+ */
+
+#include "config.h"
+
+#include "scan_trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+struct hs_trace {
+    FILE *f = nullptr;
+    bool failed = false;
+    mutex m;
+    unordered_map<const hs_database_t *, uint32_t> dbIds;
+    unordered_map<const hs_stream_t *, uint32_t> streamIds;
+    uint32_t nextStreamId = 0;
+};
+
+namespace {
+
+/** Wraps the caller's callback to count the matches delivered. */
+struct CountingContext {
+    match_event_handler onEvent;
+    void *context;
+    uint64_t matches = 0;
+
+    CountingContext(match_event_handler cb, void *ctx)
+        : onEvent(cb), context(ctx) {}
+};
+
+static
+int countMatch(unsigned int id, unsigned long long from,
+               unsigned long long to, unsigned int flags, void *ctx) {
+    CountingContext *cc = (CountingContext *)ctx;
+    cc->matches++;
+    return cc->onEvent ? cc->onEvent(id, from, to, flags, cc->context) : 0;
+}
+
+static
+TraceRecord makeRecord(TraceOp op, uint32_t id, uint32_t aux,
+                       unsigned int flags, hs_error_t result,
+                       uint64_t matches, uint64_t length) {
+    TraceRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.op = op;
+    rec.id = id;
+    rec.aux = aux;
+    rec.flags = flags;
+    rec.result = result;
+    rec.matches = matches;
+    rec.length = length;
+    return rec;
+}
+
+/** Appends a record; the caller must hold the trace's lock. */
+static
+void writeRecord(hs_trace_t *trace, const TraceRecord &rec,
+                 const char *payload) {
+    if (fwrite(&rec, sizeof(rec), 1, trace->f) != 1 ||
+        (rec.length && fwrite(payload, rec.length, 1, trace->f) != 1)) {
+        trace->failed = true;
+    }
+}
+
+/** Returns the number of \a db in the trace, serializing it into the trace
+ * the first time it is seen. The caller must hold the trace's lock. */
+static
+uint32_t databaseId(hs_trace_t *trace, const hs_database_t *db) {
+    auto it = trace->dbIds.find(db);
+    if (it != trace->dbIds.end()) {
+        return it->second;
+    }
+
+    uint32_t id = (uint32_t)trace->dbIds.size();
+    trace->dbIds.emplace(db, id);
+
+    char *bytes = nullptr;
+    size_t length = 0;
+    if (hs_serialize_database(db, &bytes, &length) != HS_SUCCESS) {
+        trace->failed = true;
+        return id;
+    }
+    writeRecord(trace, makeRecord(TRACE_DATABASE, id, 0, 0, HS_SUCCESS, 0,
+                                  length), bytes);
+    free(bytes);
+    return id;
+}
+
+/** Returns the number of a live stream. The caller must hold the trace's
+ * lock. */
+static
+uint32_t streamId(hs_trace_t *trace, const hs_stream_t *stream) {
+    auto it = trace->streamIds.find(stream);
+    if (it == trace->streamIds.end()) {
+        // Opened before tracing started, or not through this layer.
+        trace->failed = true;
+        return ~0U;
+    }
+    return it->second;
+}
+
+static
+uint32_t newStream(hs_trace_t *trace, const hs_stream_t *stream) {
+    uint32_t id = trace->nextStreamId++;
+    trace->streamIds[stream] = id;
+    return id;
+}
+
+} // namespace
+
+hs_error_t hs_trace_start(const char *filename, hs_trace_t **trace) {
+    if (!filename || !trace) {
+        return HS_INVALID;
+    }
+    *trace = nullptr;
+
+    FILE *f = fopen(filename, "wb");
+    if (!f) {
+        return HS_INVALID;
+    }
+    if (fwrite(HS_TRACE_MAGIC, sizeof(HS_TRACE_MAGIC), 1, f) != 1) {
+        fclose(f);
+        return HS_INVALID;
+    }
+
+    hs_trace_t *t = new (nothrow) hs_trace;
+    if (!t) {
+        fclose(f);
+        return HS_NOMEM;
+    }
+    t->f = f;
+    *trace = t;
+    return HS_SUCCESS;
+}
+
+hs_error_t hs_trace_stop(hs_trace_t *trace) {
+    if (!trace) {
+        return HS_INVALID;
+    }
+
+    bool ok = !trace->failed;
+    if (fclose(trace->f) != 0) {
+        ok = false;
+    }
+    delete trace;
+    return ok ? HS_SUCCESS : HS_INVALID;
+}
+
+hs_error_t hs_trace_open_stream(hs_trace_t *trace, const hs_database_t *db,
+                                unsigned int flags, hs_stream_t **stream) {
+    hs_error_t ret = hs_open_stream(db, flags, stream);
+    if (!trace || ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    lock_guard<mutex> lock(trace->m);
+    uint32_t db_id = databaseId(trace, db);
+    uint32_t id = newStream(trace, *stream);
+    writeRecord(trace, makeRecord(TRACE_OPEN_STREAM, id, db_id, flags, ret, 0,
+                                  0), nullptr);
+    return ret;
+}
+
+hs_error_t hs_trace_scan_stream(hs_trace_t *trace, hs_stream_t *id,
+                                const char *data, unsigned int length,
+                                unsigned int flags, hs_scratch_t *scratch,
+                                match_event_handler onEvent, void *ctxt) {
+    if (!trace) {
+        return hs_scan_stream(id, data, length, flags, scratch, onEvent, ctxt);
+    }
+
+    CountingContext cc(onEvent, ctxt);
+    hs_error_t ret = hs_scan_stream(id, data, length, flags, scratch,
+                                    countMatch, &cc);
+
+    lock_guard<mutex> lock(trace->m);
+    writeRecord(trace, makeRecord(TRACE_SCAN_STREAM, streamId(trace, id), 0,
+                                  flags, ret, cc.matches, data ? length : 0),
+                data);
+    return ret;
+}
+
+hs_error_t hs_trace_close_stream(hs_trace_t *trace, hs_stream_t *id,
+                                 hs_scratch_t *scratch,
+                                 match_event_handler onEvent, void *ctxt) {
+    if (!trace) {
+        return hs_close_stream(id, scratch, onEvent, ctxt);
+    }
+
+    // Look the stream up first: once closed, its address may be reused.
+    uint32_t stream_id;
+    {
+        lock_guard<mutex> lock(trace->m);
+        stream_id = streamId(trace, id);
+        trace->streamIds.erase(id);
+    }
+
+    // Without a callback no end-of-data matches are wanted, so none are run.
+    CountingContext cc(onEvent, ctxt);
+    hs_error_t ret = hs_close_stream(id, scratch,
+                                     onEvent ? countMatch : nullptr, &cc);
+
+    lock_guard<mutex> lock(trace->m);
+    writeRecord(trace, makeRecord(TRACE_CLOSE_STREAM, stream_id,
+                                  scratch && onEvent ? 1 : 0, 0, ret,
+                                  cc.matches, 0),
+                nullptr);
+    return ret;
+}
+
+hs_error_t hs_trace_reset_stream(hs_trace_t *trace, hs_stream_t *id,
+                                 unsigned int flags, hs_scratch_t *scratch,
+                                 match_event_handler onEvent, void *context) {
+    if (!trace) {
+        return hs_reset_stream(id, flags, scratch, onEvent, context);
+    }
+
+    CountingContext cc(onEvent, context);
+    hs_error_t ret = hs_reset_stream(id, flags, scratch,
+                                     onEvent ? countMatch : nullptr, &cc);
+
+    lock_guard<mutex> lock(trace->m);
+    writeRecord(trace, makeRecord(TRACE_RESET_STREAM, streamId(trace, id),
+                                  scratch && onEvent ? 1 : 0, flags, ret,
+                                  cc.matches, 0),
+                nullptr);
+    return ret;
+}
+
+hs_error_t hs_trace_copy_stream(hs_trace_t *trace, hs_stream_t **to_id,
+                                const hs_stream_t *from_id) {
+    hs_error_t ret = hs_copy_stream(to_id, from_id);
+    if (!trace || ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    lock_guard<mutex> lock(trace->m);
+    uint32_t from = streamId(trace, from_id);
+    uint32_t to = newStream(trace, *to_id);
+    writeRecord(trace, makeRecord(TRACE_COPY_STREAM, to, from, 0, ret, 0, 0),
+                nullptr);
+    return ret;
+}
+
+hs_error_t hs_trace_scan(hs_trace_t *trace, const hs_database_t *db,
+                         const char *data, unsigned int length,
+                         unsigned int flags, hs_scratch_t *scratch,
+                         match_event_handler onEvent, void *context) {
+    if (!trace) {
+        return hs_scan(db, data, length, flags, scratch, onEvent, context);
+    }
+
+    CountingContext cc(onEvent, context);
+    hs_error_t ret = hs_scan(db, data, length, flags, scratch, countMatch,
+                             &cc);
+
+    lock_guard<mutex> lock(trace->m);
+    uint32_t db_id = databaseId(trace, db);
+    writeRecord(trace, makeRecord(TRACE_SCAN, db_id, 0, flags, ret,
+                                  cc.matches, data ? length : 0), data);
+    return ret;
+}
+
+TraceReader::TraceReader(const string &fname)
+    : in(fname.c_str(), ios::binary), filename(fname) {
+    if (!in) {
+        throw runtime_error("Unable to open trace " + filename);
+    }
+
+    char magic[sizeof(HS_TRACE_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) ||
+        memcmp(magic, HS_TRACE_MAGIC, sizeof(magic))) {
+        throw runtime_error(filename + " is not a scan trace");
+    }
+}
+
+bool TraceReader::next(TraceRecord &rec, string &payload) {
+    if (!in.read((char *)&rec, sizeof(rec))) {
+        if (in.gcount() == 0) {
+            return false;
+        }
+        throw runtime_error(filename + " is truncated");
+    }
+
+    payload.resize(rec.length);
+    if (rec.length && !in.read(&payload[0], rec.length)) {
+        throw runtime_error(filename + " is truncated");
+    }
+    return true;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2015, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Recording of scan calls to a trace file, and reading them back.
+ *
+ * Layered over the public API: each hs_trace_* function makes the
+ * corresponding Hyperscan call and, if given a trace, appends a record of the
+ * call to it, including the data scanned, the value returned and the number
+ * of matches delivered. The databases used are serialized into the trace the
+ * first time they are seen, so that a trace can be replayed on its own (see
+ * tools/hsreplay). Passing a NULL trace makes the calls untraced, so the layer
+ * can be left in place and enabled only when needed.
+ *
+ * Several threads may record into one trace at once; records are written in
+ * the order in which the calls complete. Databases must not be freed while a
+ * trace that has seen them is still being recorded.
+ *
+ * A trace file is an eight byte magic string followed by a sequence of
+ * records, each a TraceRecord followed by TraceRecord::length bytes of
+ * payload, all in host byte order.
+ */
+
+#ifndef SCAN_TRACE_H
+#define SCAN_TRACE_H
+
+#include "hs.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+/** Magic string at the start of every trace file, including the NUL. */
+#define HS_TRACE_MAGIC "HSTRACE"
+
+/** Calls that may be recorded in a trace. */
+enum TraceOp {
+    TRACE_DATABASE = 1,  //!< a serialized database, as payload
+    TRACE_OPEN_STREAM,   //!< hs_open_stream
+    TRACE_SCAN_STREAM,   //!< hs_scan_stream, with the data as payload
+    TRACE_CLOSE_STREAM,  //!< hs_close_stream
+    TRACE_RESET_STREAM,  //!< hs_reset_stream
+    TRACE_COPY_STREAM,   //!< hs_copy_stream
+    TRACE_SCAN           //!< hs_scan, with the data as payload
+};
+
+/** Header of one trace record. */
+struct TraceRecord {
+    uint8_t op;          //!< a TraceOp
+    uint8_t reserved[3];
+
+    /** Database number for TRACE_DATABASE and TRACE_SCAN, otherwise stream
+     * number. Both are assigned in order of first appearance from zero. */
+    uint32_t id;
+
+    /** Database number for TRACE_OPEN_STREAM, source stream number for
+     * TRACE_COPY_STREAM, and for TRACE_CLOSE_STREAM and TRACE_RESET_STREAM
+     * non-zero if both scratch and a callback were supplied, so that
+     * end-of-data matches were delivered. */
+    uint32_t aux;
+
+    uint32_t flags;      //!< flags argument of the call
+    int32_t result;      //!< value returned by the call
+    uint32_t reserved2;
+
+    /** Matches delivered by the call. If the call returned
+     * HS_SCAN_TERMINATED, the last of these is the one for which the callback
+     * asked for scanning to stop. */
+    uint64_t matches;
+
+    uint64_t length;     //!< bytes of payload following this header
+};
+
+static_assert(sizeof(TraceRecord) == 40, "trace records must be packed");
+
+/** Opaque trace recorder. */
+struct hs_trace;
+typedef struct hs_trace hs_trace_t;
+
+/** Creates (or truncates) \a filename and starts recording a trace into it.
+ * Returns HS_INVALID if the file cannot be opened. */
+hs_error_t hs_trace_start(const char *filename, hs_trace_t **trace);
+
+/** Finishes recording and frees the trace. Returns HS_INVALID if any
+ * record could not be written. */
+hs_error_t hs_trace_stop(hs_trace_t *trace);
+
+/** \ref hs_open_stream, recorded in \a trace. */
+hs_error_t hs_trace_open_stream(hs_trace_t *trace, const hs_database_t *db,
+                                unsigned int flags, hs_stream_t **stream);
+
+/** \ref hs_scan_stream, recorded in \a trace. */
+hs_error_t hs_trace_scan_stream(hs_trace_t *trace, hs_stream_t *id,
+                                const char *data, unsigned int length,
+                                unsigned int flags, hs_scratch_t *scratch,
+                                match_event_handler onEvent, void *ctxt);
+
+/** \ref hs_close_stream, recorded in \a trace. */
+hs_error_t hs_trace_close_stream(hs_trace_t *trace, hs_stream_t *id,
+                                 hs_scratch_t *scratch,
+                                 match_event_handler onEvent, void *ctxt);
+
+/** \ref hs_reset_stream, recorded in \a trace. */
+hs_error_t hs_trace_reset_stream(hs_trace_t *trace, hs_stream_t *id,
+                                 unsigned int flags, hs_scratch_t *scratch,
+                                 match_event_handler onEvent, void *context);
+
+/** \ref hs_copy_stream, recorded in \a trace. */
+hs_error_t hs_trace_copy_stream(hs_trace_t *trace, hs_stream_t **to_id,
+                                const hs_stream_t *from_id);
+
+/** \ref hs_scan, recorded in \a trace. */
+hs_error_t hs_trace_scan(hs_trace_t *trace, const hs_database_t *db,
+                         const char *data, unsigned int length,
+                         unsigned int flags, hs_scratch_t *scratch,
+                         match_event_handler onEvent, void *context);
+
+/** Reads the records of a trace file in order. */
+class TraceReader {
+public:
+    /** Opens \a filename and checks its magic string; throws
+     * std::runtime_error on failure. */
+    explicit TraceReader(const std::string &filename);
+
+    /** Reads the next record and its payload. Returns false at the end of
+     * the trace; throws std::runtime_error if the trace is truncated. */
+    bool next(TraceRecord &rec, std::string &payload);
+
+private:
+    std::ifstream in;
+    std::string filename;
+};
+
+#endif